@@ -82,6 +82,28 @@ Renderer* RendererFactory::createHeatmapRenderer()
     return Renderer::fromJson(rendererDocument.toJson(), this);
 }
 
+Renderer* RendererFactory::createDensityRenderer()
+{
+    QJsonObject rendererObject;
+    rendererObject.insert("type", "classBreaks");
+    rendererObject.insert("field", "density");
+    rendererObject.insert("minValue", 0);
+
+    // Same warm gradient as the heatmap, the cells stay translucent above the basemap
+    QJsonArray classBreakInfosArray;
+    classBreakInfosArray.push_back(createFillClassBreak(0.15, QColor(242,224,63,96)));
+    classBreakInfosArray.push_back(createFillClassBreak(0.3, QColor(239,192,58,128)));
+    classBreakInfosArray.push_back(createFillClassBreak(0.45, QColor(236,160,53,160)));
+    classBreakInfosArray.push_back(createFillClassBreak(0.6, QColor(232,129,47,176)));
+    classBreakInfosArray.push_back(createFillClassBreak(0.75, QColor(229,97,42,192)));
+    classBreakInfosArray.push_back(createFillClassBreak(1, QColor(226,65,37,208)));
+
+    rendererObject.insert("classBreakInfos", classBreakInfosArray);
+
+    QJsonDocument rendererDocument(rendererObject);
+    return Renderer::fromJson(rendererDocument.toJson(), this);
+}
+
 QJsonObject RendererFactory::createColorStop(double ratio, const QColor &color)
 {
     QJsonObject colorStop;
@@ -94,3 +116,22 @@ QJsonObject RendererFactory::createColorStop(double ratio, const QColor &color)
     colorStop.insert("color", colorArray);
     return colorStop;
 }
+
+QJsonObject RendererFactory::createFillClassBreak(double maxValue, const QColor &color)
+{
+    QJsonObject symbolObject;
+    symbolObject.insert("type", "esriSFS");
+    symbolObject.insert("style", "esriSFSSolid");
+    QJsonArray colorArray;
+    colorArray.push_back(color.red());
+    colorArray.push_back(color.green());
+    colorArray.push_back(color.blue());
+    colorArray.push_back(color.alpha());
+    symbolObject.insert("color", colorArray);
+    symbolObject.insert("outline", QJsonValue());
+
+    QJsonObject classBreak;
+    classBreak.insert("classMaxValue", maxValue);
+    classBreak.insert("symbol", symbolObject);
+    return classBreak;
+}
@@ -45,10 +45,14 @@ public:
 
     Esri::ArcGISRuntime::Renderer* createHeatmapRenderer();
 
+    // Colors the cells of the density grid by their relative "density" attribute
+    Esri::ArcGISRuntime::Renderer* createDensityRenderer();
+
 signals:
 
 private:
     QJsonObject createColorStop(double ratio, const QColor &color);
+    QJsonObject createFillClassBreak(double maxValue, const QColor &color);
 
 };
 
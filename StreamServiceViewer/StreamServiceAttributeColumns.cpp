@@ -0,0 +1,241 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceAttributeColumns.h"
+
+namespace
+{
+// A slot of the graphic's attribute map and the state and value kept in the column
+const qint64 GraphicAttributeBytes = 64;
+const qint64 ColumnValueBytes = 16;
+}
+
+StreamServiceAttributeColumns::StreamServiceAttributeColumns()
+{
+}
+
+void StreamServiceAttributeColumns::setSchema(const StreamServiceFieldSchema &schema)
+{
+    const int handleCapacity = m_handleCapacity;
+    m_schema = schema;
+    m_columns.clear();
+    m_columns.resize(schema.fieldCount());
+    m_strings.clear();
+    m_handleCapacity = 0;
+    resize(handleCapacity);
+}
+
+const StreamServiceFieldSchema& StreamServiceAttributeColumns::schema() const
+{
+    return m_schema;
+}
+
+void StreamServiceAttributeColumns::resize(int handleCapacity)
+{
+    if (handleCapacity <= m_handleCapacity)
+    {
+        return;
+    }
+
+    // Only the vector matching the type of the field is allocated
+    for (int slot = 0; slot < m_columns.size(); slot++)
+    {
+        Column &column = m_columns[slot];
+        column.states.resize(handleCapacity);
+        switch (m_schema.field(slot).type)
+        {
+        case StreamServiceFieldSchema::FieldType::Integer:
+        case StreamServiceFieldSchema::FieldType::Date:
+            column.integers.resize(handleCapacity);
+            break;
+        case StreamServiceFieldSchema::FieldType::Double:
+            column.numbers.resize(handleCapacity);
+            break;
+        case StreamServiceFieldSchema::FieldType::String:
+            column.stringIds.resize(handleCapacity);
+            break;
+        }
+    }
+    m_handleCapacity = handleCapacity;
+}
+
+void StreamServiceAttributeColumns::store(int handleIndex, const StreamServiceAttributeRow &row, QVector<int> &changedSlots)
+{
+    // Rows decoded using a previous schema may not match the columns
+    const int slotCount = qMin(row.size(), m_columns.size());
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        const StreamServiceAttributeValue &value = row[slot];
+        if (StreamServiceAttributeValue::State::Missing == value.state)
+        {
+            continue;
+        }
+
+        if (storeValue(m_columns[slot], m_schema.field(slot).type, handleIndex, value))
+        {
+            changedSlots.append(slot);
+        }
+    }
+}
+
+bool StreamServiceAttributeColumns::storeValue(Column &column, StreamServiceFieldSchema::FieldType type, int handleIndex, const StreamServiceAttributeValue &value)
+{
+    StreamServiceAttributeValue::State &state = column.states[handleIndex];
+    if (StreamServiceAttributeValue::State::Null == value.state)
+    {
+        if (StreamServiceAttributeValue::State::Null == state)
+        {
+            return false;
+        }
+
+        if (StreamServiceFieldSchema::FieldType::String == type)
+        {
+            m_strings.release(column.stringIds[handleIndex]);
+            column.stringIds[handleIndex] = StreamServiceStringPool::NullId;
+        }
+        state = StreamServiceAttributeValue::State::Null;
+        return true;
+    }
+
+    const bool wasSet = StreamServiceAttributeValue::State::Set == state;
+    switch (type)
+    {
+    case StreamServiceFieldSchema::FieldType::Integer:
+    case StreamServiceFieldSchema::FieldType::Date:
+        if (wasSet && column.integers[handleIndex] == value.integer)
+        {
+            return false;
+        }
+        column.integers[handleIndex] = value.integer;
+        break;
+    case StreamServiceFieldSchema::FieldType::Double:
+        if (wasSet && column.numbers[handleIndex] == value.number)
+        {
+            return false;
+        }
+        column.numbers[handleIndex] = value.number;
+        break;
+    case StreamServiceFieldSchema::FieldType::String:
+    {
+        quint32 &stringId = column.stringIds[handleIndex];
+        if (wasSet && m_strings.string(stringId) == value.string)
+        {
+            return false;
+        }
+        const quint32 previousId = stringId;
+        stringId = m_strings.intern(value.string);
+        m_strings.release(previousId);
+        break;
+    }
+    }
+    state = StreamServiceAttributeValue::State::Set;
+    return true;
+}
+
+void StreamServiceAttributeColumns::clear(int handleIndex)
+{
+    for (int slot = 0; slot < m_columns.size(); slot++)
+    {
+        clearValue(handleIndex, slot);
+    }
+}
+
+void StreamServiceAttributeColumns::clearValue(int handleIndex, int slot)
+{
+    if (m_handleCapacity <= handleIndex)
+    {
+        return;
+    }
+
+    Column &column = m_columns[slot];
+    if (StreamServiceFieldSchema::FieldType::String == m_schema.field(slot).type)
+    {
+        m_strings.release(column.stringIds[handleIndex]);
+        column.stringIds[handleIndex] = StreamServiceStringPool::NullId;
+    }
+    column.states[handleIndex] = StreamServiceAttributeValue::State::Missing;
+}
+
+StreamServiceAttributeValue StreamServiceAttributeColumns::typedValue(int handleIndex, int slot) const
+{
+    const Column &column = m_columns[slot];
+    StreamServiceAttributeValue value;
+    value.state = column.states[handleIndex];
+    if (StreamServiceAttributeValue::State::Set == value.state)
+    {
+        switch (m_schema.field(slot).type)
+        {
+        case StreamServiceFieldSchema::FieldType::Integer:
+        case StreamServiceFieldSchema::FieldType::Date:
+            value.integer = column.integers[handleIndex];
+            break;
+        case StreamServiceFieldSchema::FieldType::Double:
+            value.number = column.numbers[handleIndex];
+            break;
+        case StreamServiceFieldSchema::FieldType::String:
+            value.string = m_strings.string(column.stringIds[handleIndex]);
+            break;
+        }
+    }
+    return value;
+}
+
+QVariant StreamServiceAttributeColumns::value(int handleIndex, int slot) const
+{
+    return m_schema.toVariant(slot, typedValue(handleIndex, slot));
+}
+
+void StreamServiceAttributeColumns::insertInto(int handleIndex, QVariantMap &attributes) const
+{
+    for (int slot = 0; slot < m_columns.size(); slot++)
+    {
+        if (StreamServiceAttributeValue::State::Missing != m_columns[slot].states[handleIndex])
+        {
+            attributes.insert(m_schema.field(slot).name, value(handleIndex, slot));
+        }
+    }
+}
+
+qint64 StreamServiceAttributeColumns::estimateBytes(int handleIndex) const
+{
+    qint64 trackBytes = 0;
+    for (int slot = 0; slot < m_columns.size(); slot++)
+    {
+        const Column &column = m_columns[slot];
+        if (StreamServiceAttributeValue::State::Missing == column.states[handleIndex])
+        {
+            continue;
+        }
+
+        // The graphic holds the name and a shared copy of the interned string
+        const StreamServiceFieldSchema::Field &field = m_schema.field(slot);
+        trackBytes += GraphicAttributeBytes + ColumnValueBytes + 2 * field.name.size();
+        if (StreamServiceFieldSchema::FieldType::String == field.type)
+        {
+            trackBytes += 2 * m_strings.string(column.stringIds[handleIndex]).size();
+        }
+    }
+    return trackBytes;
+}
@@ -0,0 +1,82 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEATTRIBUTECOLUMNS_H
+#define STREAMSERVICEATTRIBUTECOLUMNS_H
+
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceStringPool.h"
+
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+///
+/// \brief The StreamServiceAttributeColumns class
+/// The typed attributes of the live tracks, one column per field of the schema indexed by track handle.
+/// String values are interned, tracks sharing a value share its storage.
+///
+class StreamServiceAttributeColumns
+{
+public:
+    StreamServiceAttributeColumns();
+
+    // Drops all stored values
+    void setSchema(const StreamServiceFieldSchema &schema);
+    const StreamServiceFieldSchema& schema() const;
+
+    void resize(int handleCapacity);
+
+    // Missing values keep the stored ones, the slots of the changed values are appended
+    void store(int handleIndex, const StreamServiceAttributeRow &row, QVector<int> &changedSlots);
+    void clear(int handleIndex);
+    void clearValue(int handleIndex, int slot);
+
+    StreamServiceAttributeValue typedValue(int handleIndex, int slot) const;
+    QVariant value(int handleIndex, int slot) const;
+    void insertInto(int handleIndex, QVariantMap &attributes) const;
+
+    // Includes the copies held by the graphic
+    qint64 estimateBytes(int handleIndex) const;
+
+private:
+    struct Column
+    {
+        QVector<StreamServiceAttributeValue::State> states;
+        QVector<qint64> integers;
+        QVector<double> numbers;
+        QVector<quint32> stringIds;
+    };
+
+    bool storeValue(Column &column, StreamServiceFieldSchema::FieldType type, int handleIndex, const StreamServiceAttributeValue &value);
+
+    StreamServiceFieldSchema m_schema;
+    QVector<Column> m_columns;
+    StreamServiceStringPool m_strings;
+    int m_handleCapacity = 0;
+};
+
+#endif // STREAMSERVICEATTRIBUTECOLUMNS_H
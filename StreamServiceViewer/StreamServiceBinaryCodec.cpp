@@ -0,0 +1,840 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceBinaryCodec.h"
+#include "StreamServiceTrackUpdate.h"
+
+#include <QDebug>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+
+using namespace Esri::ArcGISRuntime;
+using namespace StreamServiceBinaryCodec;
+
+namespace
+{
+
+void writeVarint(QByteArray &buffer, quint64 value)
+{
+    while (value >= 0x80)
+    {
+        buffer.append(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    buffer.append(static_cast<char>(value));
+}
+
+void writeZigZag(QByteArray &buffer, qint64 value)
+{
+    writeVarint(buffer, (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63));
+}
+
+void writeDouble(QByteArray &buffer, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits = qToLittleEndian(bits);
+    buffer.append(reinterpret_cast<const char*>(&bits), sizeof(bits));
+}
+
+void writeString(QByteArray &buffer, const QString &value)
+{
+    const QByteArray utf8Value = value.toUtf8();
+    writeVarint(buffer, static_cast<quint64>(utf8Value.size()));
+    buffer.append(utf8Value);
+}
+
+bool readVarint(const uchar *&position, const uchar *end, quint64 &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7)
+    {
+        if (position == end)
+        {
+            return false;
+        }
+
+        const uchar byte = *position++;
+        value |= static_cast<quint64>(byte & 0x7F) << shift;
+        if (0 == (byte & 0x80))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool readZigZag(const uchar *&position, const uchar *end, qint64 &value)
+{
+    quint64 encodedValue;
+    if (!readVarint(position, end, encodedValue))
+    {
+        return false;
+    }
+    value = static_cast<qint64>(encodedValue >> 1) ^ -static_cast<qint64>(encodedValue & 1);
+    return true;
+}
+
+bool readDouble(const uchar *&position, const uchar *end, double &value)
+{
+    if (end - position < 8)
+    {
+        return false;
+    }
+    const quint64 bits = qFromLittleEndian<quint64>(position);
+    std::memcpy(&value, &bits, sizeof(value));
+    position += 8;
+    return true;
+}
+
+bool readString(const uchar *&position, const uchar *end, QString &value)
+{
+    quint64 length;
+    if (!readVarint(position, end, length) || static_cast<quint64>(end - position) < length)
+    {
+        return false;
+    }
+
+    // Decode straight out of the received frame
+    value = QString::fromUtf8(reinterpret_cast<const char*>(position), static_cast<int>(length));
+    position += length;
+    return true;
+}
+
+bool isIntegral(double value)
+{
+    return std::floor(value) == value && std::fabs(value) < 9007199254740992.0;
+}
+
+FieldType fieldTypeOf(const QJsonValue &value)
+{
+    switch (value.type())
+    {
+    case QJsonValue::Bool:
+        return FieldType::Boolean;
+    case QJsonValue::Double:
+        return isIntegral(value.toDouble()) ? FieldType::Integer : FieldType::Double;
+    default:
+        return FieldType::String;
+    }
+}
+
+qint64 scaleForSpatialReference(int wkid)
+{
+    // Geographic coordinates need about a centimeter, projected ones a millimeter
+    return (4326 == wkid) ? 10000000 : 1000;
+}
+
+}
+
+StreamServiceBinaryEncoder::StreamServiceBinaryEncoder()
+{
+}
+
+void StreamServiceBinaryEncoder::setDateFields(const QStringList &dateFields)
+{
+    m_dateFields = QSet<QString>(dateFields.cbegin(), dateFields.cend());
+}
+
+void StreamServiceBinaryEncoder::addFeature(const QJsonObject &featureObject)
+{
+    auto const geometryKey = "geometry";
+    auto const attributesKey = "attributes";
+    const QJsonObject geometryObject = featureObject.value(geometryKey).toObject();
+    const QJsonObject attributesObject = featureObject.value(attributesKey).toObject();
+
+    // The schema must be complete before the feature is encoded
+    bool schemaChanged = ensureSpatialReference(geometryObject);
+    for (auto attributeIterator = attributesObject.constBegin(); attributeIterator != attributesObject.constEnd(); ++attributeIterator)
+    {
+        schemaChanged |= ensureField(attributeIterator.key(), attributeIterator.value());
+    }
+
+    if (schemaChanged || 0 == m_schema.version)
+    {
+        // Pending features were encoded using the previous schema version
+        flush();
+        m_schema.version++;
+        m_frames.append(schemaFrame());
+    }
+
+    encodeGeometry(geometryObject);
+
+    writeVarint(m_featureBuffer, static_cast<quint64>(attributesObject.size()));
+    for (auto attributeIterator = attributesObject.constBegin(); attributeIterator != attributesObject.constEnd(); ++attributeIterator)
+    {
+        const int slot = m_fieldSlots.value(attributeIterator.key());
+        const QJsonValue value = attributeIterator.value();
+        const bool isNull = value.isNull() || value.isUndefined();
+        writeVarint(m_featureBuffer, (static_cast<quint64>(slot) << 1) | (isNull ? 1 : 0));
+        if (isNull)
+        {
+            continue;
+        }
+
+        switch (m_schema.fields[slot].type)
+        {
+        case FieldType::Integer:
+        case FieldType::Date:
+        {
+            const qint64 integerValue = static_cast<qint64>(value.toDouble());
+            writeZigZag(m_featureBuffer, integerValue - m_previousIntegers[slot]);
+            m_previousIntegers[slot] = integerValue;
+            break;
+        }
+        case FieldType::Double:
+            writeDouble(m_featureBuffer, value.toDouble());
+            break;
+        case FieldType::Boolean:
+            m_featureBuffer.append(static_cast<char>(value.toBool() ? 1 : 0));
+            break;
+        case FieldType::String:
+            writeString(m_featureBuffer, value.isString() ? value.toString() : value.toVariant().toString());
+            break;
+        }
+    }
+
+    m_pendingFeatureCount++;
+}
+
+void StreamServiceBinaryEncoder::flush()
+{
+    if (0 == m_pendingFeatureCount)
+    {
+        return;
+    }
+
+    QByteArray frame;
+    frame.reserve(m_featureBuffer.size() + 16);
+    frame.append(static_cast<char>(FrameMarker));
+    frame.append(static_cast<char>(FrameType::Features));
+    writeVarint(frame, m_schema.version);
+    writeVarint(frame, static_cast<quint64>(m_pendingFeatureCount));
+    frame.append(m_featureBuffer);
+    m_frames.append(frame);
+
+    // Deltas never cross frame boundaries
+    m_featureBuffer.clear();
+    m_pendingFeatureCount = 0;
+    m_previousX = 0;
+    m_previousY = 0;
+    m_previousIntegers.fill(0);
+}
+
+void StreamServiceBinaryEncoder::expireTracks(const QStringList &trackIds)
+{
+    if (trackIds.isEmpty())
+    {
+        return;
+    }
+
+    flush();
+    QByteArray frame;
+    frame.append(static_cast<char>(FrameMarker));
+    frame.append(static_cast<char>(FrameType::Expired));
+    writeVarint(frame, static_cast<quint64>(trackIds.size()));
+    for (auto const &trackId : trackIds)
+    {
+        writeString(frame, trackId);
+    }
+    m_frames.append(frame);
+}
+
+QByteArray StreamServiceBinaryEncoder::schemaFrame() const
+{
+    QByteArray frame;
+    frame.append(static_cast<char>(FrameMarker));
+    frame.append(static_cast<char>(FrameType::Schema));
+    writeVarint(frame, m_schema.version);
+    writeZigZag(frame, m_schema.wkid);
+    writeVarint(frame, static_cast<quint64>(m_schema.coordinateScale));
+    writeVarint(frame, static_cast<quint64>(m_schema.fields.size()));
+    for (auto const &field : m_schema.fields)
+    {
+        frame.append(static_cast<char>(field.type));
+        writeString(frame, field.name);
+    }
+    return frame;
+}
+
+QList<QByteArray> StreamServiceBinaryEncoder::takeFrames()
+{
+    QList<QByteArray> frames;
+    frames.swap(m_frames);
+    return frames;
+}
+
+bool StreamServiceBinaryEncoder::ensureField(const QString &name, const QJsonValue &value)
+{
+    const bool isNull = value.isNull() || value.isUndefined();
+    FieldType valueType = fieldTypeOf(value);
+    if (FieldType::Integer == valueType && m_dateFields.contains(name))
+    {
+        valueType = FieldType::Date;
+    }
+
+    auto slotIterator = m_fieldSlots.constFind(name);
+    if (slotIterator == m_fieldSlots.constEnd())
+    {
+        // Null values only reserve the slot, the first real value defines the type
+        StreamServiceBinaryField field;
+        field.name = name;
+        field.type = isNull ? FieldType::Integer : valueType;
+        const int slot = m_schema.fields.size();
+        m_schema.fields.append(field);
+        m_previousIntegers.append(0);
+        m_fieldSlots.insert(name, slot);
+        if (isNull)
+        {
+            m_untypedSlots.insert(slot);
+        }
+        return true;
+    }
+
+    if (isNull)
+    {
+        return false;
+    }
+
+    const int slot = slotIterator.value();
+    StreamServiceBinaryField &field = m_schema.fields[slot];
+    if (m_untypedSlots.remove(slot))
+    {
+        field.type = valueType;
+        return true;
+    }
+
+    if (field.type == valueType)
+    {
+        return false;
+    }
+
+    // Widen integers to doubles, every other conflict falls back to strings
+    if (FieldType::Double == field.type && (FieldType::Integer == valueType || FieldType::Date == valueType))
+    {
+        return false;
+    }
+
+    if (FieldType::String == field.type)
+    {
+        return false;
+    }
+
+    if ((FieldType::Integer == field.type || FieldType::Date == field.type) && FieldType::Double == valueType)
+    {
+        field.type = FieldType::Double;
+    }
+    else
+    {
+        field.type = FieldType::String;
+    }
+    return true;
+}
+
+bool StreamServiceBinaryEncoder::ensureSpatialReference(const QJsonObject &geometryObject)
+{
+    auto const spatialReferenceKey = "spatialReference";
+    if (!geometryObject.contains(spatialReferenceKey))
+    {
+        return false;
+    }
+
+    const QJsonObject spatialReferenceObject = geometryObject.value(spatialReferenceKey).toObject();
+    int wkid = spatialReferenceObject.value("latestWkid").toInt(0);
+    if (0 == wkid)
+    {
+        wkid = spatialReferenceObject.value("wkid").toInt(0);
+    }
+
+    if (0 == wkid || wkid == m_schema.wkid)
+    {
+        return false;
+    }
+
+    m_schema.wkid = wkid;
+    m_schema.coordinateScale = scaleForSpatialReference(wkid);
+    return true;
+}
+
+void StreamServiceBinaryEncoder::encodeGeometry(const QJsonObject &geometryObject)
+{
+    auto const xKey = "x";
+    auto const yKey = "y";
+    auto const pointsKey = "points";
+    auto const pathsKey = "paths";
+    auto const ringsKey = "rings";
+
+    if (geometryObject.contains(xKey) && geometryObject.contains(yKey))
+    {
+        m_featureBuffer.append(static_cast<char>(GeometryType::Point));
+        QJsonArray coordinatesArray;
+        coordinatesArray.append(geometryObject.value(xKey));
+        coordinatesArray.append(geometryObject.value(yKey));
+        QJsonArray pointsArray;
+        pointsArray.append(coordinatesArray);
+        encodeCoordinates(pointsArray);
+        return;
+    }
+
+    if (geometryObject.contains(pointsKey))
+    {
+        m_featureBuffer.append(static_cast<char>(GeometryType::Multipoint));
+        const QJsonArray pointsArray = geometryObject.value(pointsKey).toArray();
+        writeVarint(m_featureBuffer, static_cast<quint64>(pointsArray.size()));
+        encodeCoordinates(pointsArray);
+        return;
+    }
+
+    const bool isPolyline = geometryObject.contains(pathsKey);
+    const bool isPolygon = geometryObject.contains(ringsKey);
+    if (!isPolyline && !isPolygon)
+    {
+        m_featureBuffer.append(static_cast<char>(GeometryType::None));
+        return;
+    }
+
+    m_featureBuffer.append(static_cast<char>(isPolyline ? GeometryType::Polyline : GeometryType::Polygon));
+    const QJsonArray partsArray = geometryObject.value(isPolyline ? pathsKey : ringsKey).toArray();
+    writeVarint(m_featureBuffer, static_cast<quint64>(partsArray.size()));
+    for (auto const &partValue : partsArray)
+    {
+        const QJsonArray pointsArray = partValue.toArray();
+        writeVarint(m_featureBuffer, static_cast<quint64>(pointsArray.size()));
+        encodeCoordinates(pointsArray);
+    }
+}
+
+void StreamServiceBinaryEncoder::encodeCoordinates(const QJsonArray &coordinatesArray)
+{
+    const double scale = static_cast<double>(m_schema.coordinateScale);
+    for (auto const &coordinateValue : coordinatesArray)
+    {
+        const QJsonArray coordinateArray = coordinateValue.toArray();
+        const qint64 x = qRound64(coordinateArray.at(0).toDouble() * scale);
+        const qint64 y = qRound64(coordinateArray.at(1).toDouble() * scale);
+        writeZigZag(m_featureBuffer, x - m_previousX);
+        writeZigZag(m_featureBuffer, y - m_previousY);
+        m_previousX = x;
+        m_previousY = y;
+    }
+}
+
+StreamServiceBinaryDecoder::StreamServiceBinaryDecoder()
+{
+}
+
+void StreamServiceBinaryDecoder::setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField)
+{
+    m_trackIdField = trackIdField;
+    m_startTimeField = startTimeField;
+    m_endTimeField = endTimeField;
+    resolveTimeInfoSlots();
+}
+
+void StreamServiceBinaryDecoder::setTargetWkid(int targetWkid)
+{
+    m_geometryBuilder.setTargetWkid(targetWkid);
+}
+
+void StreamServiceBinaryDecoder::setFieldSchema(const StreamServiceFieldSchema &fieldSchema)
+{
+    m_fieldSchema = fieldSchema;
+}
+
+bool StreamServiceBinaryDecoder::hasSchema() const
+{
+    return m_hasSchema;
+}
+
+bool StreamServiceBinaryDecoder::decode(const QByteArray &frame, QVector<StreamServiceTrackUpdate> &updates)
+{
+    const uchar *position = reinterpret_cast<const uchar*>(frame.constData());
+    const uchar *end = position + frame.size();
+    if (frame.size() < 2 || FrameMarker != position[0])
+    {
+        qDebug() << "Binary message is not a stream service frame!";
+        return false;
+    }
+
+    const FrameType frameType = static_cast<FrameType>(position[1]);
+    position += 2;
+    switch (frameType)
+    {
+    case FrameType::Schema:
+        return decodeSchema(position, end);
+    case FrameType::Features:
+        return decodeFeatures(position, end, updates);
+    case FrameType::Expired:
+        return decodeExpired(position, end, updates);
+    }
+
+    qDebug() << "Unsupported binary frame type received!";
+    return false;
+}
+
+bool StreamServiceBinaryDecoder::decodeSchema(const uchar *position, const uchar *end)
+{
+    StreamServiceBinarySchema schema;
+    quint64 version, coordinateScale, fieldCount;
+    qint64 wkid;
+    if (!readVarint(position, end, version)
+            || !readZigZag(position, end, wkid)
+            || !readVarint(position, end, coordinateScale)
+            || !readVarint(position, end, fieldCount))
+    {
+        qDebug() << "Binary schema frame is truncated!";
+        return false;
+    }
+
+    schema.version = static_cast<quint32>(version);
+    schema.wkid = static_cast<int>(wkid);
+    schema.coordinateScale = static_cast<qint64>(coordinateScale);
+    if (0 == schema.coordinateScale || static_cast<quint64>(end - position) < fieldCount)
+    {
+        qDebug() << "Binary schema frame is invalid!";
+        return false;
+    }
+
+    schema.fields.reserve(static_cast<int>(fieldCount));
+    for (quint64 fieldIndex = 0; fieldIndex < fieldCount; fieldIndex++)
+    {
+        if (position == end)
+        {
+            return false;
+        }
+
+        StreamServiceBinaryField field;
+        field.type = static_cast<FieldType>(*position++);
+        if (!readString(position, end, field.name))
+        {
+            qDebug() << "Binary schema frame is truncated!";
+            return false;
+        }
+        schema.fields.append(field);
+    }
+
+    m_schema = schema;
+    m_hasSchema = true;
+    m_previousIntegers.fill(0, m_schema.fields.size());
+    resolveTimeInfoSlots();
+    return true;
+}
+
+bool StreamServiceBinaryDecoder::decodeFeatures(const uchar *position, const uchar *end, QVector<StreamServiceTrackUpdate> &updates)
+{
+    quint64 version, featureCount;
+    if (!readVarint(position, end, version) || !readVarint(position, end, featureCount))
+    {
+        qDebug() << "Binary features frame is truncated!";
+        return false;
+    }
+
+    if (!m_hasSchema || version != m_schema.version)
+    {
+        qDebug() << "Binary features frame references an unknown schema!";
+        return false;
+    }
+
+    // The geometries of the whole frame are projected at once, also when a malformed part ends the frame
+    m_geometryBuilder.clear();
+    m_geometryIndices.resize(0);
+    const int firstUpdateIndex = updates.size();
+    const bool decoded = decodeFeatureList(position, end, featureCount, updates);
+    m_geometryBuilder.project();
+    for (int updateIndex = firstUpdateIndex; updateIndex < updates.size(); updateIndex++)
+    {
+        updates[updateIndex].geometry = m_geometryBuilder.geometry(m_geometryIndices[updateIndex - firstUpdateIndex]);
+    }
+    return decoded;
+}
+
+bool StreamServiceBinaryDecoder::decodeFeatureList(const uchar *&position, const uchar *end, quint64 featureCount, QVector<StreamServiceTrackUpdate> &updates)
+{
+    const double scale = static_cast<double>(m_schema.coordinateScale);
+    const int fieldCount = m_schema.fields.size();
+    qint64 previousX = 0, previousY = 0;
+    m_previousIntegers.fill(0);
+
+    auto readPoint = [&]() {
+        qint64 deltaX, deltaY;
+        if (!readZigZag(position, end, deltaX) || !readZigZag(position, end, deltaY))
+        {
+            return false;
+        }
+        previousX += deltaX;
+        previousY += deltaY;
+        m_geometryBuilder.addPoint(previousX / scale, previousY / scale);
+        return true;
+    };
+
+    for (quint64 featureIndex = 0; featureIndex < featureCount; featureIndex++)
+    {
+        if (position == end)
+        {
+            qDebug() << "Binary features frame is truncated!";
+            return false;
+        }
+
+        StreamServiceTrackUpdate update;
+        const GeometryType geometryType = static_cast<GeometryType>(*position++);
+        int geometryIndex = -1;
+        switch (geometryType)
+        {
+        case GeometryType::None:
+            break;
+        case GeometryType::Point:
+        {
+            geometryIndex = m_geometryBuilder.beginGeometry(StreamServiceGeometryBuilder::GeometryType::Point);
+            m_geometryBuilder.setSpatialReference(m_schema.wkid, false);
+            if (!readPoint())
+            {
+                return false;
+            }
+            break;
+        }
+        case GeometryType::Multipoint:
+        {
+            quint64 pointCount;
+            if (!readVarint(position, end, pointCount))
+            {
+                return false;
+            }
+            geometryIndex = m_geometryBuilder.beginGeometry(StreamServiceGeometryBuilder::GeometryType::Multipoint);
+            m_geometryBuilder.setSpatialReference(m_schema.wkid, false);
+            for (quint64 pointIndex = 0; pointIndex < pointCount; pointIndex++)
+            {
+                if (!readPoint())
+                {
+                    return false;
+                }
+            }
+            break;
+        }
+        case GeometryType::Polyline:
+        case GeometryType::Polygon:
+        {
+            quint64 partCount;
+            if (!readVarint(position, end, partCount))
+            {
+                return false;
+            }
+            geometryIndex = m_geometryBuilder.beginGeometry((GeometryType::Polyline == geometryType)
+                                                            ? StreamServiceGeometryBuilder::GeometryType::Polyline
+                                                            : StreamServiceGeometryBuilder::GeometryType::Polygon);
+            m_geometryBuilder.setSpatialReference(m_schema.wkid, false);
+            for (quint64 partIndex = 0; partIndex < partCount; partIndex++)
+            {
+                quint64 pointCount;
+                if (!readVarint(position, end, pointCount))
+                {
+                    return false;
+                }
+                m_geometryBuilder.beginPart();
+                for (quint64 pointIndex = 0; pointIndex < pointCount; pointIndex++)
+                {
+                    if (!readPoint())
+                    {
+                        return false;
+                    }
+                }
+            }
+            break;
+        }
+        default:
+            qDebug() << "Unsupported binary geometry type received!";
+            return false;
+        }
+
+        quint64 attributeCount;
+        if (!readVarint(position, end, attributeCount))
+        {
+            return false;
+        }
+
+        for (quint64 attributeIndex = 0; attributeIndex < attributeCount; attributeIndex++)
+        {
+            quint64 slotAndNull;
+            if (!readVarint(position, end, slotAndNull))
+            {
+                return false;
+            }
+
+            // Checked before narrowing, a crafted varint must not wrap into a valid or negative slot
+            if (static_cast<quint64>(fieldCount) <= (slotAndNull >> 1))
+            {
+                qDebug() << "Binary feature references an unknown attribute slot!";
+                return false;
+            }
+
+            const int slot = static_cast<int>(slotAndNull >> 1);
+
+            const StreamServiceBinaryField &field = m_schema.fields[slot];
+            if (slotAndNull & 1)
+            {
+                update.attributes.insert(field.name, QVariant());
+                continue;
+            }
+
+            switch (field.type)
+            {
+            case FieldType::Integer:
+            case FieldType::Date:
+            {
+                qint64 delta;
+                if (!readZigZag(position, end, delta))
+                {
+                    return false;
+                }
+                m_previousIntegers[slot] += delta;
+                update.attributes.insert(field.name, static_cast<qlonglong>(m_previousIntegers[slot]));
+                break;
+            }
+            case FieldType::Double:
+            {
+                double doubleValue;
+                if (!readDouble(position, end, doubleValue))
+                {
+                    return false;
+                }
+                update.attributes.insert(field.name, doubleValue);
+                break;
+            }
+            case FieldType::Boolean:
+            {
+                if (position == end)
+                {
+                    return false;
+                }
+                update.attributes.insert(field.name, 0 != *position++);
+                break;
+            }
+            case FieldType::String:
+            {
+                QString stringValue;
+                if (!readString(position, end, stringValue))
+                {
+                    return false;
+                }
+                update.attributes.insert(field.name, stringValue);
+                break;
+            }
+            default:
+                qDebug() << "Unsupported binary field type received!";
+                return false;
+            }
+        }
+
+        if (geometryIndex < 0 || 0 == m_geometryBuilder.pointCount(geometryIndex))
+        {
+            continue;
+        }
+
+        if (0 <= m_trackIdSlot)
+        {
+            update.trackId = update.attributes.value(m_schema.fields[m_trackIdSlot].name).toString();
+            update.trackIdHash = StreamServiceTrackTable::hashTrackId(update.trackId);
+        }
+
+        if (0 <= m_startTimeSlot && update.attributes.contains(m_startTimeField))
+        {
+            update.startTime = QDateTime::fromMSecsSinceEpoch(update.attributes.value(m_startTimeField).toLongLong(), Qt::UTC);
+        }
+
+        if (0 <= m_endTimeSlot && update.attributes.contains(m_endTimeField))
+        {
+            update.endTime = QDateTime::fromMSecsSinceEpoch(update.attributes.value(m_endTimeField).toLongLong(), Qt::UTC);
+        }
+
+        // The time info fields are resolved by name, so the attributes are split afterwards
+        if (!m_fieldSchema.isEmpty())
+        {
+            m_fieldSchema.splitVariantMap(update.attributes, update.attributeRow);
+        }
+
+        updates.append(std::move(update));
+        m_geometryIndices.append(geometryIndex);
+    }
+
+    return true;
+}
+
+bool StreamServiceBinaryDecoder::decodeExpired(const uchar *position, const uchar *end, QVector<StreamServiceTrackUpdate> &updates) const
+{
+    // Track ids do not depend on the schema
+    quint64 trackCount;
+    if (!readVarint(position, end, trackCount))
+    {
+        qDebug() << "Binary expired frame is truncated!";
+        return false;
+    }
+
+    for (quint64 trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        StreamServiceTrackUpdate update;
+        if (!readString(position, end, update.trackId))
+        {
+            qDebug() << "Binary expired frame is truncated!";
+            return false;
+        }
+
+        if (!update.trackId.isEmpty())
+        {
+            update.trackIdHash = StreamServiceTrackTable::hashTrackId(update.trackId);
+            update.expired = true;
+            updates.append(std::move(update));
+        }
+    }
+    return true;
+}
+
+void StreamServiceBinaryDecoder::resolveTimeInfoSlots()
+{
+    m_trackIdSlot = -1;
+    m_startTimeSlot = -1;
+    m_endTimeSlot = -1;
+    for (int slot = 0; slot < m_schema.fields.size(); slot++)
+    {
+        const QString &fieldName = m_schema.fields[slot].name;
+        if (fieldName.isEmpty())
+        {
+            continue;
+        }
+
+        if (fieldName == m_trackIdField)
+        {
+            m_trackIdSlot = slot;
+        }
+        if (fieldName == m_startTimeField)
+        {
+            m_startTimeSlot = slot;
+        }
+        if (fieldName == m_endTimeField)
+        {
+            m_endTimeSlot = slot;
+        }
+    }
+}
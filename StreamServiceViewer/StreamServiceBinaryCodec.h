@@ -0,0 +1,179 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEBINARYCODEC_H
+#define STREAMSERVICEBINARYCODEC_H
+
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceGeometryBuilder.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+struct StreamServiceTrackUpdate;
+
+///
+/// Compact binary feature encoding used between a relay and the stream service layer.
+///
+/// Every frame starts with the marker byte and the frame type.
+/// A schema frame defines the attribute slots, the spatial reference and the coordinate scale.
+/// A features frame references the schema version and contains a number of features.
+/// An expired frame lists the ids of the tracks the sender stopped tracking.
+/// Integers are zigzag varints, integer and date attributes are delta encoded per slot
+/// and coordinates are quantized and delta encoded within the frame.
+///
+namespace StreamServiceBinaryCodec
+{
+const quint8 FrameMarker = 0xB5;
+
+// Request header sent at subscribe time, a server not knowing it simply sends Esri JSON
+const char* const EncodingHeader = "X-Stream-Encoding";
+const char* const EncodingName = "bosbin-1";
+
+enum class FrameType : quint8
+{
+    Schema = 1,
+    Features = 2,
+    Expired = 3
+};
+
+enum class FieldType : quint8
+{
+    Integer = 1,
+    Double = 2,
+    String = 3,
+    Date = 4,
+    Boolean = 5
+};
+
+enum class GeometryType : quint8
+{
+    None = 0,
+    Point = 1,
+    Multipoint = 2,
+    Polyline = 3,
+    Polygon = 4
+};
+}
+
+struct StreamServiceBinaryField
+{
+    QString name;
+    StreamServiceBinaryCodec::FieldType type = StreamServiceBinaryCodec::FieldType::Integer;
+};
+
+struct StreamServiceBinarySchema
+{
+    quint32 version = 0;
+    int wkid = 4326;
+    qint64 coordinateScale = 10000000;
+    QVector<StreamServiceBinaryField> fields;
+};
+
+///
+/// \brief The StreamServiceBinaryEncoder class
+/// Encodes Esri JSON features, the schema is inferred from the features and grows on demand.
+///
+class StreamServiceBinaryEncoder
+{
+public:
+    StreamServiceBinaryEncoder();
+
+    void setDateFields(const QStringList &dateFields);
+
+    void addFeature(const QJsonObject &featureObject);
+    void flush();
+
+    // Follows the pending features, so that a receiver removes the tracks after their last update
+    void expireTracks(const QStringList &trackIds);
+
+    QByteArray schemaFrame() const;
+    QList<QByteArray> takeFrames();
+
+private:
+    bool ensureField(const QString &name, const QJsonValue &value);
+    bool ensureSpatialReference(const QJsonObject &geometryObject);
+    void encodeGeometry(const QJsonObject &geometryObject);
+    void encodeCoordinates(const QJsonArray &coordinatesArray);
+
+    StreamServiceBinarySchema m_schema;
+    QHash<QString, int> m_fieldSlots;
+    QSet<QString> m_dateFields;
+    QSet<int> m_untypedSlots;
+    QByteArray m_featureBuffer;
+    int m_pendingFeatureCount = 0;
+    qint64 m_previousX = 0;
+    qint64 m_previousY = 0;
+    QVector<qint64> m_previousIntegers;
+    QList<QByteArray> m_frames;
+};
+
+///
+/// \brief The StreamServiceBinaryDecoder class
+/// Decodes schema and features frames directly from the received frame without intermediate copies.
+/// The geometries of a features frame are built as one batch.
+///
+class StreamServiceBinaryDecoder
+{
+public:
+    StreamServiceBinaryDecoder();
+
+    void setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField);
+    void setTargetWkid(int targetWkid);
+    void setFieldSchema(const StreamServiceFieldSchema &fieldSchema);
+
+    bool hasSchema() const;
+    bool decode(const QByteArray &frame, QVector<StreamServiceTrackUpdate> &updates);
+
+private:
+    bool decodeSchema(const uchar *position, const uchar *end);
+    bool decodeFeatures(const uchar *position, const uchar *end, QVector<StreamServiceTrackUpdate> &updates);
+    bool decodeFeatureList(const uchar *&position, const uchar *end, quint64 featureCount, QVector<StreamServiceTrackUpdate> &updates);
+    bool decodeExpired(const uchar *position, const uchar *end, QVector<StreamServiceTrackUpdate> &updates) const;
+    void resolveTimeInfoSlots();
+
+    StreamServiceBinarySchema m_schema;
+    bool m_hasSchema = false;
+    StreamServiceFieldSchema m_fieldSchema;
+    QString m_trackIdField;
+    QString m_startTimeField;
+    QString m_endTimeField;
+    int m_trackIdSlot = -1;
+    int m_startTimeSlot = -1;
+    int m_endTimeSlot = -1;
+    QVector<qint64> m_previousIntegers;
+    StreamServiceGeometryBuilder m_geometryBuilder;
+    QVector<int> m_geometryIndices;
+};
+
+#endif // STREAMSERVICEBINARYCODEC_H
@@ -0,0 +1,262 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceCapture.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QtEndian>
+
+#include <cstring>
+
+using namespace StreamServiceCapture;
+
+namespace
+{
+// The mapping grows in chunks, so that remapping stays rare
+const qint64 GrowthChunkSize = 64 * 1024 * 1024;
+
+qint64 paddedSize(qint64 size)
+{
+    return (size + 7) & ~qint64(7);
+}
+}
+
+StreamServiceCaptureWriter::StreamServiceCaptureWriter()
+{
+}
+
+StreamServiceCaptureWriter::~StreamServiceCaptureWriter()
+{
+    close();
+}
+
+bool StreamServiceCaptureWriter::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        qWarning() << "Capture file could not be opened:" << m_file.errorString();
+        return false;
+    }
+
+    m_offset = HeaderSize;
+    if (!reserve(0))
+    {
+        m_file.close();
+        return false;
+    }
+
+    std::memcpy(m_map, Magic, sizeof(Magic));
+    qToLittleEndian<quint64>(static_cast<quint64>(m_offset), m_map + 8);
+    qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), m_map + 16);
+    qToLittleEndian<quint64>(0, m_map + 24);
+    m_clock.start();
+    return true;
+}
+
+bool StreamServiceCaptureWriter::isOpen() const
+{
+    return nullptr != m_map;
+}
+
+void StreamServiceCaptureWriter::close()
+{
+    if (!m_file.isOpen())
+    {
+        return;
+    }
+
+    if (nullptr != m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    // Drop the unused part of the last chunk
+    m_file.resize(m_offset);
+    m_file.close();
+    m_mappedSize = 0;
+}
+
+bool StreamServiceCaptureWriter::append(MessageType type, const QByteArray &payload)
+{
+    if (nullptr == m_map)
+    {
+        return false;
+    }
+
+    const qint64 recordSize = RecordHeaderSize + paddedSize(payload.size());
+    if (!reserve(recordSize))
+    {
+        return false;
+    }
+
+    uchar *record = m_map + m_offset;
+    qToLittleEndian<qint64>(m_clock.nsecsElapsed(), record);
+    qToLittleEndian<quint32>(static_cast<quint32>(payload.size()), record + 8);
+    record[12] = static_cast<uchar>(type);
+    record[13] = record[14] = record[15] = 0;
+    std::memcpy(record + RecordHeaderSize, payload.constData(), static_cast<size_t>(payload.size()));
+
+    // Publish the record by moving the end offset behind it
+    m_offset += recordSize;
+    qToLittleEndian<quint64>(static_cast<quint64>(m_offset), m_map + 8);
+    return true;
+}
+
+qint64 StreamServiceCaptureWriter::size() const
+{
+    return m_offset;
+}
+
+bool StreamServiceCaptureWriter::reserve(qint64 bytes)
+{
+    if (m_offset + bytes <= m_mappedSize)
+    {
+        return true;
+    }
+
+    if (nullptr != m_map)
+    {
+        m_file.unmap(m_map);
+        m_map = nullptr;
+    }
+
+    const qint64 mappedSize = m_mappedSize + qMax(GrowthChunkSize, paddedSize(bytes));
+    if (!m_file.resize(mappedSize))
+    {
+        qWarning() << "Capture file could not be enlarged:" << m_file.errorString();
+        m_file.resize(m_offset);
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, mappedSize);
+    if (nullptr == m_map)
+    {
+        qWarning() << "Capture file could not be mapped:" << m_file.errorString();
+        m_file.resize(m_offset);
+        m_file.close();
+        return false;
+    }
+
+    m_mappedSize = mappedSize;
+    return true;
+}
+
+StreamServiceCaptureReader::StreamServiceCaptureReader()
+{
+}
+
+StreamServiceCaptureReader::~StreamServiceCaptureReader()
+{
+    close();
+}
+
+bool StreamServiceCaptureReader::open(const QString &filePath)
+{
+    close();
+
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Capture file could not be opened:" << m_file.errorString();
+        return false;
+    }
+
+    const qint64 fileSize = m_file.size();
+    if (fileSize < HeaderSize)
+    {
+        qWarning() << "Capture file is too small!";
+        m_file.close();
+        return false;
+    }
+
+    m_map = m_file.map(0, fileSize);
+    if (nullptr == m_map || 0 != std::memcmp(m_map, Magic, sizeof(Magic)))
+    {
+        qWarning() << "File does not represent a stream capture!";
+        close();
+        return false;
+    }
+
+    m_endOffset = qMin(fileSize, static_cast<qint64>(qFromLittleEndian<quint64>(m_map + 8)));
+    m_startTime = qFromLittleEndian<qint64>(m_map + 16);
+    m_offset = HeaderSize;
+    return true;
+}
+
+bool StreamServiceCaptureReader::isOpen() const
+{
+    return nullptr != m_map;
+}
+
+void StreamServiceCaptureReader::close()
+{
+    if (nullptr != m_map)
+    {
+        m_file.unmap(const_cast<uchar*>(m_map));
+        m_map = nullptr;
+    }
+    m_file.close();
+    m_endOffset = 0;
+    m_offset = 0;
+}
+
+qint64 StreamServiceCaptureReader::startTime() const
+{
+    return m_startTime;
+}
+
+bool StreamServiceCaptureReader::readNext(StreamServiceCaptureRecord &record)
+{
+    if (nullptr == m_map || m_endOffset < m_offset + RecordHeaderSize)
+    {
+        return false;
+    }
+
+    const uchar *recordStart = m_map + m_offset;
+    const qint64 payloadSize = qFromLittleEndian<quint32>(recordStart + 8);
+    const qint64 recordSize = RecordHeaderSize + paddedSize(payloadSize);
+    if (m_endOffset < m_offset + recordSize)
+    {
+        qWarning() << "Capture file ends within a record!";
+        return false;
+    }
+
+    record.receiveTime = qFromLittleEndian<qint64>(recordStart);
+    record.type = static_cast<MessageType>(recordStart[12]);
+    record.payload = QByteArray::fromRawData(reinterpret_cast<const char*>(recordStart + RecordHeaderSize), static_cast<int>(payloadSize));
+    m_offset += recordSize;
+    return true;
+}
+
+void StreamServiceCaptureReader::rewind()
+{
+    m_offset = HeaderSize;
+}
@@ -0,0 +1,119 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICECAPTURE_H
+#define STREAMSERVICECAPTURE_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+
+///
+/// Append-only capture of the received stream messages.
+///
+/// The file starts with the magic, the end offset of the last complete record
+/// and the capture start time in milliseconds since epoch. Every record holds the
+/// receive time in nanoseconds since the capture start, the payload size, the
+/// message type and the payload padded to eight bytes. The end offset is updated
+/// after every record, so the records of an aborted capture remain readable.
+///
+namespace StreamServiceCapture
+{
+const char Magic[8] = { 'B', 'O', 'S', 'C', 'A', 'P', '0', '1' };
+const int HeaderSize = 32;
+const int RecordHeaderSize = 16;
+
+enum class MessageType : quint8
+{
+    Text = 1,
+    Binary = 2
+};
+}
+
+struct StreamServiceCaptureRecord
+{
+    qint64 receiveTime = 0;
+    StreamServiceCapture::MessageType type = StreamServiceCapture::MessageType::Text;
+    QByteArray payload;
+};
+
+///
+/// \brief The StreamServiceCaptureWriter class
+/// Appends records to a memory-mapped capture file, the file grows in large chunks
+/// and is truncated to the used size when closed.
+///
+class StreamServiceCaptureWriter
+{
+public:
+    StreamServiceCaptureWriter();
+    ~StreamServiceCaptureWriter();
+
+    bool open(const QString &filePath);
+    bool isOpen() const;
+    void close();
+
+    bool append(StreamServiceCapture::MessageType type, const QByteArray &payload);
+    qint64 size() const;
+
+private:
+    bool reserve(qint64 bytes);
+
+    QFile m_file;
+    uchar *m_map = nullptr;
+    qint64 m_mappedSize = 0;
+    qint64 m_offset = 0;
+    QElapsedTimer m_clock;
+};
+
+///
+/// \brief The StreamServiceCaptureReader class
+/// Reads the records of a memory-mapped capture file, the payloads reference the mapping
+/// and are valid until the reader is closed.
+///
+class StreamServiceCaptureReader
+{
+public:
+    StreamServiceCaptureReader();
+    ~StreamServiceCaptureReader();
+
+    bool open(const QString &filePath);
+    bool isOpen() const;
+    void close();
+
+    qint64 startTime() const;
+    bool readNext(StreamServiceCaptureRecord &record);
+    void rewind();
+
+private:
+    QFile m_file;
+    const uchar *m_map = nullptr;
+    qint64 m_endOffset = 0;
+    qint64 m_offset = 0;
+    qint64 m_startTime = 0;
+};
+
+#endif // STREAMSERVICECAPTURE_H
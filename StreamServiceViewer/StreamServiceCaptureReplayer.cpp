@@ -0,0 +1,216 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceCaptureReplayer.h"
+
+#include <QDebug>
+#include <QWebSocketServer>
+
+namespace
+{
+// Records replayed per event loop iteration when running as fast as possible
+const int MaximumSpeedBatchSize = 256;
+}
+
+StreamServiceCaptureReplayer::StreamServiceCaptureReplayer(QObject *parent) : QObject(parent),
+    m_replayTimer(this)
+{
+    m_replayTimer.setSingleShot(true);
+    m_replayTimer.setTimerType(Qt::PreciseTimer);
+    connect(&m_replayTimer, &QTimer::timeout, this, &StreamServiceCaptureReplayer::onReplayTimeout);
+}
+
+StreamServiceCaptureReplayer::~StreamServiceCaptureReplayer()
+{
+    if (nullptr != m_server)
+    {
+        m_server->close();
+    }
+}
+
+bool StreamServiceCaptureReplayer::open(const QString &filePath)
+{
+    stop();
+    return m_reader.open(filePath);
+}
+
+double StreamServiceCaptureReplayer::speed() const
+{
+    return m_speed;
+}
+
+void StreamServiceCaptureReplayer::setSpeed(double speed)
+{
+    m_speed = qMax(0.0, speed);
+}
+
+bool StreamServiceCaptureReplayer::listen(quint16 port)
+{
+    if (nullptr == m_server)
+    {
+        m_server = new QWebSocketServer(QStringLiteral("StreamServiceCaptureReplayer"), QWebSocketServer::NonSecureMode, this);
+        connect(m_server, &QWebSocketServer::newConnection, this, &StreamServiceCaptureReplayer::onNewConnection);
+    }
+
+    if (!m_server->listen(QHostAddress::LocalHost, port))
+    {
+        qWarning() << "Capture replayer failed to listen:" << m_server->errorString();
+        return false;
+    }
+
+    qDebug() << "Capture replayer listening on" << localEndpoint();
+    return true;
+}
+
+QUrl StreamServiceCaptureReplayer::localEndpoint() const
+{
+    QUrl endpoint;
+    if (nullptr == m_server)
+    {
+        return endpoint;
+    }
+
+    endpoint.setScheme(QStringLiteral("ws"));
+    endpoint.setHost(m_server->serverAddress().toString());
+    endpoint.setPort(m_server->serverPort());
+    return endpoint;
+}
+
+void StreamServiceCaptureReplayer::start()
+{
+    if (!m_reader.isOpen())
+    {
+        qWarning() << "No capture file opened!";
+        return;
+    }
+
+    m_reader.rewind();
+    m_hasPendingRecord = false;
+    m_firstReceiveTime = -1;
+    m_replayedCount = 0;
+    m_replayClock.start();
+    m_replayTimer.start(0);
+}
+
+void StreamServiceCaptureReplayer::stop()
+{
+    m_replayTimer.stop();
+    m_hasPendingRecord = false;
+}
+
+void StreamServiceCaptureReplayer::onReplayTimeout()
+{
+    int batchCount = 0;
+    while (true)
+    {
+        if (!m_hasPendingRecord)
+        {
+            if (!m_reader.readNext(m_pendingRecord))
+            {
+                qDebug() << "Capture replay finished after" << m_replayedCount << "messages in" << m_replayClock.elapsed() << "ms";
+                emit finished();
+                return;
+            }
+
+            m_hasPendingRecord = true;
+            if (m_firstReceiveTime < 0)
+            {
+                m_firstReceiveTime = m_pendingRecord.receiveTime;
+            }
+        }
+
+        if (0 < m_speed)
+        {
+            // Wait for the scaled receive time of the record
+            const qint64 dueTime = static_cast<qint64>((m_pendingRecord.receiveTime - m_firstReceiveTime) / m_speed);
+            const qint64 waitTime = dueTime - m_replayClock.nsecsElapsed();
+            if (0 < waitTime)
+            {
+                m_replayTimer.start(static_cast<int>(qMin(qint64(1000), waitTime / 1000000)));
+                return;
+            }
+        }
+        else if (MaximumSpeedBatchSize <= batchCount)
+        {
+            // Keep the event loop responsive
+            m_replayTimer.start(0);
+            return;
+        }
+
+        replayRecord(m_pendingRecord);
+        m_hasPendingRecord = false;
+        batchCount++;
+    }
+}
+
+void StreamServiceCaptureReplayer::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QWebSocket *client = m_server->nextPendingConnection();
+        connect(client, &QWebSocket::disconnected, this, &StreamServiceCaptureReplayer::onClientDisconnected);
+        m_clients.append(client);
+    }
+
+    // The first client starts the replay, later ones join it
+    if (!m_replayTimer.isActive() && !m_hasPendingRecord && 0 == m_replayedCount)
+    {
+        start();
+    }
+}
+
+void StreamServiceCaptureReplayer::onClientDisconnected()
+{
+    QWebSocket *client = qobject_cast<QWebSocket*>(sender());
+    if (nullptr == client)
+    {
+        return;
+    }
+
+    m_clients.removeOne(client);
+    client->deleteLater();
+}
+
+void StreamServiceCaptureReplayer::replayRecord(const StreamServiceCaptureRecord &record)
+{
+    m_replayedCount++;
+    if (nullptr == m_server)
+    {
+        emit messageReplayed(record.type, record.payload);
+        return;
+    }
+
+    for (QWebSocket *client : qAsConst(m_clients))
+    {
+        if (StreamServiceCapture::MessageType::Binary == record.type)
+        {
+            client->sendBinaryMessage(record.payload);
+        }
+        else
+        {
+            client->sendTextMessage(QString::fromUtf8(record.payload));
+        }
+    }
+}
@@ -0,0 +1,91 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICECAPTUREREPLAYER_H
+#define STREAMSERVICECAPTUREREPLAYER_H
+
+#include "StreamServiceCapture.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+#include <QWebSocket>
+
+class QWebSocketServer;
+
+///
+/// \brief The StreamServiceCaptureReplayer class
+/// Replays a capture file keeping the recorded receive times, scaled by the replay speed.
+/// A speed of zero replays as fast as possible.
+/// The messages are either emitted for the decode path or, after listen was called,
+/// sent to the clients of a local websocket server. The replay starts with the first client.
+///
+class StreamServiceCaptureReplayer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamServiceCaptureReplayer(QObject *parent = nullptr);
+    ~StreamServiceCaptureReplayer() override;
+
+    bool open(const QString &filePath);
+
+    double speed() const;
+    void setSpeed(double speed);
+
+    bool listen(quint16 port);
+    QUrl localEndpoint() const;
+
+public slots:
+    void start();
+    void stop();
+
+signals:
+    void messageReplayed(StreamServiceCapture::MessageType type, const QByteArray &payload);
+    void finished();
+
+private slots:
+    void onReplayTimeout();
+    void onNewConnection();
+    void onClientDisconnected();
+
+private:
+    void replayRecord(const StreamServiceCaptureRecord &record);
+
+    StreamServiceCaptureReader m_reader;
+    QWebSocketServer *m_server = nullptr;
+    QList<QWebSocket*> m_clients;
+    QTimer m_replayTimer;
+    QElapsedTimer m_replayClock;
+    double m_speed = 1.0;
+    qint64 m_firstReceiveTime = -1;
+    StreamServiceCaptureRecord m_pendingRecord;
+    bool m_hasPendingRecord = false;
+    qint64 m_replayedCount = 0;
+};
+
+#endif // STREAMSERVICECAPTUREREPLAYER_H
@@ -0,0 +1,638 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceDecodePool.h"
+#include "StreamServiceCounters.h"
+#include "StreamServiceFeatureDecoder.h"
+#include "StreamServiceTrace.h"
+
+#include <QMutexLocker>
+#include <QThread>
+
+namespace
+{
+// A power of two, so that a track hash selects its shard by masking
+const int ShardCount = 64;
+const size_t ShardQueueCapacity = 512;
+
+// A thread hands a busy shard back after a batch, so that a single hot shard cannot starve the others
+const int ShardBatchSize = 64;
+
+// Idle and blocked threads also wake up periodically, a lost wake up only delays them
+const unsigned long IdleTimeout = 10;
+
+const size_t CacheLineSize = 64;
+
+// Delivered tracks are forgotten after this many nanoseconds, unless the track time to live is set
+const qint64 DefaultDeduplicationRetention = Q_INT64_C(5) * 60 * 1000 * 1000 * 1000;
+const qint64 NanosPerMillisecond = 1000 * 1000;
+}
+
+struct StreamServiceDecodePool::Shard
+{
+    Shard() :
+        input(ShardQueueCapacity),
+        output(ShardQueueCapacity)
+    {
+    }
+
+    StreamServiceUpdateQueue<StreamServiceDecodeTask> input;
+    StreamServiceTrackUpdateQueue output;
+
+    // Set while the shard is queued or decoded, so that only one thread owns it
+    std::atomic<bool> scheduled{false};
+
+    // Owned by the decoding thread
+    StreamServiceTrackTable deliveredTracks;
+    QVector<qint64> deliveredTimes;
+    QVector<uint> deliveredContentHashes;
+    QVector<bool> deliveredExpiries;
+    QVector<qint64> deliveredReceiveTimes;
+    qint64 nextSweepTime = 0;
+    int deduplicationGeneration = 0;
+};
+
+struct StreamServiceDecodePool::Worker
+{
+    QMutex mutex;
+    std::deque<int> readyShards;
+
+    StreamServiceFeatureDecoder decoder;
+    int settingsGeneration = -1;
+
+    std::atomic<quint64> parseFailureCount{0};
+    std::atomic<quint64> decodedMessageCount{0};
+    std::atomic<quint64> decodeNanos{0};
+    std::atomic<quint64> decodeQueueNanos{0};
+    char padding[CacheLineSize];
+};
+
+class StreamServiceDecodePool::Thread : public QThread
+{
+public:
+    Thread(StreamServiceDecodePool *pool, int workerIndex) :
+        m_pool(pool),
+        m_workerIndex(workerIndex)
+    {
+        setObjectName(QStringLiteral("StreamServiceDecode%1").arg(workerIndex));
+    }
+
+protected:
+    void run() override
+    {
+        m_pool->runWorker(m_workerIndex);
+    }
+
+private:
+    StreamServiceDecodePool *m_pool;
+    int m_workerIndex;
+};
+
+StreamServiceDecodePool::StreamServiceDecodePool(QObject *parent) : QObject(parent),
+    m_shards(new Shard[ShardCount]),
+    m_deduplicationRetention(DefaultDeduplicationRetention)
+{
+}
+
+StreamServiceDecodePool::~StreamServiceDecodePool()
+{
+    stop();
+}
+
+void StreamServiceDecodePool::start(int threadCount)
+{
+    if (isRunning())
+    {
+        return;
+    }
+
+    if (threadCount <= 0)
+    {
+        threadCount = defaultThreadCount();
+    }
+
+    m_stopping.store(false, std::memory_order_relaxed);
+    m_workers.reset(new Worker[threadCount]);
+    m_workerCount = threadCount;
+    for (int workerIndex = 0; workerIndex < threadCount; workerIndex++)
+    {
+        Thread *thread = new Thread(this, workerIndex);
+        m_threads.append(thread);
+        thread->start();
+    }
+}
+
+void StreamServiceDecodePool::stop()
+{
+    if (!isRunning())
+    {
+        return;
+    }
+
+    requestStop();
+    for (Thread *thread : qAsConst(m_threads))
+    {
+        thread->wait();
+        delete thread;
+    }
+    m_threads.clear();
+}
+
+void StreamServiceDecodePool::requestStop()
+{
+    // Pushing and enqueueing give up once stopping, the threads leave their loop
+    {
+        QMutexLocker idleLocker(&m_idleMutex);
+        m_stopping.store(true, std::memory_order_seq_cst);
+        m_workAvailable.wakeAll();
+    }
+
+    QMutexLocker spaceLocker(&m_spaceMutex);
+    m_spaceAvailable.wakeAll();
+}
+
+bool StreamServiceDecodePool::isRunning() const
+{
+    return !m_threads.isEmpty();
+}
+
+int StreamServiceDecodePool::threadCount() const
+{
+    return m_threads.size();
+}
+
+int StreamServiceDecodePool::defaultThreadCount()
+{
+    // The ingest and the GUI thread keep a core each
+    return qMax(1, QThread::idealThreadCount() - 2);
+}
+
+void StreamServiceDecodePool::setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField)
+{
+    QMutexLocker settingsLocker(&m_settingsMutex);
+    m_trackIdField = trackIdField;
+    m_startTimeField = startTimeField;
+    m_endTimeField = endTimeField;
+    m_settingsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void StreamServiceDecodePool::setTargetWkid(int targetWkid)
+{
+    QMutexLocker settingsLocker(&m_settingsMutex);
+    m_targetWkid = targetWkid;
+    m_settingsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void StreamServiceDecodePool::setFieldSchema(const StreamServiceFieldSchema &fieldSchema)
+{
+    QMutexLocker settingsLocker(&m_settingsMutex);
+    m_fieldSchema = fieldSchema;
+    m_settingsGeneration.fetch_add(1, std::memory_order_release);
+}
+
+void StreamServiceDecodePool::setDeduplicate(bool deduplicate)
+{
+    m_deduplicate.store(deduplicate, std::memory_order_relaxed);
+}
+
+void StreamServiceDecodePool::resetDeduplication()
+{
+    // Every shard clears its delivered tracks in front of its next batch
+    m_deduplicationGeneration.fetch_add(1, std::memory_order_relaxed);
+}
+
+void StreamServiceDecodePool::setDeduplicationRetention(qint64 msecs)
+{
+    m_deduplicationRetention.store((0 < msecs) ? msecs * NanosPerMillisecond : DefaultDeduplicationRetention, std::memory_order_relaxed);
+}
+
+void StreamServiceDecodePool::pushMessage(const QByteArray &message, const QString &trackId, qint64 receiveTime)
+{
+    int shardIndex = 0;
+    if (trackId.isEmpty())
+    {
+        shardIndex = m_roundRobinShard;
+        m_roundRobinShard = (m_roundRobinShard + 1) & (ShardCount - 1);
+    }
+    else
+    {
+        shardIndex = static_cast<int>(StreamServiceTrackTable::hashTrackId(trackId) & (ShardCount - 1));
+    }
+
+    StreamServiceDecodeTask task;
+    task.message = message;
+    task.update.receiveTime = receiveTime;
+    push(shardIndex, std::move(task));
+}
+
+void StreamServiceDecodePool::pushUpdate(StreamServiceTrackUpdate &&update, uint contentHash)
+{
+    int shardIndex = 0;
+    if (update.trackId.isEmpty())
+    {
+        shardIndex = m_roundRobinShard;
+        m_roundRobinShard = (m_roundRobinShard + 1) & (ShardCount - 1);
+    }
+    else
+    {
+        shardIndex = static_cast<int>(update.trackIdHash & (ShardCount - 1));
+    }
+
+    StreamServiceDecodeTask task;
+    task.update = std::move(update);
+    task.contentHash = contentHash;
+    task.decoded = true;
+    push(shardIndex, std::move(task));
+}
+
+void StreamServiceDecodePool::acknowledgeUpdates()
+{
+    m_updatesPending.store(false, std::memory_order_release);
+}
+
+bool StreamServiceDecodePool::tryPop(StreamServiceTrackUpdate &update)
+{
+    // Every shard keeps the order of its tracks, the shards are drained one after the other
+    for (int shardCount = 0; shardCount < ShardCount; shardCount++)
+    {
+        if (m_shards[m_popShard].output.tryPop(update))
+        {
+            wakeSpaceWaiters();
+            return true;
+        }
+        m_popShard = (m_popShard + 1) & (ShardCount - 1);
+    }
+    return false;
+}
+
+size_t StreamServiceDecodePool::sizeApprox() const
+{
+    size_t size = 0;
+    for (int shardIndex = 0; shardIndex < ShardCount; shardIndex++)
+    {
+        size += m_shards[shardIndex].input.sizeApprox() + m_shards[shardIndex].output.sizeApprox();
+    }
+    return size;
+}
+
+quint64 StreamServiceDecodePool::parseFailureCount() const
+{
+    quint64 count = 0;
+    for (int workerIndex = 0; workerIndex < m_workerCount; workerIndex++)
+    {
+        count += m_workers[workerIndex].parseFailureCount.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+quint64 StreamServiceDecodePool::decodedMessageCount() const
+{
+    quint64 count = 0;
+    for (int workerIndex = 0; workerIndex < m_workerCount; workerIndex++)
+    {
+        count += m_workers[workerIndex].decodedMessageCount.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+quint64 StreamServiceDecodePool::decodeNanos() const
+{
+    quint64 nanos = 0;
+    for (int workerIndex = 0; workerIndex < m_workerCount; workerIndex++)
+    {
+        nanos += m_workers[workerIndex].decodeNanos.load(std::memory_order_relaxed);
+    }
+    return nanos;
+}
+
+quint64 StreamServiceDecodePool::decodeQueueNanos() const
+{
+    quint64 nanos = 0;
+    for (int workerIndex = 0; workerIndex < m_workerCount; workerIndex++)
+    {
+        nanos += m_workers[workerIndex].decodeQueueNanos.load(std::memory_order_relaxed);
+    }
+    return nanos;
+}
+
+void StreamServiceDecodePool::push(int shardIndex, StreamServiceDecodeTask &&task)
+{
+    // The decode threads are behind, hold back the socket instead of dropping messages
+    Shard &shard = m_shards[shardIndex];
+    while (!shard.input.tryPush(std::move(task)))
+    {
+        if (!waitForSpace(shard.input))
+        {
+            return;
+        }
+    }
+
+    // Pairs with the fence of the thread releasing the shard, one of both sees the other
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!shard.scheduled.exchange(true, std::memory_order_acq_rel))
+    {
+        schedule(shardIndex);
+    }
+}
+
+template <typename Queue>
+bool StreamServiceDecodePool::waitForSpace(const Queue &queue)
+{
+    // Holding the space mutex while checking, so that a wake up cannot get lost in between
+    QMutexLocker spaceLocker(&m_spaceMutex);
+    m_spaceWaitingCount.fetch_add(1, std::memory_order_seq_cst);
+    if (!m_stopping.load(std::memory_order_acquire) && queue.capacity() <= queue.sizeApprox())
+    {
+        m_spaceAvailable.wait(&m_spaceMutex, IdleTimeout);
+    }
+    m_spaceWaitingCount.fetch_sub(1, std::memory_order_relaxed);
+    return !m_stopping.load(std::memory_order_acquire);
+}
+
+void StreamServiceDecodePool::wakeSpaceWaiters()
+{
+    if (0 < m_spaceWaitingCount.load(std::memory_order_seq_cst))
+    {
+        QMutexLocker spaceLocker(&m_spaceMutex);
+        m_spaceAvailable.wakeAll();
+    }
+}
+
+void StreamServiceDecodePool::schedule(int shardIndex)
+{
+    Worker &worker = m_workers[shardIndex % m_workerCount];
+    {
+        QMutexLocker workerLocker(&worker.mutex);
+        worker.readyShards.push_back(shardIndex);
+    }
+
+    if (0 < m_sleepingCount.load(std::memory_order_seq_cst))
+    {
+        QMutexLocker idleLocker(&m_idleMutex);
+        m_workAvailable.wakeOne();
+    }
+}
+
+int StreamServiceDecodePool::takeShard(int workerIndex)
+{
+    // The own deque is served in order, others are stolen from the back
+    {
+        Worker &worker = m_workers[workerIndex];
+        QMutexLocker workerLocker(&worker.mutex);
+        if (!worker.readyShards.empty())
+        {
+            const int shardIndex = worker.readyShards.front();
+            worker.readyShards.pop_front();
+            return shardIndex;
+        }
+    }
+
+    const int threadCount = m_workerCount;
+    for (int offset = 1; offset < threadCount; offset++)
+    {
+        Worker &victim = m_workers[(workerIndex + offset) % threadCount];
+        QMutexLocker victimLocker(&victim.mutex);
+        if (!victim.readyShards.empty())
+        {
+            const int shardIndex = victim.readyShards.back();
+            victim.readyShards.pop_back();
+            return shardIndex;
+        }
+    }
+    return -1;
+}
+
+bool StreamServiceDecodePool::hasReadyShard()
+{
+    for (int workerIndex = 0; workerIndex < m_workerCount; workerIndex++)
+    {
+        Worker &worker = m_workers[workerIndex];
+        QMutexLocker workerLocker(&worker.mutex);
+        if (!worker.readyShards.empty())
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+void StreamServiceDecodePool::runWorker(int workerIndex)
+{
+    Worker &worker = m_workers[workerIndex];
+    while (!m_stopping.load(std::memory_order_acquire))
+    {
+        const int shardIndex = takeShard(workerIndex);
+        if (0 <= shardIndex)
+        {
+            decodeShard(worker, shardIndex);
+            continue;
+        }
+
+        // Holding the idle mutex while checking, so that a wake up cannot get lost in between
+        QMutexLocker idleLocker(&m_idleMutex);
+        m_sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+        if (!m_stopping.load(std::memory_order_acquire) && !hasReadyShard())
+        {
+            m_workAvailable.wait(&m_idleMutex, IdleTimeout);
+        }
+        m_sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void StreamServiceDecodePool::decodeShard(Worker &worker, int shardIndex)
+{
+    STREAMSERVICE_TRACE_SCOPE("decode batch");
+    const int settingsGeneration = m_settingsGeneration.load(std::memory_order_acquire);
+    if (settingsGeneration != worker.settingsGeneration)
+    {
+        QMutexLocker settingsLocker(&m_settingsMutex);
+        worker.decoder.setTimeInfoFields(m_trackIdField, m_startTimeField, m_endTimeField);
+        worker.decoder.setTargetWkid(m_targetWkid);
+        worker.decoder.setFieldSchema(m_fieldSchema);
+        worker.settingsGeneration = m_settingsGeneration.load(std::memory_order_relaxed);
+    }
+
+    Shard &shard = m_shards[shardIndex];
+    const int deduplicationGeneration = m_deduplicationGeneration.load(std::memory_order_relaxed);
+    if (deduplicationGeneration != shard.deduplicationGeneration)
+    {
+        shard.deliveredTracks.clear();
+        shard.deliveredTimes.clear();
+        shard.deliveredContentHashes.clear();
+        shard.deliveredExpiries.clear();
+        shard.deliveredReceiveTimes.clear();
+        shard.deduplicationGeneration = deduplicationGeneration;
+    }
+
+    const qint64 batchTime = StreamServiceTrackUpdate::currentReceiveTime();
+    if (shard.nextSweepTime <= batchTime)
+    {
+        forgetDeliveredTracks(shard, batchTime);
+    }
+
+    StreamServiceDecodeTask task;
+    int taskCount = 0;
+    for (; taskCount < ShardBatchSize && shard.input.tryPop(task); taskCount++)
+    {
+        if (task.decoded)
+        {
+            if (!isDuplicate(shard, task.update, task.contentHash, batchTime))
+            {
+                enqueueUpdate(shard, std::move(task.update));
+            }
+            continue;
+        }
+
+        STREAMSERVICE_TRACE_SCOPE("decode");
+        const qint64 receiveTime = task.update.receiveTime;
+        const qint64 decodeStartTime = StreamServiceTrackUpdate::currentReceiveTime();
+        const bool decoded = worker.decoder.decode(task.message, task.update);
+        const qint64 decodeEndTime = StreamServiceTrackUpdate::currentReceiveTime();
+        if (!decoded)
+        {
+            StreamServiceCounters::increment(worker.parseFailureCount, 1);
+        }
+        StreamServiceCounters::increment(worker.decodedMessageCount, 1);
+        StreamServiceCounters::increment(worker.decodeNanos, static_cast<quint64>(decodeEndTime - decodeStartTime));
+        StreamServiceCounters::increment(worker.decodeQueueNanos, static_cast<quint64>(decodeStartTime - receiveTime));
+        if (decoded && !isDuplicate(shard, task.update, qHash(task.message), batchTime))
+        {
+            task.update.receiveTime = receiveTime;
+            enqueueUpdate(shard, std::move(task.update));
+        }
+    }
+
+    // The producer may wait for the input of this shard
+    if (0 < taskCount)
+    {
+        wakeSpaceWaiters();
+    }
+
+    // A full batch leaves more work behind, the shard goes to the back of the own deque
+    if (ShardBatchSize == taskCount)
+    {
+        QMutexLocker workerLocker(&worker.mutex);
+        worker.readyShards.push_back(shardIndex);
+        return;
+    }
+
+    // Release the shard, a message pushed meanwhile is either seen here or schedules the shard again
+    shard.scheduled.store(false, std::memory_order_release);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (0 < shard.input.sizeApprox() && !shard.scheduled.exchange(true, std::memory_order_acq_rel))
+    {
+        QMutexLocker workerLocker(&worker.mutex);
+        worker.readyShards.push_back(shardIndex);
+    }
+}
+
+bool StreamServiceDecodePool::isDuplicate(Shard &shard, const StreamServiceTrackUpdate &update, uint contentHash, qint64 batchTime)
+{
+    // Only parallel connections deliver the same observation more than once
+    if (!m_deduplicate.load(std::memory_order_relaxed) || update.trackId.isEmpty())
+    {
+        return false;
+    }
+
+    bool inserted = false;
+    const quint32 trackHandle = shard.deliveredTracks.insert(update.trackId, update.trackIdHash, &inserted);
+    const int handleIndex = static_cast<int>(trackHandle);
+    if (shard.deliveredTimes.size() <= handleIndex)
+    {
+        shard.deliveredTimes.resize(shard.deliveredTracks.handleCapacity());
+        shard.deliveredContentHashes.resize(shard.deliveredTracks.handleCapacity());
+        shard.deliveredExpiries.resize(shard.deliveredTracks.handleCapacity());
+        shard.deliveredReceiveTimes.resize(shard.deliveredTracks.handleCapacity());
+    }
+    shard.deliveredReceiveTimes[handleIndex] = batchTime;
+
+    // An expiry is announced once until the track was updated again, the times of the track are kept for the replays
+    if (update.expired)
+    {
+        const bool duplicate = !inserted && shard.deliveredExpiries[handleIndex];
+        shard.deliveredExpiries[handleIndex] = true;
+        return duplicate;
+    }
+
+    // Observations having a time must be newer than the delivered one, others must differ
+    if (update.startTime.isValid())
+    {
+        const qint64 time = update.startTime.toMSecsSinceEpoch();
+        if (!inserted && time <= shard.deliveredTimes[handleIndex])
+        {
+            return true;
+        }
+        shard.deliveredTimes[handleIndex] = time;
+        shard.deliveredExpiries[handleIndex] = false;
+        return false;
+    }
+
+    if (!inserted && 0 != contentHash && contentHash == shard.deliveredContentHashes[handleIndex])
+    {
+        return true;
+    }
+    shard.deliveredContentHashes[handleIndex] = contentHash;
+    shard.deliveredExpiries[handleIndex] = false;
+    return false;
+}
+
+void StreamServiceDecodePool::forgetDeliveredTracks(Shard &shard, qint64 batchTime)
+{
+    // Tracks come and go, so the delivered tracks are swept a few times per retention
+    const qint64 retention = m_deduplicationRetention.load(std::memory_order_relaxed);
+    shard.nextSweepTime = batchTime + qMax(retention / 4, 1000 * NanosPerMillisecond);
+    const qint64 deadline = batchTime - retention;
+    for (int handleIndex = 0; handleIndex < shard.deliveredReceiveTimes.size(); handleIndex++)
+    {
+        qint64 &deliveredReceiveTime = shard.deliveredReceiveTimes[handleIndex];
+        if (0 != deliveredReceiveTime && deliveredReceiveTime < deadline)
+        {
+            shard.deliveredTracks.remove(static_cast<quint32>(handleIndex));
+            deliveredReceiveTime = 0;
+        }
+    }
+}
+
+void StreamServiceDecodePool::enqueueUpdate(Shard &shard, StreamServiceTrackUpdate &&update)
+{
+    // The GUI thread is behind, hold back the shard instead of dropping updates
+    while (!shard.output.tryPush(std::move(update)))
+    {
+        if (!m_updatesPending.exchange(true, std::memory_order_acq_rel))
+        {
+            emit updatesAvailable();
+        }
+        if (!waitForSpace(shard.output))
+        {
+            return;
+        }
+    }
+
+    // Only signal the transition from drained to pending
+    if (!m_updatesPending.exchange(true, std::memory_order_acq_rel))
+    {
+        emit updatesAvailable();
+    }
+}
@@ -0,0 +1,169 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEDECODEPOOL_H
+#define STREAMSERVICEDECODEPOOL_H
+
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceTrackTable.h"
+#include "StreamServiceTrackUpdate.h"
+#include "StreamServiceUpdateQueue.h"
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+
+typedef StreamServiceUpdateQueue<StreamServiceTrackUpdate> StreamServiceTrackUpdateQueue;
+
+class QThread;
+
+///
+/// \brief The StreamServiceDecodeTask struct
+/// A raw text message or an update already decoded on the ingest thread.
+///
+struct StreamServiceDecodeTask
+{
+    QByteArray message;
+    StreamServiceTrackUpdate update;
+    uint contentHash = 0;
+    bool decoded = false;
+};
+
+///
+/// \brief The StreamServiceDecodePool class
+/// Decodes the text messages on a pool of threads and hands the updates over to the GUI thread.
+///
+/// The messages are partitioned by the hash of their track id into a fixed number of shards.
+/// Every shard has its own input and output queue and is decoded by one thread at a time,
+/// so that the updates of a track leave the pool in the order they were received.
+/// Ready shards are queued on the deque of a thread, idle threads steal them from the others.
+/// Duplicates of parallel connections are dropped per shard after decoding.
+///
+/// The ingest thread is the only producer and the GUI thread is the only consumer.
+///
+class StreamServiceDecodePool : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamServiceDecodePool(QObject *parent = nullptr);
+    ~StreamServiceDecodePool() override;
+
+    // The thread count is fixed while running, zero uses all but two of the cores
+    void start(int threadCount);
+    void stop();
+
+    // Releases a producer waiting for a full shard without joining the threads, call it before the producer is joined
+    void requestStop();
+    bool isRunning() const;
+    int threadCount() const;
+
+    static int defaultThreadCount();
+
+    // Thread-safe, the decode threads apply the settings in front of their next batch
+    void setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField);
+    void setTargetWkid(int targetWkid);
+    void setFieldSchema(const StreamServiceFieldSchema &fieldSchema);
+    void setDeduplicate(bool deduplicate);
+    void resetDeduplication();
+
+    // Tracks not delivered within the retention are forgotten by the deduplication, zero uses five minutes
+    void setDeduplicationRetention(qint64 msecs);
+
+    // Producer side only, messages without a track id are spread over all shards
+    void pushMessage(const QByteArray &message, const QString &trackId, qint64 receiveTime);
+    void pushUpdate(StreamServiceTrackUpdate &&update, uint contentHash);
+
+    // Consumer side only, called before draining
+    void acknowledgeUpdates();
+    bool tryPop(StreamServiceTrackUpdate &update);
+    size_t sizeApprox() const;
+
+    // Thread-safe counters of the messages decoded by the pool, the queue time runs from receiving a message up to its decode
+    quint64 parseFailureCount() const;
+    quint64 decodedMessageCount() const;
+    quint64 decodeNanos() const;
+    quint64 decodeQueueNanos() const;
+
+signals:
+    void updatesAvailable();
+
+private:
+    struct Shard;
+    struct Worker;
+    class Thread;
+
+    void push(int shardIndex, StreamServiceDecodeTask &&task);
+    template <typename Queue> bool waitForSpace(const Queue &queue);
+    void wakeSpaceWaiters();
+    void schedule(int shardIndex);
+    int takeShard(int workerIndex);
+    bool hasReadyShard();
+    void runWorker(int workerIndex);
+    void decodeShard(Worker &worker, int shardIndex);
+    bool isDuplicate(Shard &shard, const StreamServiceTrackUpdate &update, uint contentHash, qint64 batchTime);
+    void forgetDeliveredTracks(Shard &shard, qint64 batchTime);
+    void enqueueUpdate(Shard &shard, StreamServiceTrackUpdate &&update);
+
+    std::unique_ptr<Shard[]> m_shards;
+    std::unique_ptr<Worker[]> m_workers;
+    QVector<Thread*> m_threads;
+    int m_workerCount = 0;
+    int m_roundRobinShard = 0;
+    int m_popShard = 0;
+
+    // Threads without a ready shard sleep until the producer schedules one
+    QMutex m_idleMutex;
+    QWaitCondition m_workAvailable;
+    std::atomic<int> m_sleepingCount{0};
+    std::atomic<bool> m_stopping{false};
+
+    // The producer and decode threads facing a full queue sleep until its consumer takes from it
+    QMutex m_spaceMutex;
+    QWaitCondition m_spaceAvailable;
+    std::atomic<int> m_spaceWaitingCount{0};
+
+    QMutex m_settingsMutex;
+    std::atomic<int> m_settingsGeneration{0};
+    QString m_trackIdField;
+    QString m_startTimeField;
+    QString m_endTimeField;
+    int m_targetWkid = 0;
+    StreamServiceFieldSchema m_fieldSchema;
+
+    std::atomic<bool> m_deduplicate{false};
+    std::atomic<int> m_deduplicationGeneration{0};
+    std::atomic<qint64> m_deduplicationRetention;
+    std::atomic<bool> m_updatesPending{false};
+};
+
+#endif // STREAMSERVICEDECODEPOOL_H
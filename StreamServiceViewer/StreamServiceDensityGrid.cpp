@@ -0,0 +1,387 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceDensityGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+const qint32 NoCell = -1;
+const int TileCellCount = StreamServiceDensityGrid::TileSize * StreamServiceDensityGrid::TileSize;
+
+qint32 clampCell(double coordinate, int cellCount)
+{
+    return static_cast<qint32>(qBound(0.0, std::floor(coordinate), static_cast<double>(cellCount - 1)));
+}
+}
+
+StreamServiceDensityGrid::StreamServiceDensityGrid()
+{
+    // Web Mercator bounds of the world in meters
+    setExtent(-20037508.34, -20037508.34, 20037508.34, 20037508.34);
+    setResolution(16384, 9);
+}
+
+void StreamServiceDensityGrid::setExtent(double xMin, double yMin, double xMax, double yMax)
+{
+    m_xMin = xMin;
+    m_yMin = yMin;
+    m_xMax = qMax(xMin + 1.0, xMax);
+    m_yMax = qMax(yMin + 1.0, yMax);
+    clear();
+}
+
+void StreamServiceDensityGrid::setResolution(int columnCount, int levelCount)
+{
+    // The coarsest level has a single cell at most
+    m_columns = qMax(1, columnCount);
+    int maximumLevelCount = 1;
+    while (1 < columns(maximumLevelCount - 1))
+    {
+        maximumLevelCount++;
+    }
+    m_levels.resize(qBound(1, levelCount, maximumLevelCount));
+    clear();
+}
+
+int StreamServiceDensityGrid::levelCount() const
+{
+    return m_levels.size();
+}
+
+int StreamServiceDensityGrid::columns(int level) const
+{
+    // A coarser cell covers two by two finer ones, the last one may stick out of the extent
+    return ((m_columns - 1) >> level) + 1;
+}
+
+double StreamServiceDensityGrid::cellWidth(int level) const
+{
+    return (m_xMax - m_xMin) / m_columns * (1 << level);
+}
+
+double StreamServiceDensityGrid::cellHeight(int level) const
+{
+    return (m_yMax - m_yMin) / m_columns * (1 << level);
+}
+
+void StreamServiceDensityGrid::update(quint32 handle, double x, double y, float weight)
+{
+    ensureHandle(handle);
+    const int handleIndex = static_cast<int>(handle);
+    const qint32 column = clampCell((x - m_xMin) / cellWidth(0), m_columns);
+    const qint32 row = clampCell((y - m_yMin) / cellHeight(0), m_columns);
+    const qint32 previousColumn = m_trackColumns[handleIndex];
+    const qint32 previousRow = m_trackRows[handleIndex];
+    if (NoCell != previousColumn)
+    {
+        // Moving within the finest cell only changes the weight, if at all
+        if (column == previousColumn && row == previousRow)
+        {
+            const float weightDelta = weight - m_trackWeights[handleIndex];
+            if (0.0f != weightDelta)
+            {
+                add(column, row, weightDelta, 0);
+                m_trackWeights[handleIndex] = weight;
+            }
+            return;
+        }
+
+        add(previousColumn, previousRow, -m_trackWeights[handleIndex], -1);
+    }
+    else
+    {
+        m_size++;
+    }
+
+    add(column, row, weight, 1);
+    m_trackColumns[handleIndex] = column;
+    m_trackRows[handleIndex] = row;
+    m_trackWeights[handleIndex] = weight;
+}
+
+void StreamServiceDensityGrid::remove(quint32 handle)
+{
+    if (!contains(handle))
+    {
+        return;
+    }
+
+    const int handleIndex = static_cast<int>(handle);
+    add(m_trackColumns[handleIndex], m_trackRows[handleIndex], -m_trackWeights[handleIndex], -1);
+    m_trackColumns[handleIndex] = NoCell;
+    m_trackRows[handleIndex] = NoCell;
+    m_trackWeights[handleIndex] = 0.0f;
+    m_size--;
+}
+
+bool StreamServiceDensityGrid::contains(quint32 handle) const
+{
+    const int handleIndex = static_cast<int>(handle);
+    return handleIndex < m_trackColumns.size() && NoCell != m_trackColumns[handleIndex];
+}
+
+void StreamServiceDensityGrid::clear()
+{
+    for (auto &tiles : m_levels)
+    {
+        tiles.clear();
+    }
+    m_trackColumns.clear();
+    m_trackRows.clear();
+    m_trackWeights.clear();
+    m_size = 0;
+}
+
+int StreamServiceDensityGrid::size() const
+{
+    return m_size;
+}
+
+void StreamServiceDensityGrid::decay(float factor)
+{
+    // Plain loops over contiguous floats, the compiler vectorizes them
+    for (auto &tiles : m_levels)
+    {
+        for (auto tileIterator = tiles.begin(); tileIterator != tiles.end(); ++tileIterator)
+        {
+            float *cells = tileIterator.value().cells.data();
+            for (int cellIndex = 0; cellIndex < TileCellCount; cellIndex++)
+            {
+                cells[cellIndex] *= factor;
+            }
+        }
+    }
+
+    float *trackWeights = m_trackWeights.data();
+    const int handleCount = m_trackWeights.size();
+    for (int handleIndex = 0; handleIndex < handleCount; handleIndex++)
+    {
+        trackWeights[handleIndex] *= factor;
+    }
+}
+
+int StreamServiceDensityGrid::level(double width, int maximumColumns) const
+{
+    for (int level = 0; level < m_levels.size(); level++)
+    {
+        if (width / cellWidth(level) <= maximumColumns)
+        {
+            return level;
+        }
+    }
+    return m_levels.size() - 1;
+}
+
+void StreamServiceDensityGrid::window(int level, double xMin, double yMin, double xMax, double yMax, int blurRadius, StreamServiceDensityWindow &window) const
+{
+    level = qBound(0, level, m_levels.size() - 1);
+    blurRadius = qMax(0, blurRadius);
+    const int levelColumns = columns(level);
+    const double levelCellWidth = cellWidth(level);
+    const double levelCellHeight = cellHeight(level);
+    const qint32 firstColumn = clampCell((xMin - m_xMin) / levelCellWidth, levelColumns);
+    const qint32 lastColumn = clampCell((xMax - m_xMin) / levelCellWidth, levelColumns);
+    const qint32 firstRow = clampCell((yMin - m_yMin) / levelCellHeight, levelColumns);
+    const qint32 lastRow = clampCell((yMax - m_yMin) / levelCellHeight, levelColumns);
+
+    window.level = level;
+    window.columns = qMax(0, lastColumn - firstColumn + 1);
+    window.rows = qMax(0, lastRow - firstRow + 1);
+    window.xMin = m_xMin + firstColumn * levelCellWidth;
+    window.yMin = m_yMin + firstRow * levelCellHeight;
+    window.cellWidth = levelCellWidth;
+    window.cellHeight = levelCellHeight;
+    window.values.fill(0.0f, window.columns * window.rows);
+    window.maximum = 0.0f;
+    if (0 == window.values.size())
+    {
+        return;
+    }
+
+    // The blur needs the cells around the window, the padding outside of the grid stays empty
+    const int paddedColumns = window.columns + 2 * blurRadius;
+    const int paddedRows = window.rows + 2 * blurRadius;
+    m_paddedValues.fill(0.0f, paddedColumns * paddedRows);
+    const qint32 paddedFirstColumn = firstColumn - blurRadius;
+    const qint32 paddedFirstRow = firstRow - blurRadius;
+    const qint32 copyFirstColumn = qMax(0, paddedFirstColumn);
+    const qint32 copyLastColumn = qMin(levelColumns - 1, lastColumn + blurRadius);
+    const qint32 copyFirstRow = qMax(0, paddedFirstRow);
+    const qint32 copyLastRow = qMin(levelColumns - 1, lastRow + blurRadius);
+
+    // Only the tiles overlapping the window are visited
+    const QHash<quint64, Tile> &tiles = m_levels[level];
+    for (qint32 tileRow = copyFirstRow / TileSize; tileRow <= copyLastRow / TileSize; tileRow++)
+    {
+        for (qint32 tileColumn = copyFirstColumn / TileSize; tileColumn <= copyLastColumn / TileSize; tileColumn++)
+        {
+            auto tileIterator = tiles.constFind(tileKey(tileColumn, tileRow));
+            if (tileIterator == tiles.cend())
+            {
+                continue;
+            }
+
+            const float *cells = tileIterator.value().cells.constData();
+            const qint32 rowStart = qMax(copyFirstRow, tileRow * TileSize);
+            const qint32 rowEnd = qMin(copyLastRow, tileRow * TileSize + TileSize - 1);
+            const qint32 columnStart = qMax(copyFirstColumn, tileColumn * TileSize);
+            const qint32 columnEnd = qMin(copyLastColumn, tileColumn * TileSize + TileSize - 1);
+            for (qint32 row = rowStart; row <= rowEnd; row++)
+            {
+                const float *source = cells + (row - tileRow * TileSize) * TileSize + (columnStart - tileColumn * TileSize);
+                float *target = m_paddedValues.data() + (row - paddedFirstRow) * paddedColumns + (columnStart - paddedFirstColumn);
+                std::copy(source, source + (columnEnd - columnStart + 1), target);
+            }
+        }
+    }
+
+    // Normalized gaussian weights, the blur keeps the total density
+    QVector<float> kernel(2 * blurRadius + 1, 1.0f);
+    if (0 < blurRadius)
+    {
+        const double sigma = 0.5 * blurRadius + 0.5;
+        double kernelSum = 0.0;
+        for (int offset = -blurRadius; offset <= blurRadius; offset++)
+        {
+            const double weight = std::exp(-0.5 * offset * offset / (sigma * sigma));
+            kernel[offset + blurRadius] = static_cast<float>(weight);
+            kernelSum += weight;
+        }
+        for (float &weight : kernel)
+        {
+            weight = static_cast<float>(weight / kernelSum);
+        }
+    }
+
+    // Separable passes, every inner loop runs over a contiguous row
+    m_blurredRows.fill(0.0f, paddedRows * window.columns);
+    for (int row = 0; row < paddedRows; row++)
+    {
+        const float *source = m_paddedValues.constData() + row * paddedColumns;
+        float *target = m_blurredRows.data() + row * window.columns;
+        for (int kernelIndex = 0; kernelIndex < kernel.size(); kernelIndex++)
+        {
+            const float weight = kernel[kernelIndex];
+            const float *shiftedSource = source + kernelIndex;
+            for (int column = 0; column < window.columns; column++)
+            {
+                target[column] += weight * shiftedSource[column];
+            }
+        }
+    }
+
+    for (int row = 0; row < window.rows; row++)
+    {
+        float *target = window.values.data() + row * window.columns;
+        for (int kernelIndex = 0; kernelIndex < kernel.size(); kernelIndex++)
+        {
+            const float weight = kernel[kernelIndex];
+            const float *source = m_blurredRows.constData() + (row + kernelIndex) * window.columns;
+            for (int column = 0; column < window.columns; column++)
+            {
+                target[column] += weight * source[column];
+            }
+        }
+    }
+
+    window.maximum = *std::max_element(window.values.cbegin(), window.values.cend());
+}
+
+float StreamServiceDensityGrid::total() const
+{
+    // The coarsest level has the fewest cells to sum up
+    float total = 0.0f;
+    const QHash<quint64, Tile> &tiles = m_levels.last();
+    for (auto tileIterator = tiles.cbegin(); tileIterator != tiles.cend(); ++tileIterator)
+    {
+        const float *cells = tileIterator.value().cells.constData();
+        for (int cellIndex = 0; cellIndex < TileCellCount; cellIndex++)
+        {
+            total += cells[cellIndex];
+        }
+    }
+    return total;
+}
+
+qint64 StreamServiceDensityGrid::memoryUsage() const
+{
+    qint64 tileCount = 0;
+    for (auto const &tiles : m_levels)
+    {
+        tileCount += tiles.size();
+    }
+    return tileCount * TileCellCount * static_cast<qint64>(sizeof(float))
+            + m_trackColumns.size() * static_cast<qint64>(2 * sizeof(qint32) + sizeof(float));
+}
+
+void StreamServiceDensityGrid::ensureHandle(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (handleIndex < m_trackColumns.size())
+    {
+        return;
+    }
+
+    const int handleCount = qMax(handleIndex + 1, 2 * m_trackColumns.size());
+    const int addedCount = handleCount - m_trackColumns.size();
+    m_trackColumns.insert(m_trackColumns.end(), addedCount, NoCell);
+    m_trackRows.insert(m_trackRows.end(), addedCount, NoCell);
+    m_trackWeights.insert(m_trackWeights.end(), addedCount, 0.0f);
+}
+
+void StreamServiceDensityGrid::add(qint32 column, qint32 row, float weight, int trackDelta)
+{
+    for (int level = 0; level < m_levels.size(); level++)
+    {
+        const qint32 levelColumn = column >> level;
+        const qint32 levelRow = row >> level;
+        const quint64 key = tileKey(levelColumn / TileSize, levelRow / TileSize);
+        QHash<quint64, Tile> &tiles = m_levels[level];
+        auto tileIterator = tiles.find(key);
+        if (tileIterator == tiles.end())
+        {
+            tileIterator = tiles.insert(key, Tile());
+            tileIterator.value().cells.fill(0.0f, TileCellCount);
+        }
+
+        // An empty tile is released, which also drops the rounding errors accumulated in it
+        Tile &tile = tileIterator.value();
+        tile.trackCount += trackDelta;
+        if (tile.trackCount <= 0)
+        {
+            tiles.erase(tileIterator);
+            continue;
+        }
+        tile.cells[(levelRow % TileSize) * TileSize + levelColumn % TileSize] += weight;
+    }
+}
+
+quint64 StreamServiceDensityGrid::tileKey(qint32 tileColumn, qint32 tileRow)
+{
+    return (static_cast<quint64>(static_cast<quint32>(tileColumn)) << 32) | static_cast<quint32>(tileRow);
+}
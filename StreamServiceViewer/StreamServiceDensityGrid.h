@@ -0,0 +1,121 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEDENSITYGRID_H
+#define STREAMSERVICEDENSITYGRID_H
+
+#include <QHash>
+#include <QVector>
+
+///
+/// \brief The StreamServiceDensityWindow struct
+/// Dense copy of the cells of one level overlapping an extent, the rows run from south to north.
+///
+struct StreamServiceDensityWindow
+{
+    int level = 0;
+    int columns = 0;
+    int rows = 0;
+
+    // Lower left corner of the first cell
+    double xMin = 0.0;
+    double yMin = 0.0;
+    double cellWidth = 0.0;
+    double cellHeight = 0.0;
+
+    QVector<float> values;
+    float maximum = 0.0f;
+};
+
+///
+/// \brief The StreamServiceDensityGrid class
+/// Multi-resolution density grid over the track positions indexed by track handle.
+/// Every level halves the resolution of the finer one, the cells are stored in sparse tiles.
+/// Moving a track subtracts its weight from the old cells and adds it to the new ones,
+/// so the grid is never rebuilt. Tiles are released once their last track left them.
+///
+class StreamServiceDensityGrid
+{
+public:
+    static const int TileSize = 64;
+
+    StreamServiceDensityGrid();
+
+    // Both reset the grid, the finest level has the given number of columns and rows
+    void setExtent(double xMin, double yMin, double xMax, double yMax);
+    void setResolution(int columnCount, int levelCount);
+
+    int levelCount() const;
+    int columns(int level) const;
+    double cellWidth(int level) const;
+    double cellHeight(int level) const;
+
+    void update(quint32 handle, double x, double y, float weight);
+    void remove(quint32 handle);
+    bool contains(quint32 handle) const;
+    void clear();
+    int size() const;
+
+    // Scales the cells and the weights of all tracks, updated tracks start again at their full weight
+    void decay(float factor);
+
+    // The finest level covering the width by at most the given number of columns
+    int level(double width, int maximumColumns) const;
+
+    // Copies the cells overlapping the extent and blurs them by a separable gaussian of the radius in cells
+    void window(int level, double xMin, double yMin, double xMax, double yMax, int blurRadius, StreamServiceDensityWindow &window) const;
+
+    float total() const;
+    qint64 memoryUsage() const;
+
+private:
+    struct Tile
+    {
+        QVector<float> cells;
+        int trackCount = 0;
+    };
+
+    void ensureHandle(quint32 handle);
+    void add(qint32 column, qint32 row, float weight, int trackDelta);
+    static quint64 tileKey(qint32 tileColumn, qint32 tileRow);
+
+    double m_xMin = 0.0;
+    double m_yMin = 0.0;
+    double m_xMax = 0.0;
+    double m_yMax = 0.0;
+    int m_columns = 0;
+    QVector<QHash<quint64, Tile>> m_levels;
+    QVector<qint32> m_trackColumns;
+    QVector<qint32> m_trackRows;
+    QVector<float> m_trackWeights;
+    int m_size = 0;
+
+    // Scratch buffers of the window, kept to avoid reallocating them on every refresh
+    mutable QVector<float> m_paddedValues;
+    mutable QVector<float> m_blurredRows;
+};
+
+#endif // STREAMSERVICEDENSITYGRID_H
@@ -0,0 +1,157 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceDescriptionCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDebug>
+#include <QFile>
+#include <QJsonDocument>
+#include <QNetworkReply>
+#include <QNetworkRequest>
+#include <QSaveFile>
+
+namespace
+{
+const quint32 CacheMagic = 0x43445342;
+const quint32 CacheVersion = 1;
+}
+
+StreamServiceDescriptionCache::StreamServiceDescriptionCache(const QString &filePath) :
+    m_filePath(filePath)
+{
+}
+
+QString StreamServiceDescriptionCache::filePath() const
+{
+    return m_filePath;
+}
+
+void StreamServiceDescriptionCache::setFilePath(const QString &filePath)
+{
+    m_filePath = filePath;
+    m_valid = false;
+}
+
+bool StreamServiceDescriptionCache::load(const QUrl &serviceEndpoint)
+{
+    m_valid = false;
+    QFile cacheFile(m_filePath);
+    if (m_filePath.isEmpty() || !cacheFile.open(QIODevice::ReadOnly))
+    {
+        return false;
+    }
+
+    QDataStream cacheStream(&cacheFile);
+    cacheStream.setVersion(QDataStream::Qt_5_12);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QUrl endpoint;
+    QByteArray digest;
+    cacheStream >> magic >> version;
+    if (CacheMagic != magic || CacheVersion != version)
+    {
+        qDebug() << "Cached service description has an unsupported format!";
+        return false;
+    }
+
+    cacheStream >> endpoint >> m_storedAt >> m_entityTag >> m_lastModified >> m_description >> digest;
+    if (QDataStream::Ok != cacheStream.status() || endpoint != serviceEndpoint)
+    {
+        return false;
+    }
+
+    // The description must be intact and still parse
+    if (QCryptographicHash::hash(m_description, QCryptographicHash::Sha1) != digest
+            || !QJsonDocument::fromJson(m_description).isObject())
+    {
+        qDebug() << "Cached service description is corrupted!";
+        return false;
+    }
+
+    m_valid = true;
+    return true;
+}
+
+bool StreamServiceDescriptionCache::store(const QUrl &serviceEndpoint, const QByteArray &description, const QNetworkReply *reply)
+{
+    if (m_filePath.isEmpty())
+    {
+        return false;
+    }
+
+    m_description = description;
+    m_entityTag = reply->rawHeader("ETag");
+    m_lastModified = reply->rawHeader("Last-Modified");
+    m_storedAt = QDateTime::currentDateTimeUtc();
+    m_valid = true;
+
+    // Replaced atomically, a crash never leaves a partial entry behind
+    QSaveFile cacheFile(m_filePath);
+    if (!cacheFile.open(QIODevice::WriteOnly))
+    {
+        qWarning() << "Service description cannot be cached in" << m_filePath;
+        return false;
+    }
+
+    QDataStream cacheStream(&cacheFile);
+    cacheStream.setVersion(QDataStream::Qt_5_12);
+    cacheStream << CacheMagic << CacheVersion << serviceEndpoint << m_storedAt << m_entityTag << m_lastModified
+                << m_description << QCryptographicHash::hash(m_description, QCryptographicHash::Sha1);
+    return cacheFile.commit();
+}
+
+bool StreamServiceDescriptionCache::isValid() const
+{
+    return m_valid;
+}
+
+const QByteArray& StreamServiceDescriptionCache::description() const
+{
+    return m_description;
+}
+
+QDateTime StreamServiceDescriptionCache::storedAt() const
+{
+    return m_storedAt;
+}
+
+void StreamServiceDescriptionCache::addValidators(QNetworkRequest &request) const
+{
+    if (!m_valid)
+    {
+        return;
+    }
+
+    if (!m_entityTag.isEmpty())
+    {
+        request.setRawHeader("If-None-Match", m_entityTag);
+    }
+    if (!m_lastModified.isEmpty())
+    {
+        request.setRawHeader("If-Modified-Since", m_lastModified);
+    }
+}
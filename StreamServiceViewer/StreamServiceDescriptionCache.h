@@ -0,0 +1,73 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEDESCRIPTIONCACHE_H
+#define STREAMSERVICEDESCRIPTIONCACHE_H
+
+#include <QByteArray>
+#include <QDateTime>
+#include <QString>
+#include <QUrl>
+
+class QNetworkReply;
+class QNetworkRequest;
+
+///
+/// \brief The StreamServiceDescriptionCache class
+/// The last service description received from a stream service, kept on disk for a warm start.
+///
+/// An entry is only accepted for the same service endpoint, the same format version and
+/// an intact description. The HTTP validators of the response are kept, so that the
+/// description is revalidated by a conditional request instead of being downloaded again.
+///
+class StreamServiceDescriptionCache
+{
+public:
+    explicit StreamServiceDescriptionCache(const QString &filePath = QString());
+
+    QString filePath() const;
+    void setFilePath(const QString &filePath);
+
+    bool load(const QUrl &serviceEndpoint);
+    bool store(const QUrl &serviceEndpoint, const QByteArray &description, const QNetworkReply *reply);
+
+    bool isValid() const;
+    const QByteArray& description() const;
+    QDateTime storedAt() const;
+
+    // Adds If-None-Match and If-Modified-Since using the validators of the cached response
+    void addValidators(QNetworkRequest &request) const;
+
+private:
+    QString m_filePath;
+    QByteArray m_description;
+    QByteArray m_entityTag;
+    QByteArray m_lastModified;
+    QDateTime m_storedAt;
+    bool m_valid = false;
+};
+
+#endif // STREAMSERVICEDESCRIPTIONCACHE_H
@@ -0,0 +1,634 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceFanOutServer.h"
+#include "StreamServiceLayerTimeInfo.h"
+
+#include "GeometryEngine.h"
+#include "Point.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QWebSocket>
+#include <QWebSocketServer>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace
+{
+// A client is skipped while this many bytes are queued, it gets the full state once it caught up
+const qint64 MaximumOutstandingBytes = 4 * 1024 * 1024;
+
+QJsonObject createFeatureObject(const Geometry &geometry, const QVariantMap &attributes)
+{
+    QJsonObject geometryObject;
+    if (GeometryType::Point == geometry.geometryType())
+    {
+        // Points are the common case, they do not need the runtime JSON
+        const Point point(geometry);
+        geometryObject.insert(QStringLiteral("x"), point.x());
+        geometryObject.insert(QStringLiteral("y"), point.y());
+        const int wkid = point.spatialReference().wkid();
+        if (0 < wkid)
+        {
+            QJsonObject spatialReferenceObject;
+            spatialReferenceObject.insert(QStringLiteral("wkid"), wkid);
+            geometryObject.insert(QStringLiteral("spatialReference"), spatialReferenceObject);
+        }
+    }
+    else if (!geometry.isEmpty())
+    {
+        geometryObject = QJsonDocument::fromJson(geometry.toJson().toUtf8()).object();
+    }
+
+    QJsonObject featureObject;
+    featureObject.insert(QStringLiteral("geometry"), geometryObject);
+    featureObject.insert(QStringLiteral("attributes"), QJsonObject::fromVariantMap(attributes));
+    return featureObject;
+}
+
+bool withinExtent(const Geometry &geometry, const Envelope &extent)
+{
+    if (extent.isEmpty())
+    {
+        return true;
+    }
+
+    if (GeometryType::Point == geometry.geometryType())
+    {
+        const Point point(geometry);
+        return extent.xMin() <= point.x() && point.x() <= extent.xMax()
+                && extent.yMin() <= point.y() && point.y() <= extent.yMax();
+    }
+
+    const Envelope geometryExtent = geometry.extent();
+    return !geometryExtent.isEmpty()
+            && geometryExtent.xMin() <= extent.xMax() && extent.xMin() <= geometryExtent.xMax()
+            && geometryExtent.yMin() <= extent.yMax() && extent.yMin() <= geometryExtent.yMax();
+}
+}
+
+StreamServiceFanOutServer::StreamServiceFanOutServer(const QList<QUrl> &webSocketEndpoints, QObject *parent) : QObject(parent),
+    m_ingestWorker(m_ingestPipeline.worker()),
+    m_webSocketEndpoints(webSocketEndpoints),
+    m_server(new QWebSocketServer(QStringLiteral("StreamServiceFanOutServer"), QWebSocketServer::NonSecureMode, this))
+{
+    connect(&m_ingestPipeline.decodePool(), &StreamServiceDecodePool::updatesAvailable, this, &StreamServiceFanOutServer::onUpdatesAvailable, Qt::QueuedConnection);
+
+    connect(m_server, &QWebSocketServer::newConnection, this, &StreamServiceFanOutServer::onNewConnection);
+
+    // Changes are coalesced per track and published at a fixed rate
+    m_publishTimer.setInterval(250);
+    connect(&m_publishTimer, &QTimer::timeout, this, &StreamServiceFanOutServer::onPublishTimeout);
+
+    m_expiryTimer.setInterval(StreamServiceTrackClock::TickInterval);
+    connect(&m_expiryTimer, &QTimer::timeout, this, &StreamServiceFanOutServer::onExpiryTimeout);
+}
+
+StreamServiceFanOutServer::~StreamServiceFanOutServer()
+{
+    for (auto clientIterator = m_clients.cbegin(); clientIterator != m_clients.cend(); ++clientIterator)
+    {
+        QWebSocket *websocket = clientIterator.key();
+        websocket->disconnect(this);
+        websocket->close();
+        websocket->deleteLater();
+    }
+    m_clients.clear();
+    m_server->close();
+}
+
+bool StreamServiceFanOutServer::listen(const QHostAddress &address, quint16 port)
+{
+    if (!m_server->listen(address, port))
+    {
+        qWarning() << "Stream service fan-out failed to listen:" << m_server->errorString();
+        return false;
+    }
+
+    m_publishTimer.start();
+    qDebug() << "Stream service fan-out listening on" << localEndpoint();
+    return true;
+}
+
+QUrl StreamServiceFanOutServer::localEndpoint() const
+{
+    QUrl endpoint;
+    endpoint.setScheme(QStringLiteral("ws"));
+    endpoint.setHost(m_server->serverAddress().toString());
+    endpoint.setPort(m_server->serverPort());
+    return endpoint;
+}
+
+void StreamServiceFanOutServer::subscribe()
+{
+    m_ingestPipeline.start(m_decodeThreadCount);
+
+    QList<QUrl> subscribeEndpoints;
+    for (const QUrl &webSocketEndpoint : qAsConst(m_webSocketEndpoints))
+    {
+        QUrl subscribeEndpoint(webSocketEndpoint);
+        subscribeEndpoint.setPath(subscribeEndpoint.path() + QStringLiteral("/subscribe"));
+        subscribeEndpoints.append(subscribeEndpoint);
+    }
+
+    QMetaObject::invokeMethod(m_ingestWorker, [this, subscribeEndpoints]() {
+        m_ingestWorker->subscribe(subscribeEndpoints);
+    }, Qt::QueuedConnection);
+}
+
+void StreamServiceFanOutServer::unsubscribe()
+{
+    QMetaObject::invokeMethod(m_ingestWorker, &StreamServiceIngestWorker::unsubscribe, Qt::QueuedConnection);
+}
+
+void StreamServiceFanOutServer::setTimeInfo(const StreamServiceLayerTimeInfo *timeInfo)
+{
+    QString trackIdField, startTimeField, endTimeField;
+    if (nullptr != timeInfo)
+    {
+        trackIdField = timeInfo->trackIdField();
+        startTimeField = timeInfo->startTimeField();
+        endTimeField = timeInfo->endTimeField();
+        setTrackTimeToLive(timeInfo->trackTimeToLive());
+    }
+
+    // Binary clients encode the time fields as dates
+    m_dateFields = QStringList() << startTimeField << endTimeField;
+    for (auto clientIterator = m_clients.begin(); clientIterator != m_clients.end(); ++clientIterator)
+    {
+        clientIterator.value().encoder.setDateFields(m_dateFields);
+    }
+
+    QMetaObject::invokeMethod(m_ingestWorker, [this, trackIdField, startTimeField, endTimeField]() {
+        m_ingestWorker->setTimeInfoFields(trackIdField, startTimeField, endTimeField);
+    }, Qt::QueuedConnection);
+}
+
+void StreamServiceFanOutServer::setConnectionMode(StreamServiceIngestWorker::ConnectionMode connectionMode)
+{
+    QMetaObject::invokeMethod(m_ingestWorker, [this, connectionMode]() {
+        m_ingestWorker->setConnectionMode(connectionMode);
+    }, Qt::QueuedConnection);
+}
+
+void StreamServiceFanOutServer::setDecodeThreadCount(int threadCount)
+{
+    m_decodeThreadCount = threadCount;
+}
+
+void StreamServiceFanOutServer::setTargetWkid(int targetWkid)
+{
+    m_spatialReference = (0 < targetWkid) ? SpatialReference(targetWkid) : SpatialReference();
+    QMetaObject::invokeMethod(m_ingestWorker, [this, targetWkid]() {
+        m_ingestWorker->setTargetWkid(targetWkid);
+    }, Qt::QueuedConnection);
+}
+
+int StreamServiceFanOutServer::publishInterval() const
+{
+    return m_publishTimer.interval();
+}
+
+void StreamServiceFanOutServer::setPublishInterval(int msecs)
+{
+    m_publishTimer.setInterval(qMax(1, msecs));
+}
+
+qint64 StreamServiceFanOutServer::trackTimeToLive() const
+{
+    return m_trackClock.timeToLive();
+}
+
+void StreamServiceFanOutServer::setTrackTimeToLive(qint64 msecs)
+{
+    m_trackClock.setTimeToLive(msecs);
+    m_ingestPipeline.decodePool().setDeduplicationRetention(m_trackClock.timeToLive());
+    if (0 == m_trackClock.timeToLive())
+    {
+        m_expiryTimer.stop();
+        return;
+    }
+
+    if (!m_expiryTimer.isActive())
+    {
+        m_expiryTimer.start();
+    }
+}
+
+int StreamServiceFanOutServer::trackCount() const
+{
+    return m_trackTable.size();
+}
+
+int StreamServiceFanOutServer::clientCount() const
+{
+    return m_clients.size();
+}
+
+quint64 StreamServiceFanOutServer::receivedMessageCount() const
+{
+    return m_ingestWorker->receivedMessageCount();
+}
+
+quint64 StreamServiceFanOutServer::duplicateCount() const
+{
+    return m_duplicateCount;
+}
+
+quint64 StreamServiceFanOutServer::publishedMessageCount() const
+{
+    return m_publishedMessageCount;
+}
+
+void StreamServiceFanOutServer::onUpdatesAvailable()
+{
+    // Bounded, so that the websocket clients and the timers are served in between
+    const bool drainedAll = m_ingestPipeline.drain([this](StreamServiceTrackUpdate &&update) {
+        applyUpdate(std::move(update));
+    });
+    if (!drainedAll)
+    {
+        QTimer::singleShot(0, this, &StreamServiceFanOutServer::onUpdatesAvailable);
+    }
+}
+
+void StreamServiceFanOutServer::onPublishTimeout()
+{
+    // Every changed track is encoded once, all clients share the messages
+    int publishCount = 0;
+    for (int dirtyIndex = 0; dirtyIndex < m_dirtyHandles.size(); dirtyIndex++)
+    {
+        const quint32 dirtyHandle = m_dirtyHandles[dirtyIndex];
+        StreamServiceFanOutTrack &track = m_tracks[static_cast<int>(dirtyHandle)];
+        track.dirty = false;
+        if (m_trackTable.contains(dirtyHandle))
+        {
+            encodeTrack(track);
+            m_dirtyHandles[publishCount++] = dirtyHandle;
+        }
+    }
+    m_dirtyHandles.resize(publishCount);
+
+    QString expiredMessage;
+    if (!m_expiredTrackIds.isEmpty())
+    {
+        QJsonObject expiredObject;
+        expiredObject.insert(QStringLiteral("trackIds"), QJsonArray::fromStringList(m_expiredTrackIds));
+        QJsonObject messageObject;
+        messageObject.insert(QStringLiteral("expired"), expiredObject);
+        expiredMessage = QString::fromUtf8(QJsonDocument(messageObject).toJson(QJsonDocument::Compact));
+    }
+
+    QVector<QString> untrackedMessages;
+    untrackedMessages.reserve(m_untrackedFeatures.size());
+    for (auto const &untrackedFeature : qAsConst(m_untrackedFeatures))
+    {
+        untrackedMessages.append(QString::fromUtf8(QJsonDocument(untrackedFeature).toJson(QJsonDocument::Compact)));
+    }
+
+    for (auto clientIterator = m_clients.begin(); clientIterator != m_clients.end(); ++clientIterator)
+    {
+        QWebSocket *websocket = clientIterator.key();
+        StreamServiceFanOutClient &client = clientIterator.value();
+
+        // Also sent to clients falling behind, the full state never removes a track
+        if (!expiredMessage.isEmpty())
+        {
+            sendExpiredTracks(websocket, client, expiredMessage);
+        }
+
+        if (MaximumOutstandingBytes < client.outstandingBytes)
+        {
+            // Changes skipped now are only covered by the full state
+            client.resync = true;
+            continue;
+        }
+
+        if (client.resync)
+        {
+            sendSnapshot(websocket, client);
+        }
+        else
+        {
+            for (quint32 dirtyHandle : qAsConst(m_dirtyHandles))
+            {
+                const StreamServiceFanOutTrack &track = m_tracks[static_cast<int>(dirtyHandle)];
+                if (withinExtent(track.geometry, client.extent))
+                {
+                    sendFeature(websocket, client, track.featureObject, track.message);
+                }
+            }
+        }
+
+        for (int untrackedIndex = 0; untrackedIndex < m_untrackedFeatures.size(); untrackedIndex++)
+        {
+            sendFeature(websocket, client, m_untrackedFeatures[untrackedIndex], untrackedMessages[untrackedIndex]);
+        }
+        flushClient(websocket, client);
+    }
+
+    m_dirtyHandles.clear();
+    m_untrackedFeatures.clear();
+    m_expiredTrackIds.clear();
+}
+
+void StreamServiceFanOutServer::onExpiryTimeout()
+{
+    m_trackClock.expire(m_expiredHandles);
+    for (quint32 expiredHandle : qAsConst(m_expiredHandles))
+    {
+        expireTrack(expiredHandle);
+    }
+}
+
+void StreamServiceFanOutServer::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QWebSocket *websocket = m_server->nextPendingConnection();
+        connect(websocket, &QWebSocket::disconnected, this, &StreamServiceFanOutServer::onClientDisconnected);
+        connect(websocket, &QWebSocket::textMessageReceived, this, &StreamServiceFanOutServer::onClientTextMessageReceived);
+        connect(websocket, &QWebSocket::bytesWritten, this, &StreamServiceFanOutServer::onClientBytesWritten);
+
+        // The full state follows with the next publish, a filter sent meanwhile already applies to it
+        StreamServiceFanOutClient client;
+        client.binary = (websocket->request().rawHeader(StreamServiceBinaryCodec::EncodingHeader) == StreamServiceBinaryCodec::EncodingName);
+        client.encoder.setDateFields(m_dateFields);
+        m_clients.insert(websocket, client);
+        qDebug() << "Stream service fan-out client connected," << m_clients.size() << "clients";
+    }
+}
+
+void StreamServiceFanOutServer::onClientDisconnected()
+{
+    QWebSocket *websocket = qobject_cast<QWebSocket*>(sender());
+    if (nullptr == websocket)
+    {
+        return;
+    }
+
+    m_clients.remove(websocket);
+    websocket->deleteLater();
+    qDebug() << "Stream service fan-out client disconnected," << m_clients.size() << "clients";
+}
+
+void StreamServiceFanOutServer::onClientTextMessageReceived(const QString &message)
+{
+    QWebSocket *websocket = qobject_cast<QWebSocket*>(sender());
+    auto clientIterator = m_clients.find(websocket);
+    if (clientIterator == m_clients.end())
+    {
+        return;
+    }
+
+    // Clients only send filter requests, the upstream filter is shared and never changed by them
+    const QJsonObject messageObject = QJsonDocument::fromJson(message.toUtf8()).object();
+    auto const filterKey = "filter";
+    if (!messageObject.value(filterKey).isObject())
+    {
+        qDebug() << "Stream service fan-out received an unsupported client message!";
+        return;
+    }
+
+    const QJsonObject filterObject = messageObject.value(filterKey).toObject();
+    const QJsonValue geometryValue = filterObject.value(QStringLiteral("geometry"));
+    Geometry filterGeometry;
+    if (geometryValue.isString() && !geometryValue.toString().isEmpty())
+    {
+        filterGeometry = Geometry::fromJson(geometryValue.toString());
+    }
+    else if (geometryValue.isObject())
+    {
+        filterGeometry = Geometry::fromJson(QString::fromUtf8(QJsonDocument(geometryValue.toObject()).toJson(QJsonDocument::Compact)));
+    }
+
+    StreamServiceFanOutClient &client = clientIterator.value();
+    client.requestedExtent = filterGeometry.isEmpty() ? Envelope() : filterGeometry.extent();
+    updateClientExtent(client);
+
+    // Tracks entering the new extent must show up without waiting for their next change
+    client.resync = true;
+
+    QJsonObject replyObject;
+    replyObject.insert(filterKey, filterObject);
+    websocket->sendTextMessage(QString::fromUtf8(QJsonDocument(replyObject).toJson(QJsonDocument::Compact)));
+}
+
+void StreamServiceFanOutServer::onClientBytesWritten(qint64 bytes)
+{
+    auto clientIterator = m_clients.find(qobject_cast<QWebSocket*>(sender()));
+    if (clientIterator == m_clients.end())
+    {
+        return;
+    }
+
+    qint64 &outstandingBytes = clientIterator.value().outstandingBytes;
+    outstandingBytes = qMax(qint64(0), outstandingBytes - bytes);
+}
+
+void StreamServiceFanOutServer::applyUpdate(StreamServiceTrackUpdate &&update)
+{
+    if (update.expired)
+    {
+        // Expired by an upstream fan-out, the clients are told with the next publish
+        const quint32 trackHandle = m_trackTable.find(update.trackId, update.trackIdHash);
+        if (StreamServiceTrackTable::InvalidHandle != trackHandle)
+        {
+            expireTrack(trackHandle);
+        }
+        return;
+    }
+
+    if (m_spatialReference.isEmpty() && !update.geometry.isEmpty())
+    {
+        // Client extents are compared in the spatial reference of the stream
+        m_spatialReference = update.geometry.spatialReference();
+        for (auto clientIterator = m_clients.begin(); clientIterator != m_clients.end(); ++clientIterator)
+        {
+            updateClientExtent(clientIterator.value());
+        }
+    }
+
+    if (update.trackId.isEmpty())
+    {
+        m_untrackedFeatures.append(createFeatureObject(update.geometry, update.attributes));
+        return;
+    }
+
+    bool inserted = false;
+    const quint32 trackHandle = m_trackTable.insert(update.trackId, update.trackIdHash, &inserted);
+    const int handleIndex = static_cast<int>(trackHandle);
+    if (m_tracks.size() <= handleIndex)
+    {
+        m_tracks.resize(m_trackTable.handleCapacity());
+    }
+
+    if (!m_trackClock.observe(trackHandle, update.startTime))
+    {
+        return;
+    }
+    m_trackClock.touch(trackHandle);
+
+    StreamServiceFanOutTrack &track = m_tracks[handleIndex];
+    bool changed = inserted;
+    if (inserted)
+    {
+        track.geometry = update.geometry;
+        track.attributes = std::move(update.attributes);
+    }
+    else
+    {
+        if (!track.geometry.equals(update.geometry))
+        {
+            track.geometry = update.geometry;
+            changed = true;
+        }
+
+        // Attributes are merged, a message may only carry some of them
+        for (auto attributeIterator = update.attributes.cbegin(); attributeIterator != update.attributes.cend(); ++attributeIterator)
+        {
+            auto storedIterator = track.attributes.find(attributeIterator.key());
+            if (storedIterator == track.attributes.end())
+            {
+                track.attributes.insert(attributeIterator.key(), attributeIterator.value());
+                changed = true;
+            }
+            else if (storedIterator.value() != attributeIterator.value())
+            {
+                storedIterator.value() = attributeIterator.value();
+                changed = true;
+            }
+        }
+    }
+
+    if (!changed)
+    {
+        m_duplicateCount++;
+        return;
+    }
+
+    if (!track.dirty)
+    {
+        track.dirty = true;
+        m_dirtyHandles.append(trackHandle);
+    }
+}
+
+void StreamServiceFanOutServer::removeTrack(quint32 trackHandle)
+{
+    // A queued change of the handle is skipped by the next publish, unless the handle was reused
+    StreamServiceFanOutTrack &track = m_tracks[static_cast<int>(trackHandle)];
+    const bool dirty = track.dirty;
+    track = StreamServiceFanOutTrack();
+    track.dirty = dirty;
+    m_trackClock.remove(trackHandle);
+    m_trackTable.remove(trackHandle);
+}
+
+void StreamServiceFanOutServer::expireTrack(quint32 trackHandle)
+{
+    m_expiredTrackIds.append(m_trackTable.trackId(trackHandle));
+    removeTrack(trackHandle);
+}
+
+void StreamServiceFanOutServer::encodeTrack(StreamServiceFanOutTrack &track) const
+{
+    track.featureObject = createFeatureObject(track.geometry, track.attributes);
+    track.message = QString::fromUtf8(QJsonDocument(track.featureObject).toJson(QJsonDocument::Compact));
+}
+
+void StreamServiceFanOutServer::sendSnapshot(QWebSocket *websocket, StreamServiceFanOutClient &client)
+{
+    client.resync = false;
+    for (int handleIndex = 0; handleIndex < m_tracks.size(); handleIndex++)
+    {
+        StreamServiceFanOutTrack &track = m_tracks[handleIndex];
+        if (!m_trackTable.contains(static_cast<quint32>(handleIndex)) || !withinExtent(track.geometry, client.extent))
+        {
+            continue;
+        }
+
+        // Changed tracks were encoded by this publish, the others keep their last encoding
+        if (track.message.isEmpty())
+        {
+            encodeTrack(track);
+        }
+        sendFeature(websocket, client, track.featureObject, track.message);
+    }
+}
+
+void StreamServiceFanOutServer::sendFeature(QWebSocket *websocket, StreamServiceFanOutClient &client, const QJsonObject &featureObject, const QString &message)
+{
+    m_publishedMessageCount++;
+    if (client.binary)
+    {
+        client.encoder.addFeature(featureObject);
+        return;
+    }
+
+    client.outstandingBytes += websocket->sendTextMessage(message);
+}
+
+void StreamServiceFanOutServer::sendExpiredTracks(QWebSocket *websocket, StreamServiceFanOutClient &client, const QString &message)
+{
+    if (!client.binary)
+    {
+        client.outstandingBytes += websocket->sendTextMessage(message);
+        return;
+    }
+
+    client.encoder.expireTracks(m_expiredTrackIds);
+    flushClient(websocket, client);
+}
+
+void StreamServiceFanOutServer::flushClient(QWebSocket *websocket, StreamServiceFanOutClient &client)
+{
+    if (!client.binary)
+    {
+        return;
+    }
+
+    client.encoder.flush();
+    const QList<QByteArray> frames = client.encoder.takeFrames();
+    for (auto const &frame : frames)
+    {
+        client.outstandingBytes += websocket->sendBinaryMessage(frame);
+    }
+}
+
+void StreamServiceFanOutServer::updateClientExtent(StreamServiceFanOutClient &client) const
+{
+    const Envelope &requestedExtent = client.requestedExtent;
+    if (requestedExtent.isEmpty() || m_spatialReference.isEmpty() || requestedExtent.spatialReference().isEmpty()
+            || requestedExtent.spatialReference().wkid() == m_spatialReference.wkid())
+    {
+        client.extent = requestedExtent;
+        return;
+    }
+
+    client.extent = Envelope(GeometryEngine::project(requestedExtent, m_spatialReference));
+}
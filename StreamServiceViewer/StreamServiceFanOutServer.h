@@ -0,0 +1,169 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEFANOUTSERVER_H
+#define STREAMSERVICEFANOUTSERVER_H
+
+#include "StreamServiceBinaryCodec.h"
+#include "StreamServiceIngestPipeline.h"
+#include "StreamServiceIngestWorker.h"
+#include "StreamServiceTrackClock.h"
+#include "StreamServiceTrackTable.h"
+#include "Envelope.h"
+#include "Geometry.h"
+#include "SpatialReference.h"
+
+#include <QHash>
+#include <QHostAddress>
+#include <QJsonObject>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QTimer>
+#include <QUrl>
+#include <QVariantMap>
+#include <QVector>
+
+class QWebSocket;
+class QWebSocketServer;
+class StreamServiceLayerTimeInfo;
+
+struct StreamServiceFanOutTrack
+{
+    Esri::ArcGISRuntime::Geometry geometry;
+    QVariantMap attributes;
+    bool dirty = false;
+
+    // Encoded once per change and shared by every client
+    QJsonObject featureObject;
+    QString message;
+};
+
+struct StreamServiceFanOutClient
+{
+    bool binary = false;
+    StreamServiceBinaryEncoder encoder;
+
+    // Requested by the filter of the client, empty sends everything
+    Esri::ArcGISRuntime::Envelope requestedExtent;
+    Esri::ArcGISRuntime::Envelope extent;
+
+    qint64 outstandingBytes = 0;
+
+    // The full state is sent instead of the changes, e.g. after connecting or changing the filter
+    bool resync = true;
+};
+
+///
+/// \brief The StreamServiceFanOutServer class
+/// Subscribes to a stream service once and re-publishes it to many local clients without rendering anything.
+///
+/// The messages take the ingest path of the stream service layer, the latest state of every track is kept once.
+/// Updates not changing the geometry or an attribute of a track are dropped.
+/// Changes are published once per interval, only the latest state of a track is sent.
+/// Every client gets the full state when it connects, changes its filter or catches up after falling behind.
+/// Tracks expiring after their time to live are announced to every client, which removes them.
+/// Filter requests of the clients are answered locally, only their extent is applied.
+/// Clients offering the binary encoding get binary frames, others get Esri JSON.
+///
+class StreamServiceFanOutServer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamServiceFanOutServer(const QList<QUrl> &webSocketEndpoints, QObject *parent = nullptr);
+    ~StreamServiceFanOutServer() override;
+
+    bool listen(const QHostAddress &address, quint16 port);
+    QUrl localEndpoint() const;
+
+    void subscribe();
+    void unsubscribe();
+
+    void setTimeInfo(const StreamServiceLayerTimeInfo *timeInfo);
+    void setConnectionMode(StreamServiceIngestWorker::ConnectionMode connectionMode);
+
+    // Fixed by the first subscribe, zero uses all but two of the cores
+    void setDecodeThreadCount(int threadCount);
+
+    // Geographic features are projected once for every client, zero keeps the spatial reference of the service
+    void setTargetWkid(int targetWkid);
+
+    int publishInterval() const;
+    void setPublishInterval(int msecs);
+
+    qint64 trackTimeToLive() const;
+    void setTrackTimeToLive(qint64 msecs);
+
+    int trackCount() const;
+    int clientCount() const;
+
+    // The counters only grow
+    quint64 receivedMessageCount() const;
+    quint64 duplicateCount() const;
+    quint64 publishedMessageCount() const;
+
+private slots:
+    void onUpdatesAvailable();
+    void onPublishTimeout();
+    void onExpiryTimeout();
+    void onNewConnection();
+    void onClientDisconnected();
+    void onClientTextMessageReceived(const QString &message);
+    void onClientBytesWritten(qint64 bytes);
+
+private:
+    void applyUpdate(StreamServiceTrackUpdate &&update);
+    void removeTrack(quint32 trackHandle);
+    void expireTrack(quint32 trackHandle);
+    void encodeTrack(StreamServiceFanOutTrack &track) const;
+    void sendSnapshot(QWebSocket *websocket, StreamServiceFanOutClient &client);
+    void sendFeature(QWebSocket *websocket, StreamServiceFanOutClient &client, const QJsonObject &featureObject, const QString &message);
+    void sendExpiredTracks(QWebSocket *websocket, StreamServiceFanOutClient &client, const QString &message);
+    void flushClient(QWebSocket *websocket, StreamServiceFanOutClient &client);
+    void updateClientExtent(StreamServiceFanOutClient &client) const;
+
+    StreamServiceIngestPipeline m_ingestPipeline;
+    int m_decodeThreadCount = 0;
+    StreamServiceIngestWorker *m_ingestWorker;
+    QList<QUrl> m_webSocketEndpoints;
+    QStringList m_dateFields;
+    Esri::ArcGISRuntime::SpatialReference m_spatialReference;
+    StreamServiceTrackTable m_trackTable;
+    QVector<StreamServiceFanOutTrack> m_tracks;
+    QVector<quint32> m_dirtyHandles;
+    QVector<QJsonObject> m_untrackedFeatures;
+    QWebSocketServer *m_server;
+    QHash<QWebSocket*, StreamServiceFanOutClient> m_clients;
+    QTimer m_publishTimer;
+    StreamServiceTrackClock m_trackClock;
+    QTimer m_expiryTimer;
+    QVector<quint32> m_expiredHandles;
+    QStringList m_expiredTrackIds;
+    quint64 m_duplicateCount = 0;
+    quint64 m_publishedMessageCount = 0;
+};
+
+#endif // STREAMSERVICEFANOUTSERVER_H
@@ -0,0 +1,1503 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceFeatureDecoder.h"
+#include "StreamServiceProjection.h"
+#include "StreamServiceTrace.h"
+#include "StreamServiceTrackUpdate.h"
+
+#include "GeometryEngine.h"
+#include "SpatialReference.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtAlgorithms>
+
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#include <emmintrin.h>
+#define STREAMSERVICE_SSE2
+#endif
+
+using namespace Esri::ArcGISRuntime;
+
+namespace
+{
+// Deeper messages take the document path which has its own limit
+const int MaximumNestingDepth = 512;
+
+// Integers having more digits may not fit into 64 bits
+const int MaximumIntegerDigits = 18;
+
+///
+/// Finds the next byte of a string which needs a closer look:
+/// the closing quote, an escape, a control character or the start of a multi-byte sequence.
+///
+inline const char* findStringSpecial(const char *position, const char *end)
+{
+#ifdef STREAMSERVICE_SSE2
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i space = _mm_set1_epi8(0x20);
+    while (16 <= end - position)
+    {
+        // The signed comparison catches control characters and non-ASCII bytes at once
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(position));
+        const __m128i special = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, quote), _mm_cmpeq_epi8(chunk, backslash)),
+                                             _mm_cmplt_epi8(chunk, space));
+        const int mask = _mm_movemask_epi8(special);
+        if (0 != mask)
+        {
+            return position + qCountTrailingZeroBits(static_cast<quint32>(mask));
+        }
+        position += 16;
+    }
+#endif
+    while (position < end)
+    {
+        const unsigned char character = static_cast<unsigned char>(*position);
+        if ('"' == character || '\\' == character || character < 0x20 || 0x80 <= character)
+        {
+            return position;
+        }
+        position++;
+    }
+    return end;
+}
+
+inline bool isDigit(char character)
+{
+    return '0' <= character && character <= '9';
+}
+
+inline int hexValue(char character)
+{
+    if (isDigit(character))
+    {
+        return character - '0';
+    }
+    if ('a' <= character && character <= 'f')
+    {
+        return character - 'a' + 10;
+    }
+    if ('A' <= character && character <= 'F')
+    {
+        return character - 'A' + 10;
+    }
+    return -1;
+}
+
+/// The raw bytes between the quotes of a JSON string
+struct StringSlice
+{
+    const char *begin = nullptr;
+    const char *end = nullptr;
+    bool escaped = false;
+    bool ascii = true;
+};
+
+///
+/// \brief The FeatureScanner class
+/// Scans an Esri JSON feature on its UTF-8 bytes in one pass.
+/// The attributes are converted into the same variants QJsonObject::toVariantMap creates.
+/// Using a field schema, attributes matching the type of their field go into typed slots instead.
+/// Plain geometries go into the geometry builder, any other geometry object is only validated
+/// and handed out as a slice of the message.
+/// Anything not being strict JSON is rejected, so that the document path has the last word.
+///
+class FeatureScanner
+{
+public:
+    FeatureScanner(const char *begin, const char *end) :
+        m_position(begin),
+        m_end(end)
+    {
+    }
+
+    bool scanFeature(StreamServiceGeometryBuilder &geometryBuilder, StringSlice &geometry, const StreamServiceFieldSchema &schema,
+                     StreamServiceAttributeRow &row, QVariantMap &attributes, bool &hasAttributes)
+    {
+        hasAttributes = false;
+        skipWhitespace();
+        if (!consume('{'))
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (consume('}'))
+        {
+            return false;
+        }
+
+        while (true)
+        {
+            StringSlice key;
+            if (!scanString(key) || key.escaped)
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            if (!consume(':'))
+            {
+                return false;
+            }
+
+            // The last member wins like in the document
+            skipWhitespace();
+            if (keyEquals(key, "geometry"))
+            {
+                const char *geometryBegin = m_position;
+                const bool isObject = (m_position < m_end && '{' == *m_position);
+                geometryBuilder.clear();
+                if (!isObject || !scanGeometry(geometryBuilder))
+                {
+                    // Scan the geometry again, the runtime has to parse it
+                    geometryBuilder.clear();
+                    m_position = geometryBegin;
+                    if (!skipValue(1))
+                    {
+                        return false;
+                    }
+                }
+                geometry.begin = isObject ? geometryBegin : nullptr;
+                geometry.end = isObject ? m_position : nullptr;
+            }
+            else if (keyEquals(key, "attributes") && m_position < m_end && '{' == *m_position)
+            {
+                attributes.clear();
+                row.clear();
+                const bool scannedAttributes = schema.isEmpty() ? scanObject(attributes, 1) : scanAttributes(schema, row, attributes);
+                if (!scannedAttributes)
+                {
+                    return false;
+                }
+                hasAttributes = true;
+            }
+            else
+            {
+                if (keyEquals(key, "attributes"))
+                {
+                    attributes.clear();
+                    row.clear();
+                    hasAttributes = false;
+                }
+                if (!skipValue(1))
+                {
+                    return false;
+                }
+            }
+
+            skipWhitespace();
+            if (consume('}'))
+            {
+                break;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+
+        skipWhitespace();
+        return m_position == m_end && nullptr != geometry.begin;
+    }
+
+private:
+    void skipWhitespace()
+    {
+        while (m_position < m_end)
+        {
+            const char character = *m_position;
+            if (' ' != character && '\n' != character && '\r' != character && '\t' != character)
+            {
+                return;
+            }
+            m_position++;
+        }
+    }
+
+    bool consume(char character)
+    {
+        if (m_position < m_end && character == *m_position)
+        {
+            m_position++;
+            return true;
+        }
+        return false;
+    }
+
+    static bool keyEquals(const StringSlice &key, const char *name)
+    {
+        const size_t length = std::strlen(name);
+        return static_cast<size_t>(key.end - key.begin) == length && 0 == std::memcmp(key.begin, name, length);
+    }
+
+    bool scanLiteral(const char *literal)
+    {
+        const size_t length = std::strlen(literal);
+        if (static_cast<size_t>(m_end - m_position) < length || 0 != std::memcmp(m_position, literal, length))
+        {
+            return false;
+        }
+        m_position += length;
+        return true;
+    }
+
+    bool skipEscape()
+    {
+        // Points at the backslash
+        if (m_end - m_position < 2)
+        {
+            return false;
+        }
+
+        switch (m_position[1])
+        {
+        case '"':
+        case '\\':
+        case '/':
+        case 'b':
+        case 'f':
+        case 'n':
+        case 'r':
+        case 't':
+            m_position += 2;
+            return true;
+        case 'u':
+            if (m_end - m_position < 6)
+            {
+                return false;
+            }
+            for (int index = 2; index < 6; index++)
+            {
+                if (hexValue(m_position[index]) < 0)
+                {
+                    return false;
+                }
+            }
+            m_position += 6;
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    bool skipUtf8Sequence()
+    {
+        // Overlong forms, surrogates and code points beyond the Unicode range are invalid
+        const unsigned char lead = static_cast<unsigned char>(*m_position);
+        int length;
+        uint codePoint;
+        uint minimum;
+        if (0xC0 == (lead & 0xE0))
+        {
+            length = 2;
+            codePoint = lead & 0x1F;
+            minimum = 0x80;
+        }
+        else if (0xE0 == (lead & 0xF0))
+        {
+            length = 3;
+            codePoint = lead & 0x0F;
+            minimum = 0x800;
+        }
+        else if (0xF0 == (lead & 0xF8))
+        {
+            length = 4;
+            codePoint = lead & 0x07;
+            minimum = 0x10000;
+        }
+        else
+        {
+            return false;
+        }
+
+        if (m_end - m_position < length)
+        {
+            return false;
+        }
+        for (int index = 1; index < length; index++)
+        {
+            const unsigned char continuation = static_cast<unsigned char>(m_position[index]);
+            if (0x80 != (continuation & 0xC0))
+            {
+                return false;
+            }
+            codePoint = (codePoint << 6) | (continuation & 0x3F);
+        }
+        if (codePoint < minimum || 0x10FFFF < codePoint || (0xD800 <= codePoint && codePoint <= 0xDFFF))
+        {
+            return false;
+        }
+
+        m_position += length;
+        return true;
+    }
+
+    bool scanString(StringSlice &string)
+    {
+        if (!consume('"'))
+        {
+            return false;
+        }
+
+        string.begin = m_position;
+        while (true)
+        {
+            m_position = findStringSpecial(m_position, m_end);
+            if (m_position == m_end)
+            {
+                return false;
+            }
+
+            const unsigned char character = static_cast<unsigned char>(*m_position);
+            if ('"' == character)
+            {
+                string.end = m_position++;
+                return true;
+            }
+            if ('\\' == character)
+            {
+                if (!skipEscape())
+                {
+                    return false;
+                }
+                string.escaped = true;
+                continue;
+            }
+            if (character < 0x20 || !skipUtf8Sequence())
+            {
+                return false;
+            }
+            string.ascii = false;
+        }
+    }
+
+    static QString fromUtf8(const char *begin, const char *end, bool ascii)
+    {
+        const int length = static_cast<int>(end - begin);
+        return ascii ? QString::fromLatin1(begin, length) : QString::fromUtf8(begin, length);
+    }
+
+    static QString toString(const StringSlice &string)
+    {
+        if (!string.escaped)
+        {
+            return fromUtf8(string.begin, string.end, string.ascii);
+        }
+
+        // The escapes were validated while scanning
+        QString result;
+        result.reserve(static_cast<int>(string.end - string.begin));
+        const char *position = string.begin;
+        while (position < string.end)
+        {
+            const char *escape = static_cast<const char*>(std::memchr(position, '\\', static_cast<size_t>(string.end - position)));
+            if (nullptr == escape)
+            {
+                result.append(fromUtf8(position, string.end, string.ascii));
+                break;
+            }
+            if (position < escape)
+            {
+                result.append(fromUtf8(position, escape, string.ascii));
+            }
+
+            switch (escape[1])
+            {
+            case 'b':
+                result.append(QChar('\b'));
+                break;
+            case 'f':
+                result.append(QChar('\f'));
+                break;
+            case 'n':
+                result.append(QChar('\n'));
+                break;
+            case 'r':
+                result.append(QChar('\r'));
+                break;
+            case 't':
+                result.append(QChar('\t'));
+                break;
+            case 'u':
+            {
+                // Surrogates are appended as they are, like the document does
+                const ushort unit = static_cast<ushort>((hexValue(escape[2]) << 12) | (hexValue(escape[3]) << 8)
+                                                        | (hexValue(escape[4]) << 4) | hexValue(escape[5]));
+                result.append(QChar(unit));
+                position = escape + 6;
+                continue;
+            }
+            default:
+                result.append(QChar(escape[1]));
+                break;
+            }
+            position = escape + 2;
+        }
+        return result;
+    }
+
+    bool scanNumber(double &number)
+    {
+        const char *begin = m_position;
+        const bool negative = consume('-');
+        if (m_position == m_end)
+        {
+            return false;
+        }
+
+        // No leading zeros, at least one digit in every part
+        const char *digits = m_position;
+        qint64 integer = 0;
+        if ('0' == *m_position)
+        {
+            m_position++;
+        }
+        else if (isDigit(*m_position))
+        {
+            while (m_position < m_end && isDigit(*m_position))
+            {
+                integer = integer * 10 + (*m_position - '0');
+                m_position++;
+                if (MaximumIntegerDigits < m_position - digits)
+                {
+                    // Only the value might overflow, the grammar is still checked below
+                    integer = 0;
+                }
+            }
+        }
+        else
+        {
+            return false;
+        }
+        const int integerDigits = static_cast<int>(m_position - digits);
+
+        bool isInteger = true;
+        if (consume('.'))
+        {
+            isInteger = false;
+            if (m_position == m_end || !isDigit(*m_position))
+            {
+                return false;
+            }
+            while (m_position < m_end && isDigit(*m_position))
+            {
+                m_position++;
+            }
+        }
+        if (m_position < m_end && ('e' == *m_position || 'E' == *m_position))
+        {
+            isInteger = false;
+            m_position++;
+            if (!consume('+'))
+            {
+                consume('-');
+            }
+            if (m_position == m_end || !isDigit(*m_position))
+            {
+                return false;
+            }
+            while (m_position < m_end && isDigit(*m_position))
+            {
+                m_position++;
+            }
+        }
+
+        if (isInteger && integerDigits <= MaximumIntegerDigits)
+        {
+            // Exact and correctly rounded like the conversion of the text
+            number = static_cast<double>(negative ? -integer : integer);
+            return true;
+        }
+
+        bool converted = false;
+        number = QByteArray::fromRawData(begin, static_cast<int>(m_position - begin)).toDouble(&converted);
+        return converted;
+    }
+
+    bool scanBoolean(bool &value)
+    {
+        if (scanLiteral("true"))
+        {
+            value = true;
+            return true;
+        }
+        value = false;
+        return scanLiteral("false");
+    }
+
+    bool scanWkid(int &wkid)
+    {
+        double number;
+        if (!scanNumber(number) || number < 0 || 2147483647.0 < number || static_cast<int>(number) != number)
+        {
+            return false;
+        }
+        wkid = static_cast<int>(number);
+        return true;
+    }
+
+    bool scanSpatialReference(int &wkid)
+    {
+        // Only well-known ids, the wkid has precedence over the latest one
+        if (!consume('{'))
+        {
+            return false;
+        }
+
+        int latestWkid = 0;
+        skipWhitespace();
+        if (!consume('}'))
+        {
+            while (true)
+            {
+                StringSlice key;
+                if (!scanString(key) || key.escaped)
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if (!consume(':'))
+                {
+                    return false;
+                }
+                skipWhitespace();
+                if (keyEquals(key, "wkid"))
+                {
+                    if (!scanWkid(wkid))
+                    {
+                        return false;
+                    }
+                }
+                else if (!keyEquals(key, "latestWkid") || !scanWkid(latestWkid))
+                {
+                    return false;
+                }
+
+                skipWhitespace();
+                if (consume('}'))
+                {
+                    break;
+                }
+                if (!consume(','))
+                {
+                    return false;
+                }
+                skipWhitespace();
+            }
+        }
+
+        if (0 == wkid)
+        {
+            wkid = latestWkid;
+        }
+        return true;
+    }
+
+    bool scanCoordinate(StreamServiceGeometryBuilder &geometryBuilder, int &dimension)
+    {
+        // Two or three numbers, measures are left to the runtime
+        if (!consume('['))
+        {
+            return false;
+        }
+
+        double values[3];
+        int count = 0;
+        skipWhitespace();
+        while (true)
+        {
+            if (3 == count || !scanNumber(values[count]))
+            {
+                return false;
+            }
+            count++;
+
+            skipWhitespace();
+            if (consume(']'))
+            {
+                break;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+
+        if (count < 2 || (0 != dimension && dimension != count))
+        {
+            return false;
+        }
+        dimension = count;
+        geometryBuilder.addPoint(values[0], values[1], (3 == count) ? values[2] : 0.0);
+        return true;
+    }
+
+    bool scanCoordinates(StreamServiceGeometryBuilder &geometryBuilder, bool hasParts, int &dimension)
+    {
+        if (!consume('['))
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (consume(']'))
+        {
+            return true;
+        }
+
+        while (true)
+        {
+            if (hasParts)
+            {
+                geometryBuilder.beginPart();
+                if (!scanCoordinates(geometryBuilder, false, dimension))
+                {
+                    return false;
+                }
+            }
+            else if (!scanCoordinate(geometryBuilder, dimension))
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            if (consume(']'))
+            {
+                return true;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+    }
+
+    bool scanGeometry(StreamServiceGeometryBuilder &geometryBuilder)
+    {
+        // Plain points, multipoints, polylines and polygons, everything else is left to the runtime
+        if (!consume('{'))
+        {
+            return false;
+        }
+
+        double x = 0.0, y = 0.0, z = 0.0;
+        bool hasX = false, hasY = false, hasPointZ = false;
+        bool hasZ = false, hasZMember = false;
+        int wkid = 0;
+        int dimension = 0;
+        int geometryIndex = -1;
+        skipWhitespace();
+        if (consume('}'))
+        {
+            return false;
+        }
+
+        while (true)
+        {
+            StringSlice key;
+            if (!scanString(key) || key.escaped)
+            {
+                return false;
+            }
+            skipWhitespace();
+            if (!consume(':'))
+            {
+                return false;
+            }
+            skipWhitespace();
+
+            if (keyEquals(key, "x"))
+            {
+                if (hasX || !scanNumber(x))
+                {
+                    return false;
+                }
+                hasX = true;
+            }
+            else if (keyEquals(key, "y"))
+            {
+                if (hasY || !scanNumber(y))
+                {
+                    return false;
+                }
+                hasY = true;
+            }
+            else if (keyEquals(key, "z"))
+            {
+                if (hasPointZ || !scanNumber(z))
+                {
+                    return false;
+                }
+                hasPointZ = true;
+            }
+            else if (keyEquals(key, "points") || keyEquals(key, "paths") || keyEquals(key, "rings"))
+            {
+                if (0 <= geometryIndex)
+                {
+                    return false;
+                }
+
+                StreamServiceGeometryBuilder::GeometryType geometryType = StreamServiceGeometryBuilder::GeometryType::Multipoint;
+                if (keyEquals(key, "paths"))
+                {
+                    geometryType = StreamServiceGeometryBuilder::GeometryType::Polyline;
+                }
+                else if (keyEquals(key, "rings"))
+                {
+                    geometryType = StreamServiceGeometryBuilder::GeometryType::Polygon;
+                }
+                geometryIndex = geometryBuilder.beginGeometry(geometryType);
+                if (!scanCoordinates(geometryBuilder, StreamServiceGeometryBuilder::GeometryType::Multipoint != geometryType, dimension))
+                {
+                    return false;
+                }
+            }
+            else if (keyEquals(key, "spatialReference"))
+            {
+                if (!scanSpatialReference(wkid))
+                {
+                    return false;
+                }
+            }
+            else if (keyEquals(key, "hasZ"))
+            {
+                if (!scanBoolean(hasZ))
+                {
+                    return false;
+                }
+                hasZMember = true;
+            }
+            else if (keyEquals(key, "hasM"))
+            {
+                bool hasM;
+                if (!scanBoolean(hasM) || hasM)
+                {
+                    return false;
+                }
+            }
+            else
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            if (consume('}'))
+            {
+                break;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+
+        if (hasX || hasY || hasPointZ)
+        {
+            if (!hasX || !hasY || 0 <= geometryIndex || (hasZMember && hasPointZ != hasZ))
+            {
+                return false;
+            }
+            geometryBuilder.beginGeometry(StreamServiceGeometryBuilder::GeometryType::Point);
+            geometryBuilder.addPoint(x, y, z);
+            geometryBuilder.setSpatialReference(wkid, hasPointZ);
+            return true;
+        }
+
+        // The z values only count when announced and given for every vertex
+        if (geometryIndex < 0 || 0 == geometryBuilder.pointCount(geometryIndex) || (hasZ ? 3 : 2) != dimension)
+        {
+            return false;
+        }
+        geometryBuilder.setSpatialReference(wkid, hasZ);
+        return true;
+    }
+
+    bool scanValue(QVariant &value, int depth)
+    {
+        if (m_position == m_end)
+        {
+            return false;
+        }
+
+        switch (*m_position)
+        {
+        case '{':
+        {
+            QVariantMap object;
+            if (!scanObject(object, depth + 1))
+            {
+                return false;
+            }
+            value = object;
+            return true;
+        }
+        case '[':
+        {
+            QVariantList array;
+            if (!scanArray(array, depth + 1))
+            {
+                return false;
+            }
+            value = array;
+            return true;
+        }
+        case '"':
+        {
+            StringSlice string;
+            if (!scanString(string))
+            {
+                return false;
+            }
+            value = toString(string);
+            return true;
+        }
+        case 't':
+            value = true;
+            return scanLiteral("true");
+        case 'f':
+            value = false;
+            return scanLiteral("false");
+        case 'n':
+            // Whatever the document converts null into
+            value = QJsonValue(QJsonValue::Null).toVariant();
+            return scanLiteral("null");
+        default:
+        {
+            double number;
+            if (!scanNumber(number))
+            {
+                return false;
+            }
+            value = number;
+            return true;
+        }
+        }
+    }
+
+    bool scanTypedValue(StreamServiceFieldSchema::FieldType type, StreamServiceAttributeValue &value, bool &typed)
+    {
+        // Values not matching the field type are left unconsumed
+        typed = false;
+        if (m_position == m_end)
+        {
+            return false;
+        }
+
+        const char character = *m_position;
+        if ('n' == character)
+        {
+            if (!scanLiteral("null"))
+            {
+                return false;
+            }
+            value = StreamServiceAttributeValue();
+            value.state = StreamServiceAttributeValue::State::Null;
+            typed = true;
+            return true;
+        }
+
+        if ('"' == character)
+        {
+            if (StreamServiceFieldSchema::FieldType::String != type)
+            {
+                return true;
+            }
+            StringSlice string;
+            if (!scanString(string))
+            {
+                return false;
+            }
+            value = StreamServiceAttributeValue();
+            value.string = toString(string);
+            value.state = StreamServiceAttributeValue::State::Set;
+            typed = true;
+            return true;
+        }
+
+        if (('-' != character && !isDigit(character)) || StreamServiceFieldSchema::FieldType::String == type)
+        {
+            return true;
+        }
+
+        // Fractional numbers of integer fields are scanned again as variant
+        double number;
+        if (!scanNumber(number))
+        {
+            return false;
+        }
+        value = StreamServiceAttributeValue();
+        if (StreamServiceFieldSchema::FieldType::Double == type)
+        {
+            value.number = number;
+        }
+        else if (StreamServiceFieldSchema::isIntegral(number))
+        {
+            value.integer = static_cast<qint64>(number);
+        }
+        else
+        {
+            return true;
+        }
+        value.state = StreamServiceAttributeValue::State::Set;
+        typed = true;
+        return true;
+    }
+
+    bool scanAttributes(const StreamServiceFieldSchema &schema, StreamServiceAttributeRow &row, QVariantMap &extraAttributes)
+    {
+        row.fill(StreamServiceAttributeValue(), schema.fieldCount());
+        if (!consume('{'))
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (consume('}'))
+        {
+            return true;
+        }
+
+        while (true)
+        {
+            StringSlice key;
+            if (!scanString(key))
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            if (!consume(':'))
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            const int slot = key.escaped ? schema.slot(toString(key)) : schema.slot(key.begin, static_cast<int>(key.end - key.begin));
+            const char *valueBegin = m_position;
+            bool typed = false;
+            if (0 <= slot && !scanTypedValue(schema.field(slot).type, row[slot], typed))
+            {
+                return false;
+            }
+
+            // The last member wins like in the document, either as typed value or as variant
+            if (typed)
+            {
+                if (!extraAttributes.isEmpty())
+                {
+                    extraAttributes.remove(schema.field(slot).name);
+                }
+            }
+            else
+            {
+                m_position = valueBegin;
+                QVariant value;
+                if (!scanValue(value, 1))
+                {
+                    return false;
+                }
+                if (0 <= slot)
+                {
+                    row[slot] = StreamServiceAttributeValue();
+                }
+                extraAttributes.insert(toString(key), value);
+            }
+
+            skipWhitespace();
+            if (consume('}'))
+            {
+                return true;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+    }
+
+    bool scanObject(QVariantMap &object, int depth)
+    {
+        if (MaximumNestingDepth < depth || !consume('{'))
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (consume('}'))
+        {
+            return true;
+        }
+
+        while (true)
+        {
+            StringSlice key;
+            if (!scanString(key))
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            if (!consume(':'))
+            {
+                return false;
+            }
+
+            skipWhitespace();
+            QVariant value;
+            if (!scanValue(value, depth))
+            {
+                return false;
+            }
+            object.insert(toString(key), value);
+
+            skipWhitespace();
+            if (consume('}'))
+            {
+                return true;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+    }
+
+    bool scanArray(QVariantList &array, int depth)
+    {
+        if (MaximumNestingDepth < depth || !consume('['))
+        {
+            return false;
+        }
+
+        skipWhitespace();
+        if (consume(']'))
+        {
+            return true;
+        }
+
+        while (true)
+        {
+            QVariant value;
+            if (!scanValue(value, depth))
+            {
+                return false;
+            }
+            array.append(value);
+
+            skipWhitespace();
+            if (consume(']'))
+            {
+                return true;
+            }
+            if (!consume(','))
+            {
+                return false;
+            }
+            skipWhitespace();
+        }
+    }
+
+    bool skipValue(int depth)
+    {
+        if (MaximumNestingDepth < depth || m_position == m_end)
+        {
+            return false;
+        }
+
+        switch (*m_position)
+        {
+        case '{':
+        case '[':
+        {
+            const char close = ('{' == *m_position) ? '}' : ']';
+            const bool isObject = ('}' == close);
+            m_position++;
+            skipWhitespace();
+            if (consume(close))
+            {
+                return true;
+            }
+
+            while (true)
+            {
+                if (isObject)
+                {
+                    StringSlice key;
+                    if (!scanString(key))
+                    {
+                        return false;
+                    }
+                    skipWhitespace();
+                    if (!consume(':'))
+                    {
+                        return false;
+                    }
+                    skipWhitespace();
+                }
+                if (!skipValue(depth + 1))
+                {
+                    return false;
+                }
+
+                skipWhitespace();
+                if (consume(close))
+                {
+                    return true;
+                }
+                if (!consume(','))
+                {
+                    return false;
+                }
+                skipWhitespace();
+            }
+        }
+        case '"':
+        {
+            StringSlice string;
+            return scanString(string);
+        }
+        case 't':
+            return scanLiteral("true");
+        case 'f':
+            return scanLiteral("false");
+        case 'n':
+            return scanLiteral("null");
+        default:
+        {
+            double number;
+            return scanNumber(number);
+        }
+        }
+    }
+
+    const char *m_position;
+    const char *m_end;
+};
+
+const char* skipWhitespace(const char *position, const char *end)
+{
+    while (position < end && (' ' == *position || '\t' == *position || '\n' == *position || '\r' == *position))
+    {
+        position++;
+    }
+    return position;
+}
+}
+
+StreamServiceFeatureDecoder::StreamServiceFeatureDecoder()
+{
+}
+
+void StreamServiceFeatureDecoder::setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField)
+{
+    m_trackIdField = trackIdField;
+    m_startTimeField = startTimeField;
+    m_endTimeField = endTimeField;
+    resolveTimeInfoSlots();
+
+    // Keys needing an escape are never peeked
+    m_trackIdKey.clear();
+    const QByteArray trackIdKey = trackIdField.toUtf8();
+    if (!trackIdKey.isEmpty() && !trackIdKey.contains('"') && !trackIdKey.contains('\\'))
+    {
+        m_trackIdKey = '"' + trackIdKey + '"';
+    }
+}
+
+void StreamServiceFeatureDecoder::setTargetWkid(int targetWkid)
+{
+    m_geometryBuilder.setTargetWkid(targetWkid);
+}
+
+void StreamServiceFeatureDecoder::setFieldSchema(const StreamServiceFieldSchema &fieldSchema)
+{
+    m_fieldSchema = fieldSchema;
+    resolveTimeInfoSlots();
+}
+
+StreamServiceFeatureDecoder::TrackIdPeek StreamServiceFeatureDecoder::peekTrackId(const QByteArray &message, QString &trackId) const
+{
+    trackId.clear();
+    if (m_trackIdField.isEmpty())
+    {
+        return TrackIdPeek::Missing;
+    }
+    if (m_trackIdKey.isEmpty())
+    {
+        return TrackIdPeek::Ambiguous;
+    }
+
+    const int keyIndex = message.indexOf(m_trackIdKey);
+    if (keyIndex < 0)
+    {
+        return TrackIdPeek::Missing;
+    }
+
+    // The key may also be part of a string or of a nested object, only a single plain occurrence is trusted
+    if (0 <= message.indexOf(m_trackIdKey, keyIndex + m_trackIdKey.size())
+            || (0 < keyIndex && '\\' == message.at(keyIndex - 1)))
+    {
+        return TrackIdPeek::Ambiguous;
+    }
+
+    const char *end = message.constData() + message.size();
+    const char *position = skipWhitespace(message.constData() + keyIndex + m_trackIdKey.size(), end);
+    if (position == end || ':' != *position)
+    {
+        return TrackIdPeek::Ambiguous;
+    }
+    position = skipWhitespace(position + 1, end);
+    if (position == end)
+    {
+        return TrackIdPeek::Ambiguous;
+    }
+
+    // Strings without escapes are taken as they are
+    if ('"' == *position)
+    {
+        const char *begin = position + 1;
+        const char *quote = static_cast<const char*>(std::memchr(begin, '"', static_cast<size_t>(end - begin)));
+        if (nullptr == quote || nullptr != std::memchr(begin, '\\', static_cast<size_t>(quote - begin)))
+        {
+            return TrackIdPeek::Ambiguous;
+        }
+        trackId = QString::fromUtf8(begin, static_cast<int>(quote - begin));
+        return TrackIdPeek::Found;
+    }
+
+    // Numbers are decoded as double, the text must match the converted attribute value
+    const char *begin = position;
+    while (position < end && (isDigit(*position) || '-' == *position || '+' == *position || '.' == *position || 'e' == *position || 'E' == *position))
+    {
+        position++;
+    }
+    if (begin == position)
+    {
+        return TrackIdPeek::Ambiguous;
+    }
+
+    bool validNumber = false;
+    const double number = QByteArray::fromRawData(begin, static_cast<int>(position - begin)).toDouble(&validNumber);
+    if (!validNumber)
+    {
+        return TrackIdPeek::Ambiguous;
+    }
+    // Integer fields are decoded as qlonglong, their text has no exponent
+    const bool integerField = 0 <= m_trackIdSlot
+            && (StreamServiceFieldSchema::FieldType::Integer == m_fieldSchema.field(m_trackIdSlot).type
+                || StreamServiceFieldSchema::FieldType::Date == m_fieldSchema.field(m_trackIdSlot).type);
+    trackId = (integerField && StreamServiceFieldSchema::isIntegral(number)) ? QString::number(static_cast<qint64>(number)) : QVariant(number).toString();
+    return TrackIdPeek::Found;
+}
+
+bool StreamServiceFeatureDecoder::decode(const QByteArray &message, StreamServiceTrackUpdate &update)
+{
+    // We expect UTF-8 encoded messages here
+    StringSlice geometrySlice;
+    StreamServiceAttributeRow attributeRow;
+    QVariantMap attributes;
+    bool hasAttributes = false;
+    bool scanned;
+    {
+        STREAMSERVICE_TRACE_SCOPE("scan");
+        FeatureScanner scanner(message.constData(), message.constData() + message.size());
+        scanned = scanner.scanFeature(m_geometryBuilder, geometrySlice, m_fieldSchema, attributeRow, attributes, hasAttributes);
+    }
+    if (!scanned)
+    {
+        // The document path tells what is wrong with the message
+        return decodeDocument(message, update);
+    }
+
+    // Build the geometry
+    {
+        STREAMSERVICE_TRACE_SCOPE("geometry");
+        if (0 < m_geometryBuilder.geometryCount())
+        {
+            m_geometryBuilder.project();
+            update.geometry = m_geometryBuilder.geometry(0);
+        }
+        else
+        {
+            update.geometry = projectGeometry(Geometry::fromJson(QString::fromUtf8(geometrySlice.begin, static_cast<int>(geometrySlice.end - geometrySlice.begin))));
+        }
+    }
+    if (update.geometry.isEmpty())
+    {
+        qDebug() << "Text message does not represent a feature having a valid geometry!";
+        return false;
+    }
+
+    if (hasAttributes)
+    {
+        update.attributeRow = std::move(attributeRow);
+        update.attributes = std::move(attributes);
+    }
+
+    decodeTimeInfoFields(update);
+    return true;
+}
+
+bool StreamServiceFeatureDecoder::decodeDocument(const QByteArray &message, StreamServiceTrackUpdate &update) const
+{
+    // We expect UTF-8 encoded messages here
+    QJsonDocument featureDocument = QJsonDocument::fromJson(message);
+    if (featureDocument.isNull())
+    {
+        qDebug() << "Unsupported text message received!";
+        return false;
+    }
+
+    if (!featureDocument.isObject())
+    {
+        qDebug() << "Text message does not represent an object!";
+        return false;
+    }
+
+    auto const geometryKey = "geometry";
+    QJsonObject featureObject = featureDocument.object();
+    if (!featureObject.contains(geometryKey))
+    {
+        qDebug() << "Text message does not represent a feature having a geometry!";
+        return false;
+    }
+
+    // Obtain the geometry object
+    QJsonValue geometryValue = featureObject.value(geometryKey);
+    if (!geometryValue.isObject())
+    {
+        qDebug() << "Text message does not represent a feature having a geometry object!";
+        return false;
+    }
+
+    // Parse the geometry object
+    {
+        STREAMSERVICE_TRACE_SCOPE("geometry");
+        QJsonObject geometryObject = geometryValue.toObject();
+        QJsonDocument geometryDocument(geometryObject);
+        update.geometry = projectGeometry(Geometry::fromJson(geometryDocument.toJson()));
+    }
+    if (update.geometry.isEmpty())
+    {
+        qDebug() << "Text message does not represent a feature having a valid geometry!";
+        return false;
+    }
+
+    auto const attributesKey = "attributes";
+    if (!featureObject.contains(attributesKey))
+    {
+        return true;
+    }
+
+    // Obtain the attributes object
+    QJsonValue attributesValue = featureObject.value(attributesKey);
+    if (!attributesValue.isObject())
+    {
+        return true;
+    }
+
+    {
+        STREAMSERVICE_TRACE_SCOPE("attributes");
+        QJsonObject attributesObject = attributesValue.toObject();
+        update.attributes = attributesObject.toVariantMap();
+        if (!m_fieldSchema.isEmpty())
+        {
+            m_fieldSchema.splitVariantMap(update.attributes, update.attributeRow);
+        }
+    }
+
+    decodeTimeInfoFields(update);
+    return true;
+}
+
+Geometry StreamServiceFeatureDecoder::projectGeometry(const Geometry &geometry) const
+{
+    // Geometries parsed by the runtime are projected one by one
+    const int targetWkid = m_geometryBuilder.targetWkid();
+    if (0 == targetWkid || geometry.isEmpty() || StreamServiceProjection::Wgs84Wkid != geometry.spatialReference().wkid())
+    {
+        return geometry;
+    }
+    return GeometryEngine::project(geometry, SpatialReference(targetWkid));
+}
+
+void StreamServiceFeatureDecoder::resolveTimeInfoSlots()
+{
+    m_trackIdSlot = m_trackIdField.isEmpty() ? -1 : m_fieldSchema.slot(m_trackIdField);
+    m_startTimeSlot = m_startTimeField.isEmpty() ? -1 : m_fieldSchema.slot(m_startTimeField);
+    m_endTimeSlot = m_endTimeField.isEmpty() ? -1 : m_fieldSchema.slot(m_endTimeField);
+}
+
+bool StreamServiceFeatureDecoder::timeInfoValue(const StreamServiceTrackUpdate &update, const QString &fieldName, int slot, QVariant &value) const
+{
+    // Typed values are read from their slot, values not matching their field are variants
+    if (0 <= slot && slot < update.attributeRow.size() && StreamServiceAttributeValue::State::Missing != update.attributeRow[slot].state)
+    {
+        value = m_fieldSchema.toVariant(slot, update.attributeRow[slot]);
+        return true;
+    }
+
+    if (fieldName.isEmpty() || !update.attributes.contains(fieldName))
+    {
+        return false;
+    }
+    value = update.attributes.value(fieldName);
+    return true;
+}
+
+void StreamServiceFeatureDecoder::decodeTimeInfoFields(StreamServiceTrackUpdate &update) const
+{
+    // Track id
+    QVariant value;
+    if (timeInfoValue(update, m_trackIdField, m_trackIdSlot, value))
+    {
+        update.trackId = value.toString();
+        update.trackIdHash = StreamServiceTrackTable::hashTrackId(update.trackId);
+    }
+
+    // Start time, Esri JSON dates are milliseconds since the epoch
+    if (timeInfoValue(update, m_startTimeField, m_startTimeSlot, value))
+    {
+        update.startTime = QDateTime::fromMSecsSinceEpoch(value.toLongLong(), Qt::UTC);
+    }
+
+    // End time
+    if (timeInfoValue(update, m_endTimeField, m_endTimeSlot, value))
+    {
+        update.endTime = QDateTime::fromMSecsSinceEpoch(value.toLongLong(), Qt::UTC);
+    }
+}
@@ -0,0 +1,86 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEFEATUREDECODER_H
+#define STREAMSERVICEFEATUREDECODER_H
+
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceGeometryBuilder.h"
+
+#include <QByteArray>
+#include <QString>
+
+struct StreamServiceTrackUpdate;
+
+///
+/// \brief The StreamServiceFeatureDecoder class
+/// Decodes Esri JSON feature messages into track updates.
+/// Holds no shared state, so every ingest thread can own its own instance.
+/// The messages are scanned once on their UTF-8 bytes without building a JSON document.
+/// Messages the scanner does not accept take the document path, which also reports the errors.
+/// Plain geometries are built directly from the scanned coordinates, others are parsed by the runtime.
+///
+class StreamServiceFeatureDecoder
+{
+public:
+    enum class TrackIdPeek
+    {
+        Missing,
+        Found,
+        Ambiguous
+    };
+
+    StreamServiceFeatureDecoder();
+
+    void setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField);
+    void setTargetWkid(int targetWkid);
+    void setFieldSchema(const StreamServiceFieldSchema &fieldSchema);
+
+    // Finds the track id without decoding, ambiguous messages must be decoded to know it
+    TrackIdPeek peekTrackId(const QByteArray &message, QString &trackId) const;
+
+    bool decode(const QByteArray &message, StreamServiceTrackUpdate &update);
+    bool decodeDocument(const QByteArray &message, StreamServiceTrackUpdate &update) const;
+
+private:
+    Esri::ArcGISRuntime::Geometry projectGeometry(const Esri::ArcGISRuntime::Geometry &geometry) const;
+    void resolveTimeInfoSlots();
+    bool timeInfoValue(const StreamServiceTrackUpdate &update, const QString &fieldName, int slot, QVariant &value) const;
+    void decodeTimeInfoFields(StreamServiceTrackUpdate &update) const;
+
+    StreamServiceGeometryBuilder m_geometryBuilder;
+    StreamServiceFieldSchema m_fieldSchema;
+
+    QString m_trackIdField;
+    QByteArray m_trackIdKey;
+    QString m_startTimeField;
+    QString m_endTimeField;
+    int m_trackIdSlot = -1;
+    int m_startTimeSlot = -1;
+    int m_endTimeSlot = -1;
+};
+
+#endif // STREAMSERVICEFEATUREDECODER_H
@@ -0,0 +1,229 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceFieldSchema.h"
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include <cmath>
+
+namespace
+{
+// Doubles within this range convert into a qint64 without overflow
+const double MinimumInteger = -9223372036854775808.0;
+const double MaximumInteger = 9223372036854775808.0;
+
+bool isNullVariant(const QVariant &value)
+{
+    return !value.isValid() || QMetaType::Nullptr == value.userType();
+}
+}
+
+StreamServiceFieldSchema::StreamServiceFieldSchema()
+{
+}
+
+StreamServiceFieldSchema StreamServiceFieldSchema::createFromJson(const QJsonValue &fieldsValue)
+{
+    StreamServiceFieldSchema schema;
+    const QJsonArray fieldsArray = fieldsValue.toArray();
+    for (const QJsonValue &fieldValue : fieldsArray)
+    {
+        const QJsonObject fieldObject = fieldValue.toObject();
+        const QString name = fieldObject.value(QStringLiteral("name")).toString();
+        const QString type = fieldObject.value(QStringLiteral("type")).toString();
+        if (name.isEmpty() || schema.m_slots.contains(name))
+        {
+            continue;
+        }
+
+        Field field;
+        field.name = name;
+        if (QStringLiteral("esriFieldTypeOID") == type
+                || QStringLiteral("esriFieldTypeSmallInteger") == type
+                || QStringLiteral("esriFieldTypeInteger") == type
+                || QStringLiteral("esriFieldTypeBigInteger") == type)
+        {
+            field.type = FieldType::Integer;
+        }
+        else if (QStringLiteral("esriFieldTypeSingle") == type
+                 || QStringLiteral("esriFieldTypeDouble") == type)
+        {
+            field.type = FieldType::Double;
+        }
+        else if (QStringLiteral("esriFieldTypeString") == type
+                 || QStringLiteral("esriFieldTypeGUID") == type
+                 || QStringLiteral("esriFieldTypeGlobalID") == type)
+        {
+            field.type = FieldType::String;
+        }
+        else if (QStringLiteral("esriFieldTypeDate") == type)
+        {
+            field.type = FieldType::Date;
+        }
+        else
+        {
+            continue;
+        }
+
+        const int slot = schema.m_fields.size();
+        schema.m_fields.append(field);
+        schema.m_slots.insert(name, slot);
+        schema.m_utf8Slots.insert(name.toUtf8(), slot);
+    }
+    return schema;
+}
+
+bool StreamServiceFieldSchema::isEmpty() const
+{
+    return m_fields.isEmpty();
+}
+
+int StreamServiceFieldSchema::fieldCount() const
+{
+    return m_fields.size();
+}
+
+const StreamServiceFieldSchema::Field& StreamServiceFieldSchema::field(int slot) const
+{
+    return m_fields[slot];
+}
+
+int StreamServiceFieldSchema::slot(const QString &name) const
+{
+    return m_slots.value(name, -1);
+}
+
+int StreamServiceFieldSchema::slot(const char *utf8Name, int size) const
+{
+    return m_utf8Slots.value(QByteArray::fromRawData(utf8Name, size), -1);
+}
+
+bool StreamServiceFieldSchema::isIntegral(double number)
+{
+    return MinimumInteger <= number && number < MaximumInteger && std::floor(number) == number;
+}
+
+QVariant StreamServiceFieldSchema::toVariant(int slot, const StreamServiceAttributeValue &value) const
+{
+    switch (value.state)
+    {
+    case StreamServiceAttributeValue::State::Missing:
+        return QVariant();
+    case StreamServiceAttributeValue::State::Null:
+        // Whatever the document converts null into
+        return QJsonValue(QJsonValue::Null).toVariant();
+    case StreamServiceAttributeValue::State::Set:
+        break;
+    }
+
+    switch (m_fields[slot].type)
+    {
+    case FieldType::Integer:
+    case FieldType::Date:
+        return static_cast<qlonglong>(value.integer);
+    case FieldType::Double:
+        return value.number;
+    case FieldType::String:
+        return value.string;
+    }
+    return QVariant();
+}
+
+QVariantMap StreamServiceFieldSchema::toVariantMap(const StreamServiceAttributeRow &row, const QVariantMap &extraAttributes) const
+{
+    QVariantMap attributes = extraAttributes;
+    const int slotCount = qMin(row.size(), m_fields.size());
+    for (int slot = 0; slot < slotCount; slot++)
+    {
+        if (StreamServiceAttributeValue::State::Missing != row[slot].state)
+        {
+            attributes.insert(m_fields[slot].name, toVariant(slot, row[slot]));
+        }
+    }
+    return attributes;
+}
+
+void StreamServiceFieldSchema::splitVariantMap(QVariantMap &attributes, StreamServiceAttributeRow &row) const
+{
+    row.fill(StreamServiceAttributeValue(), m_fields.size());
+    auto attributeIterator = attributes.begin();
+    while (attributeIterator != attributes.end())
+    {
+        const int fieldSlot = slot(attributeIterator.key());
+        if (fieldSlot < 0)
+        {
+            ++attributeIterator;
+            continue;
+        }
+
+        const QVariant &value = attributeIterator.value();
+        StreamServiceAttributeValue &rowValue = row[fieldSlot];
+        if (isNullVariant(value))
+        {
+            rowValue.state = StreamServiceAttributeValue::State::Null;
+            attributeIterator = attributes.erase(attributeIterator);
+            continue;
+        }
+
+        // Values of another type than their field are left as they are
+        bool matches = false;
+        switch (m_fields[fieldSlot].type)
+        {
+        case FieldType::Integer:
+        case FieldType::Date:
+            if (QMetaType::Double == value.userType() || QMetaType::Float == value.userType())
+            {
+                matches = isIntegral(value.toDouble());
+            }
+            else
+            {
+                matches = QMetaType::Int == value.userType() || QMetaType::LongLong == value.userType()
+                        || QMetaType::UInt == value.userType();
+            }
+            rowValue.integer = matches ? value.toLongLong() : 0;
+            break;
+        case FieldType::Double:
+            matches = QMetaType::Double == value.userType() || QMetaType::Float == value.userType()
+                    || QMetaType::Int == value.userType() || QMetaType::LongLong == value.userType()
+                    || QMetaType::UInt == value.userType();
+            rowValue.number = matches ? value.toDouble() : 0.0;
+            break;
+        case FieldType::String:
+            matches = QMetaType::QString == value.userType();
+            rowValue.string = matches ? value.toString() : QString();
+            break;
+        }
+
+        if (!matches)
+        {
+            ++attributeIterator;
+            continue;
+        }
+        rowValue.state = StreamServiceAttributeValue::State::Set;
+        attributeIterator = attributes.erase(attributeIterator);
+    }
+}
@@ -0,0 +1,117 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEFIELDSCHEMA_H
+#define STREAMSERVICEFIELDSCHEMA_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QJsonValue>
+#include <QString>
+#include <QVariant>
+#include <QVariantMap>
+#include <QVector>
+
+///
+/// \brief The StreamServiceAttributeValue struct
+/// A typed attribute value, which member holds the value depends on the type of its field.
+///
+struct StreamServiceAttributeValue
+{
+    enum class State : quint8
+    {
+        Missing,
+        Null,
+        Set
+    };
+
+    State state = State::Missing;
+    qint64 integer = 0;
+    double number = 0.0;
+    QString string;
+
+    bool operator==(const StreamServiceAttributeValue &other) const
+    {
+        return state == other.state && integer == other.integer && number == other.number && string == other.string;
+    }
+};
+
+// One value per slot of the schema, fields missing in the message stay missing
+typedef QVector<StreamServiceAttributeValue> StreamServiceAttributeRow;
+
+///
+/// \brief The StreamServiceFieldSchema class
+/// The fields of the stream service description compiled into typed slots.
+/// Attributes having a slot are decoded into typed values, others are kept as variants.
+/// The values are only converted into variants at the runtime boundary.
+/// Integer and date fields become qlonglong like the binary encoding delivers them.
+///
+class StreamServiceFieldSchema
+{
+public:
+    enum class FieldType : quint8
+    {
+        Integer,
+        Double,
+        String,
+        Date
+    };
+
+    struct Field
+    {
+        QString name;
+        FieldType type = FieldType::String;
+    };
+
+    StreamServiceFieldSchema();
+
+    // Fields of unsupported types like geometry, blob or raster do not get a slot
+    static StreamServiceFieldSchema createFromJson(const QJsonValue &fieldsValue);
+
+    bool isEmpty() const;
+    int fieldCount() const;
+    const Field& field(int slot) const;
+
+    // Returns -1 for unknown fields, the UTF-8 lookup does not allocate
+    int slot(const QString &name) const;
+    int slot(const char *utf8Name, int size) const;
+
+    // Doubles without fraction within the qint64 range
+    static bool isIntegral(double number);
+
+    QVariant toVariant(int slot, const StreamServiceAttributeValue &value) const;
+    QVariantMap toVariantMap(const StreamServiceAttributeRow &row, const QVariantMap &extraAttributes) const;
+
+    // Moves every attribute matching the type of its field into the row
+    void splitVariantMap(QVariantMap &attributes, StreamServiceAttributeRow &row) const;
+
+private:
+    QVector<Field> m_fields;
+    QHash<QString, int> m_slots;
+    QHash<QByteArray, int> m_utf8Slots;
+};
+
+#endif // STREAMSERVICEFIELDSCHEMA_H
@@ -0,0 +1,232 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceGeometryBuilder.h"
+#include "StreamServiceProjection.h"
+
+#include "MultipointBuilder.h"
+#include "Part.h"
+#include "PartCollection.h"
+#include "Point.h"
+#include "PointCollection.h"
+#include "PolygonBuilder.h"
+#include "PolylineBuilder.h"
+#include "SpatialReference.h"
+
+using namespace Esri::ArcGISRuntime;
+
+StreamServiceGeometryBuilder::StreamServiceGeometryBuilder()
+{
+}
+
+int StreamServiceGeometryBuilder::targetWkid() const
+{
+    return m_targetWkid;
+}
+
+void StreamServiceGeometryBuilder::setTargetWkid(int targetWkid)
+{
+    m_targetWkid = StreamServiceProjection::isWebMercator(targetWkid) ? targetWkid : 0;
+}
+
+void StreamServiceGeometryBuilder::clear()
+{
+    // Keeps the capacity for the next batch
+    m_geometries.resize(0);
+    m_partStarts.resize(0);
+    m_x.resize(0);
+    m_y.resize(0);
+    m_z.resize(0);
+}
+
+int StreamServiceGeometryBuilder::geometryCount() const
+{
+    return m_geometries.size();
+}
+
+int StreamServiceGeometryBuilder::beginGeometry(GeometryType geometryType)
+{
+    GeometryEntry entry;
+    entry.type = geometryType;
+    entry.firstPart = m_partStarts.size();
+    entry.firstPoint = m_x.size();
+    m_geometries.append(entry);
+    if (GeometryType::Point == geometryType || GeometryType::Multipoint == geometryType)
+    {
+        beginPart();
+    }
+    return m_geometries.size() - 1;
+}
+
+void StreamServiceGeometryBuilder::beginPart()
+{
+    m_partStarts.append(m_x.size());
+}
+
+void StreamServiceGeometryBuilder::addPoint(double x, double y)
+{
+    addPoint(x, y, 0.0);
+}
+
+void StreamServiceGeometryBuilder::addPoint(double x, double y, double z)
+{
+    m_x.append(x);
+    m_y.append(y);
+    m_z.append(z);
+}
+
+void StreamServiceGeometryBuilder::setSpatialReference(int wkid, bool hasZ)
+{
+    GeometryEntry &entry = m_geometries.last();
+    entry.wkid = wkid;
+    entry.hasZ = hasZ;
+}
+
+int StreamServiceGeometryBuilder::pointCount(int geometryIndex) const
+{
+    return geometryEnd(geometryIndex) - m_geometries[geometryIndex].firstPoint;
+}
+
+void StreamServiceGeometryBuilder::project()
+{
+    if (0 == m_targetWkid)
+    {
+        return;
+    }
+
+    // Consecutive geographic geometries share one run of the kernel
+    int runStart = -1;
+    for (int geometryIndex = 0; geometryIndex <= m_geometries.size(); geometryIndex++)
+    {
+        const bool isGeographic = geometryIndex < m_geometries.size() && StreamServiceProjection::Wgs84Wkid == m_geometries[geometryIndex].wkid;
+        if (isGeographic)
+        {
+            m_geometries[geometryIndex].wkid = m_targetWkid;
+            if (runStart < 0)
+            {
+                runStart = m_geometries[geometryIndex].firstPoint;
+            }
+            continue;
+        }
+
+        if (0 <= runStart)
+        {
+            const int runEnd = (geometryIndex < m_geometries.size()) ? m_geometries[geometryIndex].firstPoint : m_x.size();
+            StreamServiceProjection::projectToWebMercator(m_x.data() + runStart, m_y.data() + runStart, runEnd - runStart);
+            runStart = -1;
+        }
+    }
+}
+
+Geometry StreamServiceGeometryBuilder::geometry(int geometryIndex) const
+{
+    const GeometryEntry &entry = m_geometries[geometryIndex];
+    const SpatialReference spatialReference = (0 == entry.wkid) ? SpatialReference() : SpatialReference(entry.wkid);
+    const int partEndIndex = (geometryIndex + 1 < m_geometries.size()) ? m_geometries[geometryIndex + 1].firstPart : m_partStarts.size();
+    switch (entry.type)
+    {
+    case GeometryType::Point:
+    {
+        const int pointIndex = entry.firstPoint;
+        if (entry.hasZ)
+        {
+            return Point(m_x[pointIndex], m_y[pointIndex], m_z[pointIndex], spatialReference);
+        }
+        return Point(m_x[pointIndex], m_y[pointIndex], spatialReference);
+    }
+    case GeometryType::Multipoint:
+    {
+        MultipointBuilder multipointBuilder(spatialReference);
+        PointCollection *points = multipointBuilder.points();
+        for (int pointIndex = entry.firstPoint; pointIndex < geometryEnd(geometryIndex); pointIndex++)
+        {
+            if (entry.hasZ)
+            {
+                points->addPoint(m_x[pointIndex], m_y[pointIndex], m_z[pointIndex]);
+            }
+            else
+            {
+                points->addPoint(m_x[pointIndex], m_y[pointIndex]);
+            }
+        }
+        return multipointBuilder.toGeometry();
+    }
+    case GeometryType::Polyline:
+    case GeometryType::Polygon:
+        break;
+    }
+
+    const bool isPolygon = (GeometryType::Polygon == entry.type);
+    PartCollection *parts = new PartCollection(spatialReference);
+    for (int partIndex = entry.firstPart; partIndex < partEndIndex; partIndex++)
+    {
+        const int firstPoint = m_partStarts[partIndex];
+        int lastPoint = partEnd(partIndex);
+
+        // Rings are closed implicitly, the closing point of Esri JSON is dropped
+        if (isPolygon && 1 < lastPoint - firstPoint
+                && m_x[firstPoint] == m_x[lastPoint - 1] && m_y[firstPoint] == m_y[lastPoint - 1] && m_z[firstPoint] == m_z[lastPoint - 1])
+        {
+            lastPoint--;
+        }
+
+        Part *part = new Part(spatialReference, parts);
+        for (int pointIndex = firstPoint; pointIndex < lastPoint; pointIndex++)
+        {
+            if (entry.hasZ)
+            {
+                part->addPoint(m_x[pointIndex], m_y[pointIndex], m_z[pointIndex]);
+            }
+            else
+            {
+                part->addPoint(m_x[pointIndex], m_y[pointIndex]);
+            }
+        }
+        parts->addPart(part);
+    }
+
+    if (isPolygon)
+    {
+        PolygonBuilder polygonBuilder(spatialReference);
+        parts->setParent(&polygonBuilder);
+        polygonBuilder.setParts(parts);
+        return polygonBuilder.toGeometry();
+    }
+
+    PolylineBuilder polylineBuilder(spatialReference);
+    parts->setParent(&polylineBuilder);
+    polylineBuilder.setParts(parts);
+    return polylineBuilder.toGeometry();
+}
+
+int StreamServiceGeometryBuilder::partEnd(int partIndex) const
+{
+    return (partIndex + 1 < m_partStarts.size()) ? m_partStarts[partIndex + 1] : m_x.size();
+}
+
+int StreamServiceGeometryBuilder::geometryEnd(int geometryIndex) const
+{
+    return (geometryIndex + 1 < m_geometries.size()) ? m_geometries[geometryIndex + 1].firstPoint : m_x.size();
+}
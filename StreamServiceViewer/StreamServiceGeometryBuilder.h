@@ -0,0 +1,93 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEGEOMETRYBUILDER_H
+#define STREAMSERVICEGEOMETRYBUILDER_H
+
+#include "Geometry.h"
+
+#include <QVector>
+
+///
+/// \brief The StreamServiceGeometryBuilder class
+/// Collects the decoded coordinates of a batch of geometries and builds the runtime geometries directly from them.
+/// WGS84 coordinates are projected into the target spatial reference for the whole batch at once,
+/// so that the runtime does not need to project the graphics while rendering.
+/// Only Web Mercator is supported as target, a target wkid of zero keeps the decoded spatial reference.
+///
+class StreamServiceGeometryBuilder
+{
+public:
+    enum class GeometryType
+    {
+        Point,
+        Multipoint,
+        Polyline,
+        Polygon
+    };
+
+    StreamServiceGeometryBuilder();
+
+    int targetWkid() const;
+    void setTargetWkid(int targetWkid);
+
+    void clear();
+    int geometryCount() const;
+
+    // Points and multipoints have exactly one part, polylines and polygons start each part explicitly
+    int beginGeometry(GeometryType geometryType);
+    void beginPart();
+    void addPoint(double x, double y);
+    void addPoint(double x, double y, double z);
+    void setSpatialReference(int wkid, bool hasZ);
+
+    int pointCount(int geometryIndex) const;
+
+    void project();
+    Esri::ArcGISRuntime::Geometry geometry(int geometryIndex) const;
+
+private:
+    struct GeometryEntry
+    {
+        GeometryType type = GeometryType::Point;
+        int wkid = 0;
+        bool hasZ = false;
+        int firstPart = 0;
+        int firstPoint = 0;
+    };
+
+    int partEnd(int partIndex) const;
+    int geometryEnd(int geometryIndex) const;
+
+    QVector<GeometryEntry> m_geometries;
+    QVector<int> m_partStarts;
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<double> m_z;
+    int m_targetWkid = 0;
+};
+
+#endif // STREAMSERVICEGEOMETRYBUILDER_H
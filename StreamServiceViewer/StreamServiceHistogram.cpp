@@ -0,0 +1,194 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceHistogram.h"
+
+#include <QtAlgorithms>
+
+#include <cmath>
+
+namespace
+{
+// Sixteen sub-buckets per power of two
+const int SubBucketBits = 4;
+const int SubBucketCount = 1 << SubBucketBits;
+
+// Values up to 2^63 need 60 powers of two in front of the linear part
+const int BucketCount = (64 - SubBucketBits + 1) * SubBucketCount;
+}
+
+StreamServiceHistogram::StreamServiceHistogram() :
+    m_buckets(BucketCount, 0)
+{
+}
+
+void StreamServiceHistogram::record(qint64 value)
+{
+    const qint64 clampedValue = qMax(qint64(0), value);
+    m_buckets[bucketIndex(static_cast<quint64>(clampedValue))]++;
+    if (0 == m_count || clampedValue < m_minimum)
+    {
+        m_minimum = clampedValue;
+    }
+    if (0 == m_count || m_maximum < clampedValue)
+    {
+        m_maximum = clampedValue;
+    }
+    m_count++;
+    m_sum += clampedValue;
+}
+
+void StreamServiceHistogram::merge(const StreamServiceHistogram &other)
+{
+    if (0 == other.m_count)
+    {
+        return;
+    }
+
+    for (int index = 0; index < BucketCount; index++)
+    {
+        m_buckets[index] += other.m_buckets[index];
+    }
+    m_minimum = (0 == m_count) ? other.m_minimum : qMin(m_minimum, other.m_minimum);
+    m_maximum = (0 == m_count) ? other.m_maximum : qMax(m_maximum, other.m_maximum);
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+}
+
+void StreamServiceHistogram::reset()
+{
+    m_buckets.fill(0);
+    m_count = 0;
+    m_minimum = 0;
+    m_maximum = 0;
+    m_sum = 0;
+}
+
+StreamServiceHistogram StreamServiceHistogram::since(const StreamServiceHistogram &earlier) const
+{
+    StreamServiceHistogram difference;
+    if (m_count <= earlier.m_count)
+    {
+        return difference;
+    }
+
+    // The extremes of the difference are only known up to their buckets
+    int firstBucket = -1;
+    int lastBucket = -1;
+    for (int index = 0; index < BucketCount; index++)
+    {
+        difference.m_buckets[index] = m_buckets[index] - qMin(m_buckets[index], earlier.m_buckets[index]);
+        if (0 < difference.m_buckets[index])
+        {
+            if (firstBucket < 0)
+            {
+                firstBucket = index;
+            }
+            lastBucket = index;
+        }
+    }
+    if (firstBucket < 0)
+    {
+        return difference;
+    }
+
+    difference.m_count = m_count - earlier.m_count;
+    difference.m_sum = m_sum - earlier.m_sum;
+    difference.m_minimum = qMax(m_minimum, static_cast<qint64>((0 == firstBucket) ? 0 : bucketUpperBound(firstBucket - 1) + 1));
+    difference.m_maximum = qMin(m_maximum, static_cast<qint64>(bucketUpperBound(lastBucket)));
+    return difference;
+}
+
+quint64 StreamServiceHistogram::count() const
+{
+    return m_count;
+}
+
+qint64 StreamServiceHistogram::minimum() const
+{
+    return m_minimum;
+}
+
+qint64 StreamServiceHistogram::maximum() const
+{
+    return m_maximum;
+}
+
+double StreamServiceHistogram::sum() const
+{
+    return m_sum;
+}
+
+double StreamServiceHistogram::mean() const
+{
+    return (0 == m_count) ? 0 : m_sum / m_count;
+}
+
+qint64 StreamServiceHistogram::quantile(double fraction) const
+{
+    if (0 == m_count)
+    {
+        return 0;
+    }
+
+    // Rank of the requested value, one based
+    const quint64 rank = qMax(quint64(1), static_cast<quint64>(std::ceil(qBound(0.0, fraction, 1.0) * m_count)));
+    quint64 accumulatedCount = 0;
+    for (int index = 0; index < BucketCount; index++)
+    {
+        accumulatedCount += m_buckets[index];
+        if (rank <= accumulatedCount)
+        {
+            return qBound(m_minimum, static_cast<qint64>(bucketUpperBound(index)), m_maximum);
+        }
+    }
+    return m_maximum;
+}
+
+int StreamServiceHistogram::bucketIndex(quint64 value)
+{
+    if (value < static_cast<quint64>(SubBucketCount))
+    {
+        return static_cast<int>(value);
+    }
+
+    // The highest bit selects the power of two, the following bits the sub-bucket
+    const int highestBit = 63 - static_cast<int>(qCountLeadingZeroBits(value));
+    const int shift = highestBit - SubBucketBits;
+    return (shift + 1) * SubBucketCount + static_cast<int>((value >> shift) & (SubBucketCount - 1));
+}
+
+quint64 StreamServiceHistogram::bucketUpperBound(int bucketIndex)
+{
+    if (bucketIndex < SubBucketCount)
+    {
+        return static_cast<quint64>(bucketIndex);
+    }
+
+    const int shift = bucketIndex / SubBucketCount - 1;
+    const quint64 subBucket = static_cast<quint64>(bucketIndex % SubBucketCount);
+    const quint64 lowerBound = (static_cast<quint64>(SubBucketCount) + subBucket) << shift;
+    return lowerBound + (quint64(1) << shift) - 1;
+}
@@ -0,0 +1,70 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEHISTOGRAM_H
+#define STREAMSERVICEHISTOGRAM_H
+
+#include <QVector>
+
+///
+/// \brief The StreamServiceHistogram class
+/// Log-linear histogram of non-negative values, e.g. latencies in nanoseconds.
+/// Every power of two is split into sixteen buckets, so quantiles are within 6.25 percent.
+/// Recording is O(1) and never allocates, the histogram is not thread-safe.
+///
+class StreamServiceHistogram
+{
+public:
+    StreamServiceHistogram();
+
+    void record(qint64 value);
+    void merge(const StreamServiceHistogram &other);
+    void reset();
+
+    // Values recorded after the earlier copy of this histogram, e.g. for the last second
+    StreamServiceHistogram since(const StreamServiceHistogram &earlier) const;
+
+    quint64 count() const;
+    qint64 minimum() const;
+    qint64 maximum() const;
+    double sum() const;
+    double mean() const;
+
+    // Upper bound of the bucket holding the quantile, e.g. 0.99 for p99
+    qint64 quantile(double fraction) const;
+
+private:
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int bucketIndex);
+
+    QVector<quint64> m_buckets;
+    quint64 m_count = 0;
+    qint64 m_minimum = 0;
+    qint64 m_maximum = 0;
+    double m_sum = 0;
+};
+
+#endif // STREAMSERVICEHISTOGRAM_H
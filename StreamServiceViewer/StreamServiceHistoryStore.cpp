@@ -0,0 +1,198 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceHistoryStore.h"
+
+#include <algorithm>
+
+StreamServiceHistoryStore::StreamServiceHistoryStore()
+{
+}
+
+qint64 StreamServiceHistoryStore::retention() const
+{
+    return m_retention;
+}
+
+void StreamServiceHistoryStore::setRetention(qint64 msecs)
+{
+    m_retention = qMax(qint64(0), msecs);
+    if (0 == m_retention)
+    {
+        clear();
+        return;
+    }
+    trim();
+}
+
+void StreamServiceHistoryStore::append(const QString &trackId, uint trackIdHash, double x, double y, qint64 time, const QVariantMap &attributes)
+{
+    if (0 == m_retention || trackId.isEmpty())
+    {
+        return;
+    }
+
+    const quint32 trackKey = m_trackTable.insert(trackId, trackIdHash);
+    const int keyIndex = static_cast<int>(trackKey);
+    if (m_observationCounts.size() <= keyIndex)
+    {
+        m_observationCounts.resize(m_trackTable.handleCapacity());
+        m_attributes.resize(m_trackTable.handleCapacity());
+        m_queryStamps.resize(m_trackTable.handleCapacity());
+    }
+    m_observationCounts[keyIndex]++;
+    m_attributes[keyIndex] = attributes;
+
+    // Observations mostly arrive in time order, late ones are inserted in place
+    int row = m_times.size();
+    if (m_begin < row && time < m_times.last())
+    {
+        row = upperBound(time);
+    }
+
+    m_times.insert(row, time);
+    m_trackKeys.insert(row, trackKey);
+    m_x.insert(row, x);
+    m_y.insert(row, y);
+    trim();
+}
+
+void StreamServiceHistoryStore::clear()
+{
+    m_begin = 0;
+    m_times.clear();
+    m_trackKeys.clear();
+    m_x.clear();
+    m_y.clear();
+    m_trackTable.clear();
+    m_observationCounts.clear();
+    m_attributes.clear();
+    m_queryStamps.clear();
+}
+
+int StreamServiceHistoryStore::size() const
+{
+    return m_times.size() - m_begin;
+}
+
+qint64 StreamServiceHistoryStore::startTime() const
+{
+    return (0 < size()) ? m_times[m_begin] : 0;
+}
+
+qint64 StreamServiceHistoryStore::endTime() const
+{
+    return (0 < size()) ? m_times.last() : 0;
+}
+
+QVector<StreamServiceHistoryObservation> StreamServiceHistoryStore::latestInWindow(qint64 windowStart, qint64 windowEnd)
+{
+    QVector<StreamServiceHistoryObservation> observations;
+    const int firstRow = lowerBound(windowStart);
+    const int lastRow = upperBound(windowEnd);
+    if (lastRow <= firstRow)
+    {
+        return observations;
+    }
+
+    // Walk backwards, the first observation seen of every track is its latest one
+    m_queryStamp++;
+    if (0 == m_queryStamp)
+    {
+        m_queryStamps.fill(0);
+        m_queryStamp = 1;
+    }
+
+    for (int row = lastRow - 1; firstRow <= row; row--)
+    {
+        const quint32 trackKey = m_trackKeys[row];
+        quint32 &queryStamp = m_queryStamps[static_cast<int>(trackKey)];
+        if (m_queryStamp == queryStamp)
+        {
+            continue;
+        }
+
+        queryStamp = m_queryStamp;
+        observations.append(StreamServiceHistoryObservation{trackKey, m_x[row], m_y[row], m_times[row]});
+    }
+    return observations;
+}
+
+QString StreamServiceHistoryStore::trackId(quint32 trackKey) const
+{
+    return m_trackTable.trackId(trackKey);
+}
+
+QVariantMap StreamServiceHistoryStore::attributes(quint32 trackKey) const
+{
+    return m_attributes.value(static_cast<int>(trackKey));
+}
+
+int StreamServiceHistoryStore::lowerBound(qint64 time) const
+{
+    return static_cast<int>(std::lower_bound(m_times.cbegin() + m_begin, m_times.cend(), time) - m_times.cbegin());
+}
+
+int StreamServiceHistoryStore::upperBound(qint64 time) const
+{
+    return static_cast<int>(std::upper_bound(m_times.cbegin() + m_begin, m_times.cend(), time) - m_times.cbegin());
+}
+
+void StreamServiceHistoryStore::trim()
+{
+    if (0 == size())
+    {
+        return;
+    }
+
+    // The retention is relative to the newest observation
+    const qint64 oldestTime = m_times.last() - m_retention;
+    while (m_begin < m_times.size() && m_times[m_begin] < oldestTime)
+    {
+        const quint32 trackKey = m_trackKeys[m_begin];
+        const int keyIndex = static_cast<int>(trackKey);
+        if (0 == --m_observationCounts[keyIndex])
+        {
+            m_attributes[keyIndex] = QVariantMap();
+            m_trackTable.remove(trackKey);
+        }
+        m_begin++;
+    }
+
+    // Trimmed rows are dropped once they make up half of the columns
+    if (m_times.size() < 2 * m_begin)
+    {
+        compact();
+    }
+}
+
+void StreamServiceHistoryStore::compact()
+{
+    m_times.remove(0, m_begin);
+    m_trackKeys.remove(0, m_begin);
+    m_x.remove(0, m_begin);
+    m_y.remove(0, m_begin);
+    m_begin = 0;
+}
@@ -0,0 +1,91 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEHISTORYSTORE_H
+#define STREAMSERVICEHISTORYSTORE_H
+
+#include "StreamServiceTrackTable.h"
+
+#include <QVariantMap>
+#include <QVector>
+
+struct StreamServiceHistoryObservation
+{
+    quint32 trackKey;
+    double x;
+    double y;
+    qint64 time;
+};
+
+///
+/// \brief The StreamServiceHistoryStore class
+/// Time ordered columnar store of the received observations.
+/// Time window queries use a binary search over the time column, observations
+/// older than the retention are trimmed from the front.
+/// Only the latest attributes are kept per track, not per observation.
+///
+class StreamServiceHistoryStore
+{
+public:
+    StreamServiceHistoryStore();
+
+    qint64 retention() const;
+    void setRetention(qint64 msecs);
+
+    void append(const QString &trackId, uint trackIdHash, double x, double y, qint64 time, const QVariantMap &attributes);
+    void clear();
+
+    int size() const;
+    qint64 startTime() const;
+    qint64 endTime() const;
+
+    // The latest observation of every track within the window
+    QVector<StreamServiceHistoryObservation> latestInWindow(qint64 windowStart, qint64 windowEnd);
+
+    QString trackId(quint32 trackKey) const;
+    QVariantMap attributes(quint32 trackKey) const;
+
+private:
+    int lowerBound(qint64 time) const;
+    int upperBound(qint64 time) const;
+    void trim();
+    void compact();
+
+    qint64 m_retention = 0;
+    int m_begin = 0;
+    QVector<qint64> m_times;
+    QVector<quint32> m_trackKeys;
+    QVector<double> m_x;
+    QVector<double> m_y;
+
+    StreamServiceTrackTable m_trackTable;
+    QVector<int> m_observationCounts;
+    QVector<QVariantMap> m_attributes;
+    QVector<quint32> m_queryStamps;
+    quint32 m_queryStamp = 0;
+};
+
+#endif // STREAMSERVICEHISTORYSTORE_H
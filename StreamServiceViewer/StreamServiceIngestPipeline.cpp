@@ -0,0 +1,65 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceIngestPipeline.h"
+
+StreamServiceIngestPipeline::StreamServiceIngestPipeline() :
+    m_ingestWorker(new StreamServiceIngestWorker(&m_decodePool))
+{
+    // The ingest worker owns the websockets and hands the messages over to the decode threads
+    m_ingestThread.setObjectName(QStringLiteral("StreamServiceIngest"));
+    m_ingestWorker->moveToThread(&m_ingestThread);
+    QObject::connect(&m_ingestThread, &QThread::finished, m_ingestWorker, &QObject::deleteLater);
+    m_ingestThread.start();
+}
+
+StreamServiceIngestPipeline::~StreamServiceIngestPipeline()
+{
+    // The ingest thread may wait for a full shard, which nobody drains any longer
+    m_decodePool.requestStop();
+    m_ingestThread.quit();
+    m_ingestThread.wait();
+    m_decodePool.stop();
+}
+
+StreamServiceIngestWorker* StreamServiceIngestPipeline::worker() const
+{
+    return m_ingestWorker;
+}
+
+StreamServiceDecodePool& StreamServiceIngestPipeline::decodePool()
+{
+    return m_decodePool;
+}
+
+const StreamServiceDecodePool& StreamServiceIngestPipeline::decodePool() const
+{
+    return m_decodePool;
+}
+
+void StreamServiceIngestPipeline::start(int decodeThreadCount)
+{
+    m_decodePool.start(decodeThreadCount);
+}
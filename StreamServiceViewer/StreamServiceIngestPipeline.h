@@ -0,0 +1,84 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEINGESTPIPELINE_H
+#define STREAMSERVICEINGESTPIPELINE_H
+
+#include "StreamServiceDecodePool.h"
+#include "StreamServiceIngestWorker.h"
+
+#include <QThread>
+
+///
+/// \brief The StreamServiceIngestPipeline class
+/// Runs the ingest worker on its own thread and hands its messages to the decode pool.
+/// The consumer drains the decoded updates in bounded batches, so that its event loop keeps up.
+///
+class StreamServiceIngestPipeline
+{
+public:
+    // Updates taken from the decode pool at once
+    static const int MaximumDrainCount = 4096;
+
+    StreamServiceIngestPipeline();
+    ~StreamServiceIngestPipeline();
+
+    StreamServiceIngestWorker* worker() const;
+    StreamServiceDecodePool& decodePool();
+    const StreamServiceDecodePool& decodePool() const;
+
+    // The decode threads are started once, zero uses all but two of the cores
+    void start(int decodeThreadCount);
+
+    // Returns false if updates are left for the next call
+    template <typename UpdateHandler>
+    bool drain(UpdateHandler handleUpdate);
+
+private:
+    QThread m_ingestThread;
+    StreamServiceDecodePool m_decodePool;
+    StreamServiceIngestWorker *m_ingestWorker;
+};
+
+template <typename UpdateHandler>
+bool StreamServiceIngestPipeline::drain(UpdateHandler handleUpdate)
+{
+    // Acknowledge first, so that updates pushed while draining signal again
+    m_decodePool.acknowledgeUpdates();
+
+    StreamServiceTrackUpdate update;
+    for (int drainCount = 0; drainCount < MaximumDrainCount; drainCount++)
+    {
+        if (!m_decodePool.tryPop(update))
+        {
+            return true;
+        }
+        handleUpdate(std::move(update));
+    }
+    return false;
+}
+
+#endif // STREAMSERVICEINGESTPIPELINE_H
@@ -0,0 +1,548 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceIngestWorker.h"
+#include "StreamServiceCaptureReplayer.h"
+#include "StreamServiceCounters.h"
+#include "StreamServiceTrace.h"
+
+#include <QDebug>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QNetworkRequest>
+#include <QRandomGenerator>
+
+namespace
+{
+// Connections neither sending messages nor answering pings for this long are unhealthy
+const qint64 HealthTimeout = 6000;
+const int HealthCheckInterval = 2000;
+
+// Reconnect delays double with every attempt up to the maximum
+const int ReconnectBaseDelay = 500;
+const int ReconnectMaximumDelay = 30000;
+}
+
+StreamServiceIngestWorker::StreamServiceIngestWorker(StreamServiceDecodePool *decodePool, QObject *parent) : QObject(parent),
+    m_healthCheckTimer(this),
+    m_decodePool(decodePool)
+{
+    m_healthCheckTimer.setInterval(HealthCheckInterval);
+    connect(&m_healthCheckTimer, &QTimer::timeout, this, &StreamServiceIngestWorker::onHealthCheckTimeout);
+}
+
+quint64 StreamServiceIngestWorker::receivedMessageCount() const
+{
+    return m_receivedMessageCount.load(std::memory_order_relaxed);
+}
+
+quint64 StreamServiceIngestWorker::receivedBytes() const
+{
+    return m_receivedBytes.load(std::memory_order_relaxed);
+}
+
+quint64 StreamServiceIngestWorker::parseFailureCount() const
+{
+    return m_parseFailureCount.load(std::memory_order_relaxed) + m_decodePool->parseFailureCount();
+}
+
+quint64 StreamServiceIngestWorker::decodedMessageCount() const
+{
+    return m_decodedMessageCount.load(std::memory_order_relaxed) + m_decodePool->decodedMessageCount();
+}
+
+quint64 StreamServiceIngestWorker::decodeNanos() const
+{
+    return m_decodeNanos.load(std::memory_order_relaxed) + m_decodePool->decodeNanos();
+}
+
+quint64 StreamServiceIngestWorker::decodeQueueNanos() const
+{
+    return m_decodePool->decodeQueueNanos();
+}
+
+void StreamServiceIngestWorker::subscribe(const QList<QUrl> &subscribeEndpoints)
+{
+    unsubscribe();
+
+    for (const QUrl &subscribeEndpoint : subscribeEndpoints)
+    {
+        const int connectionIndex = m_connections.size();
+        StreamServiceConnection connection;
+        connection.websocket = new QWebSocket(QString(), QWebSocketProtocol::VersionLatest, this);
+        connection.endpoint = subscribeEndpoint;
+        connection.lastActivity.start();
+        connection.reconnectTimer = new QTimer(this);
+        connection.reconnectTimer->setSingleShot(true);
+        connection.binaryDecoder.setTimeInfoFields(m_trackIdField, m_startTimeField, m_endTimeField);
+        connection.binaryDecoder.setTargetWkid(m_targetWkid);
+        connection.binaryDecoder.setFieldSchema(m_fieldSchema);
+        m_connections.append(connection);
+
+        // Listen to the websocket signals
+        QWebSocket *websocket = connection.websocket;
+        connect(websocket, &QWebSocket::connected, this, [this, connectionIndex]() {
+            onConnected(connectionIndex);
+        });
+        connect(websocket, &QWebSocket::disconnected, this, [this, connectionIndex]() {
+            onDisconnected(connectionIndex);
+        });
+        connect(websocket, QOverload<QAbstractSocket::SocketError>::of(&QWebSocket::error), this, [this, connectionIndex]() {
+            // Failed opening attempts do not always signal a disconnect
+            if (QAbstractSocket::UnconnectedState == m_connections[connectionIndex].websocket->state())
+            {
+                scheduleReconnect(connectionIndex);
+            }
+        });
+        connect(websocket, &QWebSocket::binaryMessageReceived, this, [this, connectionIndex](const QByteArray &message) {
+            onBinaryMessageReceived(connectionIndex, message);
+        });
+        connect(websocket, &QWebSocket::textMessageReceived, this, [this, connectionIndex](const QString &message) {
+            onTextMessageReceived(connectionIndex, message);
+        });
+        connect(websocket, &QWebSocket::pong, this, [this, connectionIndex]() {
+            m_connections[connectionIndex].lastActivity.restart();
+        });
+        connect(connection.reconnectTimer, &QTimer::timeout, this, [this, connectionIndex]() {
+            openConnection(connectionIndex);
+        });
+
+        openConnection(connectionIndex);
+    }
+
+    if (!m_connections.isEmpty())
+    {
+        m_activeConnection = 0;
+        m_healthCheckTimer.start();
+    }
+}
+
+void StreamServiceIngestWorker::unsubscribe()
+{
+    m_healthCheckTimer.stop();
+    for (const StreamServiceConnection &connection : qAsConst(m_connections))
+    {
+        connection.websocket->disconnect(this);
+        connection.websocket->close();
+        connection.websocket->deleteLater();
+
+        // A pending reconnect would open a connection index of the next subscription
+        connection.reconnectTimer->stop();
+        connection.reconnectTimer->disconnect(this);
+        connection.reconnectTimer->deleteLater();
+    }
+    m_connections.clear();
+    m_activeConnection = -1;
+
+    // A new subscription starts without any delivered track
+    m_decodePool->resetDeduplication();
+}
+
+void StreamServiceIngestWorker::setConnectionMode(StreamServiceIngestWorker::ConnectionMode connectionMode)
+{
+    m_connectionMode = connectionMode;
+    m_decodePool->setDeduplicate(ConnectionMode::Parallel == connectionMode);
+}
+
+void StreamServiceIngestWorker::setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField)
+{
+    m_trackIdField = trackIdField;
+    m_startTimeField = startTimeField;
+    m_endTimeField = endTimeField;
+    m_decoder.setTimeInfoFields(trackIdField, startTimeField, endTimeField);
+    m_decodePool->setTimeInfoFields(trackIdField, startTimeField, endTimeField);
+    m_replayBinaryDecoder.setTimeInfoFields(trackIdField, startTimeField, endTimeField);
+    for (StreamServiceConnection &connection : m_connections)
+    {
+        connection.binaryDecoder.setTimeInfoFields(trackIdField, startTimeField, endTimeField);
+    }
+}
+
+void StreamServiceIngestWorker::setTargetWkid(int targetWkid)
+{
+    m_targetWkid = targetWkid;
+    m_decoder.setTargetWkid(targetWkid);
+    m_decodePool->setTargetWkid(targetWkid);
+    m_replayBinaryDecoder.setTargetWkid(targetWkid);
+    for (StreamServiceConnection &connection : m_connections)
+    {
+        connection.binaryDecoder.setTargetWkid(targetWkid);
+    }
+}
+
+void StreamServiceIngestWorker::setFieldSchema(const StreamServiceFieldSchema &fieldSchema)
+{
+    m_fieldSchema = fieldSchema;
+    m_decoder.setFieldSchema(fieldSchema);
+    m_decodePool->setFieldSchema(fieldSchema);
+    m_replayBinaryDecoder.setFieldSchema(fieldSchema);
+    for (StreamServiceConnection &connection : m_connections)
+    {
+        connection.binaryDecoder.setFieldSchema(fieldSchema);
+    }
+}
+
+void StreamServiceIngestWorker::setFilter(const QString &filterMessage)
+{
+    // The latest filter is also sent on every connect
+    m_filterMessage = filterMessage;
+    for (const StreamServiceConnection &connection : qAsConst(m_connections))
+    {
+        if (QAbstractSocket::ConnectedState == connection.websocket->state())
+        {
+            connection.websocket->sendTextMessage(m_filterMessage);
+        }
+    }
+}
+
+void StreamServiceIngestWorker::startRecording(const QString &captureFilePath)
+{
+    if (m_captureWriter.open(captureFilePath))
+    {
+        qDebug() << "Recording the stream to" << captureFilePath;
+    }
+}
+
+void StreamServiceIngestWorker::stopRecording()
+{
+    m_captureWriter.close();
+}
+
+void StreamServiceIngestWorker::startReplay(const QString &captureFilePath, double speed)
+{
+    if (nullptr == m_replayer)
+    {
+        m_replayer = new StreamServiceCaptureReplayer(this);
+        connect(m_replayer, &StreamServiceCaptureReplayer::messageReplayed, this, &StreamServiceIngestWorker::onMessageReplayed);
+    }
+
+    if (!m_replayer->open(captureFilePath))
+    {
+        return;
+    }
+
+    m_replayer->setSpeed(speed);
+    m_replayer->start();
+}
+
+void StreamServiceIngestWorker::stopReplay()
+{
+    if (nullptr != m_replayer)
+    {
+        m_replayer->stop();
+    }
+}
+
+void StreamServiceIngestWorker::onHealthCheckTimeout()
+{
+    for (const StreamServiceConnection &connection : qAsConst(m_connections))
+    {
+        if (QAbstractSocket::ConnectedState == connection.websocket->state())
+        {
+            connection.websocket->ping();
+        }
+    }
+
+    if (ConnectionMode::Failover != m_connectionMode || isHealthy(m_activeConnection))
+    {
+        return;
+    }
+
+    // Prefer the next healthy standby, so that the endpoints are used round robin
+    for (int offset = 1; offset < m_connections.size(); offset++)
+    {
+        const int connectionIndex = (m_activeConnection + offset) % m_connections.size();
+        if (isHealthy(connectionIndex))
+        {
+            activateConnection(connectionIndex);
+            return;
+        }
+    }
+}
+
+void StreamServiceIngestWorker::onConnected(int connectionIndex)
+{
+    StreamServiceConnection &connection = m_connections[connectionIndex];
+    qDebug() << "Websocket connected..." << connection.endpoint.toString();
+    connection.lastActivity.restart();
+    connection.reconnectAttempt = 0;
+    if (connection.disconnectedSince.isValid())
+    {
+        connection.disconnectDuration = connection.disconnectedSince.elapsed();
+        connection.disconnectedSince.invalidate();
+    }
+    if (!m_filterMessage.isEmpty())
+    {
+        connection.websocket->sendTextMessage(m_filterMessage);
+    }
+}
+
+void StreamServiceIngestWorker::onDisconnected(int connectionIndex)
+{
+    qDebug() << "Websocket disconnected..." << m_connections[connectionIndex].endpoint.toString();
+    scheduleReconnect(connectionIndex);
+    if (ConnectionMode::Failover == m_connectionMode && connectionIndex == m_activeConnection)
+    {
+        onHealthCheckTimeout();
+    }
+}
+
+void StreamServiceIngestWorker::openConnection(int connectionIndex)
+{
+    // Offer the binary encoding, servers not supporting it keep sending Esri JSON
+    const StreamServiceConnection &connection = m_connections[connectionIndex];
+    QNetworkRequest subscribeRequest(connection.endpoint);
+    subscribeRequest.setRawHeader(StreamServiceBinaryCodec::EncodingHeader, StreamServiceBinaryCodec::EncodingName);
+    connection.websocket->open(subscribeRequest);
+}
+
+void StreamServiceIngestWorker::scheduleReconnect(int connectionIndex)
+{
+    StreamServiceConnection &connection = m_connections[connectionIndex];
+    if (connection.reconnectTimer->isActive())
+    {
+        return;
+    }
+
+    if (!connection.disconnectedSince.isValid())
+    {
+        connection.disconnectedSince.start();
+    }
+
+    // Full jitter over the upper half keeps many clients from reconnecting in lockstep
+    const int attempt = qMin(connection.reconnectAttempt, 16);
+    const int delay = static_cast<int>(qMin(qint64(ReconnectMaximumDelay), qint64(ReconnectBaseDelay) << attempt));
+    const int jitteredDelay = delay / 2 + static_cast<int>(QRandomGenerator::global()->bounded(delay / 2 + 1));
+    connection.reconnectAttempt++;
+    connection.reconnectTimer->start(jitteredDelay);
+    qDebug() << "Reconnecting to" << connection.endpoint.toString() << "in" << jitteredDelay << "ms";
+}
+
+void StreamServiceIngestWorker::onBinaryMessageReceived(int connectionIndex, const QByteArray &message)
+{
+    STREAMSERVICE_TRACE_SCOPE("receive");
+    const qint64 receiveTime = StreamServiceTrackUpdate::currentReceiveTime();
+
+    // Standby connections still follow the schema, the features are dropped
+    StreamServiceBinaryDecoder &binaryDecoder = m_connections[connectionIndex].binaryDecoder;
+    if (!acceptMessage(connectionIndex))
+    {
+        if (1 < message.size() && static_cast<quint8>(StreamServiceBinaryCodec::FrameType::Schema) == static_cast<quint8>(message.at(1)))
+        {
+            m_binaryUpdates.clear();
+            binaryDecoder.decode(message, m_binaryUpdates);
+        }
+        return;
+    }
+
+    if (m_captureWriter.isOpen())
+    {
+        m_captureWriter.append(StreamServiceCapture::MessageType::Binary, message);
+    }
+    decodeBinaryMessage(binaryDecoder, message, receiveTime);
+}
+
+void StreamServiceIngestWorker::onTextMessageReceived(int connectionIndex, const QString &message)
+{
+    STREAMSERVICE_TRACE_SCOPE("receive");
+    const qint64 receiveTime = StreamServiceTrackUpdate::currentReceiveTime();
+    if (handleControlMessage(message) || !acceptMessage(connectionIndex))
+    {
+        return;
+    }
+
+    // We expect UTF-8 encoded messages here
+    const QByteArray utf8Message = message.toUtf8();
+    if (m_captureWriter.isOpen())
+    {
+        m_captureWriter.append(StreamServiceCapture::MessageType::Text, utf8Message);
+    }
+    decodeTextMessage(utf8Message, receiveTime);
+}
+
+void StreamServiceIngestWorker::onMessageReplayed(StreamServiceCapture::MessageType type, const QByteArray &payload)
+{
+    STREAMSERVICE_TRACE_SCOPE("replay");
+    const qint64 receiveTime = StreamServiceTrackUpdate::currentReceiveTime();
+    if (StreamServiceCapture::MessageType::Binary == type)
+    {
+        decodeBinaryMessage(m_replayBinaryDecoder, payload, receiveTime);
+        return;
+    }
+
+    // The payload points into the mapped capture, which may be unmapped before the pool decodes the copy
+    decodeTextMessage(QByteArray(payload.constData(), payload.size()), receiveTime);
+}
+
+void StreamServiceIngestWorker::decodeTextMessage(const QByteArray &message, qint64 receiveTime)
+{
+    STREAMSERVICE_TRACE_SCOPE("partition");
+    recordReceive(message.size());
+    if (decodeExpiredMessage(message, receiveTime))
+    {
+        return;
+    }
+
+    // The partition must follow the decoded track id, so that the pool keeps the order of every track
+    QString trackId;
+    if (StreamServiceFeatureDecoder::TrackIdPeek::Ambiguous != m_decoder.peekTrackId(message, trackId))
+    {
+        m_decodePool->pushMessage(message, trackId, receiveTime);
+        return;
+    }
+
+    // Rare layouts are decoded here and partitioned by the decoded track id
+    StreamServiceTrackUpdate update;
+    const qint64 decodeStartTime = StreamServiceTrackUpdate::currentReceiveTime();
+    const bool decoded = m_decoder.decode(message, update);
+    recordDecode(decodeStartTime, decoded);
+    if (decoded)
+    {
+        update.receiveTime = receiveTime;
+        m_decodePool->pushUpdate(std::move(update), qHash(message));
+    }
+}
+
+bool StreamServiceIngestWorker::decodeExpiredMessage(const QByteArray &message, qint64 receiveTime)
+{
+    // Announcements of a fan-out are tiny compared to features, only the start of the message is checked
+    if (!message.left(32).trimmed().startsWith("{\"expired\""))
+    {
+        return false;
+    }
+
+    // Every removal takes the shard of its track, so that it follows the last update of the track
+    const QJsonArray trackIdsArray = QJsonDocument::fromJson(message).object().value(QStringLiteral("expired")).toObject().value(QStringLiteral("trackIds")).toArray();
+    const uint contentHash = qHash(message);
+    for (auto const &trackIdValue : trackIdsArray)
+    {
+        StreamServiceTrackUpdate update;
+        update.trackId = trackIdValue.toString();
+        if (update.trackId.isEmpty())
+        {
+            continue;
+        }
+
+        update.trackIdHash = StreamServiceTrackTable::hashTrackId(update.trackId);
+        update.expired = true;
+        update.receiveTime = receiveTime;
+        m_decodePool->pushUpdate(std::move(update), contentHash);
+    }
+    return true;
+}
+
+void StreamServiceIngestWorker::decodeBinaryMessage(StreamServiceBinaryDecoder &binaryDecoder, const QByteArray &message, qint64 receiveTime)
+{
+    STREAMSERVICE_TRACE_SCOPE("decode");
+    // Features decoded in front of a malformed part are still delivered
+    m_binaryUpdates.clear();
+    recordReceive(message.size());
+    const qint64 decodeStartTime = StreamServiceTrackUpdate::currentReceiveTime();
+    const bool decoded = binaryDecoder.decode(message, m_binaryUpdates);
+    recordDecode(decodeStartTime, decoded);
+
+    // Parallel connections relay the same frames, updates without a time are told apart by their frame
+    const uint contentHash = m_binaryUpdates.isEmpty() ? 0 : qHash(message);
+    for (auto &update : m_binaryUpdates)
+    {
+        update.receiveTime = receiveTime;
+        m_decodePool->pushUpdate(std::move(update), contentHash);
+    }
+    m_binaryUpdates.clear();
+}
+
+void StreamServiceIngestWorker::recordReceive(int messageBytes)
+{
+    StreamServiceCounters::increment(m_receivedMessageCount, 1);
+    StreamServiceCounters::increment(m_receivedBytes, static_cast<quint64>(messageBytes));
+}
+
+void StreamServiceIngestWorker::recordDecode(qint64 decodeStartTime, bool decoded)
+{
+    // Only the ingest thread writes, readers may see the counters slightly apart
+    if (!decoded)
+    {
+        StreamServiceCounters::increment(m_parseFailureCount, 1);
+    }
+    StreamServiceCounters::increment(m_decodedMessageCount, 1);
+    StreamServiceCounters::increment(m_decodeNanos, static_cast<quint64>(StreamServiceTrackUpdate::currentReceiveTime() - decodeStartTime));
+}
+
+bool StreamServiceIngestWorker::acceptMessage(int connectionIndex)
+{
+    StreamServiceConnection &connection = m_connections[connectionIndex];
+    connection.lastActivity.restart();
+
+    // The gap lasts from the last message in front of the disconnect up to the first one after it
+    if (0 <= connection.disconnectDuration)
+    {
+        const qint64 gapDuration = connection.lastMessage.isValid() ? connection.lastMessage.elapsed() : connection.disconnectDuration;
+        qDebug() << "Stream resumed after" << connection.disconnectDuration << "ms disconnected," << gapDuration << "ms without messages";
+        emit connectionRestored(connection.endpoint, connection.disconnectDuration, gapDuration);
+        connection.disconnectDuration = -1;
+    }
+    connection.lastMessage.start();
+
+    // Standby connections are kept alive, but their messages are not decoded
+    return ConnectionMode::Parallel == m_connectionMode || connectionIndex == m_activeConnection;
+}
+
+bool StreamServiceIngestWorker::isHealthy(int connectionIndex) const
+{
+    if (connectionIndex < 0 || m_connections.size() <= connectionIndex)
+    {
+        return false;
+    }
+
+    const StreamServiceConnection &connection = m_connections[connectionIndex];
+    return QAbstractSocket::ConnectedState == connection.websocket->state()
+            && !connection.lastActivity.hasExpired(HealthTimeout);
+}
+
+void StreamServiceIngestWorker::activateConnection(int connectionIndex)
+{
+    qDebug() << "Failing over to" << m_connections[connectionIndex].endpoint.toString();
+    m_activeConnection = connectionIndex;
+}
+
+bool StreamServiceIngestWorker::handleControlMessage(const QString &message)
+{
+    // Filter replies are tiny compared to features, only the start of the message is checked
+    const QStringRef messageStart = message.leftRef(32).trimmed();
+    if (messageStart.startsWith(QLatin1String("{\"filter\"")))
+    {
+        qDebug() << "Stream service filter applied";
+        return true;
+    }
+
+    if (messageStart.startsWith(QLatin1String("{\"error\"")))
+    {
+        qWarning() << "Stream service rejected the request:" << message;
+        return true;
+    }
+
+    return false;
+}
@@ -0,0 +1,159 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEINGESTWORKER_H
+#define STREAMSERVICEINGESTWORKER_H
+
+#include "StreamServiceBinaryCodec.h"
+#include "StreamServiceCapture.h"
+#include "StreamServiceDecodePool.h"
+#include "StreamServiceFeatureDecoder.h"
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceTrackUpdate.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+#include <QWebSocket>
+
+#include <atomic>
+
+class StreamServiceCaptureReplayer;
+
+struct StreamServiceConnection
+{
+    QWebSocket *websocket = nullptr;
+    QUrl endpoint;
+    QElapsedTimer lastActivity;
+
+    // Reconnect state, the durations are measured on reconnect and reported with the first message
+    QTimer *reconnectTimer = nullptr;
+    int reconnectAttempt = 0;
+    QElapsedTimer disconnectedSince;
+    QElapsedTimer lastMessage;
+    qint64 disconnectDuration = -1;
+
+    // Binary schemas are negotiated per connection
+    StreamServiceBinaryDecoder binaryDecoder;
+};
+
+///
+/// \brief The StreamServiceIngestWorker class
+/// Lives on the ingest thread, owns the websockets and hands every message over to the decode pool.
+/// Text messages are partitioned by their track id and decoded by the pool.
+/// Binary frames depend on the frames in front of them, they are decoded here and partitioned afterwards.
+///
+/// Using failover, every endpoint is connected but only the messages of the active one are decoded.
+/// The active connection is replaced by a healthy standby when it disconnects or stops answering pings.
+/// Using parallel ingest, the messages of all endpoints are decoded and duplicates are dropped per track.
+/// Lost connections are reopened using a jittered exponential backoff until unsubscribe is called.
+/// The decoded messages can be recorded to a capture file, a replayed capture takes the same decode path.
+///
+class StreamServiceIngestWorker : public QObject
+{
+    Q_OBJECT
+public:
+    enum class ConnectionMode
+    {
+        Failover,
+        Parallel
+    };
+
+    explicit StreamServiceIngestWorker(StreamServiceDecodePool *decodePool, QObject *parent = nullptr);
+
+    // Thread-safe counters including the decode pool, the queue time is spent by text messages waiting for a decode thread
+    quint64 receivedMessageCount() const;
+    quint64 receivedBytes() const;
+    quint64 parseFailureCount() const;
+    quint64 decodedMessageCount() const;
+    quint64 decodeNanos() const;
+    quint64 decodeQueueNanos() const;
+
+public slots:
+    void subscribe(const QList<QUrl> &subscribeEndpoints);
+    void unsubscribe();
+    void setConnectionMode(StreamServiceIngestWorker::ConnectionMode connectionMode);
+    void setTimeInfoFields(const QString &trackIdField, const QString &startTimeField, const QString &endTimeField);
+    void setTargetWkid(int targetWkid);
+    void setFieldSchema(const StreamServiceFieldSchema &fieldSchema);
+    void setFilter(const QString &filterMessage);
+
+    void startRecording(const QString &captureFilePath);
+    void stopRecording();
+    void startReplay(const QString &captureFilePath, double speed);
+    void stopReplay();
+
+signals:
+    void connectionRestored(const QUrl &endpoint, qint64 disconnectDuration, qint64 gapDuration);
+
+private slots:
+    void onHealthCheckTimeout();
+
+private:
+    void onConnected(int connectionIndex);
+    void onDisconnected(int connectionIndex);
+    void onBinaryMessageReceived(int connectionIndex, const QByteArray &message);
+    void onTextMessageReceived(int connectionIndex, const QString &message);
+
+    void openConnection(int connectionIndex);
+    void scheduleReconnect(int connectionIndex);
+    bool acceptMessage(int connectionIndex);
+    bool isHealthy(int connectionIndex) const;
+    void activateConnection(int connectionIndex);
+    void onMessageReplayed(StreamServiceCapture::MessageType type, const QByteArray &payload);
+    void decodeTextMessage(const QByteArray &message, qint64 receiveTime);
+    bool decodeExpiredMessage(const QByteArray &message, qint64 receiveTime);
+    void decodeBinaryMessage(StreamServiceBinaryDecoder &binaryDecoder, const QByteArray &message, qint64 receiveTime);
+    void recordReceive(int messageBytes);
+    void recordDecode(qint64 decodeStartTime, bool decoded);
+    bool handleControlMessage(const QString &message);
+
+    QVector<StreamServiceConnection> m_connections;
+    int m_activeConnection = -1;
+    ConnectionMode m_connectionMode = ConnectionMode::Failover;
+    QTimer m_healthCheckTimer;
+    StreamServiceFeatureDecoder m_decoder;
+    QString m_trackIdField;
+    QString m_startTimeField;
+    QString m_endTimeField;
+    int m_targetWkid = 0;
+    StreamServiceFieldSchema m_fieldSchema;
+    QVector<StreamServiceTrackUpdate> m_binaryUpdates;
+    StreamServiceDecodePool *m_decodePool;
+    QString m_filterMessage;
+    StreamServiceCaptureWriter m_captureWriter;
+    StreamServiceCaptureReplayer *m_replayer = nullptr;
+    StreamServiceBinaryDecoder m_replayBinaryDecoder;
+    std::atomic<quint64> m_receivedMessageCount{0};
+    std::atomic<quint64> m_receivedBytes{0};
+    std::atomic<quint64> m_parseFailureCount{0};
+    std::atomic<quint64> m_decodedMessageCount{0};
+    std::atomic<quint64> m_decodeNanos{0};
+};
+
+#endif // STREAMSERVICEINGESTWORKER_H
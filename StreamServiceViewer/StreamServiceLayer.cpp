@@ -25,39 +25,171 @@
 
 #include "StreamServiceLayer.h"
 #include "StreamServiceLayerTimeInfo.h"
+#include "StreamServiceTrace.h"
 
+#include "AttributeListModel.h"
+#include "Envelope.h"
 #include "Feature.h"
 #include "Geometry.h"
 #include "GeometryEngine.h"
 #include "Graphic.h"
 #include "GraphicListModel.h"
+#include "Point.h"
+#include "PolylineBuilder.h"
 
 #include <QJsonDocument>
 #include <QJsonObject>
 
+#include <cmath>
+
 using namespace Esri::ArcGISRuntime;
 
-StreamServiceLayer::StreamServiceLayer(const QUrl &webSocketEndpoint, QObject *parent) : QObject(parent),
-    m_webSocketEndpoint(webSocketEndpoint)
+namespace
+{
+// Cell sizes of the spatial index for geographic and projected coordinates
+const double GeographicCellSize = 0.05;
+const double ProjectedCellSize = 5000.0;
+
+// Number of density cells across the visible extent and the weakest visible density in relation to the strongest one
+const int MaximumDensityColumns = 128;
+const float MinimumDensityRatio = 1.0f / 255.0f;
+
+// Merges the delta into the stored attributes and returns the number of changed fields
+int mergeAttributeDelta(QVariantMap &storedAttributes, const QVariantMap &attributes, QString &changedKey)
+{
+    int changedCount = 0;
+    for (auto attributeIterator = attributes.cbegin(); attributeIterator != attributes.cend(); ++attributeIterator)
+    {
+        auto storedIterator = storedAttributes.constFind(attributeIterator.key());
+        if (storedIterator != storedAttributes.cend() && storedIterator.value() == attributeIterator.value())
+        {
+            continue;
+        }
+
+        storedAttributes.insert(attributeIterator.key(), attributeIterator.value());
+        changedKey = attributeIterator.key();
+        changedCount++;
+    }
+    return changedCount;
+}
+
+void applyChangedAttribute(AttributeListModel *attributeModel, const QString &changedKey, const QVariant &changedValue)
+{
+    if (attributeModel->containsAttribute(changedKey))
+    {
+        attributeModel->replaceAttribute(changedKey, changedValue);
+    }
+    else
+    {
+        attributeModel->insertAttribute(changedKey, changedValue);
+    }
+}
+}
+
+StreamServiceLayer::StreamServiceLayer(const QList<QUrl> &webSocketEndpoints, QObject *parent) : QObject(parent),
+    m_ingestWorker(m_ingestPipeline.worker()),
+    m_webSocketEndpoints(webSocketEndpoints)
+{
+    connect(&m_ingestPipeline.decodePool(), &StreamServiceDecodePool::updatesAvailable, this, &StreamServiceLayer::onUpdatesAvailable, Qt::QueuedConnection);
+    connect(m_ingestWorker, &StreamServiceIngestWorker::connectionRestored, this, &StreamServiceLayer::onConnectionRestored, Qt::QueuedConnection);
+
+    // Staged updates are committed at most once per display frame
+    m_commitTimer.setSingleShot(true);
+    m_commitTimer.setTimerType(Qt::PreciseTimer);
+    m_commitTimer.setInterval(16);
+    connect(&m_commitTimer, &QTimer::timeout, this, &StreamServiceLayer::commitStagedUpdates);
+
+    // Stale tracks are expired once per tick
+    m_expiryTimer.setInterval(StreamServiceTrackClock::TickInterval);
+    connect(&m_expiryTimer, &QTimer::timeout, this, &StreamServiceLayer::onExpiryTimeout);
+
+    connect(&m_snapshotTimer, &QTimer::timeout, this, &StreamServiceLayer::writeSnapshot);
+}
+
+StreamServiceLayer::~StreamServiceLayer()
 {
-    // Listen to the websocket signals
-    connect(&m_websocket, &QWebSocket::connected, this, &StreamServiceLayer::onConnected);
-    connect(&m_websocket, &QWebSocket::disconnected, this, &StreamServiceLayer::onDisconnected);
-    connect(&m_websocket, &QWebSocket::binaryMessageReceived, this, &StreamServiceLayer::onBinaryMessageReceived);
-    connect(&m_websocket, &QWebSocket::textMessageReceived, this, &StreamServiceLayer::onTextMessageReceived);
+    // The last picture is kept for the next start
+    if (m_snapshot.isOpen())
+    {
+        writeSnapshot();
+    }
 }
 
 void StreamServiceLayer::subscribe()
 {
-    // Open the public accessible websocket
-    QUrl subscribeEndpoint(m_webSocketEndpoint);
-    subscribeEndpoint.setPath(subscribeEndpoint.path() + QStringLiteral("/subscribe"));
-    m_websocket.open(subscribeEndpoint);
+    // The decode threads are started once, the ingest worker only pushes after this
+    m_ingestPipeline.start(m_decodeThreadCount);
+
+    if (!m_replayCaptureFilePath.isEmpty())
+    {
+        const QString captureFilePath = m_replayCaptureFilePath;
+        const double speed = m_replaySpeed;
+        QMetaObject::invokeMethod(m_ingestWorker, [this, captureFilePath, speed]() {
+            m_ingestWorker->startReplay(captureFilePath, speed);
+        }, Qt::QueuedConnection);
+        return;
+    }
+
+    // Open the public accessible websockets
+    QList<QUrl> subscribeEndpoints;
+    for (const QUrl &webSocketEndpoint : qAsConst(m_webSocketEndpoints))
+    {
+        QUrl subscribeEndpoint(webSocketEndpoint);
+        subscribeEndpoint.setPath(subscribeEndpoint.path() + QStringLiteral("/subscribe"));
+        subscribeEndpoints.append(subscribeEndpoint);
+    }
+
+    QMetaObject::invokeMethod(m_ingestWorker, [this, subscribeEndpoints]() {
+        m_ingestWorker->subscribe(subscribeEndpoints);
+    }, Qt::QueuedConnection);
 }
 
 void StreamServiceLayer::unsubscribe()
 {
-    m_websocket.close();
+    QMetaObject::invokeMethod(m_ingestWorker, &StreamServiceIngestWorker::unsubscribe, Qt::QueuedConnection);
+    QMetaObject::invokeMethod(m_ingestWorker, &StreamServiceIngestWorker::stopReplay, Qt::QueuedConnection);
+}
+
+void StreamServiceLayer::startRecording(const QString &captureFilePath)
+{
+    QMetaObject::invokeMethod(m_ingestWorker, [this, captureFilePath]() {
+        m_ingestWorker->startRecording(captureFilePath);
+    }, Qt::QueuedConnection);
+}
+
+void StreamServiceLayer::stopRecording()
+{
+    QMetaObject::invokeMethod(m_ingestWorker, &StreamServiceIngestWorker::stopRecording, Qt::QueuedConnection);
+}
+
+void StreamServiceLayer::setReplayCapture(const QString &captureFilePath, double speed)
+{
+    m_replayCaptureFilePath = captureFilePath;
+    m_replaySpeed = speed;
+}
+
+int StreamServiceLayer::decodeThreadCount() const
+{
+    const StreamServiceDecodePool &decodePool = m_ingestPipeline.decodePool();
+    return decodePool.isRunning() ? decodePool.threadCount() : m_decodeThreadCount;
+}
+
+void StreamServiceLayer::setDecodeThreadCount(int threadCount)
+{
+    m_decodeThreadCount = threadCount;
+}
+
+StreamServiceIngestWorker::ConnectionMode StreamServiceLayer::connectionMode() const
+{
+    return m_connectionMode;
+}
+
+void StreamServiceLayer::setConnectionMode(StreamServiceIngestWorker::ConnectionMode connectionMode)
+{
+    m_connectionMode = connectionMode;
+    QMetaObject::invokeMethod(m_ingestWorker, [this, connectionMode]() {
+        m_ingestWorker->setConnectionMode(connectionMode);
+    }, Qt::QueuedConnection);
 }
 
 void StreamServiceLayer::setGraphicsModel(Esri::ArcGISRuntime::GraphicListModel *graphicsModel)
@@ -65,179 +197,1228 @@ void StreamServiceLayer::setGraphicsModel(Esri::ArcGISRuntime::GraphicListModel
     m_graphicsModel = graphicsModel;
 }
 
+void StreamServiceLayer::setTrailGraphicsModel(GraphicListModel *trailGraphicsModel)
+{
+    m_trailGraphicsModel = trailGraphicsModel;
+}
+
+void StreamServiceLayer::setHistoryGraphicsModel(GraphicListModel *historyGraphicsModel)
+{
+    m_historyGraphicsModel = historyGraphicsModel;
+}
+
 void StreamServiceLayer::setTimeInfo(StreamServiceLayerTimeInfo *timeInfo)
 {
     m_timeInfo = timeInfo;
+    if (nullptr != m_timeInfo)
+    {
+        setTrackTimeToLive(m_timeInfo->trackTimeToLive());
+    }
+
+    // The ingest thread only gets copies of the field names
+    QString trackIdField, startTimeField, endTimeField;
+    if (nullptr != m_timeInfo)
+    {
+        trackIdField = m_timeInfo->trackIdField();
+        startTimeField = m_timeInfo->startTimeField();
+        endTimeField = m_timeInfo->endTimeField();
+    }
+
+    QMetaObject::invokeMethod(m_ingestWorker, [this, trackIdField, startTimeField, endTimeField]() {
+        m_ingestWorker->setTimeInfoFields(trackIdField, startTimeField, endTimeField);
+    }, Qt::QueuedConnection);
+
+    // Restricted out fields must contain the time info fields
+    if (!m_outFields.isEmpty())
+    {
+        updateFilter();
+    }
 }
 
-void StreamServiceLayer::onConnected()
+void StreamServiceLayer::setFieldSchema(const StreamServiceFieldSchema &fieldSchema)
 {
-    qDebug() << "Websocket connected...";
+    // Tracks committed using the previous schema keep their graphic attributes
+    m_attributeColumns.setSchema(fieldSchema);
+    m_densityWeightSlot = m_densityWeightField.isEmpty() ? -1 : fieldSchema.slot(m_densityWeightField);
+    QMetaObject::invokeMethod(m_ingestWorker, [this, fieldSchema]() {
+        m_ingestWorker->setFieldSchema(fieldSchema);
+    }, Qt::QueuedConnection);
 }
 
-void StreamServiceLayer::onDisconnected()
+void StreamServiceLayer::setSnapshotFile(const QString &filePath, const QString &source, int intervalMsecs)
 {
-    qDebug() << "Websocket disconnected...";
+    m_snapshotTimer.stop();
+    m_snapshot.close();
+    if (filePath.isEmpty() || intervalMsecs <= 0 || !m_snapshot.open(filePath, source))
+    {
+        return;
+    }
+
+    m_snapshotTimer.start(intervalMsecs);
 }
 
-void StreamServiceLayer::onBinaryMessageReceived(const QByteArray &message)
+int StreamServiceLayer::restoreSnapshot(const QString &filePath, const QString &source, qint64 maximumAge)
 {
-    qDebug() << "Websocket binary message received...";
+    int wkid = 0;
+    QVector<StreamServiceSnapshotTrack> snapshotTracks;
+    if (nullptr == m_graphicsModel || !StreamServiceSnapshot::read(filePath, source, maximumAge, wkid, snapshotTracks))
+    {
+        return 0;
+    }
+
+    // Restored into the live tracks only, the last known positions are neither history nor trails nor part of the time extent
+    const SpatialReference spatialReference(wkid);
+    const StreamServiceFieldSchema &fieldSchema = m_attributeColumns.schema();
+    int restoredTrackCount = 0;
+    for (StreamServiceSnapshotTrack &snapshotTrack : snapshotTracks)
+    {
+        if (snapshotTrack.trackId.isEmpty())
+        {
+            continue;
+        }
+
+        StreamServiceTrackUpdate update;
+        update.geometry = Point(snapshotTrack.x, snapshotTrack.y, spatialReference);
+        update.trackId = snapshotTrack.trackId;
+        update.trackIdHash = StreamServiceTrackTable::hashTrackId(update.trackId);
+        update.attributes = snapshotTrack.attributes;
+        if (!fieldSchema.isEmpty())
+        {
+            fieldSchema.splitVariantMap(update.attributes, update.attributeRow);
+        }
+
+        // Live observations older than the restored one are dropped like replays
+        internTrack(update);
+        if (0 < snapshotTrack.time)
+        {
+            update.startTime = QDateTime::fromMSecsSinceEpoch(snapshotTrack.time);
+            m_trackClock.setLatestTime(update.trackHandle, snapshotTrack.time);
+        }
+        applyUpdate(update);
+        restoredTrackCount++;
+    }
+    evictTracks();
+    return restoredTrackCount;
 }
 
-void StreamServiceLayer::onTextMessageReceived(const QString &message)
+void StreamServiceLayer::writeSnapshot()
 {
-    //qDebug() << "Websocket text message received...";
-    //qDebug() << message;
-
-    // We expect UTF-8 encoded messages here
-    QJsonDocument featureDocument = QJsonDocument::fromJson(message.toUtf8());
-    if (featureDocument.isNull())
+    STREAMSERVICE_TRACE_SCOPE("snapshot");
+    if (m_pointSpatialReference.isEmpty())
     {
-        qDebug() << "Unsupported text message received!";
         return;
     }
 
-    if (!featureDocument.isObject())
+    // The stored attributes are used, the graphics are only asked for their position
+    m_snapshot.begin(m_pointSpatialReference.wkid());
+
+    // The typed columns are written as they are, their names are registered once
+    const StreamServiceFieldSchema &fieldSchema = m_attributeColumns.schema();
+    QVector<int> columnKeyIndices(fieldSchema.fieldCount());
+    for (int slot = 0; slot < columnKeyIndices.size(); slot++)
     {
-        qDebug() << "Text message does not represent an object!";
-        return;
+        columnKeyIndices[slot] = m_snapshot.keyIndex(fieldSchema.field(slot).name);
     }
 
-    auto const geometryKey = "geometry";
-    QJsonObject featureObject = featureDocument.object();
-    if (!featureObject.contains(geometryKey))
+    for (int handleIndex = 0; handleIndex < m_trackGraphics.size(); handleIndex++)
     {
-        qDebug() << "Text message does not represent a feature having a geometry!";
-        return;
+        Graphic *trackGraphic = m_trackGraphics[handleIndex];
+        if (nullptr == trackGraphic || GeometryType::Point != trackGraphic->geometry().geometryType())
+        {
+            continue;
+        }
+
+        // Column values follow the other attributes, so they win over a mistyped value of the same name
+        const Point position(trackGraphic->geometry());
+        m_snapshot.beginTrack(m_trackTable.trackId(static_cast<quint32>(handleIndex)), position.x(), position.y(), m_trackClock.latestTime(static_cast<quint32>(handleIndex)));
+        m_snapshot.appendAttributes(m_trackAttributes[handleIndex]);
+        for (int slot = 0; slot < columnKeyIndices.size(); slot++)
+        {
+            m_snapshot.appendAttribute(columnKeyIndices[slot], fieldSchema.field(slot).type, m_attributeColumns.typedValue(handleIndex, slot));
+        }
+        m_snapshot.endTrack();
     }
+    m_snapshot.commit();
+}
+
+void StreamServiceLayer::setTargetSpatialReference(const SpatialReference &spatialReference)
+{
+    const int targetWkid = spatialReference.isEmpty() ? 0 : spatialReference.wkid();
+    QMetaObject::invokeMethod(m_ingestWorker, [this, targetWkid]() {
+        m_ingestWorker->setTargetWkid(targetWkid);
+    }, Qt::QueuedConnection);
+}
+
+Envelope StreamServiceLayer::filterExtent() const
+{
+    return m_filterExtent;
+}
+
+void StreamServiceLayer::setFilterExtent(const Envelope &extent)
+{
+    m_filterExtent = extent;
+    updateFilter();
+}
+
+QString StreamServiceLayer::whereClause() const
+{
+    return m_whereClause;
+}
+
+void StreamServiceLayer::setWhereClause(const QString &whereClause)
+{
+    m_whereClause = whereClause;
+    updateFilter();
+}
+
+QStringList StreamServiceLayer::outFields() const
+{
+    return m_outFields;
+}
+
+void StreamServiceLayer::setOutFields(const QStringList &outFields)
+{
+    m_outFields = outFields;
+    updateFilter();
+}
+
+int StreamServiceLayer::commitInterval() const
+{
+    return m_commitTimer.interval();
+}
+
+void StreamServiceLayer::setCommitInterval(int msecs)
+{
+    m_commitTimer.setInterval(qMax(0, msecs));
+}
+
+qint64 StreamServiceLayer::trackTimeToLive() const
+{
+    return m_trackClock.timeToLive();
+}
 
-    // Obtain the geometry object
-    QJsonValue geometryValue = featureObject.value(geometryKey);
-    if (!geometryValue.isObject())
+void StreamServiceLayer::setTrackTimeToLive(qint64 msecs)
+{
+    m_trackClock.setTimeToLive(msecs);
+    m_ingestPipeline.decodePool().setDeduplicationRetention(m_trackClock.timeToLive());
+    if (0 == m_trackClock.timeToLive())
     {
-        qDebug() << "Text message does not represent a feature having a geometry object!";
+        // Existing graphics live forever
+        m_expiryTimer.stop();
+        m_untrackedGraphics.clear();
         return;
     }
 
-    // Parse the geometry object
-    QJsonObject geometryObject = geometryValue.toObject();
-    QJsonDocument geometryDocument(geometryObject);
-    Geometry constructedGeometry = Geometry::fromJson(geometryDocument.toJson());
-    if (constructedGeometry.isEmpty())
+    if (!m_expiryTimer.isActive())
     {
-        qDebug() << "Text message does not represent a feature having a valid geometry!";
-        return;
+        m_expiryTimer.start();
     }
+}
 
-    if (nullptr == m_graphicsModel)
+int StreamServiceLayer::maximumTrackCount() const
+{
+    return m_maximumTrackCount;
+}
+
+void StreamServiceLayer::setMaximumTrackCount(int maximumTrackCount)
+{
+    m_maximumTrackCount = qMax(0, maximumTrackCount);
+    evictTracks();
+}
+
+qint64 StreamServiceLayer::memoryBudget() const
+{
+    return m_memoryBudget;
+}
+
+void StreamServiceLayer::setMemoryBudget(qint64 bytes)
+{
+    m_memoryBudget = qMax(qint64(0), bytes);
+    evictTracks();
+}
+
+int StreamServiceLayer::graphicPoolCapacity() const
+{
+    return m_graphicPoolCapacity;
+}
+
+void StreamServiceLayer::setGraphicPoolCapacity(int capacity)
+{
+    m_graphicPoolCapacity = qMax(0, capacity);
+    while (m_graphicPoolCapacity < m_graphicPool.size())
     {
-        return;
+        removeGraphic(m_graphicPool.takeLast());
     }
+}
 
-    QVariantMap attributes;
-    QString trackId;
-    QDateTime startTime, endTime;
-    auto const attributesKey = "attributes";
-    if (featureObject.contains(attributesKey))
+int StreamServiceLayer::trackCount() const
+{
+    return m_trackRecency.size();
+}
+
+int StreamServiceLayer::trailLength() const
+{
+    return m_trailStore.trailLength();
+}
+
+void StreamServiceLayer::setTrailLength(int trailLength)
+{
+    m_trailStore.setTrailLength(trailLength);
+    for (Graphic *trailGraphic : qAsConst(m_trailGraphics))
     {
-        // Obtain the attributes object
-        QJsonValue attributesValue = featureObject.value(attributesKey);
-        if (attributesValue.isObject())
+        if (nullptr != trailGraphic)
         {
-            QJsonObject attributesObject = attributesValue.toObject();
-            attributes = attributesObject.toVariantMap();
+            trailGraphic->setVisible(false);
+        }
+    }
+}
 
-            // Parse the attributes
-            if (nullptr != m_timeInfo)
-            {
-                // Track id
-                QString trackIdField = m_timeInfo->trackIdField();
-                if (attributes.contains(trackIdField))
-                {
-                    trackId = attributes.value(trackIdField).toString();
-                }
-
-                // Start time
-                QString startTimeField = m_timeInfo->startTimeField();
-                if (attributes.contains(startTimeField))
-                {
-                    auto unixTimestamp = attributes.value(startTimeField).toLongLong();
-                    startTime.setTime_t(unixTimestamp);
-                    if (m_timeExtent.startTime().isNull() || startTime < m_timeExtent.startTime())
-                    {
-                        if (m_timeExtent.endTime().isNull())
-                        {
-                            m_timeExtent = TimeExtent(startTime);
-                        }
-                        else
-                        {
-                            m_timeExtent = TimeExtent(startTime, m_timeExtent.endTime());
-                        }
-                        //qDebug() << m_timeExtent.startTime() << "-" << m_timeExtent.endTime();
-                    }
-
-                    // Start time is greather than end time e.g. for instant times where no end time field is defined
-                    if (m_timeExtent.endTime().isNull() || m_timeExtent.endTime() < startTime)
-                    {
-                        m_timeExtent = TimeExtent(m_timeExtent.startTime(), startTime);
-                        //qDebug() << m_timeExtent.startTime() << "-" << m_timeExtent.endTime();
-                    }
-                }
-
-                // End time
-                QString endTimeField = m_timeInfo->endTimeField();
-                if (attributes.contains(endTimeField))
-                {
-                    auto unixTimestamp = attributes.value(endTimeField).toLongLong();
-                    endTime.setTime_t(unixTimestamp);
-                    if (m_timeExtent.endTime().isNull() || m_timeExtent.endTime() < endTime)
-                    {
-                        m_timeExtent = TimeExtent(m_timeExtent.startTime(), endTime);
-                        //qDebug() << m_timeExtent.startTime() << "-" << m_timeExtent.endTime();
-                    }
-                }
-            }
+qint64 StreamServiceLayer::historyRetention() const
+{
+    return m_historyStore.retention();
+}
+
+void StreamServiceLayer::setHistoryRetention(qint64 msecs)
+{
+    m_historyStore.setRetention(msecs);
+}
+
+qint64 StreamServiceLayer::historyStartTime() const
+{
+    return m_historyStore.startTime();
+}
+
+qint64 StreamServiceLayer::historyEndTime() const
+{
+    return m_historyStore.endTime();
+}
+
+int StreamServiceLayer::materializeHistory(qint64 windowStart, qint64 windowEnd)
+{
+    if (nullptr == m_historyGraphicsModel)
+    {
+        return 0;
+    }
+
+    // Only the graphics valid within the window exist, the others are hidden and reused
+    const QVector<StreamServiceHistoryObservation> observations = m_historyStore.latestInWindow(windowStart, windowEnd);
+    for (int observationIndex = 0; observationIndex < observations.size(); observationIndex++)
+    {
+        const StreamServiceHistoryObservation &observation = observations[observationIndex];
+        const Point position(observation.x, observation.y, m_pointSpatialReference);
+        const QVariantMap attributes = m_historyStore.attributes(observation.trackKey);
+        if (m_historyGraphics.size() <= observationIndex)
+        {
+            Graphic *historyGraphic = new Graphic(position, attributes, this);
+            m_historyGraphicsModel->append(historyGraphic);
+            m_historyGraphics.append(historyGraphic);
+            continue;
         }
+
+        Graphic *historyGraphic = m_historyGraphics[observationIndex];
+        historyGraphic->setGeometry(position);
+        historyGraphic->attributes()->setAttributesMap(attributes);
+        historyGraphic->setVisible(true);
     }
 
-    // Validate if the message represents an position update
-    if (!trackId.isEmpty() && m_trackGraphics.contains(trackId))
+    for (int graphicIndex = observations.size(); graphicIndex < m_historyGraphics.size(); graphicIndex++)
     {
-        qDebug() << "Position update";
+        m_historyGraphics[graphicIndex]->setVisible(false);
+    }
 
-        // Update the graphics position
-        Graphic *existingTrackGraphic = m_trackGraphics.value(trackId);
-        existingTrackGraphic->setGeometry(constructedGeometry);
+    return observations.size();
+}
 
-        // Update the graphics attributes
-        AttributeListModel *attributeModel = existingTrackGraphic->attributes();
-        QVariantMap existingAttributes = attributeModel->attributesMap();
-        const QList<QString> attributeKeys = attributes.keys();
-        for (auto const &attributeKey : attributeKeys)
+void StreamServiceLayer::setDensityGraphicsModel(GraphicListModel *densityGraphicsModel)
+{
+    m_densityGraphicsModel = densityGraphicsModel;
+    m_densityGrid.clear();
+    m_densityClock.start();
+    if (nullptr == m_densityGraphicsModel)
+    {
+        for (Graphic *densityGraphic : qAsConst(m_densityGraphics))
+        {
+            densityGraphic->setVisible(false);
+        }
+        return;
+    }
+
+    // The grid is only fed while it is shown, enabling it aggregates the live tracks once
+    for (int handleIndex = 0; handleIndex < m_trackGraphics.size(); handleIndex++)
+    {
+        if (nullptr != m_trackGraphics[handleIndex])
+        {
+            updateDensity(static_cast<quint32>(handleIndex), m_trackGraphics[handleIndex]->geometry());
+        }
+    }
+}
+
+void StreamServiceLayer::setDensityWeightField(const QString &weightField)
+{
+    m_densityWeightField = weightField;
+    m_densityWeightSlot = weightField.isEmpty() ? -1 : m_attributeColumns.schema().slot(weightField);
+}
+
+void StreamServiceLayer::setDensityHalfLife(qint64 msecs)
+{
+    m_densityHalfLife = qMax(Q_INT64_C(0), msecs);
+}
+
+void StreamServiceLayer::setDensityResolution(int columns, int blurRadius)
+{
+    m_densityGrid.setResolution(columns, m_densityGrid.levelCount());
+    m_densityBlurRadius = qMax(0, blurRadius);
+    if (nullptr != m_densityGraphicsModel)
+    {
+        setDensityGraphicsModel(m_densityGraphicsModel);
+    }
+}
+
+int StreamServiceLayer::updateDensityGraphics(const Envelope &extent)
+{
+    STREAMSERVICE_TRACE_SCOPE("density");
+    Envelope indexExtent;
+    if (nullptr == m_densityGraphicsModel || !toIndexExtent(extent, indexExtent))
+    {
+        return 0;
+    }
+
+    // Tracks fade out between their updates, an update restores the full weight
+    if (0 < m_densityHalfLife)
+    {
+        const qint64 elapsed = m_densityClock.restart();
+        m_densityGrid.decay(static_cast<float>(std::pow(0.5, static_cast<double>(elapsed) / m_densityHalfLife)));
+    }
+
+    const int level = m_densityGrid.level(indexExtent.width(), MaximumDensityColumns);
+    m_densityGrid.window(level, indexExtent.xMin(), indexExtent.yMin(), indexExtent.xMax(), indexExtent.yMax(), m_densityBlurRadius, m_densityWindow);
+
+    // Only the cells of a noticeable density get a graphic, the others are hidden and reused
+    int graphicIndex = 0;
+    const float minimumDensity = m_densityWindow.maximum * MinimumDensityRatio;
+    QVariantMap attributes;
+    for (int row = 0; row < m_densityWindow.rows; row++)
+    {
+        const float *values = m_densityWindow.values.constData() + row * m_densityWindow.columns;
+        for (int column = 0; column < m_densityWindow.columns; column++)
         {
-            qDebug() << attributeKey;
-            if (existingAttributes.contains(attributeKey))
+            if (values[column] <= minimumDensity)
             {
-                qDebug() << "old Value:" << existingAttributes.value(attributeKey);
+                continue;
             }
-            const QVariant newValue = attributes.value(attributeKey);
-            qDebug() << "new Value:" << newValue;
 
-            // Inserts/Updates the attribute value
-            existingAttributes.insert(attributeKey, newValue);
+            const double xMin = m_densityWindow.xMin + column * m_densityWindow.cellWidth;
+            const double yMin = m_densityWindow.yMin + row * m_densityWindow.cellHeight;
+            const Envelope cell(xMin, yMin, xMin + m_densityWindow.cellWidth, yMin + m_densityWindow.cellHeight, m_pointSpatialReference);
+            attributes.insert(QStringLiteral("density"), values[column] / m_densityWindow.maximum);
+            if (m_densityGraphics.size() <= graphicIndex)
+            {
+                Graphic *densityGraphic = new Graphic(cell, attributes, this);
+                m_densityGraphicsModel->append(densityGraphic);
+                m_densityGraphics.append(densityGraphic);
+            }
+            else
+            {
+                Graphic *densityGraphic = m_densityGraphics[graphicIndex];
+                densityGraphic->setGeometry(cell);
+                densityGraphic->attributes()->replaceAttribute(QStringLiteral("density"), attributes.value(QStringLiteral("density")));
+                densityGraphic->setVisible(true);
+            }
+            graphicIndex++;
         }
-        qDebug() << "";
-        return;
     }
 
-    // Add a new graphic using the constructed geometry
-    Graphic *newConstructedGraphic = new Graphic(constructedGeometry, attributes, this);
-    m_graphicsModel->append(newConstructedGraphic);
+    const int visibleCount = graphicIndex;
+    for (; graphicIndex < m_densityGraphics.size(); graphicIndex++)
+    {
+        m_densityGraphics[graphicIndex]->setVisible(false);
+    }
+    return visibleCount;
+}
 
-    // Treat the new graphic as a track message
-    if (!trackId.isEmpty())
+const StreamServiceDensityGrid& StreamServiceLayer::densityGrid() const
+{
+    return m_densityGrid;
+}
+
+QList<Graphic*> StreamServiceLayer::queryTracks(const Envelope &extent) const
+{
+    Envelope indexExtent;
+    if (!toIndexExtent(extent, indexExtent))
+    {
+        return QList<Graphic*>();
+    }
+
+    m_queryHandles.clear();
+    m_spatialIndex.queryExtent(indexExtent.xMin(), indexExtent.yMin(), indexExtent.xMax(), indexExtent.yMax(), m_queryHandles);
+    return trackGraphics(m_queryHandles);
+}
+
+QList<Graphic*> StreamServiceLayer::queryTracks(const Point &center, double radius) const
+{
+    Envelope indexExtent;
+    if (!toIndexExtent(Envelope(center, 2 * radius, 2 * radius), indexExtent))
+    {
+        return QList<Graphic*>();
+    }
+
+    m_queryHandles.clear();
+    m_spatialIndex.queryRadius(indexExtent.center().x(), indexExtent.center().y(), 0.5 * indexExtent.width(), m_queryHandles);
+    return trackGraphics(m_queryHandles);
+}
+
+Graphic* StreamServiceLayer::identifyTrack(const Point &location, double tolerance) const
+{
+    Envelope indexExtent;
+    if (!toIndexExtent(Envelope(location, 2 * tolerance, 2 * tolerance), indexExtent))
     {
-        m_trackGraphics.insert(trackId, newConstructedGraphic);
+        return nullptr;
     }
+
+    const quint32 trackHandle = m_spatialIndex.nearest(indexExtent.center().x(), indexExtent.center().y(), 0.5 * indexExtent.width());
+    if (StreamServiceSpatialIndex::NoHandle == trackHandle)
+    {
+        return nullptr;
+    }
+    return m_trackGraphics[static_cast<int>(trackHandle)];
+}
+
+int StreamServiceLayer::reconnectCount() const
+{
+    return m_reconnectCount;
+}
+
+qint64 StreamServiceLayer::lastGapDuration() const
+{
+    return m_lastGapDuration;
+}
+
+quint64 StreamServiceLayer::receivedMessageCount() const
+{
+    return m_ingestWorker->receivedMessageCount();
+}
+
+quint64 StreamServiceLayer::receivedBytes() const
+{
+    return m_ingestWorker->receivedBytes();
+}
+
+quint64 StreamServiceLayer::parseFailureCount() const
+{
+    return m_ingestWorker->parseFailureCount();
+}
+
+quint64 StreamServiceLayer::decodedMessageCount() const
+{
+    return m_ingestWorker->decodedMessageCount();
+}
+
+quint64 StreamServiceLayer::decodeNanos() const
+{
+    return m_ingestWorker->decodeNanos();
+}
+
+quint64 StreamServiceLayer::decodeQueueNanos() const
+{
+    return m_ingestWorker->decodeQueueNanos();
+}
+
+int StreamServiceLayer::queueDepth() const
+{
+    return static_cast<int>(m_ingestPipeline.decodePool().sizeApprox()) + m_stagedUpdates.size();
+}
+
+quint64 StreamServiceLayer::commitCount() const
+{
+    return m_commitCount;
+}
+
+quint64 StreamServiceLayer::committedUpdateCount() const
+{
+    return m_committedUpdateCount;
+}
+
+const StreamServiceHistogram& StreamServiceLayer::commitLatency() const
+{
+    return m_commitLatency;
+}
+
+const StreamServiceHistogram& StreamServiceLayer::commitSizes() const
+{
+    return m_commitSizes;
+}
+
+const StreamServiceHistogram& StreamServiceLayer::displayStaleness() const
+{
+    return m_displayStaleness;
+}
+
+void StreamServiceLayer::resetCommitLatency()
+{
+    m_commitLatency.reset();
+}
+
+void StreamServiceLayer::onConnectionRestored(const QUrl &endpoint, qint64 disconnectDuration, qint64 gapDuration)
+{
+    Q_UNUSED(endpoint)
+
+    // Tracks stay in place while disconnected, the resumed stream simply updates them
+    m_reconnectCount++;
+    m_lastGapDuration = gapDuration;
+    emit connectionRestored(disconnectDuration, gapDuration);
+}
+
+void StreamServiceLayer::onUpdatesAvailable()
+{
+    drainUpdateQueue();
+
+    // Schedule the next commit, updates arriving meanwhile are coalesced
+    if (!m_commitTimer.isActive())
+    {
+        m_commitTimer.start();
+    }
+}
+
+void StreamServiceLayer::onExpiryTimeout()
+{
+    m_trackClock.expire(m_expiredHandles);
+    for (quint32 expiredHandle : qAsConst(m_expiredHandles))
+    {
+        // A staged update keeps the track alive, its handle must stay valid until the commit
+        if (0 <= m_stagedUpdateIndices.value(static_cast<int>(expiredHandle), -1))
+        {
+            m_trackClock.touch(expiredHandle);
+            continue;
+        }
+
+        removeTrack(expiredHandle);
+    }
+
+    // Graphics without a track id expire in insertion order
+    const qint64 currentTick = m_trackClock.currentTick();
+    while (!m_untrackedGraphics.isEmpty() && m_untrackedGraphics.head().first <= currentTick)
+    {
+        recycleGraphic(m_untrackedGraphics.dequeue().second);
+    }
+}
+
+void StreamServiceLayer::commitStagedUpdates()
+{
+    STREAMSERVICE_TRACE_SCOPE("commit");
+    m_commitTimer.stop();
+    const bool drainedAll = drainUpdateQueue();
+    if (!drainedAll)
+    {
+        m_commitTimer.start();
+    }
+
+    if (nullptr == m_graphicsModel)
+    {
+        m_stagedUpdates.clear();
+        m_stagedUpdateIndices.fill(-1);
+        return;
+    }
+
+    // Only the latest update of every track touches the graphics
+    for (auto const &stagedUpdate : qAsConst(m_stagedUpdates))
+    {
+        if (StreamServiceTrackTable::InvalidHandle != stagedUpdate.trackHandle)
+        {
+            m_stagedUpdateIndices[static_cast<int>(stagedUpdate.trackHandle)] = -1;
+        }
+        applyUpdate(stagedUpdate);
+    }
+
+    evictTracks();
+    updateTrailGraphics();
+
+    // Coalesced updates never reach the graphics, only the committed ones are measured
+    const qint64 commitTime = StreamServiceTrackUpdate::currentReceiveTime();
+    const qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+    for (auto const &stagedUpdate : qAsConst(m_stagedUpdates))
+    {
+        if (0 < stagedUpdate.receiveTime)
+        {
+            m_commitLatency.record(commitTime - stagedUpdate.receiveTime);
+        }
+        if (stagedUpdate.startTime.isValid())
+        {
+            m_displayStaleness.record(currentTime - stagedUpdate.startTime.toMSecsSinceEpoch());
+        }
+    }
+    m_commitCount++;
+    m_committedUpdateCount += static_cast<quint64>(m_stagedUpdates.size());
+    m_commitSizes.record(m_stagedUpdates.size());
+    m_stagedUpdates.clear();
+}
+
+bool StreamServiceLayer::drainUpdateQueue()
+{
+    STREAMSERVICE_TRACE_SCOPE("drain");
+    // Bounded, the rest waits for the next frame so that rendering keeps up
+    return m_ingestPipeline.drain([this](StreamServiceTrackUpdate &&update) {
+        stageUpdate(std::move(update));
+    });
+}
+
+void StreamServiceLayer::stageUpdate(StreamServiceTrackUpdate &&update)
+{
+    if (update.expired)
+    {
+        // Only known tracks are removed, the removal replaces a staged position of the track
+        update.trackHandle = m_trackTable.find(update.trackId, update.trackIdHash);
+        if (StreamServiceTrackTable::InvalidHandle != update.trackHandle)
+        {
+            stageTrackUpdate(std::move(update));
+        }
+        return;
+    }
+
+    // The time extent must see every observation, not only the committed ones
+    updateTimeExtent(m_timeExtent, update);
+    appendHistoryObservation(update);
+
+    if (update.trackId.isEmpty())
+    {
+        m_stagedUpdates.append(std::move(update));
+        return;
+    }
+
+    internTrack(update);
+
+    // Replays older than the latest observation of the track are dropped
+    if (!m_trackClock.observe(update.trackHandle, update.startTime))
+    {
+        return;
+    }
+
+    // Trails keep every position, even the ones coalesced below
+    appendTrailPoint(update);
+    stageTrackUpdate(std::move(update));
+}
+
+void StreamServiceLayer::stageTrackUpdate(StreamServiceTrackUpdate &&update)
+{
+    // Latest wins, older positions of the same track are never committed
+    int &stagedIndex = m_stagedUpdateIndices[static_cast<int>(update.trackHandle)];
+    if (0 <= stagedIndex)
+    {
+        m_stagedUpdates[stagedIndex] = std::move(update);
+        return;
+    }
+
+    stagedIndex = m_stagedUpdates.size();
+    m_stagedUpdates.append(std::move(update));
+}
+
+void StreamServiceLayer::internTrack(StreamServiceTrackUpdate &update)
+{
+    // Intern the track id, the handle is used by the rest of the pipeline
+    update.trackHandle = m_trackTable.insert(update.trackId, update.trackIdHash);
+    const int handleIndex = static_cast<int>(update.trackHandle);
+    if (m_stagedUpdateIndices.size() <= handleIndex)
+    {
+        // Grown elements are value-initialized, only the staged indices need another default
+        m_stagedUpdateIndices.insert(m_stagedUpdateIndices.end(), m_trackTable.handleCapacity() - m_stagedUpdateIndices.size(), -1);
+        m_trackGraphics.resize(m_trackTable.handleCapacity());
+        m_trackAttributes.resize(m_trackTable.handleCapacity());
+        m_attributeColumns.resize(m_trackTable.handleCapacity());
+        m_trackBytes.resize(m_trackTable.handleCapacity());
+        m_trailGraphics.resize(m_trackTable.handleCapacity());
+    }
+}
+
+void StreamServiceLayer::updateTimeExtent(TimeExtent &timeExtent, const StreamServiceTrackUpdate &update)
+{
+    // Start time
+    const QDateTime &startTime = update.startTime;
+    if (startTime.isValid())
+    {
+        if (timeExtent.startTime().isNull() || startTime < timeExtent.startTime())
+        {
+            if (timeExtent.endTime().isNull())
+            {
+                timeExtent = TimeExtent(startTime);
+            }
+            else
+            {
+                timeExtent = TimeExtent(startTime, timeExtent.endTime());
+            }
+            //qDebug() << timeExtent.startTime() << "-" << timeExtent.endTime();
+        }
+
+        // Start time is greather than end time e.g. for instant times where no end time field is defined
+        if (timeExtent.endTime().isNull() || timeExtent.endTime() < startTime)
+        {
+            timeExtent = TimeExtent(timeExtent.startTime(), startTime);
+            //qDebug() << timeExtent.startTime() << "-" << timeExtent.endTime();
+        }
+    }
+
+    // End time
+    const QDateTime &endTime = update.endTime;
+    if (endTime.isValid())
+    {
+        if (timeExtent.endTime().isNull() || timeExtent.endTime() < endTime)
+        {
+            timeExtent = TimeExtent(timeExtent.startTime(), endTime);
+            //qDebug() << timeExtent.startTime() << "-" << timeExtent.endTime();
+        }
+    }
+}
+
+void StreamServiceLayer::applyUpdate(const StreamServiceTrackUpdate &update)
+{
+    if (update.expired)
+    {
+        // The track may already be gone here, e.g. evicted or expired locally
+        if (m_trackTable.contains(update.trackHandle))
+        {
+            removeTrack(update.trackHandle);
+        }
+        return;
+    }
+
+    // Validate if the message represents an position update
+    const quint32 trackHandle = update.trackHandle;
+    Graphic *existingTrackGraphic = (StreamServiceTrackTable::InvalidHandle != trackHandle)
+            ? m_trackGraphics[static_cast<int>(trackHandle)]
+            : nullptr;
+    if (nullptr != existingTrackGraphic)
+    {
+        // Update the graphics position
+        if (!existingTrackGraphic->geometry().equals(update.geometry))
+        {
+            existingTrackGraphic->setGeometry(update.geometry);
+            updateSpatialIndex(trackHandle, update.geometry);
+        }
+
+        // Update the graphics attributes
+        const int handleIndex = static_cast<int>(trackHandle);
+        if (update.attributeRow.isEmpty())
+        {
+            applyAttributeDelta(existingTrackGraphic, m_trackAttributes[handleIndex], update.attributes);
+        }
+        else
+        {
+            applyAttributeRow(existingTrackGraphic, trackHandle, update);
+        }
+
+        if (nullptr != m_densityGraphicsModel)
+        {
+            updateDensity(trackHandle, update.geometry);
+        }
+
+        const qint64 trackBytes = estimateTrackBytes(m_trackAttributes[handleIndex]) + m_attributeColumns.estimateBytes(handleIndex);
+        m_liveTrackBytes += trackBytes - m_trackBytes[static_cast<int>(trackHandle)];
+        m_trackBytes[static_cast<int>(trackHandle)] = trackBytes;
+        m_trackRecency.touch(trackHandle);
+        m_trackClock.touch(trackHandle);
+        return;
+    }
+
+    // Add a new graphic using the constructed geometry
+    Graphic *newConstructedGraphic = acquireGraphic(update.geometry, graphicAttributes(update));
+
+    // Treat the new graphic as a track message
+    if (StreamServiceTrackTable::InvalidHandle != trackHandle)
+    {
+        const int handleIndex = static_cast<int>(trackHandle);
+        m_changedSlots.clear();
+        m_attributeColumns.store(handleIndex, update.attributeRow, m_changedSlots);
+        const qint64 trackBytes = estimateTrackBytes(update.attributes) + m_attributeColumns.estimateBytes(handleIndex);
+        m_trackGraphics[handleIndex] = newConstructedGraphic;
+        m_trackAttributes[handleIndex] = update.attributes;
+        m_trackBytes[static_cast<int>(trackHandle)] = trackBytes;
+        m_liveTrackBytes += trackBytes;
+        m_trackRecency.touch(trackHandle);
+        updateSpatialIndex(trackHandle, update.geometry);
+        if (nullptr != m_densityGraphicsModel)
+        {
+            updateDensity(trackHandle, update.geometry);
+        }
+        m_trackClock.touch(trackHandle);
+    }
+    else if (0 < m_trackClock.timeToLive())
+    {
+        m_untrackedGraphics.enqueue(qMakePair(m_trackClock.deadlineTick(), newConstructedGraphic));
+    }
+}
+
+void StreamServiceLayer::removeTrack(quint32 trackHandle)
+{
+    const int handleIndex = static_cast<int>(trackHandle);
+    recycleGraphic(m_trackGraphics[handleIndex]);
+    m_trackGraphics[handleIndex] = nullptr;
+    m_trackAttributes[handleIndex] = QVariantMap();
+    m_attributeColumns.clear(handleIndex);
+    m_liveTrackBytes -= m_trackBytes[handleIndex];
+    m_trackBytes[handleIndex] = 0;
+    m_trackRecency.remove(trackHandle);
+    m_trackClock.remove(trackHandle);
+    m_spatialIndex.remove(trackHandle);
+    m_densityGrid.remove(trackHandle);
+    m_trailStore.clear(trackHandle);
+    m_trackTable.remove(trackHandle);
+}
+
+void StreamServiceLayer::removeGraphic(Graphic *graphic)
+{
+    if (nullptr == graphic)
+    {
+        return;
+    }
+
+    if (nullptr != m_graphicsModel)
+    {
+        m_graphicsModel->removeOne(graphic);
+    }
+    delete graphic;
+}
+
+void StreamServiceLayer::recycleGraphic(Graphic *graphic)
+{
+    if (nullptr == graphic)
+    {
+        return;
+    }
+
+    if (m_graphicPoolCapacity <= m_graphicPool.size())
+    {
+        removeGraphic(graphic);
+        return;
+    }
+
+    // Pooled graphics stay in the overlay, hidden until they are reused
+    graphic->setVisible(false);
+    m_graphicPool.append(graphic);
+}
+
+Graphic* StreamServiceLayer::acquireGraphic(const Geometry &geometry, const QVariantMap &attributes)
+{
+    if (m_graphicPool.isEmpty())
+    {
+        Graphic *newGraphic = new Graphic(geometry, attributes, this);
+        m_graphicsModel->append(newGraphic);
+        return newGraphic;
+    }
+
+    Graphic *recycledGraphic = m_graphicPool.takeLast();
+    recycledGraphic->setGeometry(geometry);
+    recycledGraphic->attributes()->setAttributesMap(attributes);
+    recycledGraphic->setVisible(true);
+    return recycledGraphic;
+}
+
+void StreamServiceLayer::evictTracks()
+{
+    // Evict the least recently updated tracks until the track store fits its budget
+    while (0 < m_trackRecency.size()
+           && ((0 < m_maximumTrackCount && m_maximumTrackCount < m_trackRecency.size())
+               || (0 < m_memoryBudget && m_memoryBudget < m_liveTrackBytes)))
+    {
+        const quint32 leastRecentHandle = m_trackRecency.leastRecent();
+        if (0 <= m_stagedUpdateIndices.value(static_cast<int>(leastRecentHandle), -1))
+        {
+            // Never evict a handle referenced by a staged update
+            break;
+        }
+        removeTrack(leastRecentHandle);
+    }
+}
+
+void StreamServiceLayer::appendTrailPoint(const StreamServiceTrackUpdate &update)
+{
+    if (0 == m_trailStore.trailLength() || GeometryType::Point != update.geometry.geometryType())
+    {
+        return;
+    }
+
+    const Point position(update.geometry);
+    updatePointSpatialReference(position.spatialReference());
+
+    m_trailStore.append(update.trackHandle, position.x(), position.y(), observationTime(update));
+}
+
+void StreamServiceLayer::appendHistoryObservation(const StreamServiceTrackUpdate &update)
+{
+    if (0 == m_historyStore.retention() || update.trackId.isEmpty() || GeometryType::Point != update.geometry.geometryType())
+    {
+        return;
+    }
+
+    const Point position(update.geometry);
+    updatePointSpatialReference(position.spatialReference());
+
+    m_historyStore.append(update.trackId, update.trackIdHash, position.x(), position.y(), observationTime(update), graphicAttributes(update));
+}
+
+QVariantMap StreamServiceLayer::graphicAttributes(const StreamServiceTrackUpdate &update) const
+{
+    // Typed values only become variants at the runtime boundary
+    if (update.attributeRow.isEmpty())
+    {
+        return update.attributes;
+    }
+    return m_attributeColumns.schema().toVariantMap(update.attributeRow, update.attributes);
+}
+
+void StreamServiceLayer::updateSpatialIndex(quint32 trackHandle, const Geometry &geometry)
+{
+    updatePointSpatialReference(geometry.spatialReference());
+    if (GeometryType::Point == geometry.geometryType())
+    {
+        const Point position(geometry);
+        m_spatialIndex.insert(trackHandle, position.x(), position.y());
+        return;
+    }
+
+    // Lines and areas are indexed by the center of their extent
+    const Point center = geometry.extent().center();
+    m_spatialIndex.insert(trackHandle, center.x(), center.y());
+}
+
+void StreamServiceLayer::updateDensity(quint32 trackHandle, const Geometry &geometry)
+{
+    // Lines and areas have no meaningful density
+    if (GeometryType::Point != geometry.geometryType())
+    {
+        m_densityGrid.remove(trackHandle);
+        return;
+    }
+
+    const Point position(geometry);
+    m_densityGrid.update(trackHandle, position.x(), position.y(), densityWeight(static_cast<int>(trackHandle)));
+}
+
+float StreamServiceLayer::densityWeight(int handleIndex) const
+{
+    if (m_densityWeightField.isEmpty())
+    {
+        return 1.0f;
+    }
+
+    // Missing and non numeric weights do not contribute
+    const QVariant weightValue = (0 <= m_densityWeightSlot)
+            ? m_attributeColumns.value(handleIndex, m_densityWeightSlot)
+            : m_trackAttributes[handleIndex].value(m_densityWeightField);
+    bool validWeight = false;
+    const double weight = weightValue.toDouble(&validWeight);
+    return validWeight ? static_cast<float>(qMax(0.0, weight)) : 0.0f;
+}
+
+void StreamServiceLayer::updatePointSpatialReference(const SpatialReference &spatialReference)
+{
+    if (!m_pointSpatialReference.isEmpty() || spatialReference.isEmpty())
+    {
+        return;
+    }
+
+    // All positions are kept in the spatial reference of the first one
+    m_pointSpatialReference = spatialReference;
+    m_spatialIndex.setCellSize(spatialReference.isGeographic() ? GeographicCellSize : ProjectedCellSize);
+    if (spatialReference.isGeographic())
+    {
+        m_densityGrid.setExtent(-180.0, -90.0, 180.0, 90.0);
+    }
+}
+
+bool StreamServiceLayer::toIndexExtent(const Envelope &extent, Envelope &indexExtent) const
+{
+    if (extent.isEmpty() || m_pointSpatialReference.isEmpty())
+    {
+        return false;
+    }
+
+    if (extent.spatialReference().isEmpty() || extent.spatialReference() == m_pointSpatialReference)
+    {
+        indexExtent = extent;
+        return true;
+    }
+
+    indexExtent = Envelope(GeometryEngine::project(extent, m_pointSpatialReference));
+    return !indexExtent.isEmpty();
+}
+
+QList<Graphic*> StreamServiceLayer::trackGraphics(const QVector<quint32> &trackHandles) const
+{
+    QList<Graphic*> graphics;
+    graphics.reserve(trackHandles.size());
+    for (quint32 trackHandle : trackHandles)
+    {
+        graphics.append(m_trackGraphics[static_cast<int>(trackHandle)]);
+    }
+    return graphics;
+}
+
+void StreamServiceLayer::updateFilter()
+{
+    QStringList outFields = m_outFields;
+    if (outFields.isEmpty() || outFields.contains(QStringLiteral("*")))
+    {
+        outFields = QStringList(QStringLiteral("*"));
+    }
+    else if (nullptr != m_timeInfo)
+    {
+        // The layer relies on the track id and the time fields
+        const QStringList timeInfoFields = QStringList() << m_timeInfo->trackIdField() << m_timeInfo->startTimeField() << m_timeInfo->endTimeField();
+        for (const QString &timeInfoField : timeInfoFields)
+        {
+            if (!timeInfoField.isEmpty() && !outFields.contains(timeInfoField))
+            {
+                outFields.append(timeInfoField);
+            }
+        }
+    }
+
+    // The stream service expects the filter geometry as Esri JSON string
+    QJsonObject filterObject;
+    filterObject.insert(QStringLiteral("geometry"), m_filterExtent.isEmpty() ? QJsonValue() : QJsonValue(m_filterExtent.toJson()));
+    filterObject.insert(QStringLiteral("where"), m_whereClause.isEmpty() ? QStringLiteral("1=1") : m_whereClause);
+    filterObject.insert(QStringLiteral("outFields"), outFields.join(QLatin1Char(',')));
+    QJsonObject messageObject;
+    messageObject.insert(QStringLiteral("filter"), filterObject);
+    const QString filterMessage = QString::fromUtf8(QJsonDocument(messageObject).toJson(QJsonDocument::Compact));
+
+    QMetaObject::invokeMethod(m_ingestWorker, [this, filterMessage]() {
+        m_ingestWorker->setFilter(filterMessage);
+    }, Qt::QueuedConnection);
+}
+
+qint64 StreamServiceLayer::observationTime(const StreamServiceTrackUpdate &update) const
+{
+    // Observations without a start time are stamped on arrival
+    return update.startTime.isValid() ? update.startTime.toMSecsSinceEpoch() : QDateTime::currentMSecsSinceEpoch();
+}
+
+void StreamServiceLayer::updateTrailGraphics()
+{
+    // Only the trails of tracks updated since the last commit are rebuilt
+    const QVector<quint32> dirtyHandles = m_trailStore.takeDirtyHandles();
+    if (nullptr == m_trailGraphicsModel)
+    {
+        return;
+    }
+
+    for (quint32 dirtyHandle : dirtyHandles)
+    {
+        const int handleIndex = static_cast<int>(dirtyHandle);
+        Graphic *trailGraphic = m_trailGraphics[handleIndex];
+        const int pointCount = m_trailStore.pointCount(dirtyHandle);
+        if (pointCount < 2)
+        {
+            if (nullptr != trailGraphic)
+            {
+                trailGraphic->setVisible(false);
+            }
+            continue;
+        }
+
+        PolylineBuilder trailBuilder(m_pointSpatialReference);
+        for (int pointIndex = 0; pointIndex < pointCount; pointIndex++)
+        {
+            trailBuilder.addPoint(m_trailStore.x(dirtyHandle, pointIndex), m_trailStore.y(dirtyHandle, pointIndex));
+        }
+
+        // Trail graphics belong to the handle and are reused by the next track using it
+        if (nullptr == trailGraphic)
+        {
+            trailGraphic = new Graphic(trailBuilder.toGeometry(), this);
+            m_trailGraphicsModel->append(trailGraphic);
+            m_trailGraphics[handleIndex] = trailGraphic;
+            continue;
+        }
+
+        trailGraphic->setGeometry(trailBuilder.toGeometry());
+        trailGraphic->setVisible(true);
+    }
+}
+
+qint64 StreamServiceLayer::estimateTrackBytes(const QVariantMap &attributes)
+{
+    // Rough estimate of the graphic, its geometry and the attribute maps kept on both sides
+    const qint64 graphicBytes = 512;
+    const qint64 attributeBytes = 2 * 64;
+    qint64 trackBytes = graphicBytes;
+    for (auto attributeIterator = attributes.cbegin(); attributeIterator != attributes.cend(); ++attributeIterator)
+    {
+        trackBytes += attributeBytes + 2 * 2 * attributeIterator.key().size();
+        if (QMetaType::QString == static_cast<QMetaType::Type>(attributeIterator.value().type()))
+        {
+            trackBytes += 2 * 2 * attributeIterator.value().toString().size();
+        }
+    }
+    return trackBytes;
+}
+
+
+void StreamServiceLayer::applyAttributeDelta(Graphic *trackGraphic, QVariantMap &storedAttributes, const QVariantMap &attributes)
+{
+    // Compare against the stored attributes, the graphic is only touched for changed fields
+    QString changedKey;
+    const int changedCount = mergeAttributeDelta(storedAttributes, attributes, changedKey);
+    if (0 == changedCount)
+    {
+        return;
+    }
+
+    // A single field is replaced in place, several fields are applied in one call
+    AttributeListModel *attributeModel = trackGraphic->attributes();
+    if (1 == changedCount)
+    {
+        applyChangedAttribute(attributeModel, changedKey, storedAttributes.value(changedKey));
+        return;
+    }
+
+    attributeModel->setAttributesMap(storedAttributes);
+}
+
+void StreamServiceLayer::applyAttributeRow(Graphic *trackGraphic, quint32 trackHandle, const StreamServiceTrackUpdate &update)
+{
+    // The typed values are compared in their columns, the other attributes against the stored map
+    const int handleIndex = static_cast<int>(trackHandle);
+    const StreamServiceFieldSchema &fieldSchema = m_attributeColumns.schema();
+    QVariantMap &storedAttributes = m_trackAttributes[handleIndex];
+    for (auto attributeIterator = update.attributes.cbegin(); attributeIterator != update.attributes.cend(); ++attributeIterator)
+    {
+        // A value not matching the type of its field replaces the typed one
+        const int fieldSlot = fieldSchema.slot(attributeIterator.key());
+        if (0 <= fieldSlot)
+        {
+            m_attributeColumns.clearValue(handleIndex, fieldSlot);
+        }
+    }
+
+    QString changedKey;
+    int changedCount = mergeAttributeDelta(storedAttributes, update.attributes, changedKey);
+    m_changedSlots.clear();
+    m_attributeColumns.store(handleIndex, update.attributeRow, m_changedSlots);
+    for (const int changedSlot : qAsConst(m_changedSlots))
+    {
+        storedAttributes.remove(fieldSchema.field(changedSlot).name);
+    }
+    changedCount += m_changedSlots.size();
+    if (0 == changedCount)
+    {
+        return;
+    }
+
+    AttributeListModel *attributeModel = trackGraphic->attributes();
+    if (1 == changedCount)
+    {
+        if (m_changedSlots.isEmpty())
+        {
+            applyChangedAttribute(attributeModel, changedKey, storedAttributes.value(changedKey));
+        }
+        else
+        {
+            const int changedSlot = m_changedSlots.first();
+            applyChangedAttribute(attributeModel, fieldSchema.field(changedSlot).name, m_attributeColumns.value(handleIndex, changedSlot));
+        }
+        return;
+    }
+
+    QVariantMap attributes = storedAttributes;
+    m_attributeColumns.insertInto(handleIndex, attributes);
+    attributeModel->setAttributesMap(attributes);
 }
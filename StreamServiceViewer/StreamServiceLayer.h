@@ -33,14 +33,35 @@ namespace ArcGISRuntime
 {
 class Graphic;
 class GraphicListModel;
+class Point;
 }
 }
 
+#include "StreamServiceAttributeColumns.h"
+#include "StreamServiceDensityGrid.h"
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceHistogram.h"
+#include "StreamServiceHistoryStore.h"
+#include "StreamServiceIngestPipeline.h"
+#include "StreamServiceIngestWorker.h"
+#include "StreamServiceLruList.h"
+#include "StreamServiceSnapshot.h"
+#include "StreamServiceSpatialIndex.h"
+#include "StreamServiceTrackClock.h"
+#include "StreamServiceTrailStore.h"
+#include "StreamServiceTrackTable.h"
+#include "Envelope.h"
+#include "SpatialReference.h"
 #include "TimeExtent.h"
 
-#include <QMap>
+#include <QElapsedTimer>
+#include <QList>
 #include <QObject>
-#include <QWebSocket>
+#include <QPair>
+#include <QQueue>
+#include <QStringList>
+#include <QTimer>
+#include <QVector>
 
 class StreamServiceLayerTimeInfo;
 
@@ -48,30 +69,214 @@ class StreamServiceLayer : public QObject
 {
     Q_OBJECT
 public:
-    explicit StreamServiceLayer(const QUrl &webSocketEndpoint, QObject *parent = nullptr);
+    explicit StreamServiceLayer(const QList<QUrl> &webSocketEndpoints, QObject *parent = nullptr);
+    ~StreamServiceLayer() override;
 
     void subscribe();
     void unsubscribe();
 
+    // Records every received message, a replay capture replaces the websockets on subscribe
+    void startRecording(const QString &captureFilePath);
+    void stopRecording();
+    void setReplayCapture(const QString &captureFilePath, double speed);
+
+    // Fixed by the first subscribe, zero uses all but two of the cores
+    int decodeThreadCount() const;
+    void setDecodeThreadCount(int threadCount);
+
+    StreamServiceIngestWorker::ConnectionMode connectionMode() const;
+    void setConnectionMode(StreamServiceIngestWorker::ConnectionMode connectionMode);
+
     void setGraphicsModel(Esri::ArcGISRuntime::GraphicListModel *graphicsModel);
+    void setTrailGraphicsModel(Esri::ArcGISRuntime::GraphicListModel *trailGraphicsModel);
+    void setHistoryGraphicsModel(Esri::ArcGISRuntime::GraphicListModel *historyGraphicsModel);
     void setTimeInfo(StreamServiceLayerTimeInfo *timeInfo);
 
+    // The fields of the service description, set before subscribing
+    void setFieldSchema(const StreamServiceFieldSchema &fieldSchema);
+
+    // Writes the live tracks periodically and when the layer is destroyed, a zero interval disables it
+    void setSnapshotFile(const QString &filePath, const QString &source, int intervalMsecs);
+
+    // Shows the tracks of a previous snapshot of the same source, requires the graphics model
+    int restoreSnapshot(const QString &filePath, const QString &source, qint64 maximumAge);
+
+    // Geographic features are projected on the ingest thread, only Web Mercator is supported as target
+    void setTargetSpatialReference(const Esri::ArcGISRuntime::SpatialReference &spatialReference);
+
+    // Filters applied by the stream service, an empty extent removes the spatial filter
+    Esri::ArcGISRuntime::Envelope filterExtent() const;
+    void setFilterExtent(const Esri::ArcGISRuntime::Envelope &extent);
+    QString whereClause() const;
+    void setWhereClause(const QString &whereClause);
+    QStringList outFields() const;
+    void setOutFields(const QStringList &outFields);
+
+    int commitInterval() const;
+    void setCommitInterval(int msecs);
+
+    qint64 trackTimeToLive() const;
+    void setTrackTimeToLive(qint64 msecs);
+
+    int maximumTrackCount() const;
+    void setMaximumTrackCount(int maximumTrackCount);
+
+    qint64 memoryBudget() const;
+    void setMemoryBudget(qint64 bytes);
+
+    int graphicPoolCapacity() const;
+    void setGraphicPoolCapacity(int capacity);
+
+    int trackCount() const;
+
+    int trailLength() const;
+    void setTrailLength(int trailLength);
+
+    qint64 historyRetention() const;
+    void setHistoryRetention(qint64 msecs);
+    qint64 historyStartTime() const;
+    qint64 historyEndTime() const;
+
+    // Shows the latest position of every track observed within the time window
+    int materializeHistory(qint64 windowStart, qint64 windowEnd);
+
+    // Aggregates the live point tracks into a density grid shown as cell graphics, a null model disables it
+    void setDensityGraphicsModel(Esri::ArcGISRuntime::GraphicListModel *densityGraphicsModel);
+    void setDensityWeightField(const QString &weightField);
+    void setDensityHalfLife(qint64 msecs);
+    void setDensityResolution(int columns, int blurRadius);
+
+    // Shows the density within the extent, returns the number of visible cells
+    int updateDensityGraphics(const Esri::ArcGISRuntime::Envelope &extent);
+    const StreamServiceDensityGrid& densityGrid() const;
+
+    // Spatial queries over the live tracks, the search geometries may use any spatial reference
+    QList<Esri::ArcGISRuntime::Graphic*> queryTracks(const Esri::ArcGISRuntime::Envelope &extent) const;
+    QList<Esri::ArcGISRuntime::Graphic*> queryTracks(const Esri::ArcGISRuntime::Point &center, double radius) const;
+    Esri::ArcGISRuntime::Graphic* identifyTrack(const Esri::ArcGISRuntime::Point &location, double tolerance) const;
+
+    int reconnectCount() const;
+    qint64 lastGapDuration() const;
+
+    // Pipeline metrics, the counters only grow
+    quint64 receivedMessageCount() const;
+    quint64 receivedBytes() const;
+    quint64 parseFailureCount() const;
+    quint64 decodedMessageCount() const;
+    quint64 decodeNanos() const;
+    quint64 decodeQueueNanos() const;
+    int queueDepth() const;
+    quint64 commitCount() const;
+    quint64 committedUpdateCount() const;
+
+    // Receive to commit latency in nanoseconds, committed updates per commit and event time to commit in milliseconds
+    const StreamServiceHistogram& commitLatency() const;
+    const StreamServiceHistogram& commitSizes() const;
+    const StreamServiceHistogram& displayStaleness() const;
+    void resetCommitLatency();
+
+    // Single stages of staging and committing an update, used by the decode stage benchmark
+    static void updateTimeExtent(Esri::ArcGISRuntime::TimeExtent &timeExtent, const StreamServiceTrackUpdate &update);
+    static void applyAttributeDelta(Esri::ArcGISRuntime::Graphic *trackGraphic, QVariantMap &storedAttributes, const QVariantMap &attributes);
+
 signals:
+    void connectionRestored(qint64 disconnectDuration, qint64 gapDuration);
 
-private slots:
-    void onConnected();
-    void onDisconnected();
+public slots:
+    void commitStagedUpdates();
 
-    void onBinaryMessageReceived(const QByteArray &message);
-    void onTextMessageReceived(const QString &message);
+private slots:
+    void onUpdatesAvailable();
+    void onExpiryTimeout();
+    void onConnectionRestored(const QUrl &endpoint, qint64 disconnectDuration, qint64 gapDuration);
+    void writeSnapshot();
 
 private:
-    QWebSocket m_websocket;
-    QUrl m_webSocketEndpoint;
-    Esri::ArcGISRuntime::GraphicListModel* m_graphicsModel;
-    StreamServiceLayerTimeInfo *m_timeInfo;
+    // Returns false when updates were left behind for the next commit
+    bool drainUpdateQueue();
+    void stageUpdate(StreamServiceTrackUpdate &&update);
+    void stageTrackUpdate(StreamServiceTrackUpdate &&update);
+    void internTrack(StreamServiceTrackUpdate &update);
+    void applyUpdate(const StreamServiceTrackUpdate &update);
+    void removeTrack(quint32 trackHandle);
+    void removeGraphic(Esri::ArcGISRuntime::Graphic *graphic);
+    void recycleGraphic(Esri::ArcGISRuntime::Graphic *graphic);
+    Esri::ArcGISRuntime::Graphic* acquireGraphic(const Esri::ArcGISRuntime::Geometry &geometry, const QVariantMap &attributes);
+    void applyAttributeRow(Esri::ArcGISRuntime::Graphic *trackGraphic, quint32 trackHandle, const StreamServiceTrackUpdate &update);
+    QVariantMap graphicAttributes(const StreamServiceTrackUpdate &update) const;
+    void evictTracks();
+    void appendTrailPoint(const StreamServiceTrackUpdate &update);
+    void updateTrailGraphics();
+    void appendHistoryObservation(const StreamServiceTrackUpdate &update);
+    void updateSpatialIndex(quint32 trackHandle, const Esri::ArcGISRuntime::Geometry &geometry);
+    void updateDensity(quint32 trackHandle, const Esri::ArcGISRuntime::Geometry &geometry);
+    float densityWeight(int handleIndex) const;
+    void updatePointSpatialReference(const Esri::ArcGISRuntime::SpatialReference &spatialReference);
+    bool toIndexExtent(const Esri::ArcGISRuntime::Envelope &extent, Esri::ArcGISRuntime::Envelope &indexExtent) const;
+    QList<Esri::ArcGISRuntime::Graphic*> trackGraphics(const QVector<quint32> &trackHandles) const;
+    void updateFilter();
+    qint64 observationTime(const StreamServiceTrackUpdate &update) const;
+    static qint64 estimateTrackBytes(const QVariantMap &attributes);
+
+    StreamServiceIngestPipeline m_ingestPipeline;
+    int m_decodeThreadCount = 0;
+    StreamServiceIngestWorker *m_ingestWorker;
+    QTimer m_commitTimer;
+    QVector<StreamServiceTrackUpdate> m_stagedUpdates;
+    QVector<int> m_stagedUpdateIndices;
+    QList<QUrl> m_webSocketEndpoints;
+    QString m_replayCaptureFilePath;
+    double m_replaySpeed = 1.0;
+    StreamServiceIngestWorker::ConnectionMode m_connectionMode = StreamServiceIngestWorker::ConnectionMode::Failover;
+    Esri::ArcGISRuntime::GraphicListModel* m_graphicsModel = nullptr;
+    StreamServiceLayerTimeInfo *m_timeInfo = nullptr;
     Esri::ArcGISRuntime::TimeExtent m_timeExtent;
-    QMap<QString, Esri::ArcGISRuntime::Graphic*> m_trackGraphics;
+    Esri::ArcGISRuntime::Envelope m_filterExtent;
+    QString m_whereClause;
+    QStringList m_outFields;
+    StreamServiceTrackTable m_trackTable;
+    QVector<Esri::ArcGISRuntime::Graphic*> m_trackGraphics;
+    QVector<QVariantMap> m_trackAttributes;
+    StreamServiceAttributeColumns m_attributeColumns;
+    QVector<int> m_changedSlots;
+    int m_reconnectCount = 0;
+    qint64 m_lastGapDuration = 0;
+    quint64 m_commitCount = 0;
+    quint64 m_committedUpdateCount = 0;
+    StreamServiceHistogram m_commitLatency;
+    StreamServiceHistogram m_commitSizes;
+    StreamServiceHistogram m_displayStaleness;
+    StreamServiceTrackClock m_trackClock;
+    QTimer m_expiryTimer;
+    QVector<quint32> m_expiredHandles;
+    QQueue<QPair<qint64, Esri::ArcGISRuntime::Graphic*>> m_untrackedGraphics;
+    StreamServiceLruList m_trackRecency;
+    QVector<qint64> m_trackBytes;
+    qint64 m_liveTrackBytes = 0;
+    int m_maximumTrackCount = 0;
+    qint64 m_memoryBudget = 0;
+    QVector<Esri::ArcGISRuntime::Graphic*> m_graphicPool;
+    int m_graphicPoolCapacity = 4096;
+    Esri::ArcGISRuntime::GraphicListModel* m_trailGraphicsModel = nullptr;
+    StreamServiceTrailStore m_trailStore;
+    Esri::ArcGISRuntime::SpatialReference m_pointSpatialReference;
+    StreamServiceSpatialIndex m_spatialIndex;
+    mutable QVector<quint32> m_queryHandles;
+    QVector<Esri::ArcGISRuntime::Graphic*> m_trailGraphics;
+    Esri::ArcGISRuntime::GraphicListModel* m_historyGraphicsModel = nullptr;
+    StreamServiceHistoryStore m_historyStore;
+    QVector<Esri::ArcGISRuntime::Graphic*> m_historyGraphics;
+    Esri::ArcGISRuntime::GraphicListModel* m_densityGraphicsModel = nullptr;
+    StreamServiceDensityGrid m_densityGrid;
+    StreamServiceDensityWindow m_densityWindow;
+    QVector<Esri::ArcGISRuntime::Graphic*> m_densityGraphics;
+    QString m_densityWeightField;
+    int m_densityWeightSlot = -1;
+    int m_densityBlurRadius = 1;
+    qint64 m_densityHalfLife = 0;
+    QElapsedTimer m_densityClock;
+    StreamServiceSnapshot m_snapshot;
+    QTimer m_snapshotTimer;
 };
 
 #endif // STREAMSERVICELAYER_H
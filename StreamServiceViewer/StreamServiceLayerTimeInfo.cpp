@@ -59,20 +59,56 @@ StreamServiceLayerTimeInfo* StreamServiceLayerTimeInfo::createFromJson(QJsonValu
         layerTimeInfo->m_endTimeField = timeInfoObject.value(endTimeFieldKey).toString();
     }
 
+    // The time interval defines how long a track stays alive without any update
+    auto const timeIntervalKey = "timeInterval";
+    auto const timeIntervalUnitsKey = "timeIntervalUnits";
+    if (timeInfoObject.contains(timeIntervalKey))
+    {
+        double timeInterval = timeInfoObject.value(timeIntervalKey).toDouble();
+        QString timeIntervalUnits = timeInfoObject.value(timeIntervalUnitsKey).toString();
+        qint64 unitMilliseconds = 0;
+        if (QStringLiteral("esriTimeUnitsMilliseconds") == timeIntervalUnits)
+        {
+            unitMilliseconds = 1;
+        }
+        else if (QStringLiteral("esriTimeUnitsSeconds") == timeIntervalUnits)
+        {
+            unitMilliseconds = 1000;
+        }
+        else if (QStringLiteral("esriTimeUnitsMinutes") == timeIntervalUnits)
+        {
+            unitMilliseconds = 60 * 1000;
+        }
+        else if (QStringLiteral("esriTimeUnitsHours") == timeIntervalUnits)
+        {
+            unitMilliseconds = 60 * 60 * 1000;
+        }
+        else if (QStringLiteral("esriTimeUnitsDays") == timeIntervalUnits)
+        {
+            unitMilliseconds = 24 * 60 * 60 * 1000;
+        }
+        layerTimeInfo->m_trackTimeToLive = qMax(qint64(0), qRound64(timeInterval * unitMilliseconds));
+    }
+
     return layerTimeInfo;
 }
 
-QString StreamServiceLayerTimeInfo::trackIdField() const
+const QString& StreamServiceLayerTimeInfo::trackIdField() const
 {
     return m_trackIdField;
 }
 
-QString StreamServiceLayerTimeInfo::startTimeField() const
+const QString& StreamServiceLayerTimeInfo::startTimeField() const
 {
     return m_startTimeField;
 }
 
-QString StreamServiceLayerTimeInfo::endTimeField() const
+const QString& StreamServiceLayerTimeInfo::endTimeField() const
 {
     return m_endTimeField;
 }
+
+qint64 StreamServiceLayerTimeInfo::trackTimeToLive() const
+{
+    return m_trackTimeToLive;
+}
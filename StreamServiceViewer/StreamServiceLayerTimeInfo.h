@@ -39,9 +39,10 @@ public:
 
     static StreamServiceLayerTimeInfo* createFromJson(QJsonValue &timeInfoValue, QObject *parent = nullptr);
 
-    QString trackIdField() const;
-    QString startTimeField() const;
-    QString endTimeField() const;
+    const QString& trackIdField() const;
+    const QString& startTimeField() const;
+    const QString& endTimeField() const;
+    qint64 trackTimeToLive() const;
 
 signals:
 
@@ -49,6 +50,7 @@ private:
     QString m_trackIdField;
     QString m_startTimeField;
     QString m_endTimeField;
+    qint64 m_trackTimeToLive = 0;
 };
 
 #endif // STREAMSERVICELAYERTIMEINFO_H
@@ -0,0 +1,125 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceLruList.h"
+
+StreamServiceLruList::StreamServiceLruList()
+{
+}
+
+void StreamServiceLruList::touch(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (m_linked.size() <= handleIndex)
+    {
+        const int handleCount = qMax(handleIndex + 1, 2 * m_linked.size());
+        m_next.resize(handleCount);
+        m_previous.resize(handleCount);
+        m_linked.resize(handleCount);
+    }
+
+    if (m_linked[handleIndex])
+    {
+        if (m_mostRecent == handle)
+        {
+            return;
+        }
+        unlink(handle);
+    }
+
+    // Link in front of the most recent handle
+    m_previous[handleIndex] = NoHandle;
+    m_next[handleIndex] = m_mostRecent;
+    if (NoHandle != m_mostRecent)
+    {
+        m_previous[static_cast<int>(m_mostRecent)] = handle;
+    }
+    m_mostRecent = handle;
+    if (NoHandle == m_leastRecent)
+    {
+        m_leastRecent = handle;
+    }
+    m_linked[handleIndex] = true;
+    m_size++;
+}
+
+void StreamServiceLruList::remove(quint32 handle)
+{
+    if (contains(handle))
+    {
+        unlink(handle);
+    }
+}
+
+bool StreamServiceLruList::contains(quint32 handle) const
+{
+    return handle < static_cast<quint32>(m_linked.size()) && m_linked[static_cast<int>(handle)];
+}
+
+void StreamServiceLruList::clear()
+{
+    m_next.clear();
+    m_previous.clear();
+    m_linked.clear();
+    m_mostRecent = NoHandle;
+    m_leastRecent = NoHandle;
+    m_size = 0;
+}
+
+quint32 StreamServiceLruList::leastRecent() const
+{
+    return m_leastRecent;
+}
+
+int StreamServiceLruList::size() const
+{
+    return m_size;
+}
+
+void StreamServiceLruList::unlink(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    const quint32 next = m_next[handleIndex];
+    const quint32 previous = m_previous[handleIndex];
+    if (NoHandle != previous)
+    {
+        m_next[static_cast<int>(previous)] = next;
+    }
+    else
+    {
+        m_mostRecent = next;
+    }
+
+    if (NoHandle != next)
+    {
+        m_previous[static_cast<int>(next)] = previous;
+    }
+    else
+    {
+        m_leastRecent = previous;
+    }
+    m_linked[handleIndex] = false;
+    m_size--;
+}
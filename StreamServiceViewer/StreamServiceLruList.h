@@ -0,0 +1,62 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICELRULIST_H
+#define STREAMSERVICELRULIST_H
+
+#include <QVector>
+
+///
+/// \brief The StreamServiceLruList class
+/// Intrusive recency list over track handles, touching and removing are O(1).
+///
+class StreamServiceLruList
+{
+public:
+    static const quint32 NoHandle = 0xFFFFFFFFu;
+
+    StreamServiceLruList();
+
+    void touch(quint32 handle);
+    void remove(quint32 handle);
+    bool contains(quint32 handle) const;
+    void clear();
+
+    quint32 leastRecent() const;
+    int size() const;
+
+private:
+    void unlink(quint32 handle);
+
+    QVector<quint32> m_next;
+    QVector<quint32> m_previous;
+    QVector<bool> m_linked;
+    quint32 m_mostRecent = NoHandle;
+    quint32 m_leastRecent = NoHandle;
+    int m_size = 0;
+};
+
+#endif // STREAMSERVICELRULIST_H
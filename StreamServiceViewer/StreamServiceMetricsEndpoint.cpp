@@ -0,0 +1,175 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceMetricsEndpoint.h"
+
+#include <QDebug>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+namespace
+{
+// Scrape requests are tiny, larger ones are rejected
+const qint64 MaximumRequestSize = 8192;
+
+void appendHeader(QByteArray &text, const char *name, const char *help, const char *type)
+{
+    text += "# HELP ";
+    text += name;
+    text += ' ';
+    text += help;
+    text += "\n# TYPE ";
+    text += name;
+    text += ' ';
+    text += type;
+    text += '\n';
+}
+}
+
+StreamServiceMetricsEndpoint::StreamServiceMetricsEndpoint(QObject *parent) : QObject(parent),
+    m_server(new QTcpServer(this))
+{
+    connect(m_server, &QTcpServer::newConnection, this, &StreamServiceMetricsEndpoint::onNewConnection);
+}
+
+void StreamServiceMetricsEndpoint::setMetricsProvider(const MetricsProvider &metricsProvider)
+{
+    m_metricsProvider = metricsProvider;
+}
+
+bool StreamServiceMetricsEndpoint::listen(quint16 port)
+{
+    // Never exposed beyond the local machine
+    if (!m_server->listen(QHostAddress::LocalHost, port))
+    {
+        qWarning() << "Metrics endpoint failed to listen:" << m_server->errorString();
+        return false;
+    }
+
+    qDebug() << "Metrics endpoint listening on" << url();
+    return true;
+}
+
+QUrl StreamServiceMetricsEndpoint::url() const
+{
+    QUrl endpoint;
+    endpoint.setScheme(QStringLiteral("http"));
+    endpoint.setHost(m_server->serverAddress().toString());
+    endpoint.setPort(m_server->serverPort());
+    endpoint.setPath(QStringLiteral("/metrics"));
+    return endpoint;
+}
+
+void StreamServiceMetricsEndpoint::appendCounter(QByteArray &text, const char *name, const char *help, double value)
+{
+    appendHeader(text, name, help, "counter");
+    text += name;
+    text += ' ';
+    text += QByteArray::number(value, 'g', 17);
+    text += '\n';
+}
+
+void StreamServiceMetricsEndpoint::appendGauge(QByteArray &text, const char *name, const char *help, double value)
+{
+    appendHeader(text, name, help, "gauge");
+    text += name;
+    text += ' ';
+    text += QByteArray::number(value, 'g', 17);
+    text += '\n';
+}
+
+void StreamServiceMetricsEndpoint::appendSummary(QByteArray &text, const char *name, const char *help, const StreamServiceHistogram &histogram, double scale)
+{
+    appendHeader(text, name, help, "summary");
+    const double quantiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    for (double quantile : quantiles)
+    {
+        text += name;
+        text += "{quantile=\"";
+        text += QByteArray::number(quantile);
+        text += "\"} ";
+        text += QByteArray::number(histogram.quantile(quantile) * scale, 'g', 17);
+        text += '\n';
+    }
+    text += name;
+    text += "_sum ";
+    text += QByteArray::number(histogram.sum() * scale, 'g', 17);
+    text += '\n';
+    text += name;
+    text += "_count ";
+    text += QByteArray::number(histogram.count());
+    text += '\n';
+}
+
+void StreamServiceMetricsEndpoint::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QTcpSocket *socket = m_server->nextPendingConnection();
+        connect(socket, &QTcpSocket::readyRead, this, [this, socket]() {
+            onReadyRead(socket);
+        });
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+    }
+}
+
+void StreamServiceMetricsEndpoint::onReadyRead(QTcpSocket *socket)
+{
+    // Wait for the complete request header, the request line is all we need
+    QByteArray request = socket->peek(MaximumRequestSize);
+    if (!request.contains("\r\n\r\n"))
+    {
+        if (MaximumRequestSize <= request.size())
+        {
+            socket->abort();
+        }
+        return;
+    }
+    socket->readAll();
+
+    QByteArray status = "200 OK";
+    QByteArray body;
+    const QList<QByteArray> requestLine = request.left(request.indexOf("\r\n")).split(' ');
+    if (requestLine.size() < 2 || "GET" != requestLine.at(0))
+    {
+        status = "405 Method Not Allowed";
+    }
+    else if (!requestLine.at(1).startsWith("/metrics"))
+    {
+        status = "404 Not Found";
+    }
+    else if (m_metricsProvider)
+    {
+        body = m_metricsProvider();
+    }
+
+    QByteArray response = "HTTP/1.1 " + status + "\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " + QByteArray::number(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n";
+    response += body;
+    socket->write(response);
+    socket->disconnectFromHost();
+}
@@ -0,0 +1,73 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEMETRICSENDPOINT_H
+#define STREAMSERVICEMETRICSENDPOINT_H
+
+#include "StreamServiceHistogram.h"
+
+#include <QByteArray>
+#include <QObject>
+#include <QUrl>
+
+#include <functional>
+
+class QTcpServer;
+class QTcpSocket;
+
+///
+/// \brief The StreamServiceMetricsEndpoint class
+/// Serves the pipeline metrics in the Prometheus text format on localhost.
+/// The metrics are only collected when a scrape arrives, every request is answered and closed.
+///
+class StreamServiceMetricsEndpoint : public QObject
+{
+    Q_OBJECT
+public:
+    typedef std::function<QByteArray()> MetricsProvider;
+
+    explicit StreamServiceMetricsEndpoint(QObject *parent = nullptr);
+
+    void setMetricsProvider(const MetricsProvider &metricsProvider);
+    bool listen(quint16 port);
+    QUrl url() const;
+
+    // Prometheus text format, the histograms are written as summaries scaled by the factor
+    static void appendCounter(QByteArray &text, const char *name, const char *help, double value);
+    static void appendGauge(QByteArray &text, const char *name, const char *help, double value);
+    static void appendSummary(QByteArray &text, const char *name, const char *help, const StreamServiceHistogram &histogram, double scale);
+
+private slots:
+    void onNewConnection();
+
+private:
+    void onReadyRead(QTcpSocket *socket);
+
+    QTcpServer *m_server;
+    MetricsProvider m_metricsProvider;
+};
+
+#endif // STREAMSERVICEMETRICSENDPOINT_H
@@ -0,0 +1,135 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceProjection.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && 2 <= _M_IX86_FP)
+#include <emmintrin.h>
+#define STREAMSERVICE_SSE2
+#endif
+
+namespace
+{
+const double EarthRadius = 6378137.0;
+const double Pi = 3.14159265358979323846;
+const double DegreesToMeters = EarthRadius * Pi / 180.0;
+const double DegreesToRadians = Pi / 180.0;
+
+// Latitude of the square Web Mercator extent
+const double MaximumLatitude = 85.05112877980659;
+
+inline double projectLatitude(double latitude)
+{
+    const double clampedLatitude = qBound(-MaximumLatitude, latitude, MaximumLatitude);
+    return EarthRadius * std::atanh(std::sin(clampedLatitude * DegreesToRadians));
+}
+
+#ifdef STREAMSERVICE_SSE2
+inline __m128d select(__m128d mask, __m128d trueValue, __m128d falseValue)
+{
+    return _mm_or_pd(_mm_and_pd(mask, trueValue), _mm_andnot_pd(mask, falseValue));
+}
+
+// Sine for |angle| < pi/2, Taylor series up to the 23rd power which stays below one ulp there
+inline __m128d sine(__m128d angle)
+{
+    static const double coefficients[] = {
+        -1.0 / 6.0, 1.0 / 120.0, -1.0 / 5040.0, 1.0 / 362880.0, -1.0 / 39916800.0,
+        1.0 / 6227020800.0, -1.0 / 1307674368000.0, 1.0 / 355687428096000.0,
+        -1.0 / 121645100408832000.0, 1.0 / 51090942171709440000.0, -1.0 / 25852016738884976640000.0
+    };
+    const int coefficientCount = sizeof(coefficients) / sizeof(coefficients[0]);
+
+    const __m128d square = _mm_mul_pd(angle, angle);
+    __m128d sum = _mm_set1_pd(coefficients[coefficientCount - 1]);
+    for (int index = coefficientCount - 2; 0 <= index; index--)
+    {
+        sum = _mm_add_pd(_mm_mul_pd(sum, square), _mm_set1_pd(coefficients[index]));
+    }
+    return _mm_add_pd(angle, _mm_mul_pd(_mm_mul_pd(angle, square), sum));
+}
+
+// Natural logarithm of normal positive values, the mantissa is reduced to [sqrt(1/2), sqrt(2)) and expanded by atanh
+inline __m128d logarithm(__m128d value)
+{
+    const __m128i bits = _mm_castpd_si128(value);
+    const __m128i exponentBits = _mm_sub_epi32(_mm_srli_epi64(bits, 52), _mm_set1_epi32(1023));
+    __m128d exponent = _mm_cvtepi32_pd(_mm_shuffle_epi32(exponentBits, _MM_SHUFFLE(3, 1, 2, 0)));
+
+    const __m128i mantissaMask = _mm_set_epi32(0x000FFFFF, -1, 0x000FFFFF, -1);
+    const __m128i one = _mm_castpd_si128(_mm_set1_pd(1.0));
+    __m128d mantissa = _mm_castsi128_pd(_mm_or_si128(_mm_and_si128(bits, mantissaMask), one));
+
+    const __m128d large = _mm_cmpgt_pd(mantissa, _mm_set1_pd(1.4142135623730951));
+    mantissa = select(large, _mm_mul_pd(mantissa, _mm_set1_pd(0.5)), mantissa);
+    exponent = _mm_add_pd(exponent, _mm_and_pd(large, _mm_set1_pd(1.0)));
+
+    const __m128d ratio = _mm_div_pd(_mm_sub_pd(mantissa, _mm_set1_pd(1.0)), _mm_add_pd(mantissa, _mm_set1_pd(1.0)));
+    const __m128d square = _mm_mul_pd(ratio, ratio);
+    __m128d sum = _mm_set1_pd(1.0 / 23.0);
+    for (int denominator = 21; 1 <= denominator; denominator -= 2)
+    {
+        sum = _mm_add_pd(_mm_mul_pd(sum, square), _mm_set1_pd(1.0 / denominator));
+    }
+    const __m128d logMantissa = _mm_mul_pd(_mm_add_pd(ratio, ratio), sum);
+    return _mm_add_pd(_mm_mul_pd(exponent, _mm_set1_pd(0.6931471805599453)), logMantissa);
+}
+#endif
+}
+
+bool StreamServiceProjection::isWebMercator(int wkid)
+{
+    return WebMercatorWkid == wkid || 102100 == wkid || 102113 == wkid || 900913 == wkid;
+}
+
+void StreamServiceProjection::projectToWebMercator(double *x, double *y, int count)
+{
+    int index = 0;
+#ifdef STREAMSERVICE_SSE2
+    // y = R * atanh(sin(latitude)) = R / 2 * ln((1 + sin) / (1 - sin))
+    const __m128d degreesToMeters = _mm_set1_pd(DegreesToMeters);
+    const __m128d degreesToRadians = _mm_set1_pd(DegreesToRadians);
+    const __m128d maximumLatitude = _mm_set1_pd(MaximumLatitude);
+    const __m128d minimumLatitude = _mm_set1_pd(-MaximumLatitude);
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d halfRadius = _mm_set1_pd(EarthRadius / 2.0);
+    for (; index + 2 <= count; index += 2)
+    {
+        _mm_storeu_pd(x + index, _mm_mul_pd(_mm_loadu_pd(x + index), degreesToMeters));
+
+        const __m128d latitude = _mm_min_pd(_mm_max_pd(_mm_loadu_pd(y + index), minimumLatitude), maximumLatitude);
+        const __m128d sinLatitude = sine(_mm_mul_pd(latitude, degreesToRadians));
+        const __m128d ratio = _mm_div_pd(_mm_add_pd(one, sinLatitude), _mm_sub_pd(one, sinLatitude));
+        _mm_storeu_pd(y + index, _mm_mul_pd(halfRadius, logarithm(ratio)));
+    }
+#endif
+    for (; index < count; index++)
+    {
+        x[index] *= DegreesToMeters;
+        y[index] = projectLatitude(y[index]);
+    }
+}
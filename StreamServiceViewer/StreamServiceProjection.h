@@ -0,0 +1,49 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEPROJECTION_H
+#define STREAMSERVICEPROJECTION_H
+
+#include <QtGlobal>
+
+///
+/// Projection of geographic WGS84 coordinates into Web Mercator on the ingest thread.
+///
+/// The coordinates are projected in batches, two at a time with SSE2 where available.
+/// The kernel uses the spherical Web Mercator formulas the runtime uses and clamps the latitude to the Web Mercator extent.
+///
+namespace StreamServiceProjection
+{
+const int Wgs84Wkid = 4326;
+const int WebMercatorWkid = 3857;
+
+bool isWebMercator(int wkid);
+
+// Projects the coordinates in place, x holds the longitudes and y the latitudes in degrees
+void projectToWebMercator(double *x, double *y, int count);
+}
+
+#endif // STREAMSERVICEPROJECTION_H
@@ -0,0 +1,179 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceRelay.h"
+
+#include <QDebug>
+#include <QJsonDocument>
+#include <QWebSocketServer>
+
+StreamServiceRelay::StreamServiceRelay(const QUrl &upstreamEndpoint, QObject *parent) : QObject(parent),
+    m_server(new QWebSocketServer(QStringLiteral("StreamServiceRelay"), QWebSocketServer::NonSecureMode, this)),
+    m_upstreamEndpoint(upstreamEndpoint)
+{
+    connect(m_server, &QWebSocketServer::newConnection, this, &StreamServiceRelay::onNewConnection);
+    connect(&m_upstream, &QWebSocket::connected, this, &StreamServiceRelay::onUpstreamConnected);
+    connect(&m_upstream, &QWebSocket::textMessageReceived, this, &StreamServiceRelay::onUpstreamTextMessageReceived);
+
+    // Features arriving within one interval share a binary frame
+    m_flushTimer.setInterval(10);
+    connect(&m_flushTimer, &QTimer::timeout, this, &StreamServiceRelay::onFlushTimeout);
+}
+
+StreamServiceRelay::~StreamServiceRelay()
+{
+    m_upstream.close();
+    m_server->close();
+}
+
+bool StreamServiceRelay::listen(quint16 port)
+{
+    if (!m_server->listen(QHostAddress::LocalHost, port))
+    {
+        qWarning() << "Stream service relay failed to listen:" << m_server->errorString();
+        return false;
+    }
+
+    // Open the upstream websocket
+    QUrl subscribeEndpoint(m_upstreamEndpoint);
+    subscribeEndpoint.setPath(subscribeEndpoint.path() + QStringLiteral("/subscribe"));
+    m_upstream.open(subscribeEndpoint);
+    m_flushTimer.start();
+    qDebug() << "Stream service relay listening on" << localEndpoint();
+    return true;
+}
+
+QUrl StreamServiceRelay::localEndpoint() const
+{
+    QUrl endpoint;
+    endpoint.setScheme(QStringLiteral("ws"));
+    endpoint.setHost(m_server->serverAddress().toString());
+    endpoint.setPort(m_server->serverPort());
+    return endpoint;
+}
+
+void StreamServiceRelay::setDateFields(const QStringList &dateFields)
+{
+    m_encoder.setDateFields(dateFields);
+}
+
+void StreamServiceRelay::onNewConnection()
+{
+    while (m_server->hasPendingConnections())
+    {
+        QWebSocket *client = m_server->nextPendingConnection();
+        connect(client, &QWebSocket::disconnected, this, &StreamServiceRelay::onClientDisconnected);
+        connect(client, &QWebSocket::textMessageReceived, this, &StreamServiceRelay::onClientTextMessageReceived);
+
+        const QByteArray encoding = client->request().rawHeader(StreamServiceBinaryCodec::EncodingHeader);
+        if (encoding == StreamServiceBinaryCodec::EncodingName)
+        {
+            // Late joiners need the current schema first
+            client->sendBinaryMessage(m_encoder.schemaFrame());
+            m_binaryClients.append(client);
+        }
+        else
+        {
+            m_jsonClients.append(client);
+        }
+    }
+}
+
+void StreamServiceRelay::onClientDisconnected()
+{
+    QWebSocket *client = qobject_cast<QWebSocket*>(sender());
+    if (nullptr == client)
+    {
+        return;
+    }
+
+    m_jsonClients.removeOne(client);
+    m_binaryClients.removeOne(client);
+    client->deleteLater();
+}
+
+void StreamServiceRelay::onClientTextMessageReceived(const QString &message)
+{
+    // Clients only send filter requests
+    m_upstreamFilter = message;
+    if (QAbstractSocket::ConnectedState == m_upstream.state())
+    {
+        m_upstream.sendTextMessage(m_upstreamFilter);
+    }
+}
+
+void StreamServiceRelay::onUpstreamConnected()
+{
+    if (!m_upstreamFilter.isEmpty())
+    {
+        m_upstream.sendTextMessage(m_upstreamFilter);
+    }
+}
+
+void StreamServiceRelay::onUpstreamTextMessageReceived(const QString &message)
+{
+    for (QWebSocket *client : qAsConst(m_jsonClients))
+    {
+        client->sendTextMessage(message);
+    }
+
+    if (m_binaryClients.isEmpty())
+    {
+        return;
+    }
+
+    QJsonDocument featureDocument = QJsonDocument::fromJson(message.toUtf8());
+    if (!featureDocument.isObject())
+    {
+        qDebug() << "Relay received an unsupported text message!";
+        return;
+    }
+
+    // Filter replies and errors are not features, binary clients get them as text
+    QJsonObject featureObject = featureDocument.object();
+    if (featureObject.contains(QStringLiteral("filter")) || featureObject.contains(QStringLiteral("error")))
+    {
+        for (QWebSocket *client : qAsConst(m_binaryClients))
+        {
+            client->sendTextMessage(message);
+        }
+        return;
+    }
+
+    m_encoder.addFeature(featureObject);
+}
+
+void StreamServiceRelay::onFlushTimeout()
+{
+    m_encoder.flush();
+    const QList<QByteArray> frames = m_encoder.takeFrames();
+    for (auto const &frame : frames)
+    {
+        for (QWebSocket *client : qAsConst(m_binaryClients))
+        {
+            client->sendBinaryMessage(frame);
+        }
+    }
+}
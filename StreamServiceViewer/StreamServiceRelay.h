@@ -0,0 +1,79 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICERELAY_H
+#define STREAMSERVICERELAY_H
+
+#include "StreamServiceBinaryCodec.h"
+
+#include <QList>
+#include <QObject>
+#include <QTimer>
+#include <QUrl>
+#include <QWebSocket>
+
+class QWebSocketServer;
+
+///
+/// \brief The StreamServiceRelay class
+/// Subscribes to a stream service and republishes its features on a local websocket server.
+/// Clients offering the binary encoding receive batched binary frames, all others the original Esri JSON.
+/// Filter requests of the clients are forwarded upstream, the latest one applies to all clients.
+///
+class StreamServiceRelay : public QObject
+{
+    Q_OBJECT
+public:
+    explicit StreamServiceRelay(const QUrl &upstreamEndpoint, QObject *parent = nullptr);
+    ~StreamServiceRelay() override;
+
+    bool listen(quint16 port);
+    QUrl localEndpoint() const;
+
+    void setDateFields(const QStringList &dateFields);
+
+signals:
+
+private slots:
+    void onNewConnection();
+    void onClientDisconnected();
+    void onClientTextMessageReceived(const QString &message);
+    void onUpstreamConnected();
+    void onUpstreamTextMessageReceived(const QString &message);
+    void onFlushTimeout();
+
+private:
+    QWebSocketServer *m_server;
+    QWebSocket m_upstream;
+    QUrl m_upstreamEndpoint;
+    StreamServiceBinaryEncoder m_encoder;
+    QTimer m_flushTimer;
+    QList<QWebSocket*> m_jsonClients;
+    QList<QWebSocket*> m_binaryClients;
+    QString m_upstreamFilter;
+};
+
+#endif // STREAMSERVICERELAY_H
@@ -0,0 +1,519 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceSnapshot.h"
+
+#include <QDateTime>
+#include <QDebug>
+#include <QJsonValue>
+
+#include <cstring>
+#include <limits>
+
+namespace
+{
+const quint32 SnapshotMagic = 0x31535342;
+const quint32 SnapshotVersion = 1;
+
+// The mapping grows in steps of at least this size
+const qint64 MinimumMappedSize = 64 * 1024;
+
+enum class ValueType : quint8
+{
+    Null = 0,
+    Integer = 1,
+    Double = 2,
+    String = 3,
+    Boolean = 4
+};
+
+struct SnapshotHeader
+{
+    quint32 magic;
+    quint32 version;
+    qint64 savedAt;
+    qint32 wkid;
+    quint32 trackCount;
+    quint32 keyCount;
+    quint32 bodySize;
+    quint32 checksum;
+    quint32 reserved;
+};
+
+// FNV-1a, only detects torn or truncated writes
+quint32 checksum(const uchar *data, qint64 size)
+{
+    quint32 hash = 2166136261u;
+    for (qint64 index = 0; index < size; index++)
+    {
+        hash = (hash ^ data[index]) * 16777619u;
+    }
+    return hash;
+}
+
+template <typename T>
+void appendValue(QByteArray &buffer, T value)
+{
+    buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+///
+/// Reads from the mapped file, every read is checked against the end of the body.
+///
+class SnapshotReader
+{
+public:
+    SnapshotReader(const uchar *position, const uchar *end) :
+        m_position(position),
+        m_end(end)
+    {
+    }
+
+    template <typename T>
+    bool read(T &value)
+    {
+        if (m_end - m_position < static_cast<qint64>(sizeof(T)))
+        {
+            return false;
+        }
+        std::memcpy(&value, m_position, sizeof(T));
+        m_position += sizeof(T);
+        return true;
+    }
+
+    bool readString(QString &value)
+    {
+        quint32 size = 0;
+        if (!read(size) || m_end - m_position < static_cast<qint64>(size))
+        {
+            return false;
+        }
+        value = QString::fromUtf8(reinterpret_cast<const char*>(m_position), static_cast<int>(size));
+        m_position += size;
+        return true;
+    }
+
+    bool readBytes(QByteArray &value)
+    {
+        quint32 size = 0;
+        if (!read(size) || m_end - m_position < static_cast<qint64>(size))
+        {
+            return false;
+        }
+        value = QByteArray::fromRawData(reinterpret_cast<const char*>(m_position), static_cast<int>(size));
+        m_position += size;
+        return true;
+    }
+
+private:
+    const uchar *m_position;
+    const uchar *m_end;
+};
+}
+
+StreamServiceSnapshot::StreamServiceSnapshot()
+{
+}
+
+StreamServiceSnapshot::~StreamServiceSnapshot()
+{
+    close();
+}
+
+bool StreamServiceSnapshot::open(const QString &filePath, const QString &source)
+{
+    close();
+    m_file.setFileName(filePath);
+    if (!m_file.open(QIODevice::ReadWrite))
+    {
+        qWarning() << "Snapshot file" << filePath << "cannot be opened!";
+        return false;
+    }
+    m_source = source.toUtf8();
+    return true;
+}
+
+void StreamServiceSnapshot::close()
+{
+    if (nullptr != m_mapping)
+    {
+        m_file.unmap(m_mapping);
+        m_mapping = nullptr;
+        m_mappedSize = 0;
+    }
+    m_file.close();
+}
+
+bool StreamServiceSnapshot::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void StreamServiceSnapshot::begin(int wkid)
+{
+    m_wkid = wkid;
+    m_trackCount = 0;
+    m_trackBuffer.clear();
+    m_keyBuffer.clear();
+    m_keyIndices.clear();
+}
+
+int StreamServiceSnapshot::keyIndex(const QString &key)
+{
+    auto keyIterator = m_keyIndices.constFind(key);
+    if (keyIterator != m_keyIndices.cend())
+    {
+        return keyIterator.value();
+    }
+
+    if (std::numeric_limits<quint16>::max() <= m_keyIndices.size())
+    {
+        return -1;
+    }
+    appendString(m_keyBuffer, key);
+    return m_keyIndices.insert(key, static_cast<quint16>(m_keyIndices.size())).value();
+}
+
+void StreamServiceSnapshot::beginTrack(const QString &trackId, double x, double y, qint64 time)
+{
+    appendString(m_trackBuffer, trackId);
+    appendValue(m_trackBuffer, x);
+    appendValue(m_trackBuffer, y);
+    appendValue(m_trackBuffer, time);
+
+    // The attribute count is patched once the track is complete
+    m_attributeCountOffset = m_trackBuffer.size();
+    m_attributeCount = 0;
+    appendValue(m_trackBuffer, m_attributeCount);
+}
+
+void StreamServiceSnapshot::appendAttribute(int keyIndex, StreamServiceFieldSchema::FieldType type, const StreamServiceAttributeValue &value)
+{
+    if (keyIndex < 0 || StreamServiceAttributeValue::State::Missing == value.state)
+    {
+        return;
+    }
+
+    appendValue(m_trackBuffer, static_cast<quint16>(keyIndex));
+    if (StreamServiceAttributeValue::State::Null == value.state)
+    {
+        appendValue(m_trackBuffer, static_cast<quint8>(ValueType::Null));
+        m_attributeCount++;
+        return;
+    }
+
+    switch (type)
+    {
+    case StreamServiceFieldSchema::FieldType::Integer:
+    case StreamServiceFieldSchema::FieldType::Date:
+        appendValue(m_trackBuffer, static_cast<quint8>(ValueType::Integer));
+        appendValue(m_trackBuffer, value.integer);
+        break;
+    case StreamServiceFieldSchema::FieldType::Double:
+        appendValue(m_trackBuffer, static_cast<quint8>(ValueType::Double));
+        appendValue(m_trackBuffer, value.number);
+        break;
+    case StreamServiceFieldSchema::FieldType::String:
+        appendValue(m_trackBuffer, static_cast<quint8>(ValueType::String));
+        appendString(m_trackBuffer, value.string);
+        break;
+    }
+    m_attributeCount++;
+}
+
+void StreamServiceSnapshot::appendAttributes(const QVariantMap &attributes)
+{
+    for (auto attributeIterator = attributes.cbegin(); attributeIterator != attributes.cend(); ++attributeIterator)
+    {
+        const QVariant &value = attributeIterator.value();
+        ValueType valueType;
+        switch (value.userType())
+        {
+        case QMetaType::UnknownType:
+        case QMetaType::Nullptr:
+            valueType = ValueType::Null;
+            break;
+        case QMetaType::Int:
+        case QMetaType::UInt:
+        case QMetaType::LongLong:
+            valueType = ValueType::Integer;
+            break;
+        case QMetaType::Double:
+        case QMetaType::Float:
+            valueType = ValueType::Double;
+            break;
+        case QMetaType::QString:
+            valueType = ValueType::String;
+            break;
+        case QMetaType::Bool:
+            valueType = ValueType::Boolean;
+            break;
+        default:
+            continue;
+        }
+
+        const int attributeKeyIndex = keyIndex(attributeIterator.key());
+        if (attributeKeyIndex < 0)
+        {
+            continue;
+        }
+
+        appendValue(m_trackBuffer, static_cast<quint16>(attributeKeyIndex));
+        appendValue(m_trackBuffer, static_cast<quint8>(valueType));
+        switch (valueType)
+        {
+        case ValueType::Null:
+            break;
+        case ValueType::Integer:
+            appendValue(m_trackBuffer, static_cast<qint64>(value.toLongLong()));
+            break;
+        case ValueType::Double:
+            appendValue(m_trackBuffer, value.toDouble());
+            break;
+        case ValueType::String:
+            appendString(m_trackBuffer, value.toString());
+            break;
+        case ValueType::Boolean:
+            appendValue(m_trackBuffer, static_cast<quint8>(value.toBool() ? 1 : 0));
+            break;
+        }
+        m_attributeCount++;
+    }
+}
+
+void StreamServiceSnapshot::endTrack()
+{
+    std::memcpy(m_trackBuffer.data() + m_attributeCountOffset, &m_attributeCount, sizeof(m_attributeCount));
+    m_trackCount++;
+}
+
+bool StreamServiceSnapshot::commit()
+{
+    if (!isOpen())
+    {
+        return false;
+    }
+
+    const qint64 bodySize = static_cast<qint64>(sizeof(quint32)) + m_source.size() + m_keyBuffer.size() + m_trackBuffer.size();
+    if (!ensureMapped(static_cast<qint64>(sizeof(SnapshotHeader)) + bodySize))
+    {
+        return false;
+    }
+
+    // Invalidate the previous snapshot before overwriting its body
+    SnapshotHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(m_mapping, &header, sizeof(header));
+
+    uchar *body = m_mapping + sizeof(SnapshotHeader);
+    uchar *position = body;
+    const quint32 sourceSize = static_cast<quint32>(m_source.size());
+    std::memcpy(position, &sourceSize, sizeof(sourceSize));
+    position += sizeof(sourceSize);
+    std::memcpy(position, m_source.constData(), m_source.size());
+    position += m_source.size();
+    std::memcpy(position, m_keyBuffer.constData(), m_keyBuffer.size());
+    position += m_keyBuffer.size();
+    std::memcpy(position, m_trackBuffer.constData(), m_trackBuffer.size());
+
+    header.magic = SnapshotMagic;
+    header.version = SnapshotVersion;
+    header.savedAt = QDateTime::currentMSecsSinceEpoch();
+    header.wkid = m_wkid;
+    header.trackCount = m_trackCount;
+    header.keyCount = static_cast<quint32>(m_keyIndices.size());
+    header.bodySize = static_cast<quint32>(bodySize);
+    header.checksum = checksum(body, bodySize);
+    std::memcpy(m_mapping, &header, sizeof(header));
+    return true;
+}
+
+bool StreamServiceSnapshot::read(const QString &filePath, const QString &source, qint64 maximumAge, int &wkid, QVector<StreamServiceSnapshotTrack> &tracks)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || file.size() < static_cast<qint64>(sizeof(SnapshotHeader)))
+    {
+        return false;
+    }
+
+    const uchar *mapping = file.map(0, file.size());
+    if (nullptr == mapping)
+    {
+        return false;
+    }
+
+    SnapshotHeader header;
+    std::memcpy(&header, mapping, sizeof(header));
+    if (SnapshotMagic != header.magic || SnapshotVersion != header.version
+            || file.size() - static_cast<qint64>(sizeof(SnapshotHeader)) < static_cast<qint64>(header.bodySize))
+    {
+        return false;
+    }
+
+    if (0 < maximumAge && maximumAge < QDateTime::currentMSecsSinceEpoch() - header.savedAt)
+    {
+        qDebug() << "Snapshot is outdated, saved at" << QDateTime::fromMSecsSinceEpoch(header.savedAt).toString(Qt::ISODate);
+        return false;
+    }
+
+    const uchar *body = mapping + sizeof(SnapshotHeader);
+    if (header.checksum != checksum(body, header.bodySize))
+    {
+        qDebug() << "Snapshot is corrupted!";
+        return false;
+    }
+
+    SnapshotReader reader(body, body + header.bodySize);
+    QByteArray snapshotSource;
+    if (!reader.readBytes(snapshotSource) || snapshotSource != source.toUtf8())
+    {
+        return false;
+    }
+
+    QVector<QString> keys(static_cast<int>(header.keyCount));
+    for (QString &key : keys)
+    {
+        if (!reader.readString(key))
+        {
+            return false;
+        }
+    }
+
+    QVector<StreamServiceSnapshotTrack> snapshotTracks(static_cast<int>(header.trackCount));
+    for (StreamServiceSnapshotTrack &track : snapshotTracks)
+    {
+        quint16 attributeCount = 0;
+        if (!reader.readString(track.trackId) || !reader.read(track.x) || !reader.read(track.y)
+                || !reader.read(track.time) || !reader.read(attributeCount))
+        {
+            return false;
+        }
+
+        for (int attributeIndex = 0; attributeIndex < attributeCount; attributeIndex++)
+        {
+            quint16 keyIndex = 0;
+            quint8 valueType = 0;
+            if (!reader.read(keyIndex) || !reader.read(valueType) || keys.size() <= keyIndex)
+            {
+                return false;
+            }
+
+            QVariant value;
+            switch (static_cast<ValueType>(valueType))
+            {
+            case ValueType::Null:
+                value = QJsonValue(QJsonValue::Null).toVariant();
+                break;
+            case ValueType::Integer:
+            {
+                qint64 integer = 0;
+                if (!reader.read(integer))
+                {
+                    return false;
+                }
+                value = static_cast<qlonglong>(integer);
+                break;
+            }
+            case ValueType::Double:
+            {
+                double number = 0.0;
+                if (!reader.read(number))
+                {
+                    return false;
+                }
+                value = number;
+                break;
+            }
+            case ValueType::String:
+            {
+                QString text;
+                if (!reader.readString(text))
+                {
+                    return false;
+                }
+                value = text;
+                break;
+            }
+            case ValueType::Boolean:
+            {
+                quint8 boolean = 0;
+                if (!reader.read(boolean))
+                {
+                    return false;
+                }
+                value = (0 != boolean);
+                break;
+            }
+            default:
+                return false;
+            }
+            track.attributes.insert(keys[keyIndex], value);
+        }
+    }
+
+    wkid = header.wkid;
+    tracks = snapshotTracks;
+    return true;
+}
+
+bool StreamServiceSnapshot::ensureMapped(qint64 size)
+{
+    if (size <= m_mappedSize)
+    {
+        return true;
+    }
+
+    // Growing geometrically, so that a slowly growing snapshot is not remapped on every commit
+    const qint64 previousMappedSize = m_mappedSize;
+    if (nullptr != m_mapping)
+    {
+        m_file.unmap(m_mapping);
+        m_mapping = nullptr;
+        m_mappedSize = 0;
+    }
+
+    const qint64 mappedSize = qMax(size, qMax(2 * previousMappedSize, MinimumMappedSize));
+    if (!m_file.resize(mappedSize))
+    {
+        qWarning() << "Snapshot file" << m_file.fileName() << "cannot be resized!";
+        return false;
+    }
+
+    m_mapping = m_file.map(0, mappedSize);
+    if (nullptr == m_mapping)
+    {
+        qWarning() << "Snapshot file" << m_file.fileName() << "cannot be mapped!";
+        return false;
+    }
+    m_mappedSize = mappedSize;
+    return true;
+}
+
+void StreamServiceSnapshot::appendString(QByteArray &buffer, const QString &value)
+{
+    const QByteArray utf8 = value.toUtf8();
+    appendValue(buffer, static_cast<quint32>(utf8.size()));
+    buffer.append(utf8);
+}
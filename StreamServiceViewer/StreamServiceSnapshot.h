@@ -0,0 +1,100 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICESNAPSHOT_H
+#define STREAMSERVICESNAPSHOT_H
+
+#include "StreamServiceFieldSchema.h"
+
+#include <QByteArray>
+#include <QFile>
+#include <QHash>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+struct StreamServiceSnapshotTrack
+{
+    QString trackId;
+    double x = 0.0;
+    double y = 0.0;
+    qint64 time = 0;
+    QVariantMap attributes;
+};
+
+///
+/// \brief The StreamServiceSnapshot class
+/// Compact snapshot of the live track positions and attributes in a memory-mapped file.
+///
+/// The file stays mapped while writing, every commit overwrites the previous snapshot in place.
+/// The header is written last and carries a checksum, an interrupted commit is never read.
+/// Attribute names are stored once in a key table, the values are typed.
+/// The file uses the byte order of the machine writing it and is only meant to be read by it.
+///
+class StreamServiceSnapshot
+{
+public:
+    StreamServiceSnapshot();
+    ~StreamServiceSnapshot();
+
+    // The source identifies the stream service, snapshots of another source are never read
+    bool open(const QString &filePath, const QString &source);
+    void close();
+    bool isOpen() const;
+
+    void begin(int wkid);
+
+    // Registers an attribute name for the typed values, returns -1 once the key table is full
+    int keyIndex(const QString &key);
+
+    // Tracks are written between beginTrack and endTrack, a later value of a key replaces an earlier one when read
+    void beginTrack(const QString &trackId, double x, double y, qint64 time);
+    void appendAttribute(int keyIndex, StreamServiceFieldSchema::FieldType type, const StreamServiceAttributeValue &value);
+    void appendAttributes(const QVariantMap &attributes);
+    void endTrack();
+    bool commit();
+
+    // Rejects snapshots of another source, older than the maximum age or corrupted
+    static bool read(const QString &filePath, const QString &source, qint64 maximumAge, int &wkid, QVector<StreamServiceSnapshotTrack> &tracks);
+
+private:
+    bool ensureMapped(qint64 size);
+    void appendString(QByteArray &buffer, const QString &value);
+
+    QFile m_file;
+    uchar *m_mapping = nullptr;
+    qint64 m_mappedSize = 0;
+    QByteArray m_source;
+    int m_wkid = 0;
+    quint32 m_trackCount = 0;
+    QByteArray m_trackBuffer;
+    QByteArray m_keyBuffer;
+    QHash<QString, quint16> m_keyIndices;
+    int m_attributeCountOffset = 0;
+    quint16 m_attributeCount = 0;
+};
+
+#endif // STREAMSERVICESNAPSHOT_H
@@ -0,0 +1,274 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceSpatialIndex.h"
+
+#include <cmath>
+
+namespace
+{
+// Keeps the cell coordinates inside the key range for any input
+const double MaximumCellCoordinate = 1073741823.0;
+}
+
+StreamServiceSpatialIndex::StreamServiceSpatialIndex(double cellSize) :
+    m_cellSize(0 < cellSize ? cellSize : 1.0)
+{
+}
+
+double StreamServiceSpatialIndex::cellSize() const
+{
+    return m_cellSize;
+}
+
+void StreamServiceSpatialIndex::setCellSize(double cellSize)
+{
+    if (cellSize <= 0 || cellSize == m_cellSize)
+    {
+        return;
+    }
+
+    // Every position is assigned to its new cell
+    m_cellSize = cellSize;
+    m_cells.clear();
+    for (int handleIndex = 0; handleIndex < m_cellSlots.size(); handleIndex++)
+    {
+        if (m_cellSlots[handleIndex] < 0)
+        {
+            continue;
+        }
+
+        const quint64 key = cellKey(cellCoordinate(m_x[handleIndex]), cellCoordinate(m_y[handleIndex]));
+        QVector<quint32> &cell = m_cells[key];
+        m_cellKeys[handleIndex] = key;
+        m_cellSlots[handleIndex] = cell.size();
+        cell.append(static_cast<quint32>(handleIndex));
+    }
+}
+
+void StreamServiceSpatialIndex::insert(quint32 handle, double x, double y)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (m_cellSlots.size() <= handleIndex)
+    {
+        const int handleCapacity = qMax(handleIndex + 1, 2 * m_cellSlots.size());
+        m_x.resize(handleCapacity);
+        m_y.resize(handleCapacity);
+        m_cellKeys.resize(handleCapacity);
+        m_cellSlots.insert(m_cellSlots.end(), handleCapacity - m_cellSlots.size(), -1);
+    }
+
+    m_x[handleIndex] = x;
+    m_y[handleIndex] = y;
+    const quint64 key = cellKey(cellCoordinate(x), cellCoordinate(y));
+    if (0 <= m_cellSlots[handleIndex])
+    {
+        // Most position updates stay within the cell
+        if (key == m_cellKeys[handleIndex])
+        {
+            return;
+        }
+        removeFromCell(handle);
+    }
+    else
+    {
+        m_size++;
+    }
+
+    QVector<quint32> &cell = m_cells[key];
+    m_cellKeys[handleIndex] = key;
+    m_cellSlots[handleIndex] = cell.size();
+    cell.append(handle);
+}
+
+void StreamServiceSpatialIndex::remove(quint32 handle)
+{
+    if (!contains(handle))
+    {
+        return;
+    }
+
+    removeFromCell(handle);
+    m_cellSlots[static_cast<int>(handle)] = -1;
+    m_size--;
+}
+
+bool StreamServiceSpatialIndex::contains(quint32 handle) const
+{
+    return 0 <= m_cellSlots.value(static_cast<int>(handle), -1);
+}
+
+void StreamServiceSpatialIndex::clear()
+{
+    m_cells.clear();
+    m_x.clear();
+    m_y.clear();
+    m_cellKeys.clear();
+    m_cellSlots.clear();
+    m_size = 0;
+}
+
+int StreamServiceSpatialIndex::size() const
+{
+    return m_size;
+}
+
+double StreamServiceSpatialIndex::x(quint32 handle) const
+{
+    return m_x[static_cast<int>(handle)];
+}
+
+double StreamServiceSpatialIndex::y(quint32 handle) const
+{
+    return m_y[static_cast<int>(handle)];
+}
+
+void StreamServiceSpatialIndex::queryExtent(double xMin, double yMin, double xMax, double yMax, QVector<quint32> &handles) const
+{
+    visitCells(xMin, yMin, xMax, yMax, [&](const QVector<quint32> &cell) {
+        for (quint32 handle : cell)
+        {
+            const int handleIndex = static_cast<int>(handle);
+            const double x = m_x[handleIndex];
+            const double y = m_y[handleIndex];
+            if (xMin <= x && x <= xMax && yMin <= y && y <= yMax)
+            {
+                handles.append(handle);
+            }
+        }
+    });
+}
+
+void StreamServiceSpatialIndex::queryRadius(double x, double y, double radius, QVector<quint32> &handles) const
+{
+    const double squaredRadius = radius * radius;
+    visitCells(x - radius, y - radius, x + radius, y + radius, [&](const QVector<quint32> &cell) {
+        for (quint32 handle : cell)
+        {
+            const int handleIndex = static_cast<int>(handle);
+            const double deltaX = m_x[handleIndex] - x;
+            const double deltaY = m_y[handleIndex] - y;
+            if (deltaX * deltaX + deltaY * deltaY <= squaredRadius)
+            {
+                handles.append(handle);
+            }
+        }
+    });
+}
+
+quint32 StreamServiceSpatialIndex::nearest(double x, double y, double radius) const
+{
+    quint32 nearestHandle = NoHandle;
+    double nearestSquaredDistance = radius * radius;
+    visitCells(x - radius, y - radius, x + radius, y + radius, [&](const QVector<quint32> &cell) {
+        for (quint32 handle : cell)
+        {
+            const int handleIndex = static_cast<int>(handle);
+            const double deltaX = m_x[handleIndex] - x;
+            const double deltaY = m_y[handleIndex] - y;
+            const double squaredDistance = deltaX * deltaX + deltaY * deltaY;
+            if (squaredDistance <= nearestSquaredDistance)
+            {
+                nearestSquaredDistance = squaredDistance;
+                nearestHandle = handle;
+            }
+        }
+    });
+    return nearestHandle;
+}
+
+qint32 StreamServiceSpatialIndex::cellCoordinate(double coordinate) const
+{
+    const double cell = std::floor(coordinate / m_cellSize);
+    if (std::isnan(cell))
+    {
+        return 0;
+    }
+    return static_cast<qint32>(qBound(-MaximumCellCoordinate, cell, MaximumCellCoordinate));
+}
+
+quint64 StreamServiceSpatialIndex::cellKey(qint32 column, qint32 row)
+{
+    return (static_cast<quint64>(static_cast<quint32>(column)) << 32) | static_cast<quint32>(row);
+}
+
+void StreamServiceSpatialIndex::removeFromCell(quint32 handle)
+{
+    // Swap with the last handle of the cell, its slot moves to the freed one
+    const int handleIndex = static_cast<int>(handle);
+    auto cellIterator = m_cells.find(m_cellKeys[handleIndex]);
+    QVector<quint32> &cell = cellIterator.value();
+    const int slot = m_cellSlots[handleIndex];
+    const quint32 lastHandle = cell.last();
+    cell[slot] = lastHandle;
+    m_cellSlots[static_cast<int>(lastHandle)] = slot;
+    cell.removeLast();
+    if (cell.isEmpty())
+    {
+        m_cells.erase(cellIterator);
+    }
+}
+
+template<typename Visitor>
+void StreamServiceSpatialIndex::visitCells(double xMin, double yMin, double xMax, double yMax, Visitor visitor) const
+{
+    if (xMax < xMin || yMax < yMin || m_cells.isEmpty())
+    {
+        return;
+    }
+
+    const qint32 columnMin = cellCoordinate(xMin);
+    const qint32 columnMax = cellCoordinate(xMax);
+    const qint32 rowMin = cellCoordinate(yMin);
+    const qint32 rowMax = cellCoordinate(yMax);
+    const double rangeCellCount = (double(columnMax) - columnMin + 1) * (double(rowMax) - rowMin + 1);
+
+    // Large ranges are cheaper to answer by walking the occupied cells
+    if (m_cells.size() < rangeCellCount)
+    {
+        for (auto cellIterator = m_cells.cbegin(); cellIterator != m_cells.cend(); ++cellIterator)
+        {
+            const qint32 column = static_cast<qint32>(static_cast<quint32>(cellIterator.key() >> 32));
+            const qint32 row = static_cast<qint32>(static_cast<quint32>(cellIterator.key()));
+            if (columnMin <= column && column <= columnMax && rowMin <= row && row <= rowMax)
+            {
+                visitor(cellIterator.value());
+            }
+        }
+        return;
+    }
+
+    for (qint32 column = columnMin; column <= columnMax; column++)
+    {
+        for (qint32 row = rowMin; row <= rowMax; row++)
+        {
+            auto cellIterator = m_cells.constFind(cellKey(column, row));
+            if (cellIterator != m_cells.cend())
+            {
+                visitor(cellIterator.value());
+            }
+        }
+    }
+}
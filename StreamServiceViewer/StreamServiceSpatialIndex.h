@@ -0,0 +1,80 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICESPATIALINDEX_H
+#define STREAMSERVICESPATIALINDEX_H
+
+#include <QHash>
+#include <QVector>
+
+///
+/// \brief The StreamServiceSpatialIndex class
+/// Sparse uniform grid over the track positions indexed by track handle.
+/// Moving a track within its cell only updates its position, changing the cell
+/// swaps it out of the old cell's handle list. Queries only visit the cells
+/// overlapping the query rectangle and filter by the exact positions.
+///
+class StreamServiceSpatialIndex
+{
+public:
+    static const quint32 NoHandle = 0xFFFFFFFF;
+
+    explicit StreamServiceSpatialIndex(double cellSize = 1.0);
+
+    double cellSize() const;
+    void setCellSize(double cellSize);
+
+    void insert(quint32 handle, double x, double y);
+    void remove(quint32 handle);
+    bool contains(quint32 handle) const;
+    void clear();
+    int size() const;
+
+    double x(quint32 handle) const;
+    double y(quint32 handle) const;
+
+    void queryExtent(double xMin, double yMin, double xMax, double yMax, QVector<quint32> &handles) const;
+    void queryRadius(double x, double y, double radius, QVector<quint32> &handles) const;
+
+    // The handle closest to the location within the radius, or NoHandle
+    quint32 nearest(double x, double y, double radius) const;
+
+private:
+    qint32 cellCoordinate(double coordinate) const;
+    static quint64 cellKey(qint32 column, qint32 row);
+    void removeFromCell(quint32 handle);
+    template<typename Visitor> void visitCells(double xMin, double yMin, double xMax, double yMax, Visitor visitor) const;
+
+    double m_cellSize;
+    QHash<quint64, QVector<quint32>> m_cells;
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<quint64> m_cellKeys;
+    QVector<int> m_cellSlots;
+    int m_size = 0;
+};
+
+#endif // STREAMSERVICESPATIALINDEX_H
@@ -0,0 +1,102 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceStringPool.h"
+
+StreamServiceStringPool::StreamServiceStringPool()
+{
+    clear();
+}
+
+quint32 StreamServiceStringPool::intern(const QString &value)
+{
+    if (value.isNull())
+    {
+        return NullId;
+    }
+
+    auto idIterator = m_ids.constFind(value);
+    if (idIterator != m_ids.cend())
+    {
+        m_referenceCounts[static_cast<int>(idIterator.value())]++;
+        return idIterator.value();
+    }
+
+    quint32 id;
+    if (m_freeIds.isEmpty())
+    {
+        id = static_cast<quint32>(m_strings.size());
+        m_strings.append(value);
+        m_referenceCounts.append(1);
+    }
+    else
+    {
+        id = m_freeIds.takeLast();
+        m_strings[static_cast<int>(id)] = value;
+        m_referenceCounts[static_cast<int>(id)] = 1;
+    }
+    m_ids.insert(value, id);
+    return id;
+}
+
+void StreamServiceStringPool::release(quint32 id)
+{
+    if (NullId == id)
+    {
+        return;
+    }
+
+    const int idIndex = static_cast<int>(id);
+    if (0 < --m_referenceCounts[idIndex])
+    {
+        return;
+    }
+
+    m_ids.remove(m_strings[idIndex]);
+    m_strings[idIndex] = QString();
+    m_freeIds.append(id);
+}
+
+void StreamServiceStringPool::clear()
+{
+    m_ids.clear();
+    m_strings.clear();
+    m_referenceCounts.clear();
+    m_freeIds.clear();
+
+    // The null string
+    m_strings.append(QString());
+    m_referenceCounts.append(0);
+}
+
+const QString& StreamServiceStringPool::string(quint32 id) const
+{
+    return m_strings[static_cast<int>(id)];
+}
+
+int StreamServiceStringPool::size() const
+{
+    return m_ids.size();
+}
@@ -0,0 +1,61 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICESTRINGPOOL_H
+#define STREAMSERVICESTRINGPOOL_H
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+///
+/// \brief The StreamServiceStringPool class
+/// Reference counted interning of attribute strings, every distinct value is stored once.
+/// Id zero is the null string and is never released.
+///
+class StreamServiceStringPool
+{
+public:
+    static const quint32 NullId = 0;
+
+    StreamServiceStringPool();
+
+    // Every intern needs a matching release
+    quint32 intern(const QString &value);
+    void release(quint32 id);
+    void clear();
+
+    const QString& string(quint32 id) const;
+    int size() const;
+
+private:
+    QHash<QString, quint32> m_ids;
+    QVector<QString> m_strings;
+    QVector<quint32> m_referenceCounts;
+    QVector<quint32> m_freeIds;
+};
+
+#endif // STREAMSERVICESTRINGPOOL_H
@@ -0,0 +1,230 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTimingWheel.h"
+
+namespace
+{
+const quint32 NoHandle = 0xFFFFFFFFu;
+
+// Level 0 has one slot per tick, every further level spans a whole lower level per slot
+const int LevelCount = 4;
+const int Level0Bits = 8;
+const int LevelBits = 6;
+const int Level0Size = 1 << Level0Bits;
+const int LevelSize = 1 << LevelBits;
+const int SlotCount = Level0Size + (LevelCount - 1) * LevelSize;
+
+int levelShift(int level)
+{
+    return (0 == level) ? 0 : Level0Bits + (level - 1) * LevelBits;
+}
+
+int levelOffset(int level)
+{
+    return (0 == level) ? 0 : Level0Size + (level - 1) * LevelSize;
+}
+
+int levelMask(int level)
+{
+    return (0 == level) ? Level0Size - 1 : LevelSize - 1;
+}
+}
+
+StreamServiceTimingWheel::StreamServiceTimingWheel() :
+    m_slotHeads(SlotCount, NoHandle)
+{
+}
+
+qint64 StreamServiceTimingWheel::currentTick() const
+{
+    return m_currentTick;
+}
+
+void StreamServiceTimingWheel::touch(quint32 handle, qint64 deadlineTick)
+{
+    ensureHandle(handle);
+    const int handleIndex = static_cast<int>(handle);
+    if (deadlineTick <= m_currentTick)
+    {
+        deadlineTick = m_currentTick + 1;
+    }
+
+    // A scheduled entry only moves its deadline, it is relinked when its slot comes up
+    if (NoHandle != m_slots[handleIndex])
+    {
+        if (m_deadlines[handleIndex] < deadlineTick)
+        {
+            m_deadlines[handleIndex] = deadlineTick;
+            return;
+        }
+
+        unlink(handle);
+    }
+
+    m_deadlines[handleIndex] = deadlineTick;
+    link(handle);
+}
+
+void StreamServiceTimingWheel::cancel(quint32 handle)
+{
+    if (isScheduled(handle))
+    {
+        unlink(handle);
+    }
+}
+
+bool StreamServiceTimingWheel::isScheduled(quint32 handle) const
+{
+    return handle < static_cast<quint32>(m_slots.size()) && NoHandle != m_slots[static_cast<int>(handle)];
+}
+
+void StreamServiceTimingWheel::clear()
+{
+    m_slotHeads.fill(NoHandle);
+    m_next.clear();
+    m_previous.clear();
+    m_slots.clear();
+    m_deadlines.clear();
+}
+
+void StreamServiceTimingWheel::advance(qint64 tick, QVector<quint32> &expiredHandles)
+{
+    while (m_currentTick < tick)
+    {
+        m_currentTick++;
+
+        // Refill the lower levels whenever a level wraps around
+        for (int level = 1; level < LevelCount; level++)
+        {
+            if (0 != (m_currentTick & ((qint64(1) << levelShift(level)) - 1)))
+            {
+                break;
+            }
+            cascade(level);
+        }
+
+        const int slot = static_cast<int>(m_currentTick & levelMask(0));
+        quint32 handle = m_slotHeads[slot];
+        while (NoHandle != handle)
+        {
+            const quint32 nextHandle = m_next[static_cast<int>(handle)];
+            unlink(handle);
+            if (m_currentTick < m_deadlines[static_cast<int>(handle)])
+            {
+                // Touched since it was scheduled
+                link(handle);
+            }
+            else
+            {
+                expiredHandles.append(handle);
+            }
+            handle = nextHandle;
+        }
+    }
+}
+
+void StreamServiceTimingWheel::ensureHandle(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (handleIndex < m_slots.size())
+    {
+        return;
+    }
+
+    const int handleCount = qMax(handleIndex + 1, 2 * m_slots.size());
+    m_next.resize(handleCount);
+    m_previous.resize(handleCount);
+    m_slots.insert(m_slots.end(), handleCount - m_slots.size(), NoHandle);
+    m_deadlines.resize(handleCount);
+}
+
+void StreamServiceTimingWheel::link(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    const qint64 deadlineTick = m_deadlines[handleIndex];
+    const qint64 delta = deadlineTick - m_currentTick;
+
+    // Pick the finest level whose range still covers the deadline
+    int level = 0;
+    while (level < LevelCount - 1 && delta >= (qint64(1) << levelShift(level + 1)))
+    {
+        level++;
+    }
+
+    qint64 slotTick = deadlineTick;
+    const qint64 maximumDelta = (qint64(1) << (levelShift(LevelCount - 1) + LevelBits)) - 1;
+    if (maximumDelta < delta)
+    {
+        // Beyond the wheel, parked in the last slot and rescheduled on the way
+        slotTick = m_currentTick + maximumDelta;
+    }
+
+    const int slot = levelOffset(level) + static_cast<int>((slotTick >> levelShift(level)) & levelMask(level));
+    const quint32 head = m_slotHeads[slot];
+    m_next[handleIndex] = head;
+    m_previous[handleIndex] = NoHandle;
+    if (NoHandle != head)
+    {
+        m_previous[static_cast<int>(head)] = handle;
+    }
+    m_slotHeads[slot] = handle;
+    m_slots[handleIndex] = static_cast<quint32>(slot);
+}
+
+void StreamServiceTimingWheel::unlink(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    const quint32 next = m_next[handleIndex];
+    const quint32 previous = m_previous[handleIndex];
+    if (NoHandle != previous)
+    {
+        m_next[static_cast<int>(previous)] = next;
+    }
+    else
+    {
+        m_slotHeads[static_cast<int>(m_slots[handleIndex])] = next;
+    }
+
+    if (NoHandle != next)
+    {
+        m_previous[static_cast<int>(next)] = previous;
+    }
+    m_slots[handleIndex] = NoHandle;
+}
+
+void StreamServiceTimingWheel::cascade(int level)
+{
+    const int slot = levelOffset(level) + static_cast<int>((m_currentTick >> levelShift(level)) & levelMask(level));
+    quint32 handle = m_slotHeads[slot];
+    m_slotHeads[slot] = NoHandle;
+    while (NoHandle != handle)
+    {
+        const quint32 nextHandle = m_next[static_cast<int>(handle)];
+        m_slots[static_cast<int>(handle)] = NoHandle;
+        link(handle);
+        handle = nextHandle;
+    }
+}
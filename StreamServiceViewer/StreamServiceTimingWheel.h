@@ -0,0 +1,66 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICETIMINGWHEEL_H
+#define STREAMSERVICETIMINGWHEEL_H
+
+#include <QVector>
+
+///
+/// \brief The StreamServiceTimingWheel class
+/// Hierarchical timing wheel keyed by track handles.
+/// Scheduling, touching and expiring are O(1) per handle, advancing is O(1) per tick.
+/// Touching only moves the deadline, the entry is rescheduled lazily when its slot comes up.
+///
+class StreamServiceTimingWheel
+{
+public:
+    StreamServiceTimingWheel();
+
+    qint64 currentTick() const;
+
+    void touch(quint32 handle, qint64 deadlineTick);
+    void cancel(quint32 handle);
+    bool isScheduled(quint32 handle) const;
+    void clear();
+
+    void advance(qint64 tick, QVector<quint32> &expiredHandles);
+
+private:
+    void ensureHandle(quint32 handle);
+    void link(quint32 handle);
+    void unlink(quint32 handle);
+    void cascade(int level);
+
+    qint64 m_currentTick = 0;
+    QVector<quint32> m_slotHeads;
+    QVector<quint32> m_next;
+    QVector<quint32> m_previous;
+    QVector<quint32> m_slots;
+    QVector<qint64> m_deadlines;
+};
+
+#endif // STREAMSERVICETIMINGWHEEL_H
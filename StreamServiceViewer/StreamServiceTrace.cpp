@@ -0,0 +1,240 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTrace.h"
+#include "StreamServiceTrackUpdate.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+#include <QVector>
+
+#include <atomic>
+
+namespace
+{
+// Spans kept per thread, about 1.5 MB each
+const int ThreadBufferCapacity = 65536;
+
+struct TraceEvent
+{
+    const char *name;
+    qint64 startTime;
+    qint64 duration;
+};
+
+struct ThreadBuffer
+{
+    QMutex mutex;
+    QVector<TraceEvent> events;
+    int nextEvent = 0;
+    bool wrapped = false;
+    QString threadName;
+    int threadId = 0;
+
+    // Only touched by the owning thread
+    int depth = 0;
+    bool sampled = false;
+    quint64 rootCount = 0;
+};
+
+std::atomic<bool> traceEnabled{false};
+std::atomic<int> traceSamplingInterval{1};
+
+// The buffers outlive their threads, so that spans of finished threads can still be written
+QMutex registryMutex;
+QVector<ThreadBuffer*> threadBuffers;
+
+ThreadBuffer& threadBuffer()
+{
+    thread_local ThreadBuffer *buffer = nullptr;
+    if (nullptr == buffer)
+    {
+        buffer = new ThreadBuffer();
+        buffer->events.resize(ThreadBufferCapacity);
+        buffer->threadName = QThread::currentThread()->objectName();
+
+        QMutexLocker registryLocker(&registryMutex);
+        buffer->threadId = threadBuffers.size() + 1;
+        threadBuffers.append(buffer);
+    }
+    return *buffer;
+}
+
+void appendEvent(ThreadBuffer &buffer, const char *name, qint64 startTime, qint64 endTime)
+{
+    QMutexLocker bufferLocker(&buffer.mutex);
+    TraceEvent &event = buffer.events[buffer.nextEvent];
+    event.name = name;
+    event.startTime = startTime;
+    event.duration = endTime - startTime;
+    buffer.nextEvent++;
+    if (ThreadBufferCapacity == buffer.nextEvent)
+    {
+        buffer.nextEvent = 0;
+        buffer.wrapped = true;
+    }
+}
+
+QByteArray escapedName(const QString &name)
+{
+    QByteArray escaped = name.toUtf8();
+    escaped.replace('\\', "\\\\");
+    escaped.replace('"', "\\\"");
+    return escaped;
+}
+}
+
+void StreamServiceTrace::setEnabled(bool enabled)
+{
+    traceEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool StreamServiceTrace::isEnabled()
+{
+    return traceEnabled.load(std::memory_order_relaxed);
+}
+
+void StreamServiceTrace::setSamplingInterval(int samplingInterval)
+{
+    traceSamplingInterval.store(qMax(1, samplingInterval), std::memory_order_relaxed);
+}
+
+int StreamServiceTrace::samplingInterval()
+{
+    return traceSamplingInterval.load(std::memory_order_relaxed);
+}
+
+qint64 StreamServiceTrace::currentTime()
+{
+    return StreamServiceTrackUpdate::currentReceiveTime();
+}
+
+void StreamServiceTrace::recordSpan(const char *name, qint64 startTime, qint64 endTime)
+{
+    if (!isEnabled())
+    {
+        return;
+    }
+
+    // Outside of any scope the span is sampled on its own
+    ThreadBuffer &buffer = threadBuffer();
+    const bool sampled = (0 < buffer.depth) ? buffer.sampled : (0 == buffer.rootCount++ % static_cast<quint64>(samplingInterval()));
+    if (sampled)
+    {
+        appendEvent(buffer, name, startTime, endTime);
+    }
+}
+
+bool StreamServiceTrace::beginSpan()
+{
+    ThreadBuffer &buffer = threadBuffer();
+    if (0 == buffer.depth)
+    {
+        buffer.sampled = (0 == buffer.rootCount++ % static_cast<quint64>(samplingInterval()));
+    }
+    buffer.depth++;
+    return buffer.sampled;
+}
+
+void StreamServiceTrace::endSpan(const char *name, qint64 startTime, bool sampled)
+{
+    ThreadBuffer &buffer = threadBuffer();
+    buffer.depth--;
+    if (sampled)
+    {
+        appendEvent(buffer, name, startTime, currentTime());
+    }
+}
+
+bool StreamServiceTrace::writeChromeTrace(const QString &filePath)
+{
+    QFile traceFile(filePath);
+    if (!traceFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qWarning() << "Trace file could not be opened:" << traceFile.errorString();
+        return false;
+    }
+
+    const QByteArray processId = QByteArray::number(QCoreApplication::applicationPid());
+    QByteArray trace = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool firstEvent = true;
+    int eventCount = 0;
+
+    QMutexLocker registryLocker(&registryMutex);
+    for (ThreadBuffer *buffer : qAsConst(threadBuffers))
+    {
+        const QByteArray threadId = QByteArray::number(buffer->threadId);
+        const QString threadName = buffer->threadName.isEmpty() ? QStringLiteral("Thread %1").arg(buffer->threadId) : buffer->threadName;
+        if (!firstEvent)
+        {
+            trace += ',';
+        }
+        firstEvent = false;
+        trace += "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" + processId + ",\"tid\":" + threadId
+                + ",\"args\":{\"name\":\"" + escapedName(threadName) + "\"}}";
+
+        // Oldest span first, the timestamps are in microseconds
+        QMutexLocker bufferLocker(&buffer->mutex);
+        const int firstIndex = buffer->wrapped ? buffer->nextEvent : 0;
+        const int count = buffer->wrapped ? ThreadBufferCapacity : buffer->nextEvent;
+        for (int offset = 0; offset < count; offset++)
+        {
+            const TraceEvent &event = buffer->events[(firstIndex + offset) % ThreadBufferCapacity];
+            trace += ",\n{\"name\":\"";
+            trace += event.name;
+            trace += "\",\"ph\":\"X\",\"pid\":" + processId + ",\"tid\":" + threadId
+                    + ",\"ts\":" + QByteArray::number(event.startTime / 1000.0, 'f', 3)
+                    + ",\"dur\":" + QByteArray::number(event.duration / 1000.0, 'f', 3) + '}';
+        }
+        eventCount += count;
+
+        // Large traces are written in pieces
+        if (16 * 1024 * 1024 < trace.size())
+        {
+            traceFile.write(trace);
+            trace.clear();
+        }
+    }
+    trace += "\n]}\n";
+    traceFile.write(trace);
+
+    qDebug() << "Trace with" << eventCount << "spans written to" << filePath;
+    return true;
+}
+
+void StreamServiceTrace::clear()
+{
+    QMutexLocker registryLocker(&registryMutex);
+    for (ThreadBuffer *buffer : qAsConst(threadBuffers))
+    {
+        QMutexLocker bufferLocker(&buffer->mutex);
+        buffer->nextEvent = 0;
+        buffer->wrapped = false;
+    }
+}
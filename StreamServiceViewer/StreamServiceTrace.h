@@ -0,0 +1,114 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICETRACE_H
+#define STREAMSERVICETRACE_H
+
+#include <QString>
+
+///
+/// Tracing of the pipeline stages, written as Chrome trace JSON for chrome://tracing or Perfetto.
+///
+/// The trace points only exist when STREAMSERVICE_TRACING is defined, otherwise the macros are empty.
+/// At runtime the tracing stays off until it is enabled, a disabled trace point costs a relaxed load.
+/// Every thread records into its own bounded buffer, the oldest spans are overwritten.
+/// Sampling keeps one of every n outermost spans per thread together with all spans nested in it.
+///
+namespace StreamServiceTrace
+{
+void setEnabled(bool enabled);
+bool isEnabled();
+
+void setSamplingInterval(int samplingInterval);
+int samplingInterval();
+
+// Monotonic nanoseconds, the same clock as the receive times of the track updates
+qint64 currentTime();
+
+// Spans measured by the caller, e.g. across signals on the render thread
+void recordSpan(const char *name, qint64 startTime, qint64 endTime);
+
+bool writeChromeTrace(const QString &filePath);
+void clear();
+
+// Used by the scope, returns whether the span is sampled
+bool beginSpan();
+void endSpan(const char *name, qint64 startTime, bool sampled);
+}
+
+///
+/// \brief The StreamServiceTraceScope class
+/// Records a span from its construction up to its destruction.
+/// The name must be a string literal, it is referenced and not copied.
+///
+class StreamServiceTraceScope
+{
+public:
+    explicit StreamServiceTraceScope(const char *name) :
+        m_name(name)
+    {
+        if (!StreamServiceTrace::isEnabled())
+        {
+            return;
+        }
+
+        m_entered = true;
+        m_sampled = StreamServiceTrace::beginSpan();
+        if (m_sampled)
+        {
+            m_startTime = StreamServiceTrace::currentTime();
+        }
+    }
+
+    ~StreamServiceTraceScope()
+    {
+        if (m_entered)
+        {
+            StreamServiceTrace::endSpan(m_name, m_startTime, m_sampled);
+        }
+    }
+
+    StreamServiceTraceScope(const StreamServiceTraceScope&) = delete;
+    StreamServiceTraceScope& operator=(const StreamServiceTraceScope&) = delete;
+
+private:
+    const char *m_name;
+    qint64 m_startTime = 0;
+    bool m_entered = false;
+    bool m_sampled = false;
+};
+
+#ifdef STREAMSERVICE_TRACING
+#define STREAMSERVICE_TRACE_CONCAT_(first, second) first##second
+#define STREAMSERVICE_TRACE_CONCAT(first, second) STREAMSERVICE_TRACE_CONCAT_(first, second)
+#define STREAMSERVICE_TRACE_SCOPE(name) StreamServiceTraceScope STREAMSERVICE_TRACE_CONCAT(streamServiceTraceScope, __LINE__)(name)
+#define STREAMSERVICE_TRACE_SPAN(name, startTime, endTime) StreamServiceTrace::recordSpan(name, startTime, endTime)
+#else
+#define STREAMSERVICE_TRACE_SCOPE(name)
+#define STREAMSERVICE_TRACE_SPAN(name, startTime, endTime)
+#endif
+
+#endif // STREAMSERVICETRACE_H
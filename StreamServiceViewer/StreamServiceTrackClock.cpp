@@ -0,0 +1,114 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTrackClock.h"
+
+StreamServiceTrackClock::StreamServiceTrackClock()
+{
+    m_clock.start();
+}
+
+qint64 StreamServiceTrackClock::timeToLive() const
+{
+    return m_timeToLive;
+}
+
+void StreamServiceTrackClock::setTimeToLive(qint64 msecs)
+{
+    m_timeToLive = qMax(qint64(0), msecs);
+    if (0 == m_timeToLive)
+    {
+        // Existing tracks live forever
+        m_expiryWheel.clear();
+    }
+}
+
+bool StreamServiceTrackClock::observe(quint32 trackHandle, const QDateTime &startTime)
+{
+    if (!startTime.isValid())
+    {
+        return true;
+    }
+
+    const qint64 time = startTime.toMSecsSinceEpoch();
+    if (time < latestTime(trackHandle))
+    {
+        return false;
+    }
+
+    setLatestTime(trackHandle, time);
+    return true;
+}
+
+qint64 StreamServiceTrackClock::latestTime(quint32 trackHandle) const
+{
+    return m_latestTimes.value(static_cast<int>(trackHandle), 0);
+}
+
+void StreamServiceTrackClock::setLatestTime(quint32 trackHandle, qint64 time)
+{
+    const int handleIndex = static_cast<int>(trackHandle);
+    if (m_latestTimes.size() <= handleIndex)
+    {
+        m_latestTimes.resize(qMax(handleIndex + 1, 2 * m_latestTimes.size()));
+    }
+    m_latestTimes[handleIndex] = time;
+}
+
+void StreamServiceTrackClock::touch(quint32 trackHandle)
+{
+    if (0 < m_timeToLive)
+    {
+        m_expiryWheel.touch(trackHandle, deadlineTick());
+    }
+}
+
+void StreamServiceTrackClock::remove(quint32 trackHandle)
+{
+    // A reused handle starts without a time
+    const int handleIndex = static_cast<int>(trackHandle);
+    if (handleIndex < m_latestTimes.size())
+    {
+        m_latestTimes[handleIndex] = 0;
+    }
+    m_expiryWheel.cancel(trackHandle);
+}
+
+qint64 StreamServiceTrackClock::currentTick() const
+{
+    return m_clock.elapsed() / TickInterval;
+}
+
+qint64 StreamServiceTrackClock::deadlineTick() const
+{
+    // Round up, a track never expires before its time to live
+    return currentTick() + (m_timeToLive + TickInterval - 1) / TickInterval;
+}
+
+void StreamServiceTrackClock::expire(QVector<quint32> &expiredHandles)
+{
+    expiredHandles.clear();
+    m_expiryWheel.advance(currentTick(), expiredHandles);
+}
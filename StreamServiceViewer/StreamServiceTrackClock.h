@@ -0,0 +1,74 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICETRACKCLOCK_H
+#define STREAMSERVICETRACKCLOCK_H
+
+#include "StreamServiceTimingWheel.h"
+
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QVector>
+
+///
+/// \brief The StreamServiceTrackClock class
+/// Latest observation time and expiry deadline of every track handle.
+/// Observations older than the latest one of a track are rejected, e.g. when replayed after a reconnect.
+/// Tracks not touched within their time to live expire, the resolution is one tick.
+///
+class StreamServiceTrackClock
+{
+public:
+    // Resolution of the track expiry
+    static const int TickInterval = 250;
+
+    StreamServiceTrackClock();
+
+    // Zero keeps the tracks forever
+    qint64 timeToLive() const;
+    void setTimeToLive(qint64 msecs);
+
+    // Returns false for an observation older than the latest one of the track
+    bool observe(quint32 trackHandle, const QDateTime &startTime);
+    qint64 latestTime(quint32 trackHandle) const;
+    void setLatestTime(quint32 trackHandle, qint64 time);
+
+    void touch(quint32 trackHandle);
+    void remove(quint32 trackHandle);
+
+    qint64 currentTick() const;
+    qint64 deadlineTick() const;
+
+    void expire(QVector<quint32> &expiredHandles);
+
+private:
+    QElapsedTimer m_clock;
+    qint64 m_timeToLive = 0;
+    StreamServiceTimingWheel m_expiryWheel;
+    QVector<qint64> m_latestTimes;
+};
+
+#endif // STREAMSERVICETRACKCLOCK_H
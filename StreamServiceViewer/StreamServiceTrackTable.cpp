@@ -0,0 +1,234 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTrackTable.h"
+
+#include <QHash>
+
+namespace
+{
+const int InitialBucketCount = 1024;
+}
+
+StreamServiceTrackTable::StreamServiceTrackTable()
+{
+    rehash(InitialBucketCount);
+}
+
+uint StreamServiceTrackTable::hashTrackId(const QString &trackId)
+{
+    return qHash(trackId);
+}
+
+quint32 StreamServiceTrackTable::find(const QString &trackId, uint trackIdHash) const
+{
+    const int mask = m_buckets.size() - 1;
+    const Bucket *buckets = m_buckets.constData();
+    for (int bucketIndex = static_cast<int>(trackIdHash) & mask; ; bucketIndex = (bucketIndex + 1) & mask)
+    {
+        const Bucket &bucket = buckets[bucketIndex];
+        if (InvalidHandle == bucket.handle)
+        {
+            return InvalidHandle;
+        }
+
+        // Compare the full hash first, the string only on a match
+        if (bucket.hash == trackIdHash && m_trackIds[static_cast<int>(bucket.handle)] == trackId)
+        {
+            return bucket.handle;
+        }
+    }
+}
+
+quint32 StreamServiceTrackTable::insert(const QString &trackId, uint trackIdHash, bool *inserted)
+{
+    Q_ASSERT(!trackId.isEmpty());
+
+    // Keep the load factor below 0.7
+    if (10 * (m_size + 1) > 7 * m_buckets.size())
+    {
+        rehash(2 * m_buckets.size());
+    }
+
+    const int mask = m_buckets.size() - 1;
+    int bucketIndex = static_cast<int>(trackIdHash) & mask;
+    for (; ; bucketIndex = (bucketIndex + 1) & mask)
+    {
+        const Bucket &bucket = m_buckets[bucketIndex];
+        if (InvalidHandle == bucket.handle)
+        {
+            break;
+        }
+
+        if (bucket.hash == trackIdHash && m_trackIds[static_cast<int>(bucket.handle)] == trackId)
+        {
+            if (nullptr != inserted)
+            {
+                *inserted = false;
+            }
+            return bucket.handle;
+        }
+    }
+
+    // Reuse released handles so that handle indexed arrays stay dense
+    quint32 handle;
+    if (m_freeHandles.isEmpty())
+    {
+        handle = static_cast<quint32>(m_trackIds.size());
+        m_trackIds.append(trackId);
+        m_trackIdHashes.append(trackIdHash);
+    }
+    else
+    {
+        handle = m_freeHandles.takeLast();
+        m_trackIds[static_cast<int>(handle)] = trackId;
+        m_trackIdHashes[static_cast<int>(handle)] = trackIdHash;
+    }
+
+    m_buckets[bucketIndex] = Bucket{trackIdHash, handle};
+    m_size++;
+    if (nullptr != inserted)
+    {
+        *inserted = true;
+    }
+    return handle;
+}
+
+bool StreamServiceTrackTable::remove(quint32 handle)
+{
+    const int bucketIndex = findBucket(handle);
+    if (bucketIndex < 0)
+    {
+        return false;
+    }
+
+    // Backward shift deletion keeps the probe sequences intact without tombstones
+    const int mask = m_buckets.size() - 1;
+    int holeIndex = bucketIndex;
+    int nextIndex = bucketIndex;
+    for (;;)
+    {
+        nextIndex = (nextIndex + 1) & mask;
+        const Bucket &nextBucket = m_buckets[nextIndex];
+        if (InvalidHandle == nextBucket.handle)
+        {
+            break;
+        }
+
+        const int homeIndex = static_cast<int>(nextBucket.hash) & mask;
+        const bool homeBetween = (holeIndex <= nextIndex)
+                ? (holeIndex < homeIndex && homeIndex <= nextIndex)
+                : (holeIndex < homeIndex || homeIndex <= nextIndex);
+        if (homeBetween)
+        {
+            continue;
+        }
+
+        m_buckets[holeIndex] = nextBucket;
+        holeIndex = nextIndex;
+    }
+    m_buckets[holeIndex] = Bucket{0, InvalidHandle};
+
+    m_trackIds[static_cast<int>(handle)] = QString();
+    m_freeHandles.append(handle);
+    m_size--;
+    return true;
+}
+
+void StreamServiceTrackTable::clear()
+{
+    m_trackIds.clear();
+    m_trackIdHashes.clear();
+    m_freeHandles.clear();
+    m_size = 0;
+    rehash(InitialBucketCount);
+}
+
+bool StreamServiceTrackTable::contains(quint32 handle) const
+{
+    return handle < static_cast<quint32>(m_trackIds.size()) && !m_trackIds[static_cast<int>(handle)].isNull();
+}
+
+QString StreamServiceTrackTable::trackId(quint32 handle) const
+{
+    if (!contains(handle))
+    {
+        return QString();
+    }
+    return m_trackIds[static_cast<int>(handle)];
+}
+
+int StreamServiceTrackTable::size() const
+{
+    return m_size;
+}
+
+int StreamServiceTrackTable::handleCapacity() const
+{
+    return m_trackIds.size();
+}
+
+int StreamServiceTrackTable::findBucket(quint32 handle) const
+{
+    if (!contains(handle))
+    {
+        return -1;
+    }
+
+    const int mask = m_buckets.size() - 1;
+    for (int bucketIndex = static_cast<int>(m_trackIdHashes[static_cast<int>(handle)]) & mask; ; bucketIndex = (bucketIndex + 1) & mask)
+    {
+        const Bucket &bucket = m_buckets[bucketIndex];
+        if (handle == bucket.handle)
+        {
+            return bucketIndex;
+        }
+        if (InvalidHandle == bucket.handle)
+        {
+            return -1;
+        }
+    }
+}
+
+void StreamServiceTrackTable::rehash(int bucketCount)
+{
+    QVector<Bucket> buckets(bucketCount, Bucket{0, InvalidHandle});
+    const int mask = bucketCount - 1;
+    for (auto const &bucket : qAsConst(m_buckets))
+    {
+        if (InvalidHandle == bucket.handle)
+        {
+            continue;
+        }
+
+        int bucketIndex = static_cast<int>(bucket.hash) & mask;
+        while (InvalidHandle != buckets[bucketIndex].handle)
+        {
+            bucketIndex = (bucketIndex + 1) & mask;
+        }
+        buckets[bucketIndex] = bucket;
+    }
+    m_buckets.swap(buckets);
+}
@@ -0,0 +1,76 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICETRACKTABLE_H
+#define STREAMSERVICETRACKTABLE_H
+
+#include <QString>
+#include <QVector>
+
+///
+/// \brief The StreamServiceTrackTable class
+/// Interns track ids and maps them to stable integer track handles.
+/// Open addressing using linear probing, the hash is computed once on the ingest thread.
+/// A handle stays valid until its track is removed, afterwards it may be reused.
+///
+class StreamServiceTrackTable
+{
+public:
+    static const quint32 InvalidHandle = 0xFFFFFFFFu;
+
+    StreamServiceTrackTable();
+
+    static uint hashTrackId(const QString &trackId);
+
+    quint32 find(const QString &trackId, uint trackIdHash) const;
+    quint32 insert(const QString &trackId, uint trackIdHash, bool *inserted = nullptr);
+    bool remove(quint32 handle);
+    void clear();
+
+    bool contains(quint32 handle) const;
+    QString trackId(quint32 handle) const;
+
+    int size() const;
+    int handleCapacity() const;
+
+private:
+    struct Bucket
+    {
+        uint hash;
+        quint32 handle;
+    };
+
+    int findBucket(quint32 handle) const;
+    void rehash(int bucketCount);
+
+    QVector<Bucket> m_buckets;
+    QVector<QString> m_trackIds;
+    QVector<uint> m_trackIdHashes;
+    QVector<quint32> m_freeHandles;
+    int m_size = 0;
+};
+
+#endif // STREAMSERVICETRACKTABLE_H
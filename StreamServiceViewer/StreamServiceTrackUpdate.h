@@ -0,0 +1,70 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICETRACKUPDATE_H
+#define STREAMSERVICETRACKUPDATE_H
+
+#include "Geometry.h"
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceTrackTable.h"
+
+#include <QDateTime>
+#include <QString>
+#include <QVariantMap>
+
+#include <chrono>
+
+///
+/// \brief The StreamServiceTrackUpdate struct
+/// A fully decoded feature message handed from the decode threads to the GUI thread.
+/// It is never modified after it was pushed into an update queue.
+///
+struct StreamServiceTrackUpdate
+{
+    Esri::ArcGISRuntime::Geometry geometry;
+
+    // Using a field schema the typed values are in the row, the attributes only keep the others
+    StreamServiceAttributeRow attributeRow;
+    QVariantMap attributes;
+    QString trackId;
+    uint trackIdHash = 0;
+    quint32 trackHandle = StreamServiceTrackTable::InvalidHandle;
+    QDateTime startTime;
+    QDateTime endTime;
+
+    // Announced by the upstream, e.g. a fan-out, the track is removed instead of updated
+    bool expired = false;
+
+    // Monotonic nanoseconds when the message was received, compared with the commit time
+    qint64 receiveTime = 0;
+
+    static qint64 currentReceiveTime()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+
+#endif // STREAMSERVICETRACKUPDATE_H
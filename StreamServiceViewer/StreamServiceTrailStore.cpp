@@ -0,0 +1,189 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTrailStore.h"
+
+namespace
+{
+const int MaximumTrailLength = 0xFFFF;
+
+// QVector sizes its bytes by int, the timestamps are the largest positions
+const qint64 MaximumPositionCount = Q_INT64_C(1) << 27;
+}
+
+StreamServiceTrailStore::StreamServiceTrailStore(int trailLength) :
+    m_trailLength(qBound(0, trailLength, MaximumTrailLength))
+{
+}
+
+int StreamServiceTrailStore::trailLength() const
+{
+    return m_trailLength;
+}
+
+void StreamServiceTrailStore::setTrailLength(int trailLength)
+{
+    trailLength = qBound(0, trailLength, MaximumTrailLength);
+    if (trailLength == m_trailLength)
+    {
+        return;
+    }
+
+    // The ring buffers are laid out by trail length, existing trails are dropped
+    clear();
+    m_trailLength = trailLength;
+}
+
+void StreamServiceTrailStore::append(quint32 handle, double x, double y, qint64 time)
+{
+    if (0 == m_trailLength || !ensureHandle(handle))
+    {
+        return;
+    }
+
+    const int handleIndex = static_cast<int>(handle);
+    const int head = m_heads[handleIndex];
+    const int slot = handleIndex * m_trailLength + head;
+    m_x[slot] = static_cast<float>(x);
+    m_y[slot] = static_cast<float>(y);
+    m_times[slot] = time;
+    m_heads[handleIndex] = static_cast<quint16>((head + 1) % m_trailLength);
+    if (m_counts[handleIndex] < m_trailLength)
+    {
+        m_counts[handleIndex]++;
+    }
+    markDirty(handle);
+}
+
+void StreamServiceTrailStore::clear(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (m_counts.size() <= handleIndex || 0 == m_counts[handleIndex])
+    {
+        return;
+    }
+
+    m_heads[handleIndex] = 0;
+    m_counts[handleIndex] = 0;
+    markDirty(handle);
+}
+
+void StreamServiceTrailStore::clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_times.clear();
+    m_heads.clear();
+    m_counts.clear();
+    m_dirty.clear();
+    m_dirtyHandles.clear();
+}
+
+int StreamServiceTrailStore::pointCount(quint32 handle) const
+{
+    const int handleIndex = static_cast<int>(handle);
+    return (handleIndex < m_counts.size()) ? m_counts[handleIndex] : 0;
+}
+
+double StreamServiceTrailStore::x(quint32 handle, int index) const
+{
+    return m_x[position(handle, index)];
+}
+
+double StreamServiceTrailStore::y(quint32 handle, int index) const
+{
+    return m_y[position(handle, index)];
+}
+
+qint64 StreamServiceTrailStore::time(quint32 handle, int index) const
+{
+    return m_times[position(handle, index)];
+}
+
+QVector<quint32> StreamServiceTrailStore::takeDirtyHandles()
+{
+    for (quint32 handle : qAsConst(m_dirtyHandles))
+    {
+        m_dirty[static_cast<int>(handle)] = false;
+    }
+
+    QVector<quint32> dirtyHandles;
+    dirtyHandles.swap(m_dirtyHandles);
+    return dirtyHandles;
+}
+
+qint64 StreamServiceTrailStore::memoryUsage() const
+{
+    const qint64 positionBytes = sizeof(float) + sizeof(float) + sizeof(qint64);
+    const qint64 handleBytes = sizeof(quint16) + sizeof(quint16) + sizeof(bool);
+    return positionBytes * m_times.capacity() + handleBytes * m_counts.capacity();
+}
+
+bool StreamServiceTrailStore::ensureHandle(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (handleIndex < m_counts.size())
+    {
+        return true;
+    }
+
+    // Long trails limit the number of handles, the positions are counted in 64 bits to never wrap
+    const qint64 maximumHandleCount = MaximumPositionCount / m_trailLength;
+    if (maximumHandleCount <= handleIndex)
+    {
+        return false;
+    }
+
+    // Grow geometrically, every handle owns trail length positions
+    const qint64 handleCount = qMin(maximumHandleCount, qMax<qint64>(handleIndex + 1, qMax(1024, 2 * m_counts.size())));
+    const int positionCount = static_cast<int>(handleCount * m_trailLength);
+    m_x.resize(positionCount);
+    m_y.resize(positionCount);
+    m_times.resize(positionCount);
+    m_heads.resize(static_cast<int>(handleCount));
+    m_counts.resize(static_cast<int>(handleCount));
+    m_dirty.resize(static_cast<int>(handleCount));
+    return true;
+}
+
+int StreamServiceTrailStore::position(quint32 handle, int index) const
+{
+    const int handleIndex = static_cast<int>(handle);
+    const int count = m_counts[handleIndex];
+    const int oldest = (m_heads[handleIndex] - count + m_trailLength) % m_trailLength;
+    return handleIndex * m_trailLength + (oldest + index) % m_trailLength;
+}
+
+void StreamServiceTrailStore::markDirty(quint32 handle)
+{
+    const int handleIndex = static_cast<int>(handle);
+    if (m_dirty[handleIndex])
+    {
+        return;
+    }
+
+    m_dirty[handleIndex] = true;
+    m_dirtyHandles.append(handle);
+}
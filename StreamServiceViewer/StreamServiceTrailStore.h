@@ -0,0 +1,75 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICETRAILSTORE_H
+#define STREAMSERVICETRAILSTORE_H
+
+#include <QVector>
+
+///
+/// \brief The StreamServiceTrailStore class
+/// Keeps the last positions of every track in fixed size ring buffers.
+/// The positions are stored as struct of arrays indexed by track handle,
+/// so the footprint is 16 bytes per position plus 8 bytes per handle.
+///
+class StreamServiceTrailStore
+{
+public:
+    explicit StreamServiceTrailStore(int trailLength = 0);
+
+    int trailLength() const;
+    void setTrailLength(int trailLength);
+
+    // Handles beyond the capacity of the ring buffers keep no trail
+    void append(quint32 handle, double x, double y, qint64 time);
+    void clear(quint32 handle);
+    void clear();
+
+    // Positions are indexed from the oldest to the newest one
+    int pointCount(quint32 handle) const;
+    double x(quint32 handle, int index) const;
+    double y(quint32 handle, int index) const;
+    qint64 time(quint32 handle, int index) const;
+
+    QVector<quint32> takeDirtyHandles();
+    qint64 memoryUsage() const;
+
+private:
+    bool ensureHandle(quint32 handle);
+    int position(quint32 handle, int index) const;
+    void markDirty(quint32 handle);
+
+    int m_trailLength;
+    QVector<float> m_x;
+    QVector<float> m_y;
+    QVector<qint64> m_times;
+    QVector<quint16> m_heads;
+    QVector<quint16> m_counts;
+    QVector<bool> m_dirty;
+    QVector<quint32> m_dirtyHandles;
+};
+
+#endif // STREAMSERVICETRAILSTORE_H
@@ -0,0 +1,127 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef STREAMSERVICEUPDATEQUEUE_H
+#define STREAMSERVICEUPDATEQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+///
+/// \brief The StreamServiceUpdateQueue class
+/// Bounded lock-free single producer single consumer ring buffer.
+/// Every shard of the decode pool queues its messages and its decoded updates using one.
+///
+template <typename T>
+class StreamServiceUpdateQueue
+{
+public:
+    explicit StreamServiceUpdateQueue(size_t capacity)
+    {
+        // Round up to a power of two so that wrapping is a simple mask
+        size_t slotCount = 2;
+        while (slotCount < capacity)
+        {
+            slotCount <<= 1;
+        }
+        m_slots.resize(slotCount);
+        m_mask = slotCount - 1;
+    }
+
+    StreamServiceUpdateQueue(const StreamServiceUpdateQueue&) = delete;
+    StreamServiceUpdateQueue& operator=(const StreamServiceUpdateQueue&) = delete;
+
+    // Producer side only
+    bool tryPush(T &&item)
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if (tail - m_cachedHead > m_mask)
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+            if (tail - m_cachedHead > m_mask)
+            {
+                return false;
+            }
+        }
+
+        m_slots[tail & m_mask] = std::move(item);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side only
+    bool tryPop(T &item)
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            if (head == m_cachedTail)
+            {
+                return false;
+            }
+        }
+
+        T &slot = m_slots[head & m_mask];
+        item = std::move(slot);
+        slot = T();
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only a snapshot, both sides may move concurrently
+    size_t sizeApprox() const
+    {
+        const size_t head = m_head.load(std::memory_order_acquire);
+        const size_t tail = m_tail.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    size_t capacity() const
+    {
+        return m_mask + 1;
+    }
+
+private:
+    static const size_t CacheLineSize = 64;
+
+    std::vector<T> m_slots;
+    size_t m_mask = 0;
+
+    // Consumer owned
+    std::atomic<size_t> m_head{0};
+    size_t m_cachedTail = 0;
+    char m_consumerPadding[CacheLineSize];
+
+    // Producer owned
+    std::atomic<size_t> m_tail{0};
+    size_t m_cachedHead = 0;
+    char m_producerPadding[CacheLineSize];
+};
+
+#endif // STREAMSERVICEUPDATEQUEUE_H
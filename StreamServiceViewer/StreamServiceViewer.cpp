@@ -38,22 +38,42 @@
 
 #include "RendererFactory.h"
 #include "StreamServiceViewer.h"
+#include "StreamServiceCaptureReplayer.h"
+#include "StreamServiceDescriptionCache.h"
+#include "StreamServiceFieldSchema.h"
 #include "StreamServiceLayer.h"
 #include "StreamServiceLayerTimeInfo.h"
+#include "StreamServiceMetricsEndpoint.h"
+#include "StreamServiceRelay.h"
+#include "StreamServiceTrace.h"
 
+#include "AttributeListModel.h"
 #include "Basemap.h"
+#include "Envelope.h"
+#include "GeometryEngine.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
 #include "GraphicsOverlay.h"
+#include "LabelDefinitionListModel.h"
 #include "Map.h"
 #include "MapQuickView.h"
+#include "Point.h"
+#include "Polygon.h"
 #include "SimpleLabelExpression.h"
+#include "SimpleLineSymbol.h"
 #include "SimpleMarkerSymbol.h"
 #include "SimpleRenderer.h"
+#include "SpatialReference.h"
 #include "TextSymbol.h"
 
+#include <QCryptographicHash>
+#include <QDir>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QNetworkReply>
 #include <QProcessEnvironment>
+#include <QQuickWindow>
+#include <QStandardPaths>
 #include <QUrl>
 
 using namespace Esri::ArcGISRuntime;
@@ -62,22 +82,68 @@ StreamServiceViewer::StreamServiceViewer(QObject* parent /* = nullptr */):
     QObject(parent),
     m_map(new Map(BasemapStyle::OsmStandard, this)),
     m_streamGraphicsOverlay(new GraphicsOverlay(this)),
+    m_trailGraphicsOverlay(new GraphicsOverlay(this)),
+    m_historyGraphicsOverlay(new GraphicsOverlay(this)),
+    m_densityGraphicsOverlay(new GraphicsOverlay(this)),
     m_networkAccessManager(new QNetworkAccessManager(this)),
     m_rendererFactory(new RendererFactory(this))
 {
     // Listen to network replies
     connect(m_networkAccessManager, &QNetworkAccessManager::finished, this, &StreamServiceViewer::onStreamServiceInfoRequestFinished);
 
+    // The history overlay is only visible while scrubbing through the recorded time window
+    m_historyGraphicsOverlay->setVisible(false);
+    m_historyExtentTimer.setInterval(1000);
+    connect(&m_historyExtentTimer, &QTimer::timeout, this, &StreamServiceViewer::historyExtentChanged);
+
+    // Extent filters are sent once the map view came to rest
+    m_filterTimer.setSingleShot(true);
+    m_filterTimer.setInterval(750);
+    connect(&m_filterTimer, &QTimer::timeout, this, &StreamServiceViewer::onFilterTimeout);
+
+    // The metrics shown by the overlay are updated once per second
+    m_metricsTimer.setInterval(1000);
+    connect(&m_metricsTimer, &QTimer::timeout, this, &StreamServiceViewer::onMetricsTimeout);
+
+    // The density cells are only shown by the heat view and refreshed twice per second
+    m_densityGraphicsOverlay->setVisible(false);
+    m_densityGraphicsOverlay->setRenderer(m_rendererFactory->createDensityRenderer());
+    m_densityTimer.setInterval(500);
+    connect(&m_densityTimer, &QTimer::timeout, this, &StreamServiceViewer::onDensityTimeout);
+
     // Define the stream service endpoint
     QString streamServiceEndpointKeyName = "streamservice_endpoint";
     QProcessEnvironment systemEnvironment = QProcessEnvironment::systemEnvironment();
     if (systemEnvironment.contains(streamServiceEndpointKeyName))
     {
-        // Request the stream service json description
         QString streamServiceEndpoint = systemEnvironment.value(streamServiceEndpointKeyName);
-        QUrl streamServiceInfoEndpoint(streamServiceEndpoint);
-        streamServiceInfoEndpoint.setQuery("f=json");
-        QNetworkRequest streamServiceInfoRequest(streamServiceInfoEndpoint);
+        m_serviceInfoEndpoint = QUrl(streamServiceEndpoint);
+        m_serviceInfoEndpoint.setQuery("f=json");
+
+        // Optionally disable the warm start using the cached description and the last snapshot
+        QString warmStartKeyName = "streamservice_warm_start";
+        QString cacheDirectoryKeyName = "streamservice_cache_dir";
+        QString cacheDirectory = systemEnvironment.value(cacheDirectoryKeyName, QStandardPaths::writableLocation(QStandardPaths::CacheLocation));
+        if (QStringLiteral("0") != systemEnvironment.value(warmStartKeyName) && !cacheDirectory.isEmpty() && QDir().mkpath(cacheDirectory))
+        {
+            const QString cacheName = QString::fromLatin1(QCryptographicHash::hash(m_serviceInfoEndpoint.toEncoded(), QCryptographicHash::Md5).toHex());
+            m_descriptionCache.setFilePath(QDir(cacheDirectory).filePath(cacheName + QStringLiteral(".description")));
+            m_snapshotFilePath = QDir(cacheDirectory).filePath(cacheName + QStringLiteral(".snapshot"));
+        }
+
+        // Show the cached service right away and subscribe while the fresh description is requested
+        if (m_descriptionCache.load(m_serviceInfoEndpoint))
+        {
+            qDebug() << "Warm start using the service description cached at" << m_descriptionCache.storedAt().toString(Qt::ISODate);
+            if (applyServiceDescription(m_descriptionCache.description()))
+            {
+                subscribeEvents();
+            }
+        }
+
+        // Request the stream service json description, a cached one is only revalidated
+        QNetworkRequest streamServiceInfoRequest(m_serviceInfoEndpoint);
+        m_descriptionCache.addValidators(streamServiceInfoRequest);
         m_networkAccessManager->get(streamServiceInfoRequest);
     }
     else
@@ -88,6 +154,11 @@ StreamServiceViewer::StreamServiceViewer(QObject* parent /* = nullptr */):
 
 StreamServiceViewer::~StreamServiceViewer()
 {
+    if (!m_traceFilePath.isEmpty())
+    {
+        StreamServiceTrace::setEnabled(false);
+        StreamServiceTrace::writeChromeTrace(m_traceFilePath);
+    }
 }
 
 MapQuickView* StreamServiceViewer::mapView() const
@@ -106,8 +177,18 @@ void StreamServiceViewer::setMapView(MapQuickView* mapView)
     m_mapView = mapView;
     m_mapView->setMap(m_map);
 
-    // Add the graphics overlay
+    // Add the graphics overlays, the density and the trails are drawn below the tracks
+    m_mapView->graphicsOverlays()->append(m_densityGraphicsOverlay);
+    m_mapView->graphicsOverlays()->append(m_trailGraphicsOverlay);
     m_mapView->graphicsOverlays()->append(m_streamGraphicsOverlay);
+    m_mapView->graphicsOverlays()->append(m_historyGraphicsOverlay);
+
+    // Restrict the stream to the visible area
+    connect(m_mapView, &MapQuickView::visibleAreaChanged, this, &StreamServiceViewer::onVisibleAreaChanged);
+
+    // Count the rendered frames of the window showing the map view
+    connect(m_mapView, &QQuickItem::windowChanged, this, &StreamServiceViewer::onWindowChanged);
+    onWindowChanged(m_mapView->window());
 
     emit mapViewChanged();
 }
@@ -122,6 +203,7 @@ void StreamServiceViewer::subscribeEvents()
 
     // Start streaming
     m_streamServiceLayer->subscribe();
+    setSubscribed(true);
 }
 
 void StreamServiceViewer::unsubscribeEvents()
@@ -134,43 +216,522 @@ void StreamServiceViewer::unsubscribeEvents()
 
     // Stop streaming
     m_streamServiceLayer->unsubscribe();
+    setSubscribed(false);
+}
+
+bool StreamServiceViewer::subscribed() const
+{
+    return m_subscribed;
+}
+
+void StreamServiceViewer::setSubscribed(bool subscribed)
+{
+    if (subscribed == m_subscribed)
+    {
+        return;
+    }
+
+    m_subscribed = subscribed;
+    emit subscribedChanged();
+}
+
+void StreamServiceViewer::releaseStreamServiceLayer()
+{
+    if (nullptr == m_streamServiceLayer)
+    {
+        return;
+    }
+
+    // The graphics are owned by the layer, the overlays must not reference them any longer
+    m_streamGraphicsOverlay->graphics()->clear();
+    m_trailGraphicsOverlay->graphics()->clear();
+    m_historyGraphicsOverlay->graphics()->clear();
+    m_densityGraphicsOverlay->graphics()->clear();
+    m_streamGraphicsOverlay->labelDefinitions()->clear();
+    delete m_streamServiceLayer;
+    m_streamServiceLayer = nullptr;
 }
 
 void StreamServiceViewer::renderSimple()
 {
+    m_heatActive = false;
     m_streamGraphicsOverlay->setRenderer(m_simpleRenderer);
+    showDensity(false);
 }
 
 void StreamServiceViewer::renderHeat()
 {
-    m_streamGraphicsOverlay->setRenderer(m_heatmapRenderer);
+    m_heatActive = true;
+    if (!m_densityHeat)
+    {
+        m_streamGraphicsOverlay->setRenderer(m_heatmapRenderer);
+        return;
+    }
+
+    showDensity(true);
+}
+
+void StreamServiceViewer::showDensity(bool visible)
+{
+    if (nullptr == m_streamServiceLayer)
+    {
+        return;
+    }
+
+    // The grid is only fed while it is shown
+    if (!visible)
+    {
+        m_densityTimer.stop();
+        m_streamServiceLayer->setDensityGraphicsModel(nullptr);
+        m_densityGraphicsOverlay->setVisible(false);
+        m_streamGraphicsOverlay->setVisible(liveMode());
+        return;
+    }
+
+    m_streamServiceLayer->setDensityGraphicsModel(m_densityGraphicsOverlay->graphics());
+    m_streamGraphicsOverlay->setVisible(false);
+    m_densityGraphicsOverlay->setVisible(liveMode());
+    m_densityTimer.start();
+    onDensityTimeout();
+}
+
+double StreamServiceViewer::historyStart() const
+{
+    return (nullptr != m_streamServiceLayer) ? static_cast<double>(m_streamServiceLayer->historyStartTime()) : 0;
+}
+
+double StreamServiceViewer::historyEnd() const
+{
+    return (nullptr != m_streamServiceLayer) ? static_cast<double>(m_streamServiceLayer->historyEndTime()) : 0;
+}
+
+bool StreamServiceViewer::liveMode() const
+{
+    return !m_historyGraphicsOverlay->isVisible();
+}
+
+void StreamServiceViewer::showHistory(double windowStart, double windowEnd)
+{
+    if (nullptr == m_streamServiceLayer || 0 == m_streamServiceLayer->historyRetention())
+    {
+        qWarning() << "No history is recorded!";
+        return;
+    }
+
+    m_streamServiceLayer->materializeHistory(static_cast<qint64>(windowStart), static_cast<qint64>(windowEnd));
+    if (m_historyGraphicsOverlay->isVisible())
+    {
+        return;
+    }
+
+    // Live updates keep going, only the overlays are swapped
+    m_streamGraphicsOverlay->setVisible(false);
+    m_densityGraphicsOverlay->setVisible(false);
+    m_trailGraphicsOverlay->setVisible(false);
+    m_historyGraphicsOverlay->setVisible(true);
+    emit liveModeChanged();
+}
+
+void StreamServiceViewer::showLive()
+{
+    if (!m_historyGraphicsOverlay->isVisible())
+    {
+        return;
+    }
+
+    m_historyGraphicsOverlay->setVisible(false);
+    m_trailGraphicsOverlay->setVisible(true);
+    const bool densityVisible = m_heatActive && m_densityHeat;
+    m_densityGraphicsOverlay->setVisible(densityVisible);
+    m_streamGraphicsOverlay->setVisible(!densityVisible);
+    emit liveModeChanged();
+}
+
+QVariantList StreamServiceViewer::queryVisibleTracks() const
+{
+    QVariantList tracks;
+    if (nullptr == m_streamServiceLayer || nullptr == m_mapView)
+    {
+        return tracks;
+    }
+
+    const QList<Graphic*> trackGraphics = m_streamServiceLayer->queryTracks(m_mapView->visibleArea().extent());
+    for (Graphic *trackGraphic : trackGraphics)
+    {
+        tracks.append(trackGraphic->attributes()->attributesMap());
+    }
+    return tracks;
+}
+
+QVariantList StreamServiceViewer::queryTracksAround(double screenX, double screenY, double screenRadius) const
+{
+    QVariantList tracks;
+    if (nullptr == m_streamServiceLayer || nullptr == m_mapView)
+    {
+        return tracks;
+    }
+
+    const Point center = m_mapView->screenToLocation(screenX, screenY);
+    const QList<Graphic*> trackGraphics = m_streamServiceLayer->queryTracks(center, screenRadius * m_mapView->unitsPerDIP());
+    for (Graphic *trackGraphic : trackGraphics)
+    {
+        tracks.append(trackGraphic->attributes()->attributesMap());
+    }
+    return tracks;
+}
+
+QVariantMap StreamServiceViewer::identifyTrack(double screenX, double screenY, double screenTolerance) const
+{
+    if (nullptr == m_streamServiceLayer || nullptr == m_mapView)
+    {
+        return QVariantMap();
+    }
+
+    // Answered by the spatial index of the layer instead of the graphics overlay
+    const Point location = m_mapView->screenToLocation(screenX, screenY);
+    Graphic *trackGraphic = m_streamServiceLayer->identifyTrack(location, screenTolerance * m_mapView->unitsPerDIP());
+    if (nullptr == trackGraphic)
+    {
+        return QVariantMap();
+    }
+    return trackGraphic->attributes()->attributesMap();
+}
+
+void StreamServiceViewer::onVisibleAreaChanged()
+{
+    if (m_extentFilterEnabled)
+    {
+        m_filterTimer.start();
+    }
+}
+
+void StreamServiceViewer::onFilterTimeout()
+{
+    if (nullptr == m_streamServiceLayer || nullptr == m_mapView)
+    {
+        return;
+    }
+
+    const Envelope visibleExtent = m_mapView->visibleArea().extent();
+    if (visibleExtent.isEmpty())
+    {
+        return;
+    }
+
+    // Small pans and zooms stay within the current filter
+    const Envelope filterExtent = m_streamServiceLayer->filterExtent();
+    if (!filterExtent.isEmpty()
+            && GeometryEngine::contains(filterExtent, visibleExtent)
+            && filterExtent.width() < 4 * visibleExtent.width())
+    {
+        return;
+    }
+
+    // Buffer the visible extent, so that tracks entering the view are already known
+    const double bufferX = 0.25 * visibleExtent.width();
+    const double bufferY = 0.25 * visibleExtent.height();
+    m_streamServiceLayer->setFilterExtent(Envelope(visibleExtent.xMin() - bufferX, visibleExtent.yMin() - bufferY,
+                                                   visibleExtent.xMax() + bufferX, visibleExtent.yMax() + bufferY,
+                                                   visibleExtent.spatialReference()));
+    m_filterUpdateCount++;
+}
+
+void StreamServiceViewer::onDensityTimeout()
+{
+    if (nullptr == m_streamServiceLayer || nullptr == m_mapView || !liveMode())
+    {
+        return;
+    }
+
+    m_streamServiceLayer->updateDensityGraphics(m_mapView->visibleArea().extent());
+}
+
+void StreamServiceViewer::onWindowChanged(QQuickWindow *window)
+{
+    if (nullptr == window)
+    {
+        return;
+    }
+
+    // Frames are swapped on the render thread, the counter lives on this one
+    connect(window, &QQuickWindow::frameSwapped, this, [this]() {
+        m_frameCount++;
+    }, Qt::QueuedConnection);
+
+#ifdef STREAMSERVICE_TRACING
+    // The render tick is traced on the render thread itself
+    connect(window, &QQuickWindow::beforeRendering, this, [this]() {
+        m_renderStartTime = StreamServiceTrace::currentTime();
+    }, Qt::DirectConnection);
+    connect(window, &QQuickWindow::afterRendering, this, [this]() {
+        STREAMSERVICE_TRACE_SPAN("render", m_renderStartTime, StreamServiceTrace::currentTime());
+    }, Qt::DirectConnection);
+#endif
+}
+
+void StreamServiceViewer::onMetricsTimeout()
+{
+    if (nullptr == m_streamServiceLayer)
+    {
+        return;
+    }
+
+    const double elapsedSeconds = qMax(qint64(1), m_metricsClock.restart()) / 1000.0;
+    const quint64 receivedMessageCount = m_streamServiceLayer->receivedMessageCount();
+    const quint64 receivedBytes = m_streamServiceLayer->receivedBytes();
+    const quint64 decodedMessageCount = m_streamServiceLayer->decodedMessageCount();
+    const quint64 decodeNanos = m_streamServiceLayer->decodeNanos();
+    const quint64 commitCount = m_streamServiceLayer->commitCount();
+    const quint64 committedUpdateCount = m_streamServiceLayer->committedUpdateCount();
+
+    m_messageRate = (receivedMessageCount - m_lastReceivedMessageCount) / elapsedSeconds;
+    m_byteRate = (receivedBytes - m_lastReceivedBytes) / elapsedSeconds;
+    const quint64 decodedMessages = decodedMessageCount - m_lastDecodedMessageCount;
+    m_decodeMicroseconds = (0 < decodedMessages) ? (decodeNanos - m_lastDecodeNanos) / 1000.0 / decodedMessages : 0;
+    const quint64 commits = commitCount - m_lastCommitCount;
+    m_commitRate = commits / elapsedSeconds;
+    m_updatesPerCommit = (0 < commits) ? double(committedUpdateCount - m_lastCommittedUpdateCount) / commits : 0;
+    m_frameRate = (m_frameCount - m_lastFrameCount) / elapsedSeconds;
+
+    // Quantiles of the last second only
+    const StreamServiceHistogram &commitLatency = m_streamServiceLayer->commitLatency();
+    const StreamServiceHistogram &displayStaleness = m_streamServiceLayer->displayStaleness();
+    m_commitLatency = commitLatency.since(m_lastCommitLatency).quantile(0.99) / 1000000.0;
+    m_displayStaleness = static_cast<double>(displayStaleness.since(m_lastDisplayStaleness).quantile(0.5));
+
+    m_lastReceivedMessageCount = receivedMessageCount;
+    m_lastReceivedBytes = receivedBytes;
+    m_lastDecodedMessageCount = decodedMessageCount;
+    m_lastDecodeNanos = decodeNanos;
+    m_lastCommitCount = commitCount;
+    m_lastCommittedUpdateCount = committedUpdateCount;
+    m_lastFrameCount = m_frameCount;
+    m_lastCommitLatency = commitLatency;
+    m_lastDisplayStaleness = displayStaleness;
+    emit metricsChanged();
+}
+
+double StreamServiceViewer::messageRate() const
+{
+    return m_messageRate;
+}
+
+double StreamServiceViewer::byteRate() const
+{
+    return m_byteRate;
+}
+
+double StreamServiceViewer::parseFailureCount() const
+{
+    return (nullptr != m_streamServiceLayer) ? static_cast<double>(m_streamServiceLayer->parseFailureCount()) : 0;
+}
+
+double StreamServiceViewer::decodeMicroseconds() const
+{
+    return m_decodeMicroseconds;
+}
+
+int StreamServiceViewer::queueDepth() const
+{
+    return (nullptr != m_streamServiceLayer) ? m_streamServiceLayer->queueDepth() : 0;
+}
+
+double StreamServiceViewer::commitRate() const
+{
+    return m_commitRate;
+}
+
+double StreamServiceViewer::updatesPerCommit() const
+{
+    return m_updatesPerCommit;
+}
+
+int StreamServiceViewer::trackCount() const
+{
+    return (nullptr != m_streamServiceLayer) ? m_streamServiceLayer->trackCount() : 0;
+}
+
+double StreamServiceViewer::commitLatency() const
+{
+    return m_commitLatency;
+}
+
+double StreamServiceViewer::displayStaleness() const
+{
+    return m_displayStaleness;
+}
+
+double StreamServiceViewer::frameRate() const
+{
+    return m_frameRate;
+}
+
+QByteArray StreamServiceViewer::metricsText() const
+{
+    QByteArray text;
+    if (nullptr == m_streamServiceLayer)
+    {
+        return text;
+    }
+
+    // Collected on demand, the scrape interval defines the resolution
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_received_messages_total", "Messages received for decoding.", m_streamServiceLayer->receivedMessageCount());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_received_bytes_total", "Bytes of the messages received for decoding.", m_streamServiceLayer->receivedBytes());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_parse_failures_total", "Messages which could not be decoded.", m_streamServiceLayer->parseFailureCount());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_decoded_messages_total", "Messages passed to the decoder.", m_streamServiceLayer->decodedMessageCount());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_decode_seconds_total", "Time spent decoding the messages.", m_streamServiceLayer->decodeNanos() / 1e9);
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_decode_queue_seconds_total", "Time the messages waited for a decode thread.", m_streamServiceLayer->decodeQueueNanos() / 1e9);
+    StreamServiceMetricsEndpoint::appendGauge(text, "streamservice_queue_depth", "Updates queued or staged for the next commit.", m_streamServiceLayer->queueDepth());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_commits_total", "Commits of the staged updates.", m_streamServiceLayer->commitCount());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_committed_updates_total", "Updates committed to the graphics.", m_streamServiceLayer->committedUpdateCount());
+    StreamServiceMetricsEndpoint::appendSummary(text, "streamservice_commit_size", "Updates committed per commit.", m_streamServiceLayer->commitSizes(), 1);
+    StreamServiceMetricsEndpoint::appendSummary(text, "streamservice_receive_to_commit_seconds", "Latency from receiving a message up to committing its update.", m_streamServiceLayer->commitLatency(), 1e-9);
+    StreamServiceMetricsEndpoint::appendSummary(text, "streamservice_display_staleness_seconds", "Age of the event time when the update is committed.", m_streamServiceLayer->displayStaleness(), 1e-3);
+    StreamServiceMetricsEndpoint::appendGauge(text, "streamservice_live_tracks", "Tracks currently shown.", m_streamServiceLayer->trackCount());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_reconnects_total", "Restored stream connections.", m_streamServiceLayer->reconnectCount());
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_filter_updates_total", "Extent filters sent after the map view moved.", m_filterUpdateCount);
+    StreamServiceMetricsEndpoint::appendCounter(text, "streamservice_rendered_frames_total", "Frames rendered by the window showing the map.", m_frameCount);
+    return text;
 }
 
 void StreamServiceViewer::onStreamServiceInfoRequestFinished(QNetworkReply *infoReply)
 {
+    infoReply->deleteLater();
+
+    // Not modified since the cached description was received
+    if (304 == infoReply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt())
+    {
+        qDebug() << "Cached service description is up to date.";
+        return;
+    }
+
     if (infoReply->error())
     {
         qWarning() << "Stream service info request failed!";
         return;
     }
 
+    // Servers without validators send an unchanged description again
+    const QByteArray description = infoReply->readAll();
+    if (nullptr != m_streamServiceLayer && m_descriptionCache.isValid() && m_descriptionCache.description() == description)
+    {
+        m_descriptionCache.store(m_serviceInfoEndpoint, description, infoReply);
+        return;
+    }
+
+    if (applyServiceDescription(description))
+    {
+        m_descriptionCache.store(m_serviceInfoEndpoint, description, infoReply);
+    }
+}
+
+bool StreamServiceViewer::applyServiceDescription(const QByteArray &description)
+{
     // Parse the service description
-    QJsonDocument serviceDocument = QJsonDocument::fromJson(infoReply->readAll());
+    QJsonDocument serviceDocument = QJsonDocument::fromJson(description);
     if (serviceDocument.isNull())
     {
         qDebug() << "Unsupported service description received!";
-        return;
+        return false;
     }
 
     if (!serviceDocument.isObject())
     {
         qDebug() << "Service description does not represent an object!";
-        return;
+        return false;
     }
 
     // TODO: Parse the whole json!
     QJsonObject serviceObject = serviceDocument.object();
 
+    auto const drawingInfoKey = "drawingInfo";
+    if (!serviceObject.contains(drawingInfoKey))
+    {
+        qDebug() << "Service description does not contain a drawing info!";
+        return false;
+    }
+
+    QJsonValue drawingInfoValue = serviceObject.value(drawingInfoKey);
+    if (!drawingInfoValue.isObject())
+    {
+        qDebug() << "Drawing info does not represent an object!";
+        return false;
+    }
+
+    auto const streamUrlsKey = "streamUrls";
+    if (!serviceObject.contains(streamUrlsKey))
+    {
+        qDebug() << "Service description does not contain any streaming urls!";
+        return false;
+    }
+
+    QJsonValue streamUrlsValue = serviceObject.value(streamUrlsKey);
+    if (!streamUrlsValue.isArray())
+    {
+        qDebug() << "Streaming urls do not represent an array!";
+        return false;
+    }
+
+    // Collect the urls of every websocket transport, each of them serves the same stream
+    QList<QUrl> layerWebSocketEndpoints;
+    QObject *localEndpointProvider = nullptr;
+    const QJsonArray streamUrlsArray = streamUrlsValue.toArray();
+    for (const QJsonValue &streamUrlsItemValue : streamUrlsArray)
+    {
+        if (!streamUrlsItemValue.isObject())
+        {
+            qDebug() << "The streaming urls item does not represent an object!";
+            continue;
+        }
+
+        auto const transportKey = "transport";
+        QJsonObject streamUrlsItemObject = streamUrlsItemValue.toObject();
+        const QString transport = streamUrlsItemObject.value(transportKey).toString(QStringLiteral("ws"));
+        if (QStringLiteral("ws") != transport)
+        {
+            qDebug() << "Unsupported streaming transport" << transport;
+            continue;
+        }
+
+        auto const urlsKey = "urls";
+        QJsonValue urlsValue = streamUrlsItemObject.value(urlsKey);
+        if (!urlsValue.isArray())
+        {
+            qDebug() << "Urls do not represent an array!";
+            continue;
+        }
+
+        const QJsonArray urlsArray = urlsValue.toArray();
+        for (const QJsonValue &urlValue : urlsArray)
+        {
+            QUrl layerWebSocketEndpoint(urlValue.toString());
+            if (layerWebSocketEndpoint.isValid() && !layerWebSocketEndpoints.contains(layerWebSocketEndpoint))
+            {
+                qDebug() << "Web socket endpoint is " << layerWebSocketEndpoint.toString();
+                layerWebSocketEndpoints.append(layerWebSocketEndpoint);
+            }
+        }
+    }
+
+    if (layerWebSocketEndpoints.isEmpty())
+    {
+        qDebug() << "Streaming urls does not contain any websocket url!";
+        return false;
+    }
+
+    // Created last, so that a rejected description leaves no renderer behind
+    Renderer *simpleRenderer = m_rendererFactory->createRendererFromDrawingInfo(drawingInfoValue);
+    Renderer *historyRenderer = m_rendererFactory->createRendererFromDrawingInfo(drawingInfoValue);
+    if (nullptr == simpleRenderer || nullptr == historyRenderer)
+    {
+        delete simpleRenderer;
+        delete historyRenderer;
+        return false;
+    }
+
+    // The description is usable, it replaces the one of the warm start
+    releaseStreamServiceLayer();
+
     auto const displayFieldKey = "displayField";
     if (serviceObject.contains(displayFieldKey))
     {
@@ -204,90 +765,324 @@ void StreamServiceViewer::onStreamServiceInfoRequestFinished(QNetworkReply *info
         timeInfo = StreamServiceLayerTimeInfo::createFromJson(timeInfoValue);
     }
 
-    auto const drawingInfoKey = "drawingInfo";
-    if (!serviceObject.contains(drawingInfoKey))
+    // Optionally subscribe through a local relay using the binary encoding
+    QString relayPortKeyName = "streamservice_relay_port";
+    QProcessEnvironment systemEnvironment = QProcessEnvironment::systemEnvironment();
+    if (systemEnvironment.contains(relayPortKeyName))
     {
-        qDebug() << "Service description does not contain a drawing info!";
-        return;
+        bool validPort = false;
+        quint16 relayPort = systemEnvironment.value(relayPortKeyName).toUShort(&validPort);
+        StreamServiceRelay *relay = new StreamServiceRelay(layerWebSocketEndpoints.first(), this);
+        localEndpointProvider = relay;
+        if (nullptr != timeInfo)
+        {
+            relay->setDateFields(QStringList() << timeInfo->startTimeField() << timeInfo->endTimeField());
+        }
+        if (validPort && relay->listen(relayPort))
+        {
+            layerWebSocketEndpoints = QList<QUrl>() << relay->localEndpoint();
+        }
     }
 
-    QJsonValue drawingInfoValue = serviceObject.value(drawingInfoKey);
-    if (!drawingInfoValue.isObject())
+    // Optionally subscribe through a headless fan-out sharing one upstream subscription with other viewers
+    QString fanOutEndpointKeyName = "streamservice_fanout_endpoint";
+    if (systemEnvironment.contains(fanOutEndpointKeyName))
     {
-        qDebug() << "Drawing info does not represent an object!";
-        return;
+        QUrl fanOutEndpoint(systemEnvironment.value(fanOutEndpointKeyName));
+        if (fanOutEndpoint.isValid())
+        {
+            layerWebSocketEndpoints = QList<QUrl>() << fanOutEndpoint;
+        }
     }
 
+    // Optionally replay a capture file instead of the live stream, at the recorded speed by default
+    QString replayPathKeyName = "streamservice_replay_path";
+    QString replaySpeedKeyName = "streamservice_replay_speed";
+    QString replayPortKeyName = "streamservice_replay_port";
+    QString replayCaptureFilePath = systemEnvironment.value(replayPathKeyName);
+    double replaySpeed = 1.0;
+    if (systemEnvironment.contains(replaySpeedKeyName))
+    {
+        bool validSpeed = false;
+        replaySpeed = systemEnvironment.value(replaySpeedKeyName).toDouble(&validSpeed);
+        if (!validSpeed)
+        {
+            replaySpeed = 1.0;
+        }
+    }
 
+    if (!replayCaptureFilePath.isEmpty() && systemEnvironment.contains(replayPortKeyName))
+    {
+        // Replay through a local websocket server, so that the whole ingest path is exercised
+        bool validPort = false;
+        quint16 replayPort = systemEnvironment.value(replayPortKeyName).toUShort(&validPort);
+        StreamServiceCaptureReplayer *replayer = new StreamServiceCaptureReplayer(this);
+        localEndpointProvider = replayer;
+        replayer->setSpeed(replaySpeed);
+        if (validPort && replayer->open(replayCaptureFilePath) && replayer->listen(replayPort))
+        {
+            layerWebSocketEndpoints = QList<QUrl>() << replayer->localEndpoint();
+        }
+        replayCaptureFilePath.clear();
+    }
 
-    auto const streamUrlsKey = "streamUrls";
-    if (!serviceObject.contains(streamUrlsKey))
+    m_streamServiceLayer = new StreamServiceLayer(layerWebSocketEndpoints, this);
+    m_streamServiceLayer->setTimeInfo(timeInfo);
+    if (nullptr != localEndpointProvider)
     {
-        qDebug() << "Service description does not contain any streaming urls!";
-        return;
+        // Released together with the layer using its endpoint
+        localEndpointProvider->setParent(m_streamServiceLayer);
     }
 
-    QJsonValue streamUrlsValue = serviceObject.value(streamUrlsKey);
-    if (!streamUrlsValue.isArray())
+    // Attributes of the described fields are decoded into typed columns
+    const StreamServiceFieldSchema fieldSchema = StreamServiceFieldSchema::createFromJson(serviceObject.value(QStringLiteral("fields")));
+    if (!fieldSchema.isEmpty())
     {
-        qDebug() << "Streaming urls do not represent an array!";
-        return;
+        m_streamServiceLayer->setFieldSchema(fieldSchema);
     }
 
-    QJsonArray streamUrlsArray = streamUrlsValue.toArray();
-    if (streamUrlsArray.size() < 1)
+    // Project geographic features before they reach the map, the basemap is always Web Mercator
+    const SpatialReference mapSpatialReference = m_map->spatialReference();
+    m_streamServiceLayer->setTargetSpatialReference(mapSpatialReference.isEmpty() ? SpatialReference::webMercator() : mapSpatialReference);
+    if (!replayCaptureFilePath.isEmpty())
     {
-        qDebug() << "Streaming urls does not contain any item!";
-        return;
+        m_streamServiceLayer->setReplayCapture(replayCaptureFilePath, replaySpeed);
     }
 
-    // TODO: Take all items not only the first one
-    QJsonValue streamUrlsFirstItemValue = streamUrlsArray[0];
-    if (!streamUrlsFirstItemValue.isObject())
+    // Optionally record the received messages for a later replay
+    QString capturePathKeyName = "streamservice_capture_path";
+    if (systemEnvironment.contains(capturePathKeyName))
     {
-        qDebug() << "The first streaming urls item does not represent an object!";
-        return;
+        m_streamServiceLayer->startRecording(systemEnvironment.value(capturePathKeyName));
     }
 
-    // TODO: Parse the transport value ("ws" expected)
-    auto const urlsKey = "urls";
-    QJsonObject streamUrlsFirstItemObject = streamUrlsFirstItemValue.toObject();
-    if (!streamUrlsFirstItemObject.contains(urlsKey))
+    // Optionally decode every endpoint in parallel instead of using them as hot standby
+    QString connectionModeKeyName = "streamservice_connection_mode";
+    if (QStringLiteral("parallel") == systemEnvironment.value(connectionModeKeyName))
     {
-        qDebug() << "Streaming urls does not contain any urls!";
-        return;
+        m_streamServiceLayer->setConnectionMode(StreamServiceIngestWorker::ConnectionMode::Parallel);
     }
 
-    QJsonValue urlsValue = streamUrlsFirstItemObject.value(urlsKey);
-    if (!urlsValue.isArray())
+    // Optionally limit the threads decoding the text messages
+    QString decodeThreadsKeyName = "streamservice_decode_threads";
+    if (systemEnvironment.contains(decodeThreadsKeyName))
     {
-        qDebug() << "Urls do not represent an array!";
-        return;
+        m_streamServiceLayer->setDecodeThreadCount(systemEnvironment.value(decodeThreadsKeyName).toInt());
     }
 
-    QJsonArray urlsArray = urlsValue.toArray();
-    if (urlsArray.size() < 1)
+    // Optionally override the time to live of the tracks in seconds
+    QString trackTimeToLiveKeyName = "streamservice_track_ttl";
+    if (systemEnvironment.contains(trackTimeToLiveKeyName))
     {
-        qDebug() << "Urls does not contain any item!";
-        return;
+        bool validTimeToLive = false;
+        double trackTimeToLive = systemEnvironment.value(trackTimeToLiveKeyName).toDouble(&validTimeToLive);
+        if (validTimeToLive)
+        {
+            m_streamServiceLayer->setTrackTimeToLive(qRound64(trackTimeToLive * 1000));
+        }
     }
 
-    // TODO: Take all urls not only the first url
-    QString streamServiceWebSocketEndpoint = urlsArray[0].toString();
-    qDebug() << "Web socket endpoint is " << streamServiceWebSocketEndpoint;
-    m_streamServiceLayer = new StreamServiceLayer(QUrl(streamServiceWebSocketEndpoint), this);
-    m_streamServiceLayer->setTimeInfo(timeInfo);
+    // Optionally cap the live tracks by count and by an estimated memory budget in megabytes
+    QString maximumTrackCountKeyName = "streamservice_max_tracks";
+    if (systemEnvironment.contains(maximumTrackCountKeyName))
+    {
+        m_streamServiceLayer->setMaximumTrackCount(systemEnvironment.value(maximumTrackCountKeyName).toInt());
+    }
+
+    QString memoryBudgetKeyName = "streamservice_memory_budget";
+    if (systemEnvironment.contains(memoryBudgetKeyName))
+    {
+        m_streamServiceLayer->setMemoryBudget(systemEnvironment.value(memoryBudgetKeyName).toLongLong() * 1024 * 1024);
+    }
+
+    // Optionally keep the last positions of every track as trail
+    QString trailLengthKeyName = "streamservice_trail_length";
+    if (systemEnvironment.contains(trailLengthKeyName))
+    {
+        int trailLength = systemEnvironment.value(trailLengthKeyName).toInt();
+        if (0 < trailLength)
+        {
+            SimpleLineSymbol *trailSymbol = new SimpleLineSymbol(SimpleLineSymbolStyle::Solid, QColor(167, 173, 109, 160), 1.5f, this);
+            m_trailGraphicsOverlay->setRenderer(new SimpleRenderer(trailSymbol, this));
+            m_streamServiceLayer->setTrailLength(trailLength);
+            m_streamServiceLayer->setTrailGraphicsModel(m_trailGraphicsOverlay->graphics());
+        }
+    }
+
+    // Optionally record the observations of the last hours for time scrubbing
+    QString historyRetentionKeyName = "streamservice_history_retention";
+    if (systemEnvironment.contains(historyRetentionKeyName))
+    {
+        bool validRetention = false;
+        double historyRetention = systemEnvironment.value(historyRetentionKeyName).toDouble(&validRetention);
+        if (validRetention && 0 < historyRetention)
+        {
+            m_streamServiceLayer->setHistoryRetention(qRound64(historyRetention * 60 * 60 * 1000));
+            m_streamServiceLayer->setHistoryGraphicsModel(m_historyGraphicsOverlay->graphics());
+            m_historyExtentTimer.start();
+        }
+    }
+
+    // Optionally filter by attributes, the spatial filter follows the visible area unless disabled
+    QString whereClauseKeyName = "streamservice_where";
+    if (systemEnvironment.contains(whereClauseKeyName))
+    {
+        m_streamServiceLayer->setWhereClause(systemEnvironment.value(whereClauseKeyName));
+    }
+
+    QString outFieldsKeyName = "streamservice_out_fields";
+    if (systemEnvironment.contains(outFieldsKeyName))
+    {
+        m_streamServiceLayer->setOutFields(systemEnvironment.value(outFieldsKeyName).split(QLatin1Char(','), QString::SkipEmptyParts));
+    }
+
+    QString extentFilterKeyName = "streamservice_extent_filter";
+    if (systemEnvironment.contains(extentFilterKeyName))
+    {
+        m_extentFilterEnabled = (QStringLiteral("0") != systemEnvironment.value(extentFilterKeyName));
+    }
+
+    if (m_extentFilterEnabled)
+    {
+        onFilterTimeout();
+    }
+
+    // Optionally serve the pipeline metrics for scraping on localhost
+    QString metricsPortKeyName = "streamservice_metrics_port";
+    if (systemEnvironment.contains(metricsPortKeyName))
+    {
+        bool validPort = false;
+        quint16 metricsPort = systemEnvironment.value(metricsPortKeyName).toUShort(&validPort);
+        if (validPort && nullptr == m_metricsEndpoint)
+        {
+            m_metricsEndpoint = new StreamServiceMetricsEndpoint(this);
+            m_metricsEndpoint->setMetricsProvider([this]() {
+                return metricsText();
+            });
+            m_metricsEndpoint->listen(metricsPort);
+        }
+    }
+    m_metricsClock.start();
+    m_metricsTimer.start();
+
+    // Optionally trace the pipeline stages, every n-th message is sampled
+    QString tracePathKeyName = "streamservice_trace_path";
+    if (systemEnvironment.contains(tracePathKeyName))
+    {
+#ifdef STREAMSERVICE_TRACING
+        m_traceFilePath = systemEnvironment.value(tracePathKeyName);
+        QString traceSamplingKeyName = "streamservice_trace_sampling";
+        if (systemEnvironment.contains(traceSamplingKeyName))
+        {
+            StreamServiceTrace::setSamplingInterval(systemEnvironment.value(traceSamplingKeyName).toInt());
+        }
+        StreamServiceTrace::setEnabled(true);
+#else
+        qWarning() << "Tracing requires building with STREAMSERVICEVIEWER_ENABLE_TRACING!";
+#endif
+    }
+
+    // Optionally override how often staged track updates are committed
+    QString commitIntervalKeyName = "streamservice_commit_interval";
+    if (systemEnvironment.contains(commitIntervalKeyName))
+    {
+        bool validInterval = false;
+        int commitInterval = systemEnvironment.value(commitIntervalKeyName).toInt(&validInterval);
+        if (validInterval)
+        {
+            m_streamServiceLayer->setCommitInterval(commitInterval);
+        }
+    }
 
     // Define the graphics rendering
     /*
     SimpleMarkerSymbol *streamMarkerSymbol = new SimpleMarkerSymbol(SimpleMarkerSymbolStyle::Circle, Qt::black, 5, this);
     SimpleRenderer *streamGraphicsRenderer = new SimpleRenderer(streamMarkerSymbol, this);
     */
-    m_simpleRenderer = m_rendererFactory->createRendererFromDrawingInfo(drawingInfoValue);
-    m_heatmapRenderer = m_rendererFactory->createHeatmapRenderer();
+    Renderer *previousSimpleRenderer = m_simpleRenderer;
+    Renderer *previousHistoryRenderer = m_historyRenderer;
+    m_simpleRenderer = simpleRenderer;
+    m_historyRenderer = historyRenderer;
+    if (nullptr == m_heatmapRenderer)
+    {
+        m_heatmapRenderer = m_rendererFactory->createHeatmapRenderer();
+    }
     m_streamGraphicsOverlay->setRenderer(m_simpleRenderer);
     m_streamGraphicsOverlay->setOpacity(0.85f);
+    m_historyGraphicsOverlay->setRenderer(m_historyRenderer);
+    m_historyGraphicsOverlay->setOpacity(0.85f);
+
+    // The renderers of the replaced description are no longer referenced by an overlay
+    if (nullptr != previousSimpleRenderer)
+    {
+        previousSimpleRenderer->deleteLater();
+    }
+    if (nullptr != previousHistoryRenderer)
+    {
+        previousHistoryRenderer->deleteLater();
+    }
 
     // Define the target graphics model for the stream service layer
     m_streamServiceLayer->setGraphicsModel(m_streamGraphicsOverlay->graphics());
-}
+
+    // Optionally show the heat view as the point heatmap of the runtime or tune the density grid
+    QString heatModeKeyName = "streamservice_heat_mode";
+    m_densityHeat = (QStringLiteral("points") != systemEnvironment.value(heatModeKeyName));
+    QString heatWeightFieldKeyName = "streamservice_heat_weight_field";
+    if (systemEnvironment.contains(heatWeightFieldKeyName))
+    {
+        m_streamServiceLayer->setDensityWeightField(systemEnvironment.value(heatWeightFieldKeyName));
+    }
+
+    QString heatHalfLifeKeyName = "streamservice_heat_half_life";
+    if (systemEnvironment.contains(heatHalfLifeKeyName))
+    {
+        bool validHalfLife = false;
+        double heatHalfLife = systemEnvironment.value(heatHalfLifeKeyName).toDouble(&validHalfLife);
+        if (validHalfLife)
+        {
+            m_streamServiceLayer->setDensityHalfLife(qRound64(heatHalfLife * 1000));
+        }
+    }
+
+    QString heatCellsKeyName = "streamservice_heat_cells";
+    QString heatBlurKeyName = "streamservice_heat_blur";
+    if (systemEnvironment.contains(heatCellsKeyName) || systemEnvironment.contains(heatBlurKeyName))
+    {
+        m_streamServiceLayer->setDensityResolution(systemEnvironment.value(heatCellsKeyName, QStringLiteral("16384")).toInt(),
+                                                   systemEnvironment.value(heatBlurKeyName, QStringLiteral("1")).toInt());
+    }
+
+    // Repaint the last known tracks and keep the picture up to date for the next start
+    if (!m_snapshotFilePath.isEmpty())
+    {
+        const QString snapshotSource = m_serviceInfoEndpoint.toString();
+        const qint64 maximumSnapshotAge = (0 < m_streamServiceLayer->trackTimeToLive()) ? m_streamServiceLayer->trackTimeToLive() : 15 * 60 * 1000;
+        const int restoredTrackCount = m_streamServiceLayer->restoreSnapshot(m_snapshotFilePath, snapshotSource, maximumSnapshotAge);
+        if (0 < restoredTrackCount)
+        {
+            qDebug() << "Restored" << restoredTrackCount << "tracks from the last snapshot";
+        }
+
+        // Optionally override how often the snapshot is written in seconds, zero disables it
+        QString snapshotIntervalKeyName = "streamservice_snapshot_interval";
+        int snapshotInterval = 10;
+        if (systemEnvironment.contains(snapshotIntervalKeyName))
+        {
+            snapshotInterval = systemEnvironment.value(snapshotIntervalKeyName).toInt();
+        }
+        m_streamServiceLayer->setSnapshotFile(m_snapshotFilePath, snapshotSource, snapshotInterval * 1000);
+    }
+
+    // The heat view survives a fresh description
+    if (m_heatActive)
+    {
+        renderHeat();
+    }
+
+    // Streaming continues using the fresh description
+    if (m_subscribed)
+    {
+        m_streamServiceLayer->subscribe();
+    }
+    return true;
@@ -41,6 +41,8 @@
 
 class RendererFactory;
 class StreamServiceLayer;
+class StreamServiceMetricsEndpoint;
+class QQuickWindow;
 
 namespace Esri
 {
@@ -53,14 +55,39 @@ class Renderer;
 }
 }
 
+#include "StreamServiceDescriptionCache.h"
+#include "StreamServiceHistogram.h"
+
+#include <QElapsedTimer>
 #include <QNetworkAccessManager>
 #include <QObject>
+#include <QTimer>
+#include <QUrl>
+#include <QVariantList>
+#include <QVariantMap>
 
 class StreamServiceViewer : public QObject
 {
     Q_OBJECT
 
     Q_PROPERTY(Esri::ArcGISRuntime::MapQuickView* mapView READ mapView WRITE setMapView NOTIFY mapViewChanged)
+    Q_PROPERTY(double historyStart READ historyStart NOTIFY historyExtentChanged)
+    Q_PROPERTY(double historyEnd READ historyEnd NOTIFY historyExtentChanged)
+    Q_PROPERTY(bool liveMode READ liveMode NOTIFY liveModeChanged)
+    Q_PROPERTY(bool subscribed READ subscribed NOTIFY subscribedChanged)
+
+    // Pipeline metrics of the last second, the latencies are in milliseconds
+    Q_PROPERTY(double messageRate READ messageRate NOTIFY metricsChanged)
+    Q_PROPERTY(double byteRate READ byteRate NOTIFY metricsChanged)
+    Q_PROPERTY(double parseFailureCount READ parseFailureCount NOTIFY metricsChanged)
+    Q_PROPERTY(double decodeMicroseconds READ decodeMicroseconds NOTIFY metricsChanged)
+    Q_PROPERTY(int queueDepth READ queueDepth NOTIFY metricsChanged)
+    Q_PROPERTY(double commitRate READ commitRate NOTIFY metricsChanged)
+    Q_PROPERTY(double updatesPerCommit READ updatesPerCommit NOTIFY metricsChanged)
+    Q_PROPERTY(int trackCount READ trackCount NOTIFY metricsChanged)
+    Q_PROPERTY(double commitLatency READ commitLatency NOTIFY metricsChanged)
+    Q_PROPERTY(double displayStaleness READ displayStaleness NOTIFY metricsChanged)
+    Q_PROPERTY(double frameRate READ frameRate NOTIFY metricsChanged)
 
 public:
     explicit StreamServiceViewer(QObject* parent = nullptr);
@@ -72,25 +99,109 @@ public:
     Q_INVOKABLE void renderSimple();
     Q_INVOKABLE void renderHeat();
 
+    // Time window in milliseconds since epoch
+    Q_INVOKABLE void showHistory(double windowStart, double windowEnd);
+    Q_INVOKABLE void showLive();
+
+    // Attributes of the live tracks, the screen coordinates and sizes are in device independent pixels
+    Q_INVOKABLE QVariantList queryVisibleTracks() const;
+    Q_INVOKABLE QVariantList queryTracksAround(double screenX, double screenY, double screenRadius) const;
+    Q_INVOKABLE QVariantMap identifyTrack(double screenX, double screenY, double screenTolerance) const;
+
 signals:
     void mapViewChanged();
+    void historyExtentChanged();
+    void liveModeChanged();
+    void subscribedChanged();
+    void metricsChanged();
 
 private slots:
     void onStreamServiceInfoRequestFinished(QNetworkReply *infoReply);
+    void onVisibleAreaChanged();
+    void onFilterTimeout();
+    void onWindowChanged(QQuickWindow *window);
+    void onMetricsTimeout();
+    void onDensityTimeout();
 
 private:
     Esri::ArcGISRuntime::MapQuickView* mapView() const;
     void setMapView(Esri::ArcGISRuntime::MapQuickView* mapView);
+    double historyStart() const;
+    double historyEnd() const;
+    bool liveMode() const;
+    bool subscribed() const;
+    void setSubscribed(bool subscribed);
+    bool applyServiceDescription(const QByteArray &description);
+    void releaseStreamServiceLayer();
+    void showDensity(bool visible);
+    double messageRate() const;
+    double byteRate() const;
+    double parseFailureCount() const;
+    double decodeMicroseconds() const;
+    int queueDepth() const;
+    double commitRate() const;
+    double updatesPerCommit() const;
+    int trackCount() const;
+    double commitLatency() const;
+    double displayStaleness() const;
+    double frameRate() const;
+    QByteArray metricsText() const;
 
     Esri::ArcGISRuntime::Map* m_map = nullptr;
     Esri::ArcGISRuntime::MapQuickView* m_mapView = nullptr;
     Esri::ArcGISRuntime::GraphicsOverlay* m_streamGraphicsOverlay = nullptr;
+    Esri::ArcGISRuntime::GraphicsOverlay* m_trailGraphicsOverlay = nullptr;
+    Esri::ArcGISRuntime::GraphicsOverlay* m_historyGraphicsOverlay = nullptr;
+    Esri::ArcGISRuntime::GraphicsOverlay* m_densityGraphicsOverlay = nullptr;
+    QTimer m_historyExtentTimer;
+    QTimer m_filterTimer;
+    bool m_extentFilterEnabled = true;
+    quint64 m_filterUpdateCount = 0;
+
+    // Counters at the last metrics update, the rates are derived from their growth
+    QTimer m_metricsTimer;
+    QElapsedTimer m_metricsClock;
+    quint64 m_frameCount = 0;
+    quint64 m_lastFrameCount = 0;
+    quint64 m_lastReceivedMessageCount = 0;
+    quint64 m_lastReceivedBytes = 0;
+    quint64 m_lastDecodedMessageCount = 0;
+    quint64 m_lastDecodeNanos = 0;
+    quint64 m_lastCommitCount = 0;
+    quint64 m_lastCommittedUpdateCount = 0;
+    StreamServiceHistogram m_lastCommitLatency;
+    StreamServiceHistogram m_lastDisplayStaleness;
+    double m_messageRate = 0;
+    double m_byteRate = 0;
+    double m_decodeMicroseconds = 0;
+    double m_commitRate = 0;
+    double m_updatesPerCommit = 0;
+    double m_commitLatency = 0;
+    double m_displayStaleness = 0;
+    double m_frameRate = 0;
+    StreamServiceMetricsEndpoint* m_metricsEndpoint = nullptr;
+
+    // Written when the viewer is destroyed, the render start time is only touched by the render thread
+    QString m_traceFilePath;
+    qint64 m_renderStartTime = 0;
 
     QNetworkAccessManager* m_networkAccessManager = nullptr;
     StreamServiceLayer* m_streamServiceLayer = nullptr;
+    bool m_subscribed = false;
+
+    // The service description is cached and the live tracks are snapshot per service endpoint
+    QUrl m_serviceInfoEndpoint;
+    StreamServiceDescriptionCache m_descriptionCache;
+    QString m_snapshotFilePath;
     RendererFactory* m_rendererFactory = nullptr;
     Esri::ArcGISRuntime::Renderer* m_simpleRenderer = nullptr;
     Esri::ArcGISRuntime::Renderer* m_heatmapRenderer = nullptr;
+    Esri::ArcGISRuntime::Renderer* m_historyRenderer = nullptr;
+
+    // The heat view shows the density grid of the layer unless the point heatmap is configured
+    QTimer m_densityTimer;
+    bool m_densityHeat = true;
+    bool m_heatActive = false;
 };
 
 #endif // STREAMSERVICEVIEWER_H
@@ -0,0 +1,285 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceBinaryCodec.h"
+#include "StreamServiceTrackUpdate.h"
+#include "TestReport.h"
+
+#include "Envelope.h"
+#include "Point.h"
+
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QTextStream>
+#include <QVector>
+
+#include <cmath>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace
+{
+// Quantization of WGS84 coordinates, see scaleForSpatialReference
+const double CoordinateTolerance = 1e-7;
+
+QJsonObject createPointFeature(double x, double y, const QJsonObject &attributesObject)
+{
+    QJsonObject spatialReferenceObject;
+    spatialReferenceObject.insert(QStringLiteral("wkid"), 4326);
+    QJsonObject geometryObject;
+    geometryObject.insert(QStringLiteral("x"), x);
+    geometryObject.insert(QStringLiteral("y"), y);
+    geometryObject.insert(QStringLiteral("spatialReference"), spatialReferenceObject);
+
+    QJsonObject featureObject;
+    featureObject.insert(QStringLiteral("geometry"), geometryObject);
+    featureObject.insert(QStringLiteral("attributes"), attributesObject);
+    return featureObject;
+}
+
+QJsonObject createPolylineFeature(const QJsonObject &attributesObject)
+{
+    const QJsonArray firstPath = { QJsonArray({ 0.0, 0.0 }), QJsonArray({ 1.0, 1.0 }) };
+    const QJsonArray secondPath = { QJsonArray({ 2.0, 2.0 }), QJsonArray({ 3.0, 3.5 }) };
+    QJsonObject geometryObject;
+    geometryObject.insert(QStringLiteral("paths"), QJsonArray({ firstPath, secondPath }));
+
+    QJsonObject featureObject;
+    featureObject.insert(QStringLiteral("geometry"), geometryObject);
+    featureObject.insert(QStringLiteral("attributes"), attributesObject);
+    return featureObject;
+}
+
+// The frames of four features, a new field in the third one changes the schema in between
+QList<QByteArray> encodeFeatures()
+{
+    StreamServiceBinaryEncoder encoder;
+    encoder.setDateFields(QStringList() << QStringLiteral("time"));
+
+    QJsonObject firstAttributes;
+    firstAttributes.insert(QStringLiteral("track_id"), QStringLiteral("a"));
+    firstAttributes.insert(QStringLiteral("time"), 1600000000000.0);
+    firstAttributes.insert(QStringLiteral("speed"), 12.5);
+    firstAttributes.insert(QStringLiteral("count"), 7);
+    firstAttributes.insert(QStringLiteral("active"), true);
+    firstAttributes.insert(QStringLiteral("name"), QStringLiteral("Alpha"));
+    firstAttributes.insert(QStringLiteral("note"), QJsonValue());
+    encoder.addFeature(createPointFeature(13.4050001, 52.5200003, firstAttributes));
+
+    QJsonObject secondAttributes;
+    secondAttributes.insert(QStringLiteral("track_id"), QStringLiteral("b"));
+    secondAttributes.insert(QStringLiteral("time"), 1600000001000.0);
+    secondAttributes.insert(QStringLiteral("speed"), -3.25);
+    secondAttributes.insert(QStringLiteral("count"), -2);
+    secondAttributes.insert(QStringLiteral("active"), false);
+    secondAttributes.insert(QStringLiteral("name"), QStringLiteral("Gr\u00fc\u00dfe"));
+    secondAttributes.insert(QStringLiteral("note"), QJsonValue());
+    encoder.addFeature(createPointFeature(-70.1, -33.4, secondAttributes));
+
+    QJsonObject thirdAttributes;
+    thirdAttributes.insert(QStringLiteral("track_id"), QStringLiteral("a"));
+    thirdAttributes.insert(QStringLiteral("time"), 1600000002000.0);
+    thirdAttributes.insert(QStringLiteral("count"), 9);
+    thirdAttributes.insert(QStringLiteral("heading"), 270);
+    encoder.addFeature(createPointFeature(13.5, 52.6, thirdAttributes));
+
+    QJsonObject fourthAttributes;
+    fourthAttributes.insert(QStringLiteral("track_id"), QStringLiteral("c"));
+    fourthAttributes.insert(QStringLiteral("time"), 1600000003000.0);
+    encoder.addFeature(createPolylineFeature(fourthAttributes));
+
+    encoder.expireTracks(QStringList() << QStringLiteral("b") << QStringLiteral("d"));
+    return encoder.takeFrames();
+}
+
+void configureDecoder(StreamServiceBinaryDecoder &decoder)
+{
+    decoder.setTimeInfoFields(QStringLiteral("track_id"), QStringLiteral("time"), QString());
+}
+
+bool isNear(double value, double expectedValue)
+{
+    return std::abs(value - expectedValue) <= CoordinateTolerance;
+}
+
+bool isNearPoint(const Geometry &geometry, double x, double y)
+{
+    if (GeometryType::Point != geometry.geometryType())
+    {
+        return false;
+    }
+
+    const Point point(geometry);
+    return isNear(point.x(), x) && isNear(point.y(), y);
+}
+
+void testRoundTrip(TestReport &report, const QList<QByteArray> &frames)
+{
+    // Schema, features, schema, features and the expired tracks
+    report.check(5 == frames.size(), QStringLiteral("the encoder emits five frames"));
+
+    StreamServiceBinaryDecoder decoder;
+    configureDecoder(decoder);
+    QVector<StreamServiceTrackUpdate> updates;
+    for (auto const &frame : frames)
+    {
+        report.check(decoder.decode(frame, updates), QStringLiteral("every frame decodes"));
+    }
+    if (!report.check(6 == updates.size(), QStringLiteral("four features and two expired tracks are decoded")))
+    {
+        return;
+    }
+
+    const StreamServiceTrackUpdate &first = updates[0];
+    report.check(QStringLiteral("a") == first.trackId && StreamServiceTrackTable::hashTrackId(first.trackId) == first.trackIdHash, QStringLiteral("first track id"));
+    report.check(!first.expired, QStringLiteral("features are not expired"));
+    report.check(1600000000000 == first.startTime.toMSecsSinceEpoch(), QStringLiteral("first start time"));
+    report.check(isNearPoint(first.geometry, 13.4050001, 52.5200003), QStringLiteral("first point"));
+    report.check(4326 == first.geometry.spatialReference().wkid(), QStringLiteral("first spatial reference"));
+    report.check(12.5 == first.attributes.value(QStringLiteral("speed")).toDouble(), QStringLiteral("first double attribute"));
+    report.check(7 == first.attributes.value(QStringLiteral("count")).toLongLong(), QStringLiteral("first integer attribute"));
+    report.check(first.attributes.value(QStringLiteral("active")).toBool(), QStringLiteral("first boolean attribute"));
+    report.check(QStringLiteral("Alpha") == first.attributes.value(QStringLiteral("name")).toString(), QStringLiteral("first string attribute"));
+    report.check(first.attributes.contains(QStringLiteral("note")) && first.attributes.value(QStringLiteral("note")).isNull(), QStringLiteral("first null attribute"));
+
+    const StreamServiceTrackUpdate &second = updates[1];
+    report.check(QStringLiteral("b") == second.trackId, QStringLiteral("second track id"));
+    report.check(1600000001000 == second.startTime.toMSecsSinceEpoch(), QStringLiteral("second start time, delta encoded"));
+    report.check(isNearPoint(second.geometry, -70.1, -33.4), QStringLiteral("second point, delta encoded"));
+    report.check(-3.25 == second.attributes.value(QStringLiteral("speed")).toDouble(), QStringLiteral("second double attribute"));
+    report.check(-2 == second.attributes.value(QStringLiteral("count")).toLongLong(), QStringLiteral("second integer attribute, delta encoded"));
+    report.check(!second.attributes.value(QStringLiteral("active")).toBool(), QStringLiteral("second boolean attribute"));
+    report.check(QStringLiteral("Gr\u00fc\u00dfe") == second.attributes.value(QStringLiteral("name")).toString(), QStringLiteral("second string attribute"));
+    report.check(second.attributes.value(QStringLiteral("note")).isNull(), QStringLiteral("second null attribute"));
+
+    // Deltas restart with the frame of the new schema
+    const StreamServiceTrackUpdate &third = updates[2];
+    report.check(QStringLiteral("a") == third.trackId, QStringLiteral("third track id"));
+    report.check(1600000002000 == third.startTime.toMSecsSinceEpoch(), QStringLiteral("third start time"));
+    report.check(isNearPoint(third.geometry, 13.5, 52.6), QStringLiteral("third point"));
+    report.check(9 == third.attributes.value(QStringLiteral("count")).toLongLong(), QStringLiteral("third integer attribute"));
+    report.check(270 == third.attributes.value(QStringLiteral("heading")).toLongLong(), QStringLiteral("third attribute of the new schema"));
+    report.check(!third.attributes.contains(QStringLiteral("speed")), QStringLiteral("third attributes only contain the sent fields"));
+
+    const StreamServiceTrackUpdate &fourth = updates[3];
+    report.check(QStringLiteral("c") == fourth.trackId, QStringLiteral("fourth track id"));
+    report.check(GeometryType::Polyline == fourth.geometry.geometryType(), QStringLiteral("fourth geometry is a polyline"));
+    const Envelope extent = fourth.geometry.extent();
+    report.check(isNear(extent.xMin(), 0.0) && isNear(extent.yMin(), 0.0) && isNear(extent.xMax(), 3.0) && isNear(extent.yMax(), 3.5), QStringLiteral("fourth polyline extent"));
+
+    report.check(updates[4].expired && QStringLiteral("b") == updates[4].trackId, QStringLiteral("first expired track"));
+    report.check(updates[5].expired && QStringLiteral("d") == updates[5].trackId
+                 && StreamServiceTrackTable::hashTrackId(updates[5].trackId) == updates[5].trackIdHash, QStringLiteral("second expired track"));
+}
+
+void testTruncatedFrames(TestReport &report, const QList<QByteArray> &frames)
+{
+    // Every prefix of a frame fails, features in front of the cut may still be delivered
+    for (int frameIndex = 0; frameIndex < frames.size(); frameIndex++)
+    {
+        const QByteArray &frame = frames[frameIndex];
+        QVector<StreamServiceTrackUpdate> completeUpdates;
+        StreamServiceBinaryDecoder completeDecoder;
+        configureDecoder(completeDecoder);
+        for (int previousIndex = 0; previousIndex <= frameIndex; previousIndex++)
+        {
+            completeUpdates.clear();
+            completeDecoder.decode(frames[previousIndex], completeUpdates);
+        }
+
+        for (int prefixSize = 0; prefixSize < frame.size(); prefixSize++)
+        {
+            StreamServiceBinaryDecoder decoder;
+            configureDecoder(decoder);
+            QVector<StreamServiceTrackUpdate> updates;
+            for (int previousIndex = 0; previousIndex < frameIndex; previousIndex++)
+            {
+                decoder.decode(frames[previousIndex], updates);
+            }
+            const bool hadSchema = decoder.hasSchema();
+
+            updates.clear();
+            const QString description = QStringLiteral("frame %1 cut after %2 of %3 bytes").arg(frameIndex).arg(prefixSize).arg(frame.size());
+            report.check(!decoder.decode(frame.left(prefixSize), updates), description + QStringLiteral(" is rejected"));
+            report.check(hadSchema == decoder.hasSchema(), description + QStringLiteral(" keeps the schema state"));
+            report.check(updates.size() < qMax(1, completeUpdates.size()), description + QStringLiteral(" delivers fewer updates"));
+        }
+    }
+}
+
+void testMalformedFrames(TestReport &report, const QList<QByteArray> &frames)
+{
+    StreamServiceBinaryDecoder decoder;
+    configureDecoder(decoder);
+    QVector<StreamServiceTrackUpdate> updates;
+    report.check(!decoder.decode(QByteArray("\x00\x02", 2), updates), QStringLiteral("a frame without the marker is rejected"));
+
+    QByteArray unknownFrame;
+    unknownFrame.append(static_cast<char>(StreamServiceBinaryCodec::FrameMarker));
+    unknownFrame.append(static_cast<char>(9));
+    report.check(!decoder.decode(unknownFrame, updates), QStringLiteral("an unknown frame type is rejected"));
+
+    // Features need the schema they reference
+    report.check(!decoder.decode(frames.value(1), updates) && updates.isEmpty(), QStringLiteral("features without a schema are rejected"));
+
+    // One feature without a geometry referencing the slot behind the seven fields
+    report.check(decoder.decode(frames.value(0), updates), QStringLiteral("the schema frame decodes"));
+    QByteArray slotFrame;
+    slotFrame.append(static_cast<char>(StreamServiceBinaryCodec::FrameMarker));
+    slotFrame.append(static_cast<char>(StreamServiceBinaryCodec::FrameType::Features));
+    slotFrame.append(static_cast<char>(1));
+    slotFrame.append(static_cast<char>(1));
+    slotFrame.append(static_cast<char>(StreamServiceBinaryCodec::GeometryType::None));
+    slotFrame.append(static_cast<char>(1));
+    slotFrame.append(static_cast<char>(7 << 1));
+    slotFrame.append(static_cast<char>(0));
+    updates.clear();
+    report.check(!decoder.decode(slotFrame, updates) && updates.isEmpty(), QStringLiteral("an unknown attribute slot is rejected"));
+}
+}
+
+///
+/// Encodes features and expired tracks into binary frames and decodes them again.
+/// Every prefix of the frames and a few malformed frames must be rejected.
+///
+int main(int argc, char *argv[])
+{
+    // The geometries are never rendered
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QTextStream out(stdout);
+    TestReport report(out);
+
+    const QList<QByteArray> frames = encodeFeatures();
+    testRoundTrip(report, frames);
+    testTruncatedFrames(report, frames);
+    testMalformedFrames(report, frames);
+    return report.exitCode();
+}
@@ -0,0 +1,491 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceCapture.h"
+#include "StreamServiceDecodePool.h"
+#include "StreamServiceFeatureDecoder.h"
+#include "StreamServiceFieldSchema.h"
+#include "StreamServiceLayer.h"
+#include "StreamServiceProjection.h"
+#include "StreamServiceTrackTable.h"
+#include "StreamServiceTrackUpdate.h"
+#include "SyntheticFeatureGenerator.h"
+
+#include "AttributeListModel.h"
+#include "Graphic.h"
+#include "GraphicListModel.h"
+#include "GraphicsOverlay.h"
+
+#include <QCommandLineParser>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QGuiApplication>
+#include <QHash>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <QVector>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace
+{
+bool readCapture(const QString &captureFilePath, QVector<QByteArray> &corpus)
+{
+    StreamServiceCaptureReader captureReader;
+    if (!captureReader.open(captureFilePath))
+    {
+        return false;
+    }
+
+    // Binary frames take another decode path, only the text messages are measured
+    StreamServiceCaptureRecord record;
+    while (captureReader.readNext(record))
+    {
+        if (StreamServiceCapture::MessageType::Text == record.type)
+        {
+            corpus.append(record.payload);
+        }
+    }
+    return true;
+}
+
+bool readCorpus(const QString &corpusFilePath, QVector<QByteArray> &corpus)
+{
+    QFile corpusFile(corpusFilePath);
+    if (!corpusFile.open(QIODevice::ReadOnly))
+    {
+        qWarning() << "Failed to open the corpus file:" << corpusFile.errorString();
+        return false;
+    }
+
+    // Every line is one message, the bytes are taken as they are
+    while (!corpusFile.atEnd())
+    {
+        QByteArray line = corpusFile.readLine();
+        if (line.endsWith('\n'))
+        {
+            line.chop(1);
+        }
+        corpus.append(line);
+    }
+    return true;
+}
+
+bool sameUpdate(bool decoded, const StreamServiceTrackUpdate &update, bool expectedDecoded, const StreamServiceTrackUpdate &expected, double tolerance)
+{
+    if (decoded != expectedDecoded)
+    {
+        return false;
+    }
+    if (!decoded)
+    {
+        return true;
+    }
+
+    // The projection kernel and the runtime may differ in the last digits
+    const bool sameGeometry = (0 < tolerance) ? update.geometry.equals(expected.geometry, tolerance) : update.geometry.equals(expected.geometry);
+    return sameGeometry
+            && update.attributes == expected.attributes
+            && update.attributeRow == expected.attributeRow
+            && update.trackId == expected.trackId
+            && update.trackIdHash == expected.trackIdHash
+            && update.startTime == expected.startTime
+            && update.endTime == expected.endTime;
+}
+
+int verifyDecoder(QTextStream &out, StreamServiceFeatureDecoder &decoder, const QVector<QByteArray> &corpus, double tolerance)
+{
+    // The document path is the reference, every message must decode into the same update
+    int mismatchCount = 0;
+    for (int messageIndex = 0; messageIndex < corpus.size(); messageIndex++)
+    {
+        StreamServiceTrackUpdate update;
+        const bool decoded = decoder.decode(corpus[messageIndex], update);
+        StreamServiceTrackUpdate expected;
+        const bool expectedDecoded = decoder.decodeDocument(corpus[messageIndex], expected);
+        if (!sameUpdate(decoded, update, expectedDecoded, expected, tolerance))
+        {
+            mismatchCount++;
+            out << "mismatch in message " << messageIndex << ": " << QString::fromUtf8(corpus[messageIndex].left(200)) << endl;
+        }
+    }
+    return mismatchCount;
+}
+
+void printStage(QTextStream &out, const char *stageName, qint64 nanos, int messageCount)
+{
+    out << "  " << QString::fromLatin1(stageName).leftJustified(24) << double(nanos) / messageCount << " ns/msg" << endl;
+}
+
+///
+/// \brief The MessageProducer class
+/// Partitions the messages like the ingest worker and pushes them into the decode pool.
+///
+class MessageProducer : public QThread
+{
+public:
+    MessageProducer(StreamServiceDecodePool &decodePool, const StreamServiceFeatureDecoder &decoder, const QVector<QByteArray> &corpus) :
+        m_decodePool(decodePool),
+        m_decoder(decoder),
+        m_corpus(corpus)
+    {
+    }
+
+protected:
+    void run() override
+    {
+        // The message index is used as receive time, so that the order of every track can be checked
+        for (int messageIndex = 0; messageIndex < m_corpus.size(); messageIndex++)
+        {
+            const QByteArray &message = m_corpus[messageIndex];
+            QString trackId;
+            if (StreamServiceFeatureDecoder::TrackIdPeek::Ambiguous != m_decoder.peekTrackId(message, trackId))
+            {
+                m_decodePool.pushMessage(message, trackId, messageIndex);
+                continue;
+            }
+
+            StreamServiceTrackUpdate update;
+            if (m_decoder.decode(message, update))
+            {
+                update.receiveTime = messageIndex;
+                m_decodePool.pushUpdate(std::move(update), qHash(message));
+            }
+        }
+    }
+
+private:
+    StreamServiceDecodePool &m_decodePool;
+    StreamServiceFeatureDecoder m_decoder;
+    const QVector<QByteArray> &m_corpus;
+};
+
+// Returns the decode time in nanoseconds, or a negative value when an update is missing or out of order
+qint64 decodeParallel(StreamServiceDecodePool &decodePool, const StreamServiceFeatureDecoder &decoder, const QVector<QByteArray> &corpus, int expectedCount)
+{
+    QHash<QString, qint64> lastReceiveTimes;
+    bool ordered = true;
+    int poppedCount = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+    MessageProducer producer(decodePool, decoder, corpus);
+    producer.start();
+    StreamServiceTrackUpdate update;
+    while (poppedCount < expectedCount && !timer.hasExpired(30000))
+    {
+        if (!decodePool.tryPop(update))
+        {
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        poppedCount++;
+        if (!update.trackId.isEmpty())
+        {
+            qint64 &lastReceiveTime = lastReceiveTimes[update.trackId];
+            if (update.receiveTime < lastReceiveTime)
+            {
+                ordered = false;
+            }
+            lastReceiveTime = update.receiveTime;
+        }
+    }
+    const qint64 nanos = timer.nsecsElapsed();
+    producer.wait();
+    return (ordered && poppedCount == expectedCount) ? nanos : -1;
+}
+}
+
+///
+/// Measures every stage of decoding and committing a text message on its own.
+/// The stages run one after another over the whole corpus, every stage consumes the results of the previous one.
+/// The corpus is either the text messages of a capture file, a file having one message per line or generated synthetic features.
+/// With verify the decoder is compared with the document path on the corpus and any difference fails.
+/// With project both decoders project the geometries into Web Mercator.
+/// With fields the synthetic attributes are decoded into typed values using the fields of a matching service description.
+/// The decode pool is measured with a growing number of threads up to the given maximum,
+/// every track must leave the pool in the order its messages were pushed.
+///
+int main(int argc, char *argv[])
+{
+    // The graphics are never rendered
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption captureOption(QStringLiteral("capture"), QStringLiteral("Capture file providing the messages."), QStringLiteral("path"));
+    QCommandLineOption corpusOption(QStringLiteral("corpus"), QStringLiteral("File providing one message per line."), QStringLiteral("path"));
+    QCommandLineOption verifyOption(QStringLiteral("verify"), QStringLiteral("Compare the decoder with the document path."));
+    QCommandLineOption projectOption(QStringLiteral("project"), QStringLiteral("Project the geometries into Web Mercator."));
+    QCommandLineOption fieldsOption(QStringLiteral("fields"), QStringLiteral("Decode the synthetic attributes using a field schema."));
+    QCommandLineOption messagesOption(QStringLiteral("messages"), QStringLiteral("Number of synthetic messages."), QStringLiteral("count"), QStringLiteral("100000"));
+    QCommandLineOption tracksOption(QStringLiteral("tracks"), QStringLiteral("Number of synthetic tracks."), QStringLiteral("count"), QStringLiteral("1000"));
+    QCommandLineOption attributesOption(QStringLiteral("attributes"), QStringLiteral("Synthetic attributes besides track id and time."), QStringLiteral("count"), QStringLiteral("8"));
+    QCommandLineOption trackIdFieldOption(QStringLiteral("track-id-field"), QStringLiteral("Field holding the track id."), QStringLiteral("name"), QStringLiteral("track_id"));
+    QCommandLineOption startTimeFieldOption(QStringLiteral("start-time-field"), QStringLiteral("Field holding the start time."), QStringLiteral("name"), QStringLiteral("time"));
+    QCommandLineOption threadsOption(QStringLiteral("threads"), QStringLiteral("Maximum number of decode threads."), QStringLiteral("count"), QString::number(QThread::idealThreadCount()));
+    parser.addOptions({ captureOption, corpusOption, verifyOption, projectOption, fieldsOption, messagesOption, tracksOption, attributesOption, trackIdFieldOption, startTimeFieldOption, threadsOption });
+    parser.process(app);
+
+    const QString trackIdField = parser.value(trackIdFieldOption);
+    const QString startTimeField = parser.value(startTimeFieldOption);
+    StreamServiceFieldSchema fieldSchema;
+
+    QVector<QByteArray> corpus;
+    if (parser.isSet(captureOption))
+    {
+        if (!readCapture(parser.value(captureOption), corpus))
+        {
+            return 1;
+        }
+        out << "capture: " << parser.value(captureOption) << ", messages: " << corpus.size() << endl;
+    }
+    else if (parser.isSet(corpusOption))
+    {
+        if (!readCorpus(parser.value(corpusOption), corpus))
+        {
+            return 1;
+        }
+        out << "corpus: " << parser.value(corpusOption) << ", messages: " << corpus.size() << endl;
+    }
+    else
+    {
+        const int messageCount = qMax(1, parser.value(messagesOption).toInt());
+        const int trackCount = qMax(1, parser.value(tracksOption).toInt());
+        const int attributeCount = qMax(0, parser.value(attributesOption).toInt());
+        SyntheticFeatureGenerator generator(trackCount, attributeCount);
+        corpus.reserve(messageCount);
+        for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+        {
+            corpus.append(generator.nextMessage());
+        }
+        if (parser.isSet(fieldsOption))
+        {
+            fieldSchema = StreamServiceFieldSchema::createFromJson(generator.fieldsJson());
+        }
+        out << "synthetic messages: " << messageCount << ", tracks: " << trackCount << ", attributes: " << attributeCount << endl;
+    }
+
+    const int messageCount = corpus.size();
+    if (0 == messageCount)
+    {
+        out << "The corpus does not contain any text message!" << endl;
+        return 1;
+    }
+
+    // The websocket hands out text messages as QString
+    QVector<QString> textMessages(messageCount);
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        textMessages[messageIndex] = QString::fromUtf8(corpus[messageIndex]);
+    }
+
+    QElapsedTimer timer;
+    QVector<QByteArray> utf8Messages(messageCount);
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        utf8Messages[messageIndex] = textMessages[messageIndex].toUtf8();
+    }
+    printStage(out, "utf-16 to utf-8:", timer.nsecsElapsed(), messageCount);
+
+    QVector<QJsonObject> featureObjects(messageCount);
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        featureObjects[messageIndex] = QJsonDocument::fromJson(utf8Messages[messageIndex]).object();
+    }
+    printStage(out, "json document:", timer.nsecsElapsed(), messageCount);
+
+    QVector<StreamServiceTrackUpdate> updates(messageCount);
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        // The geometry object is serialized again, only the runtime parses geometries
+        const QJsonObject geometryObject = featureObjects[messageIndex].value(QStringLiteral("geometry")).toObject();
+        updates[messageIndex].geometry = Geometry::fromJson(QJsonDocument(geometryObject).toJson());
+    }
+    printStage(out, "geometry:", timer.nsecsElapsed(), messageCount);
+
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        updates[messageIndex].attributes = featureObjects[messageIndex].value(QStringLiteral("attributes")).toObject().toVariantMap();
+    }
+    printStage(out, "attributes:", timer.nsecsElapsed(), messageCount);
+
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        StreamServiceTrackUpdate &update = updates[messageIndex];
+        update.trackId = update.attributes.value(trackIdField).toString();
+        update.trackIdHash = StreamServiceTrackTable::hashTrackId(update.trackId);
+        update.startTime = QDateTime::fromMSecsSinceEpoch(update.attributes.value(startTimeField).toLongLong(), Qt::UTC);
+    }
+    printStage(out, "time info fields:", timer.nsecsElapsed(), messageCount);
+
+    TimeExtent timeExtent;
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        StreamServiceLayer::updateTimeExtent(timeExtent, updates[messageIndex]);
+    }
+    printStage(out, "time extent:", timer.nsecsElapsed(), messageCount);
+
+    StreamServiceTrackTable trackTable;
+    QVector<Graphic*> trackGraphics;
+    QVector<Graphic*> updateGraphics(messageCount);
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        StreamServiceTrackUpdate &update = updates[messageIndex];
+        update.trackHandle = trackTable.insert(update.trackId, update.trackIdHash);
+        const int handleIndex = static_cast<int>(update.trackHandle);
+        if (trackGraphics.size() <= handleIndex)
+        {
+            trackGraphics.resize(trackTable.handleCapacity());
+        }
+        updateGraphics[messageIndex] = trackGraphics[handleIndex];
+    }
+    printStage(out, "track lookup:", timer.nsecsElapsed(), messageCount);
+
+    // Every track has its graphic up front, so that only updates are measured
+    GraphicsOverlay graphicsOverlay;
+    QVector<QVariantMap> trackAttributes(trackGraphics.size());
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        const StreamServiceTrackUpdate &update = updates[messageIndex];
+        const int handleIndex = static_cast<int>(update.trackHandle);
+        if (nullptr == trackGraphics[handleIndex])
+        {
+            trackGraphics[handleIndex] = new Graphic(update.geometry, update.attributes, &graphicsOverlay);
+            trackAttributes[handleIndex] = update.attributes;
+            graphicsOverlay.graphics()->append(trackGraphics[handleIndex]);
+        }
+        updateGraphics[messageIndex] = trackGraphics[handleIndex];
+    }
+
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        const StreamServiceTrackUpdate &update = updates[messageIndex];
+        Graphic *trackGraphic = updateGraphics[messageIndex];
+        if (!trackGraphic->geometry().equals(update.geometry))
+        {
+            trackGraphic->setGeometry(update.geometry);
+        }
+        StreamServiceLayer::applyAttributeDelta(trackGraphic, trackAttributes[static_cast<int>(update.trackHandle)], update.attributes);
+    }
+    printStage(out, "model mutation:", timer.nsecsElapsed(), messageCount);
+
+    // The complete decoders for comparison with the sum of the decode stages
+    StreamServiceFeatureDecoder decoder;
+    decoder.setTimeInfoFields(trackIdField, startTimeField, QString());
+    const bool project = parser.isSet(projectOption);
+    if (project)
+    {
+        decoder.setTargetWkid(StreamServiceProjection::WebMercatorWkid);
+    }
+    decoder.setFieldSchema(fieldSchema);
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        StreamServiceTrackUpdate update;
+        decoder.decodeDocument(corpus[messageIndex], update);
+    }
+    printStage(out, "document decode:", timer.nsecsElapsed(), messageCount);
+
+    int decodedCount = 0;
+    timer.start();
+    for (int messageIndex = 0; messageIndex < messageCount; messageIndex++)
+    {
+        StreamServiceTrackUpdate update;
+        if (decoder.decode(corpus[messageIndex], update))
+        {
+            decodedCount++;
+        }
+    }
+    const qint64 completeDecodeNanos = timer.nsecsElapsed();
+    printStage(out, "complete decode:", completeDecodeNanos, messageCount);
+
+    // Doubling the threads up to the maximum, the speedup is relative to a single decode thread
+    const int maximumThreadCount = qMax(1, parser.value(threadsOption).toInt());
+    qint64 singleThreadNanos = 0;
+    bool parallelOrdered = true;
+    for (int threadCount = 1; ; threadCount = qMin(threadCount * 2, maximumThreadCount))
+    {
+        StreamServiceDecodePool decodePool;
+        decodePool.setTimeInfoFields(trackIdField, startTimeField, QString());
+        if (project)
+        {
+            decodePool.setTargetWkid(StreamServiceProjection::WebMercatorWkid);
+        }
+        decodePool.setFieldSchema(fieldSchema);
+        decodePool.start(threadCount);
+        const qint64 nanos = decodeParallel(decodePool, decoder, corpus, decodedCount);
+        decodePool.stop();
+        if (nanos < 0)
+        {
+            out << "  parallel decode with " << threadCount << " threads lost or reordered updates!" << endl;
+            parallelOrdered = false;
+            break;
+        }
+
+        if (1 == threadCount)
+        {
+            singleThreadNanos = nanos;
+        }
+        out << "  " << QStringLiteral("parallel decode x%1:").arg(threadCount).leftJustified(24) << double(nanos) / messageCount << " ns/msg, "
+            << qRound64(messageCount * 1e9 / nanos) << " msg/s, speedup " << double(singleThreadNanos) / nanos << endl;
+        if (maximumThreadCount == threadCount)
+        {
+            break;
+        }
+    }
+
+    out << "decoded: " << decodedCount << ", tracks: " << trackTable.size() << ", time extent: "
+        << timeExtent.startTime().toString(Qt::ISODate) << " - " << timeExtent.endTime().toString(Qt::ISODate) << endl;
+
+    if (parser.isSet(verifyOption))
+    {
+        // A millimeter in Web Mercator
+        const int mismatchCount = verifyDecoder(out, decoder, corpus, project ? 0.001 : 0.0);
+        out << "verified: " << messageCount << ", mismatches: " << mismatchCount << endl;
+        if (0 < mismatchCount)
+        {
+            return 1;
+        }
+    }
+    return (0 < decodedCount && parallelOrdered) ? 0 : 1;
+}
@@ -0,0 +1,277 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceDensityGrid.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include <cmath>
+
+namespace
+{
+// Web Mercator bounds of the world in meters
+const double WorldExtent = 20037508.0;
+
+// Viewports from a continent down to a city, about 128 cells across
+const QVector<double> ViewportSizes = { 4000000, 500000, 50000 };
+const int MaximumColumns = 128;
+
+// Windows compared with the naive grid per viewport size, placed around random tracks
+const int VerifyCount = 10;
+
+// Counts the windows differing from a naive dense grid built from every track and blurred by a direct convolution
+int countMismatches(const StreamServiceDensityGrid &densityGrid, const QVector<double> &x, const QVector<double> &y, const QVector<float> &weights, int blurRadius)
+{
+    int mismatchCount = 0;
+    double expectedTotal = 0.0;
+    for (float weight : weights)
+    {
+        expectedTotal += weight;
+    }
+    if (1e-6 * qMax(1.0, expectedTotal) < std::abs(densityGrid.total() - expectedTotal))
+    {
+        mismatchCount++;
+    }
+
+    const double sigma = 0.5 * blurRadius + 0.5;
+    QVector<double> kernel(2 * blurRadius + 1);
+    double kernelSum = 0.0;
+    for (int offset = -blurRadius; offset <= blurRadius; offset++)
+    {
+        kernel[offset + blurRadius] = std::exp(-0.5 * offset * offset / (sigma * sigma));
+        kernelSum += kernel[offset + blurRadius];
+    }
+
+    QRandomGenerator randomGenerator(7);
+    StreamServiceDensityWindow densityWindow;
+    QVector<double> cells;
+    for (double viewportSize : ViewportSizes)
+    {
+        const int level = densityGrid.level(viewportSize, MaximumColumns);
+        const int levelColumns = densityGrid.columns(level);
+        const double levelCellWidth = densityGrid.cellWidth(level);
+        for (int verifyIndex = 0; verifyIndex < VerifyCount; verifyIndex++)
+        {
+            const int centerTrack = randomGenerator.bounded(x.size());
+            const double xMin = x[centerTrack] - viewportSize / 2;
+            const double yMin = y[centerTrack] - viewportSize / 2;
+            densityGrid.window(level, xMin, yMin, xMin + viewportSize, yMin + viewportSize, blurRadius, densityWindow);
+
+            // The cells overlapping the viewport, clamped to the grid
+            const int firstColumn = qBound(0, static_cast<int>(std::floor((xMin + WorldExtent) / levelCellWidth)), levelColumns - 1);
+            const int lastColumn = qBound(0, static_cast<int>(std::floor((xMin + viewportSize + WorldExtent) / levelCellWidth)), levelColumns - 1);
+            const int firstRow = qBound(0, static_cast<int>(std::floor((yMin + WorldExtent) / levelCellWidth)), levelColumns - 1);
+            const int lastRow = qBound(0, static_cast<int>(std::floor((yMin + viewportSize + WorldExtent) / levelCellWidth)), levelColumns - 1);
+            const int columns = lastColumn - firstColumn + 1;
+            const int rows = lastRow - firstRow + 1;
+            if (level != densityWindow.level || columns != densityWindow.columns || rows != densityWindow.rows
+                    || 1e-6 * levelCellWidth < std::abs(densityWindow.xMin - (firstColumn * levelCellWidth - WorldExtent))
+                    || 1e-6 * levelCellWidth < std::abs(densityWindow.yMin - (firstRow * levelCellWidth - WorldExtent)))
+            {
+                mismatchCount++;
+                continue;
+            }
+
+            // Every track adds its weight to the cell of its finest cell on this level
+            const int paddedColumns = columns + 2 * blurRadius;
+            const int paddedRows = rows + 2 * blurRadius;
+            cells.fill(0.0, paddedColumns * paddedRows);
+            const double finestCellWidth = densityGrid.cellWidth(0);
+            for (int trackIndex = 0; trackIndex < x.size(); trackIndex++)
+            {
+                const int column = (qBound(0, static_cast<int>(std::floor((x[trackIndex] + WorldExtent) / finestCellWidth)), densityGrid.columns(0) - 1) >> level)
+                        - firstColumn + blurRadius;
+                const int row = (qBound(0, static_cast<int>(std::floor((y[trackIndex] + WorldExtent) / finestCellWidth)), densityGrid.columns(0) - 1) >> level)
+                        - firstRow + blurRadius;
+                if (0 <= column && column < paddedColumns && 0 <= row && row < paddedRows)
+                {
+                    cells[row * paddedColumns + column] += weights[trackIndex];
+                }
+            }
+
+            double expectedMaximum = 0.0;
+            bool cellsMatch = true;
+            for (int row = 0; row < rows; row++)
+            {
+                for (int column = 0; column < columns; column++)
+                {
+                    double expectedValue = 0.0;
+                    for (int rowOffset = 0; rowOffset < kernel.size(); rowOffset++)
+                    {
+                        for (int columnOffset = 0; columnOffset < kernel.size(); columnOffset++)
+                        {
+                            expectedValue += kernel[rowOffset] * kernel[columnOffset] * cells[(row + rowOffset) * paddedColumns + column + columnOffset];
+                        }
+                    }
+                    expectedValue /= kernelSum * kernelSum;
+                    expectedMaximum = qMax(expectedMaximum, expectedValue);
+                    if (1e-4 * qMax(1.0, expectedValue) < std::abs(densityWindow.values[row * columns + column] - expectedValue))
+                    {
+                        cellsMatch = false;
+                    }
+                }
+            }
+            if (!cellsMatch || 1e-4 * qMax(1.0, expectedMaximum) < std::abs(densityWindow.maximum - expectedMaximum))
+            {
+                mismatchCount++;
+            }
+        }
+    }
+    return mismatchCount;
+}
+
+int runBenchmark(QTextStream &out, int trackCount, int refreshCount, int blurRadius)
+{
+    QRandomGenerator randomGenerator(42);
+    QVector<double> x(trackCount);
+    QVector<double> y(trackCount);
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        x[trackIndex] = (2 * randomGenerator.generateDouble() - 1) * WorldExtent;
+        y[trackIndex] = (2 * randomGenerator.generateDouble() - 1) * WorldExtent;
+    }
+
+    QElapsedTimer timer;
+    StreamServiceDensityGrid densityGrid;
+    densityGrid.setExtent(-WorldExtent, -WorldExtent, WorldExtent, WorldExtent);
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        densityGrid.update(static_cast<quint32>(trackIndex), x[trackIndex], y[trackIndex], 1.0f);
+    }
+    const qint64 buildNanos = timer.nsecsElapsed();
+
+    // Every track moves a few kilometers, only the moved weights are updated
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        x[trackIndex] += 5000 * (randomGenerator.generateDouble() - 0.5);
+        y[trackIndex] += 5000 * (randomGenerator.generateDouble() - 0.5);
+    }
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        densityGrid.update(static_cast<quint32>(trackIndex), x[trackIndex], y[trackIndex], 1.0f);
+    }
+    const qint64 moveNanos = timer.nsecsElapsed();
+
+    // The incrementally moved weights must match aggregating the tracks again
+    QVector<float> weights(trackCount, 1.0f);
+    int mismatchCount = countMismatches(densityGrid, x, y, weights, 0);
+
+    // Baseline: aggregating all tracks again after they moved
+    timer.start();
+    densityGrid.clear();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        densityGrid.update(static_cast<quint32>(trackIndex), x[trackIndex], y[trackIndex], 1.0f);
+    }
+    const qint64 rebuildNanos = timer.nsecsElapsed();
+
+    timer.start();
+    densityGrid.decay(0.5f);
+    const qint64 decayNanos = timer.nsecsElapsed();
+
+    StreamServiceDensityWindow densityWindow;
+    QVector<qint64> windowNanos;
+    double checksum = densityGrid.total();
+    for (double viewportSize : ViewportSizes)
+    {
+        const int level = densityGrid.level(viewportSize, MaximumColumns);
+        timer.start();
+        for (int refreshIndex = 0; refreshIndex < refreshCount; refreshIndex++)
+        {
+            const double xMin = (2 * randomGenerator.generateDouble() - 1) * (WorldExtent - viewportSize);
+            const double yMin = (2 * randomGenerator.generateDouble() - 1) * (WorldExtent - viewportSize);
+            densityGrid.window(level, xMin, yMin, xMin + viewportSize, yMin + viewportSize, blurRadius, densityWindow);
+            checksum += densityWindow.maximum;
+        }
+        windowNanos.append(timer.nsecsElapsed());
+    }
+
+    out << "tracks: " << trackCount << ", refreshes: " << refreshCount << ", blur radius: " << blurRadius << ", checksum: " << checksum << endl;
+    out << "  build:             " << double(buildNanos) / trackCount << " ns/track" << endl;
+    out << "  incremental move:  " << double(moveNanos) / trackCount << " ns/track" << endl;
+    out << "  full rebuild:      " << double(rebuildNanos) / trackCount << " ns/track" << endl;
+    out << "  decay:             " << double(decayNanos) / 1000 << " us" << endl;
+    for (int viewportIndex = 0; viewportIndex < ViewportSizes.size(); viewportIndex++)
+    {
+        out << "  window " << ViewportSizes[viewportIndex] / 1000 << " km: " << double(windowNanos[viewportIndex]) / refreshCount / 1000 << " us/refresh" << endl;
+    }
+    out << "  memory:            " << densityGrid.memoryUsage() / 1024 << " KiB" << endl;
+
+    // Decayed and blurred windows, then again without every tenth track
+    weights.fill(0.5f);
+    mismatchCount += countMismatches(densityGrid, x, y, weights, blurRadius);
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex += 10)
+    {
+        densityGrid.remove(static_cast<quint32>(trackIndex));
+        weights[trackIndex] = 0.0f;
+    }
+    mismatchCount += countMismatches(densityGrid, x, y, weights, blurRadius);
+    out << "  verification:      " << ((0 == mismatchCount) ? QStringLiteral("ok") : QStringLiteral("%1 mismatches").arg(mismatchCount)) << endl;
+    return mismatchCount;
+}
+}
+
+///
+/// Compares moving tracks within the density grid with aggregating all of them again
+/// and measures the blurred windows shown by the heat view.
+/// The windows are verified against a naive grid aggregated from every track.
+/// Without arguments 10k, 100k and 1M tracks are measured.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList arguments = app.arguments();
+    QVector<int> trackCounts = { 10000, 100000, 1000000 };
+    int refreshCount = 100;
+    int blurRadius = 1;
+    if (1 < arguments.size())
+    {
+        trackCounts = { arguments.at(1).toInt() };
+    }
+    if (2 < arguments.size())
+    {
+        refreshCount = arguments.at(2).toInt();
+    }
+    if (3 < arguments.size())
+    {
+        blurRadius = arguments.at(3).toInt();
+    }
+
+    int mismatchCount = 0;
+    for (int trackCount : qAsConst(trackCounts))
+    {
+        mismatchCount += runBenchmark(out, trackCount, refreshCount, blurRadius);
+    }
+    return (0 == mismatchCount) ? 0 : 1;
+}
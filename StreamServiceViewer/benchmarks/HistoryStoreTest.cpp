@@ -0,0 +1,247 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceHistoryStore.h"
+#include "TestReport.h"
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVariantMap>
+#include <QVector>
+
+#include <algorithm>
+
+namespace
+{
+const int TrackCount = 300;
+const int OperationCount = 20000;
+const qint64 Retention = 5000;
+
+struct Observation
+{
+    QString trackId;
+    qint64 time;
+    int sequence;
+};
+
+// The sequence identifies an observation, it is stored as its x coordinate and as attribute
+void append(StreamServiceHistoryStore &historyStore, const QString &trackId, qint64 time, int sequence)
+{
+    QVariantMap attributes;
+    attributes.insert(QStringLiteral("sequence"), sequence);
+    historyStore.append(trackId, StreamServiceTrackTable::hashTrackId(trackId), sequence, 0, time, attributes);
+}
+
+QVector<int> sequences(const QVector<StreamServiceHistoryObservation> &observations)
+{
+    QVector<int> observationSequences;
+    for (auto const &observation : observations)
+    {
+        observationSequences.append(static_cast<int>(observation.x));
+    }
+    return observationSequences;
+}
+
+// Brute force, the latest observation of every track newest first, the later append wins on equal times
+QVector<int> latestInWindow(const QVector<Observation> &observations, qint64 windowStart, qint64 windowEnd)
+{
+    QVector<Observation> latestObservations;
+    for (auto const &observation : observations)
+    {
+        if (observation.time < windowStart || windowEnd < observation.time)
+        {
+            continue;
+        }
+
+        auto latestObservation = std::find_if(latestObservations.begin(), latestObservations.end(), [&observation](const Observation &other)
+        {
+            return other.trackId == observation.trackId;
+        });
+        if (latestObservations.end() == latestObservation)
+        {
+            latestObservations.append(observation);
+        }
+        else if (latestObservation->time < observation.time
+                 || (latestObservation->time == observation.time && latestObservation->sequence < observation.sequence))
+        {
+            *latestObservation = observation;
+        }
+    }
+
+    std::sort(latestObservations.begin(), latestObservations.end(), [](const Observation &first, const Observation &second)
+    {
+        return (first.time == second.time) ? second.sequence < first.sequence : second.time < first.time;
+    });
+    QVector<int> observationSequences;
+    for (auto const &observation : qAsConst(latestObservations))
+    {
+        observationSequences.append(observation.sequence);
+    }
+    return observationSequences;
+}
+
+// Keeps the observations within the retention relative to the newest one
+void trim(QVector<Observation> &observations, qint64 retention)
+{
+    if (observations.isEmpty())
+    {
+        return;
+    }
+
+    qint64 endTime = observations.first().time;
+    for (auto const &observation : qAsConst(observations))
+    {
+        endTime = qMax(endTime, observation.time);
+    }
+
+    const qint64 oldestTime = endTime - retention;
+    observations.erase(std::remove_if(observations.begin(), observations.end(), [oldestTime](const Observation &observation)
+    {
+        return observation.time < oldestTime;
+    }), observations.end());
+}
+
+void testOrder(TestReport &report)
+{
+    StreamServiceHistoryStore historyStore;
+    append(historyStore, QStringLiteral("a"), 1000, 0);
+    report.check(0 == historyStore.size(), QStringLiteral("nothing is recorded without a retention"));
+
+    historyStore.setRetention(1000);
+    append(historyStore, QStringLiteral("a"), 1000, 1);
+    append(historyStore, QStringLiteral("b"), 1200, 2);
+    append(historyStore, QStringLiteral("a"), 1100, 3);
+    append(historyStore, QStringLiteral("b"), 1200, 4);
+    append(historyStore, QString(), 1300, 5);
+    report.check(4 == historyStore.size() && 1000 == historyStore.startTime() && 1200 == historyStore.endTime(), QStringLiteral("late observations are inserted in time order"));
+    report.check(QVector<int>({ 4, 3 }) == sequences(historyStore.latestInWindow(0, 2000)), QStringLiteral("latest observations newest first"));
+    report.check(QVector<int>({ 1 }) == sequences(historyStore.latestInWindow(1000, 1050)), QStringLiteral("a window before the latest observation"));
+    report.check(sequences(historyStore.latestInWindow(1300, 2000)).isEmpty(), QStringLiteral("a window after every observation"));
+
+    // Too old for the retention, trimmed right away
+    append(historyStore, QStringLiteral("c"), 100, 6);
+    report.check(4 == historyStore.size(), QStringLiteral("an observation older than the retention is dropped"));
+
+    append(historyStore, QStringLiteral("c"), 2150, 7);
+    report.check(3 == historyStore.size() && 1200 == historyStore.startTime(), QStringLiteral("a newer observation trims the older ones"));
+    report.check(QVector<int>({ 7, 4 }) == sequences(historyStore.latestInWindow(0, 3000)), QStringLiteral("trimmed tracks are gone"));
+
+    historyStore.setRetention(0);
+    report.check(0 == historyStore.size() && 0 == historyStore.endTime(), QStringLiteral("a retention of zero clears the history"));
+    report.check(historyStore.latestInWindow(0, 3000).isEmpty(), QStringLiteral("a cleared history has no observations"));
+}
+
+// Mostly ordered observations with late and too old ones compared with a plain list
+void testReference(TestReport &report)
+{
+    QRandomGenerator randomGenerator(42);
+    StreamServiceHistoryStore historyStore;
+    historyStore.setRetention(Retention);
+    qint64 retention = Retention;
+    QVector<Observation> observations;
+    QVector<int> lastSequences(TrackCount, -1);
+    qint64 currentTime = 0;
+    int mismatchCount = 0;
+    int queryCount = 0;
+    for (int sequence = 0; sequence < OperationCount; sequence++)
+    {
+        const int trackIndex = randomGenerator.bounded(TrackCount);
+        const QString trackId = QString::number(trackIndex);
+        currentTime += randomGenerator.bounded(3);
+        qint64 time = currentTime;
+        if (0 == randomGenerator.bounded(10))
+        {
+            time -= randomGenerator.bounded(static_cast<int>(retention + 500));
+        }
+
+        append(historyStore, trackId, time, sequence);
+        observations.append(Observation{trackId, time, sequence});
+        lastSequences[trackIndex] = sequence;
+        trim(observations, retention);
+
+        // A longer retention does not bring back trimmed observations
+        if (0 == randomGenerator.bounded(2000))
+        {
+            retention = 1000 + randomGenerator.bounded(static_cast<int>(Retention));
+            historyStore.setRetention(retention);
+            trim(observations, retention);
+        }
+
+        if (0 != sequence % 50)
+        {
+            continue;
+        }
+
+        qint64 startTime = observations.first().time;
+        qint64 endTime = startTime;
+        for (auto const &observation : qAsConst(observations))
+        {
+            startTime = qMin(startTime, observation.time);
+            endTime = qMax(endTime, observation.time);
+        }
+        if (observations.size() != historyStore.size() || startTime != historyStore.startTime() || endTime != historyStore.endTime())
+        {
+            mismatchCount++;
+        }
+
+        const qint64 windowStart = startTime - 100 + randomGenerator.bounded(static_cast<int>(endTime - startTime + 200));
+        const qint64 windowEnd = windowStart + randomGenerator.bounded(static_cast<int>(retention));
+        const QVector<StreamServiceHistoryObservation> latestObservations = historyStore.latestInWindow(windowStart, windowEnd);
+        if (sequences(latestObservations) != latestInWindow(observations, windowStart, windowEnd))
+        {
+            mismatchCount++;
+        }
+
+        // Only the attributes of the last append are kept per track
+        for (auto const &latestObservation : latestObservations)
+        {
+            const int trackIndex = historyStore.trackId(latestObservation.trackKey).toInt();
+            if (lastSequences.value(trackIndex, -2) != historyStore.attributes(latestObservation.trackKey).value(QStringLiteral("sequence")).toInt())
+            {
+                mismatchCount++;
+            }
+        }
+        queryCount++;
+    }
+
+    report.check(0 < queryCount, QStringLiteral("the random observations are queried"));
+    report.check(0 == mismatchCount, QStringLiteral("%1 random queries mismatch the reference").arg(mismatchCount));
+}
+}
+
+///
+/// Checks the time ordered history against a brute force search over a plain list of observations.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    TestReport report(out);
+
+    testOrder(report);
+    testReference(report);
+    return report.exitCode();
+}
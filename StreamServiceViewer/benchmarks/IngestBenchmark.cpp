@@ -0,0 +1,348 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceLayer.h"
+#include "StreamServiceLayerTimeInfo.h"
+#include "StreamServiceTrace.h"
+#include "SyntheticFeatureGenerator.h"
+
+#include "GraphicsOverlay.h"
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QGuiApplication>
+#include <QHash>
+#include <QJsonObject>
+#include <QTextStream>
+#include <QThread>
+#include <QTimer>
+#include <QWebSocket>
+#include <QWebSocketServer>
+
+#include <atomic>
+
+using namespace Esri::ArcGISRuntime;
+
+namespace
+{
+// Running as fast as possible, the server waits for the socket once this many bytes are queued
+const qint64 MaximumOutstandingBytes = 4 * 1024 * 1024;
+const int MaximumBatchSize = 256;
+
+// Messages sent per tick when running at a rate, keeps a stalled client from flooding the server
+const int MaximumRatedBatchSize = 10000;
+
+const double NanosPerMillisecond = 1000000.0;
+
+///
+/// Local websocket server emitting the features of the synthetic feature generator.
+/// Lives on its own thread, so that generating the messages does not compete with the commit.
+///
+class SyntheticStreamServer : public QObject
+{
+public:
+    SyntheticStreamServer(int trackCount, int attributeCount, double rate) :
+        m_sendTimer(this),
+        m_generator(trackCount, attributeCount),
+        m_rate(rate)
+    {
+        m_sendTimer.setTimerType(Qt::PreciseTimer);
+        m_sendTimer.setInterval((0 < m_rate) ? 1 : 0);
+        connect(&m_sendTimer, &QTimer::timeout, this, [this]() { sendMessages(); });
+    }
+
+    // Must be called on the server thread
+    QUrl listen()
+    {
+        m_server = new QWebSocketServer(QStringLiteral("SyntheticStreamServer"), QWebSocketServer::NonSecureMode, this);
+        connect(m_server, &QWebSocketServer::newConnection, this, [this]() { onNewConnection(); });
+        if (!m_server->listen(QHostAddress::LocalHost, 0))
+        {
+            return QUrl();
+        }
+
+        QUrl endpoint;
+        endpoint.setScheme(QStringLiteral("ws"));
+        endpoint.setHost(m_server->serverAddress().toString());
+        endpoint.setPort(m_server->serverPort());
+        return endpoint;
+    }
+
+    void close()
+    {
+        m_sendTimer.stop();
+        const QList<QWebSocket*> clients = m_outstandingBytes.keys();
+        m_outstandingBytes.clear();
+        for (QWebSocket *client : clients)
+        {
+            client->disconnect(this);
+            client->close();
+            client->deleteLater();
+        }
+        m_server->close();
+    }
+
+    quint64 sentCount() const
+    {
+        return m_sentCount.load(std::memory_order_relaxed);
+    }
+
+private:
+    void onNewConnection()
+    {
+        while (m_server->hasPendingConnections())
+        {
+            QWebSocket *client = m_server->nextPendingConnection();
+            m_outstandingBytes.insert(client, 0);
+            connect(client, &QWebSocket::bytesWritten, this, [this, client](qint64 bytes) {
+                qint64 &outstandingBytes = m_outstandingBytes[client];
+                outstandingBytes = qMax(qint64(0), outstandingBytes - bytes);
+            });
+            connect(client, &QWebSocket::disconnected, this, [this, client]() {
+                m_outstandingBytes.remove(client);
+                client->deleteLater();
+            });
+        }
+
+        // The first client starts the stream
+        if (!m_sendTimer.isActive())
+        {
+            m_clock.start();
+            m_sendTimer.start();
+        }
+    }
+
+    void sendMessages()
+    {
+        int batchSize = MaximumBatchSize;
+        if (0 < m_rate)
+        {
+            const qint64 dueCount = static_cast<qint64>(m_rate * m_clock.nsecsElapsed() / 1e9) - static_cast<qint64>(m_sentCount.load(std::memory_order_relaxed));
+            batchSize = static_cast<int>(qBound(qint64(0), dueCount, qint64(MaximumRatedBatchSize)));
+        }
+        else
+        {
+            for (qint64 outstandingBytes : qAsConst(m_outstandingBytes))
+            {
+                if (MaximumOutstandingBytes < outstandingBytes)
+                {
+                    return;
+                }
+            }
+        }
+
+        for (int messageIndex = 0; messageIndex < batchSize; messageIndex++)
+        {
+            const QString message = QString::fromLatin1(m_generator.nextMessage());
+            const qint64 frameBytes = frameSize(message.size());
+            for (auto client = m_outstandingBytes.begin(); client != m_outstandingBytes.end(); ++client)
+            {
+                client.key()->sendTextMessage(message);
+                client.value() += frameBytes;
+            }
+            m_sentCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    static qint64 frameSize(int payloadSize)
+    {
+        // Frames sent by a server are not masked
+        if (payloadSize < 126)
+        {
+            return payloadSize + 2;
+        }
+        return payloadSize + ((payloadSize < 65536) ? 4 : 10);
+    }
+
+    QWebSocketServer *m_server = nullptr;
+    QHash<QWebSocket*, qint64> m_outstandingBytes;
+    QTimer m_sendTimer;
+    QElapsedTimer m_clock;
+    SyntheticFeatureGenerator m_generator;
+    double m_rate;
+    std::atomic<quint64> m_sentCount{0};
+};
+
+struct PipelineCounters
+{
+    quint64 sentCount = 0;
+    quint64 decodedMessageCount = 0;
+    quint64 decodeNanos = 0;
+    quint64 decodeQueueNanos = 0;
+    quint64 committedUpdateCount = 0;
+};
+
+PipelineCounters readCounters(const SyntheticStreamServer &server, const StreamServiceLayer &streamLayer)
+{
+    PipelineCounters counters;
+    counters.sentCount = server.sentCount();
+    counters.decodedMessageCount = streamLayer.decodedMessageCount();
+    counters.decodeNanos = streamLayer.decodeNanos();
+    counters.decodeQueueNanos = streamLayer.decodeQueueNanos();
+    counters.committedUpdateCount = streamLayer.committedUpdateCount();
+    return counters;
+}
+}
+
+///
+/// Streams synthetic Esri JSON features from a local websocket server through the stream service layer.
+/// Reports the sustained message rate, the decode cost per message and the latency from receiving
+/// a message up to committing it to the graphics. A rate of zero sends as fast as the layer consumes.
+/// Passing a minimum rate or a maximum p99 latency turns the run into a regression check.
+///
+int main(int argc, char *argv[])
+{
+    // The graphics are never rendered
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    QCommandLineParser parser;
+    parser.addHelpOption();
+    QCommandLineOption tracksOption(QStringLiteral("tracks"), QStringLiteral("Number of tracks."), QStringLiteral("count"), QStringLiteral("1000"));
+    QCommandLineOption attributesOption(QStringLiteral("attributes"), QStringLiteral("Attributes per feature besides track id and time."), QStringLiteral("count"), QStringLiteral("8"));
+    QCommandLineOption rateOption(QStringLiteral("rate"), QStringLiteral("Messages per second, 0 sends as fast as possible."), QStringLiteral("rate"), QStringLiteral("0"));
+    QCommandLineOption warmupOption(QStringLiteral("warmup"), QStringLiteral("Seconds streamed before measuring."), QStringLiteral("seconds"), QStringLiteral("2"));
+    QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Seconds measured."), QStringLiteral("seconds"), QStringLiteral("10"));
+    QCommandLineOption minimumRateOption(QStringLiteral("min-rate"), QStringLiteral("Fails below this many decoded messages per second."), QStringLiteral("rate"), QStringLiteral("0"));
+    QCommandLineOption maximumLatencyOption(QStringLiteral("max-p99"), QStringLiteral("Fails above this p99 latency in milliseconds."), QStringLiteral("msecs"), QStringLiteral("0"));
+    QCommandLineOption traceOption(QStringLiteral("trace"), QStringLiteral("Writes the sampled spans of the measured run as Chrome trace JSON."), QStringLiteral("path"));
+    QCommandLineOption traceSamplingOption(QStringLiteral("trace-sampling"), QStringLiteral("Traces one of every n messages."), QStringLiteral("n"), QStringLiteral("100"));
+    QCommandLineOption decodeThreadsOption(QStringLiteral("decode-threads"), QStringLiteral("Threads decoding the messages, 0 uses all but two of the cores."), QStringLiteral("count"), QStringLiteral("0"));
+    parser.addOptions({ tracksOption, attributesOption, rateOption, warmupOption, durationOption, minimumRateOption, maximumLatencyOption, traceOption, traceSamplingOption, decodeThreadsOption });
+    parser.process(app);
+
+    const int trackCount = qMax(1, parser.value(tracksOption).toInt());
+    const int attributeCount = qMax(0, parser.value(attributesOption).toInt());
+    const double rate = qMax(0.0, parser.value(rateOption).toDouble());
+    const double warmup = qMax(0.0, parser.value(warmupOption).toDouble());
+    const double duration = qMax(0.1, parser.value(durationOption).toDouble());
+    const double minimumRate = parser.value(minimumRateOption).toDouble();
+    const double maximumLatency = parser.value(maximumLatencyOption).toDouble();
+
+    QThread serverThread;
+    serverThread.setObjectName(QStringLiteral("SyntheticStreamServer"));
+    SyntheticStreamServer *server = new SyntheticStreamServer(trackCount, attributeCount, rate);
+    server->moveToThread(&serverThread);
+    QObject::connect(&serverThread, &QThread::finished, server, &QObject::deleteLater);
+    serverThread.start();
+
+    QUrl endpoint;
+    QMetaObject::invokeMethod(server, [server, &endpoint]() {
+        endpoint = server->listen();
+    }, Qt::BlockingQueuedConnection);
+    if (endpoint.isEmpty())
+    {
+        out << "The synthetic stream server failed to listen!" << endl;
+        serverThread.quit();
+        serverThread.wait();
+        return 1;
+    }
+
+    QJsonObject timeInfoObject;
+    timeInfoObject.insert(QStringLiteral("trackIdField"), QStringLiteral("track_id"));
+    timeInfoObject.insert(QStringLiteral("startTimeField"), QStringLiteral("time"));
+    QJsonValue timeInfoValue(timeInfoObject);
+
+    GraphicsOverlay graphicsOverlay;
+    StreamServiceLayer streamLayer(QList<QUrl>() << endpoint);
+    streamLayer.setTimeInfo(StreamServiceLayerTimeInfo::createFromJson(timeInfoValue, &streamLayer));
+    streamLayer.setGraphicsModel(graphicsOverlay.graphics());
+    streamLayer.setDecodeThreadCount(parser.value(decodeThreadsOption).toInt());
+    streamLayer.subscribe();
+
+    // Measure after the warmup, so that connecting and creating the graphics are excluded
+    PipelineCounters startCounters;
+    QElapsedTimer measureClock;
+    QTimer::singleShot(static_cast<int>(warmup * 1000), &app, [&]() {
+        startCounters = readCounters(*server, streamLayer);
+        streamLayer.resetCommitLatency();
+        if (parser.isSet(traceOption))
+        {
+            StreamServiceTrace::setSamplingInterval(parser.value(traceSamplingOption).toInt());
+            StreamServiceTrace::setEnabled(true);
+        }
+        measureClock.start();
+        QTimer::singleShot(static_cast<int>(duration * 1000), &app, &QCoreApplication::quit);
+    });
+    app.exec();
+
+    const double measuredSeconds = measureClock.nsecsElapsed() / 1e9;
+    const PipelineCounters endCounters = readCounters(*server, streamLayer);
+    if (parser.isSet(traceOption))
+    {
+        StreamServiceTrace::setEnabled(false);
+        StreamServiceTrace::writeChromeTrace(parser.value(traceOption));
+    }
+    streamLayer.unsubscribe();
+    QMetaObject::invokeMethod(server, [server]() {
+        server->close();
+    }, Qt::BlockingQueuedConnection);
+    serverThread.quit();
+    serverThread.wait();
+
+    const quint64 decodedCount = endCounters.decodedMessageCount - startCounters.decodedMessageCount;
+    const double decodedRate = decodedCount / measuredSeconds;
+    const StreamServiceHistogram &commitLatency = streamLayer.commitLatency();
+    const double p99Latency = commitLatency.quantile(0.99) / NanosPerMillisecond;
+
+    out << "tracks: " << trackCount << ", attributes: " << attributeCount << ", rate: " << rate << " msg/s, measured: " << measuredSeconds << " s" << endl;
+    out << "  sent:              " << (endCounters.sentCount - startCounters.sentCount) / measuredSeconds << " msg/s" << endl;
+    out << "  decoded:           " << decodedRate << " msg/s" << endl;
+    out << "  committed:         " << (endCounters.committedUpdateCount - startCounters.committedUpdateCount) / measuredSeconds << " updates/s" << endl;
+    out << "  decode:            " << ((0 < decodedCount) ? double(endCounters.decodeNanos - startCounters.decodeNanos) / decodedCount : 0.0) << " ns/msg" << endl;
+    out << "  decode queue:      " << ((0 < decodedCount) ? double(endCounters.decodeQueueNanos - startCounters.decodeQueueNanos) / decodedCount : 0.0) << " ns/msg" << endl;
+    out << "  receive to commit: p50 " << commitLatency.quantile(0.5) / NanosPerMillisecond
+        << " ms, p99 " << p99Latency
+        << " ms, p999 " << commitLatency.quantile(0.999) / NanosPerMillisecond
+        << " ms, max " << commitLatency.maximum() / NanosPerMillisecond << " ms" << endl;
+    out << "  tracks:            " << streamLayer.trackCount() << endl;
+
+    int exitCode = 0;
+    if (0 == decodedCount || 0 == commitLatency.count())
+    {
+        out << "FAILED: no messages were committed" << endl;
+        exitCode = 1;
+    }
+    if (static_cast<quint64>(trackCount) <= endCounters.sentCount && streamLayer.trackCount() < trackCount)
+    {
+        out << "FAILED: " << trackCount - streamLayer.trackCount() << " tracks were sent but never committed" << endl;
+        exitCode = 1;
+    }
+    if (0 < minimumRate && decodedRate < minimumRate)
+    {
+        out << "FAILED: decoded rate below " << minimumRate << " msg/s" << endl;
+        exitCode = 1;
+    }
+    if (0 < maximumLatency && maximumLatency < p99Latency)
+    {
+        out << "FAILED: p99 latency above " << maximumLatency << " ms" << endl;
+        exitCode = 1;
+    }
+    return exitCode;
+}
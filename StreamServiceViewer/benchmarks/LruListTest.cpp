@@ -0,0 +1,158 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceLruList.h"
+#include "TestReport.h"
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+
+namespace
+{
+const int HandleCount = 500;
+const int OperationCount = 200000;
+
+// Evicts every handle, least recent first
+QVector<quint32> evictAll(StreamServiceLruList &lruList)
+{
+    QVector<quint32> handles;
+    while (StreamServiceLruList::NoHandle != lruList.leastRecent())
+    {
+        const quint32 handle = lruList.leastRecent();
+        lruList.remove(handle);
+        handles.append(handle);
+        if (HandleCount < handles.size())
+        {
+            // The links form a cycle
+            break;
+        }
+    }
+    return handles;
+}
+
+void testOrder(TestReport &report)
+{
+    StreamServiceLruList lruList;
+    report.check(0 == lruList.size() && StreamServiceLruList::NoHandle == lruList.leastRecent(), QStringLiteral("a new list is empty"));
+
+    for (quint32 handle = 0; handle < 5; handle++)
+    {
+        lruList.touch(handle);
+    }
+    report.check(5 == lruList.size() && 0 == lruList.leastRecent(), QStringLiteral("the first touched handle is the least recent"));
+
+    // Touching the most recent handle again changes nothing
+    lruList.touch(4);
+    lruList.touch(4);
+    report.check(5 == lruList.size(), QStringLiteral("touching the most recent handle keeps the size"));
+
+    lruList.touch(0);
+    report.check(1 == lruList.leastRecent(), QStringLiteral("touching the least recent handle moves it to the front"));
+    report.check(QVector<quint32>({ 1, 2, 3, 4, 0 }) == evictAll(lruList), QStringLiteral("handles are evicted in touch order"));
+    report.check(0 == lruList.size() && !lruList.contains(0), QStringLiteral("evicting every handle empties the list"));
+
+    for (quint32 handle = 0; handle < 6; handle++)
+    {
+        lruList.touch(handle);
+    }
+    lruList.remove(5);
+    lruList.remove(0);
+    lruList.remove(2);
+    lruList.remove(2);
+    lruList.remove(static_cast<quint32>(HandleCount));
+    report.check(3 == lruList.size() && !lruList.contains(2) && lruList.contains(3), QStringLiteral("removing the most recent, the least recent and a middle handle"));
+    report.check(QVector<quint32>({ 1, 3, 4 }) == evictAll(lruList), QStringLiteral("the order survives removing handles"));
+
+    lruList.touch(7);
+    lruList.touch(3);
+    lruList.clear();
+    report.check(0 == lruList.size() && StreamServiceLruList::NoHandle == lruList.leastRecent() && !lruList.contains(3), QStringLiteral("clear removes every handle"));
+    lruList.touch(3);
+    report.check(1 == lruList.size() && 3 == lruList.leastRecent(), QStringLiteral("a cleared list is reused"));
+}
+
+// Random touches, removes and evictions compared with a plain list, least recent first
+void testReference(TestReport &report)
+{
+    QRandomGenerator randomGenerator(42);
+    StreamServiceLruList lruList;
+    QVector<quint32> handles;
+    int mismatchCount = 0;
+    for (int operationIndex = 0; operationIndex < OperationCount; operationIndex++)
+    {
+        const quint32 handle = static_cast<quint32>(randomGenerator.bounded(HandleCount));
+        const int operation = randomGenerator.bounded(10);
+        if (operation < 6)
+        {
+            lruList.touch(handle);
+            handles.removeAll(handle);
+            handles.append(handle);
+        }
+        else if (operation < 8)
+        {
+            lruList.remove(handle);
+            handles.removeAll(handle);
+        }
+        else if (!handles.isEmpty())
+        {
+            const quint32 evictedHandle = lruList.leastRecent();
+            lruList.remove(evictedHandle);
+            if (handles.takeFirst() != evictedHandle)
+            {
+                mismatchCount++;
+            }
+        }
+
+        quint32 leastRecent = StreamServiceLruList::NoHandle;
+        if (!handles.isEmpty())
+        {
+            leastRecent = handles.first();
+        }
+        if (handles.size() != lruList.size() || handles.contains(handle) != lruList.contains(handle) || leastRecent != lruList.leastRecent())
+        {
+            mismatchCount++;
+        }
+    }
+
+    report.check(0 == mismatchCount, QStringLiteral("%1 random operations mismatch the reference").arg(mismatchCount));
+    report.check(handles == evictAll(lruList), QStringLiteral("the remaining handles are evicted in reference order"));
+}
+}
+
+///
+/// Checks the eviction order of the recency list against a plain list of handles.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    TestReport report(out);
+
+    testOrder(report);
+    testReference(report);
+    return report.exitCode();
+}
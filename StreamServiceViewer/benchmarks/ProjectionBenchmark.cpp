@@ -0,0 +1,147 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceProjection.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include <cmath>
+#include <limits>
+
+namespace
+{
+const double EarthRadius = 6378137.0;
+const double DegreesToRadians = 3.14159265358979323846 / 180.0;
+
+// Latitude of the square Web Mercator extent
+const double MaximumLatitude = 85.05112877980659;
+
+// The kernel stays within a fraction of a micrometer of the standard library
+const double MaximumDeviation = 1e-6;
+
+// Keeps the largest deviation, a NaN counts as an infinite one
+void updateDeviation(double &maximumDeviation, double value, double expectedValue)
+{
+    const double deviation = std::fabs(value - expectedValue);
+    maximumDeviation = std::isnan(deviation) ? std::numeric_limits<double>::infinity() : qMax(maximumDeviation, deviation);
+}
+
+// Latitudes at and beyond the Web Mercator extent are clamped, odd counts leave a scalar tail
+double edgeDeviation()
+{
+    QVector<double> longitudes = { -180.0, 180.0, 0.0, 179.9, -0.5, 12.25, -97.0 };
+    QVector<double> latitudes = { 90.0, -90.0, MaximumLatitude, -MaximumLatitude, 85.06, -89.0, 0.0 };
+    double maximumDeviation = 0.0;
+    for (int count = 1; count <= latitudes.size(); count++)
+    {
+        QVector<double> x = longitudes.mid(0, count);
+        QVector<double> y = latitudes.mid(0, count);
+        StreamServiceProjection::projectToWebMercator(x.data(), y.data(), count);
+        for (int pointIndex = 0; pointIndex < count; pointIndex++)
+        {
+            const double latitude = qBound(-MaximumLatitude, latitudes[pointIndex], MaximumLatitude);
+            updateDeviation(maximumDeviation, x[pointIndex], EarthRadius * longitudes[pointIndex] * DegreesToRadians);
+            updateDeviation(maximumDeviation, y[pointIndex], EarthRadius * std::atanh(std::sin(latitude * DegreesToRadians)));
+        }
+    }
+    return maximumDeviation;
+}
+}
+
+///
+/// Compares projecting WGS84 positions into Web Mercator one by one with the batched kernel.
+/// The per point baseline uses the standard library, the deviation of the kernel from it is reported in meters.
+/// Fails if the kernel deviates by more than a micrometer, also at the clamped latitudes.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList arguments = app.arguments();
+    int pointCount = 1000000;
+    int batchSize = 256;
+    if (1 < arguments.size())
+    {
+        pointCount = arguments.at(1).toInt();
+    }
+    if (2 < arguments.size())
+    {
+        batchSize = qMax(1, arguments.at(2).toInt());
+    }
+
+    QVector<double> longitudes(pointCount);
+    QVector<double> latitudes(pointCount);
+    QRandomGenerator randomGenerator(42);
+    for (int pointIndex = 0; pointIndex < pointCount; pointIndex++)
+    {
+        longitudes[pointIndex] = randomGenerator.bounded(360.0) - 180.0;
+        latitudes[pointIndex] = randomGenerator.bounded(170.0) - 85.0;
+    }
+
+    QElapsedTimer timer;
+
+    // Baseline: one point after another
+    QVector<double> expectedX(pointCount);
+    QVector<double> expectedY(pointCount);
+    timer.start();
+    for (int pointIndex = 0; pointIndex < pointCount; pointIndex++)
+    {
+        expectedX[pointIndex] = EarthRadius * longitudes[pointIndex] * DegreesToRadians;
+        expectedY[pointIndex] = EarthRadius * std::atanh(std::sin(latitudes[pointIndex] * DegreesToRadians));
+    }
+    const qint64 pointNanos = timer.nsecsElapsed();
+
+    // Batched kernel, in place like the geometry builder
+    QVector<double> x = longitudes;
+    QVector<double> y = latitudes;
+    timer.start();
+    for (int batchStart = 0; batchStart < pointCount; batchStart += batchSize)
+    {
+        const int count = qMin(batchSize, pointCount - batchStart);
+        StreamServiceProjection::projectToWebMercator(x.data() + batchStart, y.data() + batchStart, count);
+    }
+    const qint64 batchNanos = timer.nsecsElapsed();
+
+    double maximumDeviation = 0.0;
+    for (int pointIndex = 0; pointIndex < pointCount; pointIndex++)
+    {
+        updateDeviation(maximumDeviation, x[pointIndex], expectedX[pointIndex]);
+        updateDeviation(maximumDeviation, y[pointIndex], expectedY[pointIndex]);
+    }
+
+    out << "points: " << pointCount << ", batch size: " << batchSize << endl;
+    out << "per point:        " << double(pointNanos) / pointCount << " ns/point" << endl;
+    out << "batched kernel:   " << double(batchNanos) / pointCount << " ns/point" << endl;
+    const double maximumEdgeDeviation = edgeDeviation();
+    out << "max deviation:    " << maximumDeviation << " m" << endl;
+    out << "edge deviation:   " << maximumEdgeDeviation << " m" << endl;
+    return (maximumDeviation <= MaximumDeviation && maximumEdgeDeviation <= MaximumDeviation) ? 0 : 1;
+}
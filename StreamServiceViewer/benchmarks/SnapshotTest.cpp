@@ -0,0 +1,226 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceSnapshot.h"
+#include "TestReport.h"
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QThread>
+#include <QVariantMap>
+#include <QVector>
+
+namespace
+{
+const int Wkid = 4326;
+
+StreamServiceAttributeValue createValue(qint64 integer, double number, const QString &string)
+{
+    StreamServiceAttributeValue value;
+    value.state = StreamServiceAttributeValue::State::Set;
+    value.integer = integer;
+    value.number = number;
+    value.string = string;
+    return value;
+}
+
+// Two tracks with variant and typed attributes, the body ends with the last typed string
+bool writeSnapshot(const QString &filePath, const QString &source)
+{
+    StreamServiceSnapshot snapshot;
+    if (!snapshot.open(filePath, source))
+    {
+        return false;
+    }
+
+    snapshot.begin(Wkid);
+    QVariantMap attributes;
+    attributes.insert(QStringLiteral("count"), 7);
+    attributes.insert(QStringLiteral("speed"), 12.5);
+    attributes.insert(QStringLiteral("name"), QStringLiteral("Gr\u00fc\u00dfe"));
+    attributes.insert(QStringLiteral("active"), true);
+    attributes.insert(QStringLiteral("note"), QVariant());
+    snapshot.beginTrack(QStringLiteral("alpha"), 13.4, 52.5, 1600000000000);
+    snapshot.appendAttributes(attributes);
+    snapshot.appendAttribute(snapshot.keyIndex(QStringLiteral("heading")), StreamServiceFieldSchema::FieldType::Double, createValue(0, 270.5, QString()));
+    StreamServiceAttributeValue nullValue;
+    nullValue.state = StreamServiceAttributeValue::State::Null;
+    snapshot.appendAttribute(snapshot.keyIndex(QStringLiteral("comment")), StreamServiceFieldSchema::FieldType::String, nullValue);
+    snapshot.appendAttribute(snapshot.keyIndex(QStringLiteral("missing")), StreamServiceFieldSchema::FieldType::Integer, StreamServiceAttributeValue());
+    snapshot.endTrack();
+
+    snapshot.beginTrack(QStringLiteral("beta"), -70.1, -33.4, 1600000001000);
+    snapshot.appendAttribute(snapshot.keyIndex(QStringLiteral("count")), StreamServiceFieldSchema::FieldType::Integer, createValue(-2, 0.0, QString()));
+    snapshot.appendAttribute(snapshot.keyIndex(QStringLiteral("status")), StreamServiceFieldSchema::FieldType::String, createValue(0, 0.0, QStringLiteral("ok")));
+    snapshot.endTrack();
+    return snapshot.commit();
+}
+
+QByteArray readFile(const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        return QByteArray();
+    }
+    return file.readAll();
+}
+
+bool writeFile(const QString &filePath, const QByteArray &contents)
+{
+    QFile file(filePath);
+    return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && contents.size() == file.write(contents);
+}
+
+bool readSnapshot(const QString &filePath, const QString &source)
+{
+    int wkid = 0;
+    QVector<StreamServiceSnapshotTrack> tracks;
+    return StreamServiceSnapshot::read(filePath, source, 0, wkid, tracks);
+}
+
+void testRoundTrip(TestReport &report, const QString &filePath, const QString &source)
+{
+    int wkid = 0;
+    QVector<StreamServiceSnapshotTrack> tracks;
+    report.check(StreamServiceSnapshot::read(filePath, source, 0, wkid, tracks), QStringLiteral("the snapshot is read"));
+    report.check(Wkid == wkid, QStringLiteral("the spatial reference is restored"));
+    if (!report.check(2 == tracks.size(), QStringLiteral("both tracks are restored")))
+    {
+        return;
+    }
+
+    const StreamServiceSnapshotTrack &first = tracks[0];
+    report.check(QStringLiteral("alpha") == first.trackId && 13.4 == first.x && 52.5 == first.y && 1600000000000 == first.time, QStringLiteral("first track position"));
+    report.check(7 == first.attributes.value(QStringLiteral("count")).toLongLong(), QStringLiteral("first integer attribute"));
+    report.check(12.5 == first.attributes.value(QStringLiteral("speed")).toDouble(), QStringLiteral("first double attribute"));
+    report.check(QStringLiteral("Gr\u00fc\u00dfe") == first.attributes.value(QStringLiteral("name")).toString(), QStringLiteral("first string attribute"));
+    report.check(first.attributes.value(QStringLiteral("active")).toBool(), QStringLiteral("first boolean attribute"));
+    report.check(first.attributes.contains(QStringLiteral("note")) && first.attributes.value(QStringLiteral("note")).isNull(), QStringLiteral("first null attribute"));
+    report.check(270.5 == first.attributes.value(QStringLiteral("heading")).toDouble(), QStringLiteral("first typed double attribute"));
+    report.check(first.attributes.contains(QStringLiteral("comment")) && first.attributes.value(QStringLiteral("comment")).isNull(), QStringLiteral("first typed null attribute"));
+    report.check(7 == first.attributes.size(), QStringLiteral("missing values are not written"));
+
+    const StreamServiceSnapshotTrack &second = tracks[1];
+    report.check(QStringLiteral("beta") == second.trackId && -70.1 == second.x && -33.4 == second.y && 1600000001000 == second.time, QStringLiteral("second track position"));
+    report.check(-2 == second.attributes.value(QStringLiteral("count")).toLongLong(), QStringLiteral("second typed integer attribute"));
+    report.check(QStringLiteral("ok") == second.attributes.value(QStringLiteral("status")).toString(), QStringLiteral("second typed string attribute"));
+    report.check(2 == second.attributes.size(), QStringLiteral("second attributes only contain the written keys"));
+}
+
+void testRejected(TestReport &report, const QString &filePath, const QString &source)
+{
+    report.check(!readSnapshot(filePath, QStringLiteral("https://example.com/other/StreamServer")), QStringLiteral("a snapshot of another source is rejected"));
+    report.check(!readSnapshot(filePath + QStringLiteral(".missing"), source), QStringLiteral("a missing snapshot is rejected"));
+
+    int wkid = 0;
+    QVector<StreamServiceSnapshotTrack> tracks;
+    QThread::msleep(50);
+    report.check(!StreamServiceSnapshot::read(filePath, source, 10, wkid, tracks), QStringLiteral("an outdated snapshot is rejected"));
+    report.check(StreamServiceSnapshot::read(filePath, source, 60000, wkid, tracks), QStringLiteral("a recent snapshot is read"));
+
+    // The body starts with the size of the source and ends with the last typed string, the rest of the mapping is zeroed
+    const QByteArray contents = readFile(filePath);
+    const int bodyStart = contents.indexOf(source.toUtf8()) - static_cast<int>(sizeof(quint32));
+    const int bodyEnd = contents.lastIndexOf(QByteArrayLiteral("ok")) + 2;
+    if (!report.check(0 < bodyStart && bodyStart < bodyEnd, QStringLiteral("the body is found within the snapshot")))
+    {
+        return;
+    }
+
+    int acceptedCount = 0;
+    for (int byteIndex = bodyStart; byteIndex < bodyEnd; byteIndex++)
+    {
+        QByteArray corruptedContents = contents;
+        corruptedContents[byteIndex] = static_cast<char>(corruptedContents[byteIndex] ^ 0x5A);
+        if (!writeFile(filePath, corruptedContents) || readSnapshot(filePath, source))
+        {
+            acceptedCount++;
+        }
+    }
+    report.check(0 == acceptedCount, QStringLiteral("%1 of %2 corrupted body bytes are accepted").arg(acceptedCount).arg(bodyEnd - bodyStart));
+
+    acceptedCount = 0;
+    for (int size = 0; size < bodyEnd; size++)
+    {
+        if (!writeFile(filePath, contents.left(size)) || readSnapshot(filePath, source))
+        {
+            acceptedCount++;
+        }
+    }
+    report.check(0 == acceptedCount, QStringLiteral("%1 of %2 truncated snapshots are accepted").arg(acceptedCount).arg(bodyEnd));
+
+    // An interrupted commit leaves the header zeroed
+    QByteArray interruptedContents = contents;
+    interruptedContents.replace(0, bodyStart, QByteArray(bodyStart, '\0'));
+    report.check(writeFile(filePath, interruptedContents) && !readSnapshot(filePath, source), QStringLiteral("an interrupted commit is rejected"));
+
+    report.check(writeFile(filePath, contents) && readSnapshot(filePath, source), QStringLiteral("the restored snapshot is read again"));
+}
+
+void testOverwrite(TestReport &report, const QString &filePath, const QString &source)
+{
+    StreamServiceSnapshot snapshot;
+    report.check(snapshot.open(filePath, source), QStringLiteral("the snapshot is opened again"));
+    snapshot.begin(Wkid);
+    snapshot.beginTrack(QStringLiteral("gamma"), 1.0, 2.0, 1600000002000);
+    snapshot.endTrack();
+    report.check(snapshot.commit(), QStringLiteral("a smaller snapshot is committed"));
+    snapshot.close();
+
+    int wkid = 0;
+    QVector<StreamServiceSnapshotTrack> tracks;
+    report.check(StreamServiceSnapshot::read(filePath, source, 0, wkid, tracks)
+                 && 1 == tracks.size() && QStringLiteral("gamma") == tracks.value(0).trackId && tracks.value(0).attributes.isEmpty(),
+                 QStringLiteral("the smaller snapshot replaces the previous one"));
+}
+}
+
+///
+/// Writes a snapshot and reads it again.
+/// Snapshots of another source, outdated, corrupted or truncated ones must be rejected.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    TestReport report(out);
+
+    QTemporaryDir temporaryDir;
+    if (!report.check(temporaryDir.isValid(), QStringLiteral("the temporary directory is created")))
+    {
+        return report.exitCode();
+    }
+
+    const QString filePath = temporaryDir.filePath(QStringLiteral("snapshot.bin"));
+    const QString source = QStringLiteral("https://example.com/arcgis/rest/services/Tracks/StreamServer");
+    report.check(writeSnapshot(filePath, source), QStringLiteral("the snapshot is written"));
+    testRoundTrip(report, filePath, source);
+    testRejected(report, filePath, source);
+    testOverwrite(report, filePath, source);
+    return report.exitCode();
+}
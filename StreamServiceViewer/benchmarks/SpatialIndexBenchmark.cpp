@@ -0,0 +1,292 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceSpatialIndex.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Web Mercator bounds of the world in meters
+const double WorldExtent = 20037508.0;
+
+// Brute force queries around random tracks, uniformly placed viewports are mostly empty
+const int VerifyCount = 200;
+
+// Counts the queries the index and scanning the present tracks disagree on
+int countMismatches(const StreamServiceSpatialIndex &spatialIndex, const QVector<double> &x, const QVector<double> &y, const QVector<bool> &present, QRandomGenerator &randomGenerator)
+{
+    const double viewportSize = 50000;
+    const double radius = 2000;
+    const double identifyTolerance = 250;
+    int mismatchCount = 0;
+    QVector<quint32> handles;
+    QVector<quint32> expectedHandles;
+    for (int verifyIndex = 0; verifyIndex < VerifyCount; verifyIndex++)
+    {
+        const int centerTrack = randomGenerator.bounded(x.size());
+        const double centerX = x[centerTrack] + 500 * (randomGenerator.generateDouble() - 0.5);
+        const double centerY = y[centerTrack] + 500 * (randomGenerator.generateDouble() - 0.5);
+        const double xMin = centerX - viewportSize / 2;
+        const double yMin = centerY - viewportSize / 2;
+
+        handles.clear();
+        spatialIndex.queryExtent(xMin, yMin, xMin + viewportSize, yMin + viewportSize, handles);
+        expectedHandles.clear();
+        for (int trackIndex = 0; trackIndex < x.size(); trackIndex++)
+        {
+            if (present[trackIndex] && xMin <= x[trackIndex] && x[trackIndex] <= xMin + viewportSize
+                    && yMin <= y[trackIndex] && y[trackIndex] <= yMin + viewportSize)
+            {
+                expectedHandles.append(static_cast<quint32>(trackIndex));
+            }
+        }
+        std::sort(handles.begin(), handles.end());
+        if (handles != expectedHandles)
+        {
+            mismatchCount++;
+        }
+
+        handles.clear();
+        spatialIndex.queryRadius(centerX, centerY, radius, handles);
+        expectedHandles.clear();
+        double nearestSquaredDistance = identifyTolerance * identifyTolerance;
+        bool hasNearest = false;
+        for (int trackIndex = 0; trackIndex < x.size(); trackIndex++)
+        {
+            const double deltaX = x[trackIndex] - centerX;
+            const double deltaY = y[trackIndex] - centerY;
+            const double squaredDistance = deltaX * deltaX + deltaY * deltaY;
+            if (!present[trackIndex])
+            {
+                continue;
+            }
+            if (squaredDistance <= radius * radius)
+            {
+                expectedHandles.append(static_cast<quint32>(trackIndex));
+            }
+            if (squaredDistance <= nearestSquaredDistance)
+            {
+                nearestSquaredDistance = squaredDistance;
+                hasNearest = true;
+            }
+        }
+        std::sort(handles.begin(), handles.end());
+        if (handles != expectedHandles)
+        {
+            mismatchCount++;
+        }
+
+        // Tracks at the same distance are equally near
+        const quint32 nearestHandle = spatialIndex.nearest(centerX, centerY, identifyTolerance);
+        if (StreamServiceSpatialIndex::NoHandle == nearestHandle)
+        {
+            if (hasNearest)
+            {
+                mismatchCount++;
+            }
+            continue;
+        }
+
+        const int nearestTrack = static_cast<int>(nearestHandle);
+        const double deltaX = x.value(nearestTrack) - centerX;
+        const double deltaY = y.value(nearestTrack) - centerY;
+        if (!hasNearest || !present.value(nearestTrack) || 1e-6 < std::abs(nearestSquaredDistance - (deltaX * deltaX + deltaY * deltaY)))
+        {
+            mismatchCount++;
+        }
+    }
+    return mismatchCount;
+}
+
+int runBenchmark(QTextStream &out, int trackCount, int queryCount, double cellSize)
+{
+    QRandomGenerator randomGenerator(42);
+    QVector<double> x(trackCount);
+    QVector<double> y(trackCount);
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        x[trackIndex] = (2 * randomGenerator.generateDouble() - 1) * WorldExtent;
+        y[trackIndex] = (2 * randomGenerator.generateDouble() - 1) * WorldExtent;
+    }
+
+    QElapsedTimer timer;
+    quint64 checksum = 0;
+
+    StreamServiceSpatialIndex spatialIndex(cellSize);
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        spatialIndex.insert(static_cast<quint32>(trackIndex), x[trackIndex], y[trackIndex]);
+    }
+    const qint64 insertNanos = timer.nsecsElapsed();
+
+    // Every track moves a few hundred meters, most of them stay within their cell
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        x[trackIndex] += 500 * (randomGenerator.generateDouble() - 0.5);
+        y[trackIndex] += 500 * (randomGenerator.generateDouble() - 0.5);
+        spatialIndex.insert(static_cast<quint32>(trackIndex), x[trackIndex], y[trackIndex]);
+    }
+    const qint64 moveNanos = timer.nsecsElapsed();
+
+    // Viewports of about a city and identify locations
+    const double viewportSize = 50000;
+    const double identifyTolerance = 250;
+    QVector<double> queryX(queryCount);
+    QVector<double> queryY(queryCount);
+    for (int queryIndex = 0; queryIndex < queryCount; queryIndex++)
+    {
+        queryX[queryIndex] = (2 * randomGenerator.generateDouble() - 1) * WorldExtent;
+        queryY[queryIndex] = (2 * randomGenerator.generateDouble() - 1) * WorldExtent;
+    }
+
+    // Baseline: scanning every track, like the graphics overlay does
+    timer.start();
+    for (int queryIndex = 0; queryIndex < queryCount; queryIndex++)
+    {
+        const double xMin = queryX[queryIndex];
+        const double yMin = queryY[queryIndex];
+        for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+        {
+            if (xMin <= x[trackIndex] && x[trackIndex] <= xMin + viewportSize
+                    && yMin <= y[trackIndex] && y[trackIndex] <= yMin + viewportSize)
+            {
+                checksum += trackIndex;
+            }
+        }
+    }
+    const qint64 scanExtentNanos = timer.nsecsElapsed();
+
+    QVector<quint32> handles;
+    timer.start();
+    for (int queryIndex = 0; queryIndex < queryCount; queryIndex++)
+    {
+        handles.clear();
+        spatialIndex.queryExtent(queryX[queryIndex], queryY[queryIndex], queryX[queryIndex] + viewportSize, queryY[queryIndex] + viewportSize, handles);
+        for (quint32 handle : qAsConst(handles))
+        {
+            checksum -= handle;
+        }
+    }
+    const qint64 indexExtentNanos = timer.nsecsElapsed();
+
+    timer.start();
+    for (int queryIndex = 0; queryIndex < queryCount; queryIndex++)
+    {
+        int nearestTrack = -1;
+        double nearestSquaredDistance = identifyTolerance * identifyTolerance;
+        for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+        {
+            const double deltaX = x[trackIndex] - queryX[queryIndex];
+            const double deltaY = y[trackIndex] - queryY[queryIndex];
+            const double squaredDistance = deltaX * deltaX + deltaY * deltaY;
+            if (squaredDistance <= nearestSquaredDistance)
+            {
+                nearestSquaredDistance = squaredDistance;
+                nearestTrack = trackIndex;
+            }
+        }
+        checksum += static_cast<quint32>(nearestTrack);
+    }
+    const qint64 scanIdentifyNanos = timer.nsecsElapsed();
+
+    timer.start();
+    for (int queryIndex = 0; queryIndex < queryCount; queryIndex++)
+    {
+        checksum -= spatialIndex.nearest(queryX[queryIndex], queryY[queryIndex], identifyTolerance);
+    }
+    const qint64 indexIdentifyNanos = timer.nsecsElapsed();
+
+    out << "tracks: " << trackCount << ", queries: " << queryCount << ", cell size: " << cellSize << " m, checksum: " << checksum << endl;
+    out << "  index insert:      " << double(insertNanos) / trackCount << " ns/track" << endl;
+    out << "  index move:        " << double(moveNanos) / trackCount << " ns/track" << endl;
+    out << "  scan extent:       " << double(scanExtentNanos) / queryCount / 1000 << " us/query" << endl;
+    out << "  index extent:      " << double(indexExtentNanos) / queryCount / 1000 << " us/query" << endl;
+    out << "  scan identify:     " << double(scanIdentifyNanos) / queryCount / 1000 << " us/query" << endl;
+    out << "  index identify:    " << double(indexIdentifyNanos) / queryCount / 1000 << " us/query" << endl;
+
+    // Removed tracks must no longer be found
+    QVector<bool> present(trackCount, true);
+    int mismatchCount = countMismatches(spatialIndex, x, y, present, randomGenerator);
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex += 10)
+    {
+        spatialIndex.remove(static_cast<quint32>(trackIndex));
+        present[trackIndex] = false;
+    }
+    mismatchCount += countMismatches(spatialIndex, x, y, present, randomGenerator);
+    if (spatialIndex.size() != trackCount - (trackCount + 9) / 10)
+    {
+        mismatchCount++;
+    }
+    out << "  verification:      " << ((0 == mismatchCount) ? QStringLiteral("ok") : QStringLiteral("%1 mismatches").arg(mismatchCount)) << endl;
+    return mismatchCount;
+}
+}
+
+///
+/// Compares extent queries and identify of the spatial index with scanning all tracks.
+/// The tracks are spread uniformly over the Web Mercator world extent.
+/// The query results are verified against the scan, also after removing tracks.
+/// Without arguments 10k, 100k and 1M tracks are measured.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList arguments = app.arguments();
+    QVector<int> trackCounts = { 10000, 100000, 1000000 };
+    int queryCount = 1000;
+    double cellSize = 5000;
+    if (1 < arguments.size())
+    {
+        trackCounts = { arguments.at(1).toInt() };
+    }
+    if (2 < arguments.size())
+    {
+        queryCount = arguments.at(2).toInt();
+    }
+    if (3 < arguments.size())
+    {
+        cellSize = arguments.at(3).toDouble();
+    }
+
+    int mismatchCount = 0;
+    for (int trackCount : qAsConst(trackCounts))
+    {
+        mismatchCount += runBenchmark(out, trackCount, queryCount, cellSize);
+    }
+    return (0 == mismatchCount) ? 0 : 1;
+}
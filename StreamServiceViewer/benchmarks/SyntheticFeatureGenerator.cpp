@@ -0,0 +1,90 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "SyntheticFeatureGenerator.h"
+
+#include <QDateTime>
+#include <QJsonObject>
+
+SyntheticFeatureGenerator::SyntheticFeatureGenerator(int trackCount, int attributeCount) :
+    m_randomGenerator(7),
+    m_baseTime(QDateTime::currentMSecsSinceEpoch()),
+    m_attributeCount(attributeCount)
+{
+    QRandomGenerator randomGenerator(42);
+    for (int trackIndex = 0; trackIndex < qMax(1, trackCount); trackIndex++)
+    {
+        m_x.append(360 * randomGenerator.generateDouble() - 180);
+        m_y.append(160 * randomGenerator.generateDouble() - 80);
+        m_sequences.append(0);
+
+        // The static attributes alternate between text and numbers
+        QByteArray staticAttributes;
+        for (int attributeIndex = 0; attributeIndex < attributeCount; attributeIndex++)
+        {
+            staticAttributes += ",\"attribute" + QByteArray::number(attributeIndex) + "\":";
+            if (0 == attributeIndex % 2)
+            {
+                staticAttributes += "\"value " + QByteArray::number(trackIndex) + "-" + QByteArray::number(attributeIndex) + "\"";
+            }
+            else
+            {
+                staticAttributes += QByteArray::number(randomGenerator.generateDouble() * 1000, 'f', 3);
+            }
+        }
+        m_staticAttributes.append(staticAttributes);
+    }
+}
+
+QByteArray SyntheticFeatureGenerator::nextMessage()
+{
+    const int trackIndex = m_nextTrack;
+    m_nextTrack = (m_nextTrack + 1) % m_x.size();
+    m_x[trackIndex] = qBound(-180.0, m_x[trackIndex] + 0.01 * (m_randomGenerator.generateDouble() - 0.5), 180.0);
+    m_y[trackIndex] = qBound(-80.0, m_y[trackIndex] + 0.01 * (m_randomGenerator.generateDouble() - 0.5), 80.0);
+    const qint64 time = m_baseTime + 1000 * m_sequences[trackIndex]++;
+
+    QByteArray message;
+    message.reserve(128 + m_staticAttributes[trackIndex].size());
+    message += "{\"geometry\":{\"x\":" + QByteArray::number(m_x[trackIndex], 'f', 6)
+            + ",\"y\":" + QByteArray::number(m_y[trackIndex], 'f', 6)
+            + ",\"spatialReference\":{\"wkid\":4326}},\"attributes\":{\"track_id\":\"track " + QByteArray::number(trackIndex)
+            + "\",\"time\":" + QByteArray::number(time)
+            + m_staticAttributes[trackIndex] + "}}";
+    return message;
+}
+
+QJsonArray SyntheticFeatureGenerator::fieldsJson() const
+{
+    QJsonArray fieldsArray;
+    fieldsArray.append(QJsonObject { { "name", "track_id" }, { "type", "esriFieldTypeString" } });
+    fieldsArray.append(QJsonObject { { "name", "time" }, { "type", "esriFieldTypeDate" } });
+    for (int attributeIndex = 0; attributeIndex < m_attributeCount; attributeIndex++)
+    {
+        const QString type = (0 == attributeIndex % 2) ? QStringLiteral("esriFieldTypeString") : QStringLiteral("esriFieldTypeDouble");
+        fieldsArray.append(QJsonObject { { "name", QStringLiteral("attribute%1").arg(attributeIndex) }, { "type", type } });
+    }
+    return fieldsArray;
+}
@@ -0,0 +1,62 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+
+#ifndef SYNTHETICFEATUREGENERATOR_H
+#define SYNTHETICFEATUREGENERATOR_H
+
+#include <QByteArray>
+#include <QJsonArray>
+#include <QRandomGenerator>
+#include <QVector>
+
+///
+/// \brief The SyntheticFeatureGenerator class
+/// Generates Esri JSON features of tracks moving randomly in WGS84.
+/// Every track moves in turn and its time grows by one second per message.
+/// The features have a track_id, a time and the given number of static attributes.
+///
+class SyntheticFeatureGenerator
+{
+public:
+    SyntheticFeatureGenerator(int trackCount, int attributeCount);
+
+    QByteArray nextMessage();
+
+    // The fields of a matching service description
+    QJsonArray fieldsJson() const;
+
+private:
+    QRandomGenerator m_randomGenerator;
+    qint64 m_baseTime;
+    QVector<double> m_x;
+    QVector<double> m_y;
+    QVector<qint64> m_sequences;
+    QVector<QByteArray> m_staticAttributes;
+    int m_attributeCount;
+    int m_nextTrack = 0;
+};
+
+#endif // SYNTHETICFEATUREGENERATOR_H
@@ -0,0 +1,197 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTimingWheel.h"
+#include "TestReport.h"
+
+#include <QCoreApplication>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+
+#include <algorithm>
+
+namespace
+{
+// Deadlines around the ranges of the four levels and beyond the wheel
+const QVector<qint64> BoundaryDeltas = { 1, 2, 255, 256, 257, 16383, 16384, 16385, 1048575, 1048576, 1048577, 67108863, 67108864, 67108869 };
+
+// Start ticks in the middle of a level and right before the levels wrap around
+const QVector<qint64> StartTicks = { 0, 1, 100, 255, 16383, 1048575, 67108863 };
+
+const int HandleCount = 2000;
+const int OperationCount = 200000;
+const qint64 NotScheduled = -1;
+
+void testBoundaries(TestReport &report)
+{
+    for (qint64 startTick : StartTicks)
+    {
+        StreamServiceTimingWheel timingWheel;
+        QVector<quint32> expiredHandles;
+        timingWheel.advance(startTick, expiredHandles);
+        report.check(startTick == timingWheel.currentTick() && expiredHandles.isEmpty(), QStringLiteral("empty wheel advances to %1").arg(startTick));
+
+        for (int deltaIndex = 0; deltaIndex < BoundaryDeltas.size(); deltaIndex++)
+        {
+            timingWheel.touch(static_cast<quint32>(deltaIndex), startTick + BoundaryDeltas[deltaIndex]);
+        }
+
+        // Every handle expires at its own deadline, not a tick earlier
+        for (int deltaIndex = 0; deltaIndex < BoundaryDeltas.size(); deltaIndex++)
+        {
+            const qint64 deadlineTick = startTick + BoundaryDeltas[deltaIndex];
+            const QString description = QStringLiteral("deadline %1 ticks after %2").arg(BoundaryDeltas[deltaIndex]).arg(startTick);
+            expiredHandles.clear();
+            timingWheel.advance(deadlineTick - 1, expiredHandles);
+            report.check(expiredHandles.isEmpty(), description + QStringLiteral(" does not expire early"));
+            report.check(timingWheel.isScheduled(static_cast<quint32>(deltaIndex)), description + QStringLiteral(" is still scheduled"));
+
+            timingWheel.advance(deadlineTick, expiredHandles);
+            report.check(1 == expiredHandles.size() && static_cast<quint32>(deltaIndex) == expiredHandles.value(0), description + QStringLiteral(" expires on time"));
+            report.check(!timingWheel.isScheduled(static_cast<quint32>(deltaIndex)), description + QStringLiteral(" is no longer scheduled"));
+        }
+    }
+}
+
+void testTouch(TestReport &report)
+{
+    StreamServiceTimingWheel timingWheel;
+    QVector<quint32> expiredHandles;
+
+    // A later deadline across the levels is applied when the first slot comes up
+    timingWheel.touch(0, 200);
+    timingWheel.touch(0, 70000);
+    timingWheel.advance(69999, expiredHandles);
+    report.check(expiredHandles.isEmpty() && timingWheel.isScheduled(0), QStringLiteral("a later deadline postpones the expiry"));
+    timingWheel.advance(70000, expiredHandles);
+    report.check(1 == expiredHandles.size(), QStringLiteral("a later deadline expires on time"));
+
+    // An earlier deadline is relinked right away
+    expiredHandles.clear();
+    timingWheel.touch(1, 80000);
+    timingWheel.touch(1, 70100);
+    timingWheel.advance(70100, expiredHandles);
+    report.check(1 == expiredHandles.size() && !timingWheel.isScheduled(1), QStringLiteral("an earlier deadline expires on time"));
+
+    // Deadlines in the past expire with the next tick
+    expiredHandles.clear();
+    timingWheel.touch(2, 10);
+    timingWheel.advance(70101, expiredHandles);
+    report.check(1 == expiredHandles.size(), QStringLiteral("a past deadline expires with the next tick"));
+
+    expiredHandles.clear();
+    timingWheel.touch(3, 70200);
+    timingWheel.cancel(3);
+    timingWheel.cancel(static_cast<quint32>(HandleCount));
+    timingWheel.advance(70300, expiredHandles);
+    report.check(expiredHandles.isEmpty() && !timingWheel.isScheduled(3), QStringLiteral("a cancelled handle never expires"));
+
+    timingWheel.touch(4, 70400);
+    timingWheel.touch(5, 90000000);
+    timingWheel.clear();
+    report.check(!timingWheel.isScheduled(4) && !timingWheel.isScheduled(5), QStringLiteral("clear removes every handle"));
+    timingWheel.advance(200000, expiredHandles);
+    report.check(expiredHandles.isEmpty(), QStringLiteral("cleared handles never expire"));
+}
+
+// Random touches, cancels and advances compared with a plain list of deadlines
+void testReference(TestReport &report)
+{
+    QRandomGenerator randomGenerator(42);
+    StreamServiceTimingWheel timingWheel;
+    QVector<qint64> deadlines(HandleCount, NotScheduled);
+    QVector<quint32> expiredHandles;
+    QVector<quint32> expectedHandles;
+    int expiredCount = 0;
+    int mismatchCount = 0;
+    for (int operationIndex = 0; operationIndex < OperationCount; operationIndex++)
+    {
+        const quint32 handle = static_cast<quint32>(randomGenerator.bounded(HandleCount));
+        const int operation = randomGenerator.bounded(10);
+        const qint64 currentTick = timingWheel.currentTick();
+        if (operation < 6)
+        {
+            // Mostly short timeouts, some far beyond the wheel
+            const int ranges[] = { 300, 20000, 2000000, 100000000 };
+            const qint64 deadlineTick = currentTick - 10 + randomGenerator.bounded(ranges[randomGenerator.bounded(4)]);
+            timingWheel.touch(handle, deadlineTick);
+            deadlines[static_cast<int>(handle)] = qMax(deadlineTick, currentTick + 1);
+        }
+        else if (operation < 7)
+        {
+            timingWheel.cancel(handle);
+            deadlines[static_cast<int>(handle)] = NotScheduled;
+        }
+        else
+        {
+            const qint64 tick = currentTick + ((0 == randomGenerator.bounded(5)) ? randomGenerator.bounded(100000) : randomGenerator.bounded(50));
+            expiredHandles.clear();
+            timingWheel.advance(tick, expiredHandles);
+
+            expectedHandles.clear();
+            for (int handleIndex = 0; handleIndex < deadlines.size(); handleIndex++)
+            {
+                if (NotScheduled != deadlines[handleIndex] && deadlines[handleIndex] <= tick)
+                {
+                    expectedHandles.append(static_cast<quint32>(handleIndex));
+                    deadlines[handleIndex] = NotScheduled;
+                }
+            }
+
+            std::sort(expiredHandles.begin(), expiredHandles.end());
+            if (expiredHandles != expectedHandles)
+            {
+                mismatchCount++;
+            }
+            expiredCount += expectedHandles.size();
+        }
+
+        if ((NotScheduled != deadlines[static_cast<int>(handle)]) != timingWheel.isScheduled(handle))
+        {
+            mismatchCount++;
+        }
+    }
+
+    report.check(0 < expiredCount, QStringLiteral("the random operations expire handles"));
+    report.check(0 == mismatchCount, QStringLiteral("%1 random operations mismatch the reference").arg(mismatchCount));
+}
+}
+
+///
+/// Checks that the timing wheel expires handles exactly at their deadlines
+/// across the level boundaries and when the levels wrap around.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    TestReport report(out);
+
+    testBoundaries(report);
+    testTouch(report);
+    testReference(report);
+    return report.exitCode();
+}
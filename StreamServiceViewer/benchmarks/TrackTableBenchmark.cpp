@@ -0,0 +1,197 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceTrackTable.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QRandomGenerator>
+#include <QStringList>
+#include <QTextStream>
+#include <QVariant>
+#include <QVector>
+
+namespace
+{
+// Counts the tracks the table and the map disagree on, every handle must resolve to its own track id
+int countMismatches(const StreamServiceTrackTable &trackTable, const QMap<QString, void*> &trackMap, const QVector<QString> &trackIds, const QVector<uint> &trackIdHashes)
+{
+    int mismatchCount = (trackMap.size() == trackTable.size()) ? 0 : 1;
+    QVector<bool> foundHandles(trackTable.handleCapacity(), false);
+    for (int trackIndex = 0; trackIndex < trackIds.size(); trackIndex++)
+    {
+        const QString &trackId = trackIds[trackIndex];
+        const quint32 handle = trackTable.find(trackId, trackIdHashes[trackIndex]);
+        if (!trackMap.contains(trackId))
+        {
+            if (StreamServiceTrackTable::InvalidHandle != handle)
+            {
+                mismatchCount++;
+            }
+            continue;
+        }
+
+        if (StreamServiceTrackTable::InvalidHandle == handle || !trackTable.contains(handle) || trackId != trackTable.trackId(handle)
+                || foundHandles.value(static_cast<int>(handle), true))
+        {
+            mismatchCount++;
+            continue;
+        }
+        foundHandles[static_cast<int>(handle)] = true;
+    }
+    return mismatchCount;
+}
+}
+
+///
+/// Compares the former QMap based track lookup with the interned track table.
+/// The baseline builds a QString from a QVariant and calls contains and value,
+/// the track table uses the id hash precomputed on the ingest thread.
+/// The track table is verified against the map, also after removing and reinserting tracks.
+///
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const QStringList arguments = app.arguments();
+    int trackCount = 100000;
+    int lookupCount = 5000000;
+    if (1 < arguments.size())
+    {
+        trackCount = arguments.at(1).toInt();
+    }
+    if (2 < arguments.size())
+    {
+        lookupCount = arguments.at(2).toInt();
+    }
+
+    QVector<QVariant> trackIdValues;
+    trackIdValues.reserve(trackCount);
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        trackIdValues.append(QVariant(QStringLiteral("MMSI-%1").arg(211000000 + trackIndex)));
+    }
+
+    QVector<int> lookupOrder;
+    lookupOrder.reserve(lookupCount);
+    QRandomGenerator randomGenerator(42);
+    for (int lookupIndex = 0; lookupIndex < lookupCount; lookupIndex++)
+    {
+        lookupOrder.append(static_cast<int>(randomGenerator.bounded(trackCount)));
+    }
+
+    QElapsedTimer timer;
+    quintptr checksum = 0;
+
+    // Baseline: QMap keyed by the track id
+    QMap<QString, void*> trackMap;
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        trackMap.insert(trackIdValues[trackIndex].toString(), reinterpret_cast<void*>(static_cast<quintptr>(trackIndex + 1)));
+    }
+    const qint64 mapInsertNanos = timer.nsecsElapsed();
+
+    timer.start();
+    for (int lookupIndex : qAsConst(lookupOrder))
+    {
+        const QString trackId = trackIdValues[lookupIndex].toString();
+        if (trackMap.contains(trackId))
+        {
+            checksum += reinterpret_cast<quintptr>(trackMap.value(trackId));
+        }
+    }
+    const qint64 mapLookupNanos = timer.nsecsElapsed();
+
+    // Track table keyed by the interned track id
+    QVector<QString> trackIds;
+    QVector<uint> trackIdHashes;
+    trackIds.reserve(trackCount);
+    trackIdHashes.reserve(trackCount);
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        trackIds.append(trackIdValues[trackIndex].toString());
+        trackIdHashes.append(StreamServiceTrackTable::hashTrackId(trackIds.last()));
+    }
+    const qint64 hashNanos = timer.nsecsElapsed();
+
+    StreamServiceTrackTable trackTable;
+    timer.start();
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex++)
+    {
+        trackTable.insert(trackIds[trackIndex], trackIdHashes[trackIndex]);
+    }
+    const qint64 tableInsertNanos = timer.nsecsElapsed();
+
+    timer.start();
+    for (int lookupIndex : qAsConst(lookupOrder))
+    {
+        checksum += trackTable.find(trackIds[lookupIndex], trackIdHashes[lookupIndex]) + 1;
+    }
+    const qint64 tableLookupNanos = timer.nsecsElapsed();
+
+    out << "tracks: " << trackCount << ", lookups: " << lookupCount << ", checksum: " << checksum << endl;
+    out << "QMap insert:          " << double(mapInsertNanos) / trackCount << " ns/track" << endl;
+    out << "QMap contains+value:  " << double(mapLookupNanos) / lookupCount << " ns/lookup" << endl;
+    out << "track id hash:        " << double(hashNanos) / trackCount << " ns/track (ingest thread)" << endl;
+    out << "track table insert:   " << double(tableInsertNanos) / trackCount << " ns/track" << endl;
+    out << "track table find:     " << double(tableLookupNanos) / lookupCount << " ns/lookup" << endl;
+
+    int mismatchCount = countMismatches(trackTable, trackMap, trackIds, trackIdHashes);
+    const QString unknownTrackId = QStringLiteral("MMSI-unknown");
+    if (StreamServiceTrackTable::InvalidHandle != trackTable.find(unknownTrackId, StreamServiceTrackTable::hashTrackId(unknownTrackId)))
+    {
+        mismatchCount++;
+    }
+
+    // Removed handles are reused by the reinserted tracks
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex += 3)
+    {
+        if (!trackTable.remove(trackTable.find(trackIds[trackIndex], trackIdHashes[trackIndex])))
+        {
+            mismatchCount++;
+        }
+        trackMap.remove(trackIds[trackIndex]);
+    }
+    mismatchCount += countMismatches(trackTable, trackMap, trackIds, trackIdHashes);
+
+    for (int trackIndex = 0; trackIndex < trackCount; trackIndex += 3)
+    {
+        bool inserted = false;
+        trackTable.insert(trackIds[trackIndex], trackIdHashes[trackIndex], &inserted);
+        if (!inserted)
+        {
+            mismatchCount++;
+        }
+        trackMap.insert(trackIds[trackIndex], reinterpret_cast<void*>(static_cast<quintptr>(trackIndex + 1)));
+    }
+    mismatchCount += countMismatches(trackTable, trackMap, trackIds, trackIdHashes);
+
+    out << "verification:         " << ((0 == mismatchCount) ? QStringLiteral("ok") : QStringLiteral("%1 mismatches").arg(mismatchCount)) << endl;
+    return (0 == mismatchCount) ? 0 : 1;
+}
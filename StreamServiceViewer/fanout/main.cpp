@@ -0,0 +1,206 @@
+// StreamServiceViewer
+// Copyright (C) 2021 Esri Deutschland GmbH
+// Jan Tschada (j.tschada@esri.de)
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 3 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU Lesser General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+// Additional permission under GNU GPL version 3 section 7
+//
+// If you modify this Program, or any covered work, by linking or combining
+// it with ArcGIS Runtime for Qt (or a modified version of that library),
+// containing parts covered by the terms of ArcGIS Runtime for Qt,
+// the licensors of this Program grant you additional permission to convey the resulting work.
+// See <https://developers.arcgis.com/qt/> for further information.
+
+#include "StreamServiceFanOutServer.h"
+#include "StreamServiceLayerTimeInfo.h"
+
+#include <QDebug>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QProcessEnvironment>
+#include <QTimer>
+#include <QUrl>
+
+//------------------------------------------------------------------------------
+
+///
+/// \brief readWebSocketEndpoints
+/// Collects the urls of every websocket transport of the service description, each of them serves the same stream.
+///
+static QList<QUrl> readWebSocketEndpoints(const QJsonObject &serviceObject)
+{
+    QList<QUrl> webSocketEndpoints;
+    const QJsonArray streamUrlsArray = serviceObject.value("streamUrls").toArray();
+    for (const QJsonValue &streamUrlsItemValue : streamUrlsArray)
+    {
+        const QJsonObject streamUrlsItemObject = streamUrlsItemValue.toObject();
+        if (QStringLiteral("ws") != streamUrlsItemObject.value("transport").toString(QStringLiteral("ws")))
+        {
+            continue;
+        }
+
+        const QJsonArray urlsArray = streamUrlsItemObject.value("urls").toArray();
+        for (const QJsonValue &urlValue : urlsArray)
+        {
+            QUrl webSocketEndpoint(urlValue.toString());
+            if (webSocketEndpoint.isValid() && !webSocketEndpoints.contains(webSocketEndpoint))
+            {
+                webSocketEndpoints.append(webSocketEndpoint);
+            }
+        }
+    }
+    return webSocketEndpoints;
+}
+
+///
+/// \brief createFanOutServer
+/// Creates the fan-out server for the service description using the settings of the process environment.
+///
+static StreamServiceFanOutServer* createFanOutServer(const QByteArray &description, QObject *parent)
+{
+    QJsonDocument serviceDocument = QJsonDocument::fromJson(description);
+    if (!serviceDocument.isObject())
+    {
+        qWarning() << "Unsupported service description received!";
+        return nullptr;
+    }
+
+    QJsonObject serviceObject = serviceDocument.object();
+    const QList<QUrl> webSocketEndpoints = readWebSocketEndpoints(serviceObject);
+    if (webSocketEndpoints.isEmpty())
+    {
+        qWarning() << "Streaming urls does not contain any websocket url!";
+        return nullptr;
+    }
+
+    StreamServiceFanOutServer *fanOutServer = new StreamServiceFanOutServer(webSocketEndpoints, parent);
+    QJsonValue timeInfoValue = serviceObject.value("timeInfo");
+    StreamServiceLayerTimeInfo *timeInfo = StreamServiceLayerTimeInfo::createFromJson(timeInfoValue, fanOutServer);
+    fanOutServer->setTimeInfo(timeInfo);
+
+    // The viewers use a Web Mercator basemap, so the features are projected once for all of them
+    QProcessEnvironment systemEnvironment = QProcessEnvironment::systemEnvironment();
+    QString wkidKeyName = "streamservice_fanout_wkid";
+    fanOutServer->setTargetWkid(systemEnvironment.value(wkidKeyName, QStringLiteral("3857")).toInt());
+
+    QString intervalKeyName = "streamservice_fanout_interval";
+    if (systemEnvironment.contains(intervalKeyName))
+    {
+        fanOutServer->setPublishInterval(systemEnvironment.value(intervalKeyName).toInt());
+    }
+
+    QString connectionModeKeyName = "streamservice_connection_mode";
+    if (QStringLiteral("parallel") == systemEnvironment.value(connectionModeKeyName))
+    {
+        fanOutServer->setConnectionMode(StreamServiceIngestWorker::ConnectionMode::Parallel);
+    }
+
+    QString decodeThreadsKeyName = "streamservice_decode_threads";
+    if (systemEnvironment.contains(decodeThreadsKeyName))
+    {
+        fanOutServer->setDecodeThreadCount(systemEnvironment.value(decodeThreadsKeyName).toInt());
+    }
+
+    QString trackTimeToLiveKeyName = "streamservice_track_ttl";
+    if (systemEnvironment.contains(trackTimeToLiveKeyName))
+    {
+        bool validTimeToLive = false;
+        double trackTimeToLive = systemEnvironment.value(trackTimeToLiveKeyName).toDouble(&validTimeToLive);
+        if (validTimeToLive)
+        {
+            fanOutServer->setTrackTimeToLive(qRound64(trackTimeToLive * 1000));
+        }
+    }
+
+    // Only local viewers are served unless another address is configured
+    QString addressKeyName = "streamservice_fanout_address";
+    QString portKeyName = "streamservice_fanout_port";
+    QHostAddress address(systemEnvironment.value(addressKeyName, QStringLiteral("127.0.0.1")));
+    bool validPort = false;
+    quint16 port = systemEnvironment.value(portKeyName).toUShort(&validPort);
+    if (!validPort || !fanOutServer->listen(address, port))
+    {
+        qWarning() << "Stream service fan-out needs a valid" << portKeyName << "to listen on!";
+        delete fanOutServer;
+        return nullptr;
+    }
+
+    fanOutServer->subscribe();
+    return fanOutServer;
+}
+
+
+int main(int argc, char *argv[])
+{
+    // The runtime geometries need a gui application, no window is ever shown
+    if (!qEnvironmentVariableIsSet("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+    QGuiApplication app(argc, argv);
+
+    QString streamServiceEndpointKeyName = "streamservice_endpoint";
+    QProcessEnvironment systemEnvironment = QProcessEnvironment::systemEnvironment();
+    if (!systemEnvironment.contains(streamServiceEndpointKeyName))
+    {
+        qWarning() << "No stream service endpoint configured!";
+        return 1;
+    }
+
+    QUrl serviceInfoEndpoint(systemEnvironment.value(streamServiceEndpointKeyName));
+    serviceInfoEndpoint.setQuery("f=json");
+
+    // Request the stream service json description, the upstream is subscribed once it arrived
+    QNetworkAccessManager networkAccessManager;
+    StreamServiceFanOutServer *fanOutServer = nullptr;
+    QObject::connect(&networkAccessManager, &QNetworkAccessManager::finished, &app, [&app, &fanOutServer](QNetworkReply *infoReply) {
+        infoReply->deleteLater();
+        if (infoReply->error())
+        {
+            qWarning() << "Stream service info request failed!";
+            app.exit(1);
+            return;
+        }
+
+        fanOutServer = createFanOutServer(infoReply->readAll(), &app);
+        if (nullptr == fanOutServer)
+        {
+            app.exit(1);
+        }
+    });
+    networkAccessManager.get(QNetworkRequest(serviceInfoEndpoint));
+
+    // Report the state of the fan-out once a minute
+    QTimer statusTimer;
+    statusTimer.setInterval(60 * 1000);
+    QObject::connect(&statusTimer, &QTimer::timeout, &app, [&fanOutServer]() {
+        if (nullptr != fanOutServer)
+        {
+            qDebug() << "Stream service fan-out:" << fanOutServer->trackCount() << "tracks,"
+                     << fanOutServer->clientCount() << "clients,"
+                     << fanOutServer->receivedMessageCount() << "received,"
+                     << fanOutServer->duplicateCount() << "duplicates,"
+                     << fanOutServer->publishedMessageCount() << "published";
+        }
+    });
+    statusTimer.start();
+
+    const int exitCode = app.exec();
+    delete fanOutServer;
+    return exitCode;
+}
@@ -16,6 +16,12 @@ import Esri.StreamServiceViewer 1.0
 
 Item {
 
+    property alias historyStart: model.historyStart
+    property alias historyEnd: model.historyEnd
+    property alias liveMode: model.liveMode
+    property alias subscribed: model.subscribed
+    property bool metricsVisible: false
+
     function subscribeEvents() {
         model.subscribeEvents();
     }
@@ -32,12 +38,67 @@ Item {
         model.renderHeat();
     }
 
+    function showHistory(windowStart, windowEnd) {
+        model.showHistory(windowStart, windowEnd);
+    }
+
+    function showLive() {
+        model.showLive();
+    }
+
     // Create MapQuickView here, and create its Map etc. in C++ code
     MapView {
         id: view
         anchors.fill: parent
         // set focus to enable keyboard navigation
         focus: true
+
+        // Identify the nearest live track
+        onMouseClicked: {
+            var attributes = model.identifyTrack(mouse.x, mouse.y, 12);
+            var lines = [];
+            for (var key in attributes) {
+                lines.push(key + ": " + attributes[key]);
+            }
+            identifyLabel.text = lines.join("\n");
+        }
+    }
+
+    Label {
+        id: identifyLabel
+        anchors.top: parent.top
+        anchors.left: parent.left
+        anchors.margins: 10
+        padding: 6
+        visible: 0 < text.length
+        background: Rectangle {
+            color: "#312d2a"
+            opacity: 0.8
+        }
+    }
+
+    // Pipeline metrics of the last second
+    Label {
+        id: metricsLabel
+        anchors.top: parent.top
+        anchors.right: parent.right
+        anchors.margins: 10
+        padding: 6
+        visible: metricsVisible
+        font.family: "monospace"
+        text: qsTr("messages: %1/s, %2 kB/s").arg(model.messageRate.toFixed(0)).arg((model.byteRate / 1024).toFixed(1)) + "\n"
+              + qsTr("parse failures: %1").arg(model.parseFailureCount) + "\n"
+              + qsTr("decode: %1 µs/msg").arg(model.decodeMicroseconds.toFixed(1)) + "\n"
+              + qsTr("queue depth: %1").arg(model.queueDepth) + "\n"
+              + qsTr("commits: %1/s, %2 updates/commit").arg(model.commitRate.toFixed(0)).arg(model.updatesPerCommit.toFixed(1)) + "\n"
+              + qsTr("tracks: %1").arg(model.trackCount) + "\n"
+              + qsTr("receive to commit p99: %1 ms").arg(model.commitLatency.toFixed(1)) + "\n"
+              + qsTr("staleness p50: %1 ms").arg(model.displayStaleness.toFixed(0)) + "\n"
+              + qsTr("frames: %1/s").arg(model.frameRate.toFixed(0))
+        background: Rectangle {
+            color: "#312d2a"
+            opacity: 0.8
+        }
     }
 
     // Declare the C++ instance which creates the map etc. and supply the view
@@ -10,6 +10,7 @@
 // See the Sample code usage restrictions document for further information.
 //
 
+import QtQuick 2.12
 import QtQuick.Controls 2.12
 import QtQuick.Controls.Material 2.12
 import QtQuick.Layouts 1.11
@@ -41,6 +42,7 @@ ApplicationWindow {
               RadioButton {
                   id: subscribeButton
                   text: qsTr("Subscribe")
+                  checked: viewerFrom.subscribed
                   onClicked: {
                     viewerFrom.subscribeEvents();
                   }
@@ -49,7 +51,7 @@ ApplicationWindow {
               RadioButton {
                   id: unsubscribeButton
                   text: qsTr("Unsubscribe")
-                  checked: true
+                  checked: !viewerFrom.subscribed
                   onClicked: {
                     viewerFrom.unsubscribeEvents();
                   }
@@ -75,6 +77,74 @@ ApplicationWindow {
                     viewerFrom.renderHeat();
                   }
               }
+
+              CheckBox {
+                  id: metricsCheckBox
+                  text: qsTr("Metrics")
+                  onCheckedChanged: {
+                    viewerFrom.metricsVisible = checked;
+                  }
+              }
+           }
+       }
+    }
+
+    footer: ToolBar {
+       RowLayout {
+           id: historyLayout
+           anchors.fill: parent
+
+           // Length of the scrubbed time window in milliseconds
+           property real historyWindow: 5 * 60 * 1000
+
+           Button {
+               id: liveButton
+               text: qsTr("Live")
+               enabled: !viewerFrom.liveMode
+               onClicked: {
+                 playbackTimer.stop();
+                 viewerFrom.showLive();
+               }
+           }
+
+           Button {
+               id: playButton
+               text: playbackTimer.running ? qsTr("Pause") : qsTr("Play")
+               enabled: historySlider.enabled
+               onClicked: {
+                 playbackTimer.running = !playbackTimer.running;
+               }
+           }
+
+           Slider {
+               id: historySlider
+               Layout.fillWidth: true
+               from: viewerFrom.historyStart
+               to: viewerFrom.historyEnd
+               enabled: viewerFrom.historyStart < viewerFrom.historyEnd
+               onMoved: {
+                 viewerFrom.showHistory(value - historyLayout.historyWindow, value);
+               }
+           }
+
+           Label {
+               text: viewerFrom.liveMode ? qsTr("Live") : new Date(historySlider.value).toLocaleTimeString(Qt.locale(), Locale.ShortFormat)
+           }
+
+           // Plays the history back at sixty times the real speed
+           Timer {
+               id: playbackTimer
+               interval: 100
+               repeat: true
+               onTriggered: {
+                 var nextValue = historySlider.value + interval * 60;
+                 if (historySlider.to <= nextValue) {
+                     nextValue = historySlider.to;
+                     stop();
+                 }
+                 historySlider.value = nextValue;
+                 viewerFrom.showHistory(nextValue - historyLayout.historyWindow, nextValue);
+               }
            }
        }
     }